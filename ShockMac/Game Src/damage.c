@@ -218,7 +218,7 @@ int random_bell_modifier(bool attack_on_player)
    rtotal = handicap;
    for (i=0;i<dies; i++)
    {
-      rval = RndRange(&damage_rnd, 0, die_value);
+      rval = RndStdRange(&damage_rnd, 0, die_value);
       rtotal += rval;
    }
  
@@ -258,7 +258,7 @@ int randomize_damage(int damage,bool attack_on_player)
       iterations++;
 
    for (i=0; i<iterations;i++)
-      dtotal += RndRange(&damage_rnd, 1, 7);
+      dtotal += RndStdRange(&damage_rnd, 1, 7);
 
    // if we're playing on difficulty 3 - reduce damage by a third
    if (!attack_on_player && (difficulty == 3))
@@ -1054,8 +1054,6 @@ void expose_player(byte damage, ubyte type, ushort tsecs)
 // 
 // returns damage to player after enviro-suit
 
-extern long long_sqrt(long num);
-
 #define ENVIRO_ABSORB_DENOM 5 
 #define ENVIRO_DRAIN_DENOM  1
 #define ENVIRO_DRAIN_RATE   32
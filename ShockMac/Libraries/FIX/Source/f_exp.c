@@ -60,3 +60,167 @@ fix fix_exp (fix x)
 	exp_frac_part = loy + (hiy - loy) * fracx / 0x1000;
 	return (fix_mul (exp_int_part, exp_frac_part));
 }
+
+//////////////////////////////
+//
+// The _fast and _hr versions work in base 2: e^x = 2^(x log2 e) and
+// x^y = 2^(y log2 x).  Both log2 and exp2 look up the top six bits of the
+// fraction in a table from fmaketab (see trigtab.h) and finish with a short
+// polynomial on what's left, which is less than 1/64, so few terms do.
+// _fast stops after the linear term.  Exponents are in 24.40 throughout.
+//
+
+#define LOG_FRAC	40
+#define LOG2E_Q42	6345039891169LL		// log2(e) in 22.42
+#define LN2_Q29		372130559			// ln(2) in 3.29
+
+// Returns log2 x in 24.40 for a raw (unscaled) x > 0
+static int64_t log2_q40 (uint32_t x, int hr)
+{
+	int z = fix_clz (x);
+	uint32_t m = x << z;							// mantissa in 1.31
+	int i = (m >> 25) & 63;
+	int64_t d, l;
+
+	// d = m * rc - 1, which is within 1/128 of 0, in 24.38
+	d = (int64_t) ((uint64_t) m * log2rctab[i] - (1ULL << 63)) >> 25;
+
+	if (hr)
+	{
+		// log(1+d) = d (1 - d/2 + d^2/3 - d^3/4), with the series in
+		// u = 128 d, which is d itself read as 1.31.  The next term is
+		// below the last bit.
+		int64_t u = d, q;
+
+		q = -((0x80000000LL / 4) >> 21);
+		q = ((0x80000000LL / 3) >> 14) + ((q * u) >> 31);
+		q = -((0x80000000LL / 2) >> 7) + ((q * u) >> 31);
+		q = 0x80000000LL + ((q * u) >> 31);
+		d = (d * q) >> 31;
+	}
+
+	// to log2, in 24.40; 1/ln(2) is 1549082005 in 2.30
+	l = (d * 1549082005) >> 28;
+	return l + log2tab[i] + ((int64_t) (31 - z) << LOG_FRAC);
+}
+
+// Returns 2^z, for z in 24.40, as a fixed point number with frac fraction
+// bits, rounded, saturating at FIX_MAX
+static fix exp2_q40 (int64_t z, int frac, int hr)
+{
+	int64_t k = z >> LOG_FRAC;						// floor
+	uint64_t f = (uint64_t) z & ((1ULL << LOG_FRAC) - 1);
+	int j = (int) (f >> (LOG_FRAC - 6));
+	int64_t a, p;
+	uint64_t v;
+	int shift;
+
+	if (k + frac >= 31)
+		return FIX_MAX;
+	shift = 62 - frac - (int) k;
+	if (shift > 63)
+		return 0;
+
+	// what's left of the fraction times ln(2), which is less than 1/64, in 1.31
+	a = (int64_t) (((f & ((1ULL << (LOG_FRAC - 6)) - 1)) * LN2_Q29) >> (LOG_FRAC + 29 - 31));
+
+	// e^a = 1 + a (1 + a/2 (1 + a/3 (1 + a/4)))
+	if (hr)
+	{
+		p = 0x80000000LL + a / 4;
+		p = 0x80000000LL + ((a * p) >> 31) / 3;
+		p = 0x80000000LL + ((a * p) >> 31) / 2;
+		p = 0x80000000LL + ((a * p) >> 31);
+	}
+	else
+		p = 0x80000000LL + a;
+
+	v = (uint64_t) exp2tab[j] * (uint64_t) p;		// in 2.62
+	v = (v + (1ULL << (shift - 1))) >> shift;
+	return (v > FIX_MAX) ? FIX_MAX : (fix) v;
+}
+
+// Returns (l * y) >> frac, for l in 24.40 and y with frac fraction bits,
+// saturating way past anything exp2_q40 can use
+static int64_t log_mul (int64_t l, int32_t y, int frac)
+{
+	uint64_t ul = (l < 0) ? -(uint64_t) l : (uint64_t) l;
+	uint64_t uy = (y < 0) ? -(uint64_t) y : (uint64_t) y;
+	uint64_t hi = (ul >> 32) * uy, lo = (ul & 0xffffffff) * uy;
+	int64_t r;
+
+	if (hi >= (1ULL << (26 + frac)))
+		r = 1LL << 58;
+	else
+		r = (int64_t) ((hi << (32 - frac)) + (lo >> frac));
+	return ((l < 0) != (y < 0)) ? -r : r;
+}
+
+// e to the x in fix or fix24
+static fix exp_tier (fix x, int frac, int hr)
+{
+	// past these it's FIX_MAX or rounds to 0 anyway
+	if (x >= (fix) (16 << frac))
+		return FIX_MAX;
+	if (x <= -(fix) (12 << frac))
+		return 0;
+	return exp2_q40 (((int64_t) x * LOG2E_Q42) >> (42 + frac - LOG_FRAC), frac, hr);
+}
+
+// x to the y in fix or fix24.  Negative x only works for whole y.
+static fix pow_tier (fix x, fix y, int frac, int hr)
+{
+	fix r;
+
+	if (y == 0)
+		return (fix) 1 << frac;
+	if (x > 0)
+		return exp2_q40 (log_mul (log2_q40 (x, hr) - ((int64_t) frac << LOG_FRAC), y, frac), frac, hr);
+	if (x == 0)
+		return (y > 0) ? 0 : FIX_MAX;
+	if (y & ((1 << frac) - 1))
+		return 0;
+
+	r = exp2_q40 (log_mul (log2_q40 (-(uint32_t) x, hr) - ((int64_t) frac << LOG_FRAC), y, frac), frac, hr);
+	return ((y >> frac) & 1) ? -r : r;
+}
+
+fix fix_exp_fast (fix x)
+{
+	return exp_tier (x, 16, 0);
+}
+
+fix fix_exp_hr (fix x)
+{
+	return exp_tier (x, 16, 1);
+}
+
+fix fix_pow_fast (fix x, fix y)
+{
+	return pow_tier (x, y, 16, 0);
+}
+
+fix fix_pow_hr (fix x, fix y)
+{
+	return pow_tier (x, y, 16, 1);
+}
+
+fix24 fix24_exp_fast (fix24 x)
+{
+	return exp_tier (x, 8, 0);
+}
+
+fix24 fix24_exp_hr (fix24 x)
+{
+	return exp_tier (x, 8, 1);
+}
+
+fix24 fix24_pow_fast (fix24 x, fix24 y)
+{
+	return pow_tier (x, y, 8, 0);
+}
+
+fix24 fix24_pow_hr (fix24 x, fix24 y)
+{
+	return pow_tier (x, y, 8, 1);
+}
@@ -99,9 +99,9 @@ int	gOVResult;
 //----------------------------------------------------------------------------
 // fix_mul: Multiply two fixed numbers.
 //----------------------------------------------------------------------------
-fix fix_mul(fix a, fix b)
+fix (fix_mul)(fix a, fix b)
 {
-	return ((int64_t) a * (int64_t) b) / (1 << 16);
+	return fix_mul_inline(a, b);
 }
 
 //----------------------------------------------------------------------------
@@ -133,30 +133,16 @@ fix fix_mul_asm_safe(fix a, fix b)
 //----------------------------------------------------------------------------
 // fix_div: Divide two fixed numbers.
 //----------------------------------------------------------------------------
-fix fix_div(fix a, fix b) {
-	return ((int64_t) a * (1 << 16)) / b;
+fix (fix_div)(fix a, fix b) {
+	return fix_div_inline(a, b);
 }
 
 //----------------------------------------------------------------------------
 // Multiply two numbers, and divide by a third. Used to be in asm, but
 // now in C.
 //----------------------------------------------------------------------------
-fix fix_mul_div (fix m0, fix m1, fix d) {
-	return ((int64_t) m0 * (int64_t) m1) / (int64_t) d;
-}
-
-int blah;
-
-//----------------------------------------------------------------------------
-// Returns the distance from (0,0) to (a,b)
-//----------------------------------------------------------------------------
-fix fix_pyth_dist (fix a, fix b)
-{
-	gOVResult = 100;
-	blah	= 200;
-
-	// should check for overflow!
- 	return fix_sqrt(fix_mul(a, a) + fix_mul(b, b));
+fix (fix_mul_div) (fix m0, fix m1, fix d) {
+	return fix_mul_div_inline(m0, m1, d);
 }
 
 
@@ -320,6 +306,38 @@ fix fix_fastcos (fixang theta)
 }
 
 
+//----------------------------------------------------------------------------
+// The high resolution versions.  The table holds full fixes, so there's no
+// rescaling, and the entries are close enough together that interpolating
+// with the low 16 - FIX_TRIG_BITS bits of theta is within a bit of exact.
+//----------------------------------------------------------------------------
+#define HR_SHIFT		(16 - FIX_TRIG_BITS)
+#define HR_FRAC(th)		((th) & ((1 << HR_SHIFT) - 1))
+#define HR_ROUND		((1 << HR_SHIFT) >> 1)
+#define HR_COS			(SINTAB_HR_SIZE / 4)
+
+void fix_sincos_hr (fixang theta, fix *sin, fix *cos)
+{
+	const fix *s = &sintab_hr[theta >> HR_SHIFT];
+	const fix *c = s + HR_COS;
+	int32_t frac = HR_FRAC(theta);
+
+	*sin = s[0] + (((s[1] - s[0]) * frac + HR_ROUND) >> HR_SHIFT);
+	*cos = c[0] + (((c[1] - c[0]) * frac + HR_ROUND) >> HR_SHIFT);
+}
+
+fix fix_sin_hr (fixang theta)
+{
+	const fix *s = &sintab_hr[theta >> HR_SHIFT];
+	return s[0] + (((s[1] - s[0]) * HR_FRAC(theta) + HR_ROUND) >> HR_SHIFT);
+}
+
+fix fix_cos_hr (fixang theta)
+{
+	const fix *c = &sintab_hr[(theta >> HR_SHIFT) + HR_COS];
+	return c[0] + (((c[1] - c[0]) * HR_FRAC(theta) + HR_ROUND) >> HR_SHIFT);
+}
+
 //----------------------------------------------------------------------------
 // Computes the arcsin of x
 // Assumes -1 <= x <= 1
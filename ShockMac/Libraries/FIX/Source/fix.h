@@ -162,6 +162,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "lg_types.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Globals
 extern int	gOVResult;
 
@@ -170,11 +174,8 @@ extern int	gOVResult;
 //
 // First some math functions that don't use fixes.
 //
-/*   Change this
-// Returns 0 if x < 0
-uint16_t long_sqrt (long x);
-#pragma aux long_sqrt parm [eax] value [ax] modify [eax ebx ecx edx esi edi]
-*/
+// Returns 0 if x < 0  (in FIX_SQRT.C)
+uint16_t long_sqrt (int32_t x);
 
 //////////////////////////////
 //
@@ -184,6 +185,20 @@ uint16_t long_sqrt (long x);
 long long_fast_pyth_dist (long a, long b);
 long long_safe_pyth_dist (long a, long b);
 
+// Returns the number of leading zero bits in x, 32 if x is 0
+static inline int fix_clz (uint32_t x)
+{
+#if defined(__GNUC__)
+	return x ? __builtin_clz(x) : 32;
+#else
+	int n = 0;
+
+	if (x == 0) return 32;
+	while (!(x & 0x80000000)) { x <<= 1; ++n; }
+	return n;
+#endif
+}
+
 
 //========================================
 //
@@ -282,13 +297,79 @@ fix fix_mul_div (fix m0, fix m1, fix d);
 fix fast_fix_mul_int(fix a, fix b);
 #define fast_fix_mul fix_mul
 
+// The bodies of fix_mul, fix_div and fix_mul_div.  fix.c builds the functions
+// above out of these.  When FIX_INLINE is defined (cmake -DFIX_INLINE=ON) calls
+// to fix_mul etc. use these directly, so the compiler can fold and vectorize
+// them.  (fix_mul)(a,b) still calls the library function.
+static inline fix fix_mul_inline(fix a, fix b)
+{
+	return ((int64_t) a * (int64_t) b) / (1 << 16);
+}
+
+static inline fix fix_div_inline(fix a, fix b)
+{
+	return ((int64_t) a * (1 << 16)) / b;
+}
+
+static inline fix fix_mul_div_inline(fix m0, fix m1, fix d)
+{
+	return ((int64_t) m0 * (int64_t) m1) / (int64_t) d;
+}
+
+#ifdef FIX_INLINE
+#define fix_mul(a,b) fix_mul_inline(a,b)
+#define fix_div(a,b) fix_div_inline(a,b)
+#define fix_mul_div(m0,m1,d) fix_mul_div_inline(m0,m1,d)
+#endif
+
+//========================================
+//
+//  Dividing lots of numbers by the same number.  (fix_recip.c)
+//
+//========================================
+
+// Set up a fix_recip for the denominator once, then each fix_recip_div is two
+// multiplies and a shift instead of a 64-bit divide.  fix_recip_init costs
+// about two divides, so this pays off from three or so divides by the same d.
+//
+// The reciprocal is normalized to 63 bits, which is enough to make the result
+// exact: fix_recip_div(&r,a) == fix_div(a,d) for every a and every d != 0,
+// including the wrap-around when the quotient doesn't fit in a fix.  (The
+// reciprocal is rounded up by less than one part in 2^62, so a times it
+// overshoots a/d by less than 1/d and can't step past the next integer.)
+// A zero denominator gives 0 instead of trapping.
+
+typedef struct {
+	uint64_t recip;		// 2^94 / (|d| << clz(|d|)), rounded up
+	int32_t shift;		// 46 - clz(|d|)
+	int32_t sign;		// -1 if d < 0, else 0
+} fix_recip;
+
+void fix_recip_init (fix_recip *r, fix d);
+
+// dst[i] = fix_div(a[i], d), dst may be a
+void fix_recip_div_array (const fix_recip *r, fix *dst, const fix *a, int32_t n);
+
+static inline fix fix_recip_div (const fix_recip *r, fix a)
+{
+	int32_t sign = r->sign ^ (a >> 31);
+	uint32_t ua = (a < 0) ? 0u - (uint32_t) a : (uint32_t) a;
+	uint64_t q;
+
+	// (ua * recip) >> 32, split so it fits in 64 bits
+	q = (uint64_t) ua * (r->recip >> 32) + (((uint64_t) ua * (uint32_t) r->recip) >> 32);
+	q >>= r->shift;
+	return (fix) (((uint32_t) q ^ sign) - sign);
+}
+
 //========================================
 //
 //  Square rooty kind of stuff.
 //
 //========================================
 
-// Returns sqrt (a^2 + b^2)
+// Returns sqrt (a^2 + b^2), exactly (rounded down).  Doesn't overflow
+// until the answer does; then returns FIX_MAX and sets gOVResult.
 fix fix_pyth_dist (fix a, fix b);
 
 // Returns approximately sqrt (a^2 + b^2)
@@ -300,11 +381,20 @@ fix fix_fast_pyth_dist (fix a, fix b);
 fix fix_safe_pyth_dist (fix a, fix b);
 
 // Now in FIX_SQRT.C
-// Returns 0 if x < 0
+// Returns 0 if x < 0.  Exact (rounded down), integer only.
 fix fix_sqrt (fix x);
 
+// Square root of the unsigned 64-bit number hi:lo, rounded down.  The
+// square root of a sum of fix products (32.32) is a fix.
 int32_t quad_sqrt(int32_t hi, int32_t lo);
 
+// Lengths of n packed x,y,z triples, FIX_MAX if too long to fit
+void fix_mag3_array (fix *dst, const fix *v, int32_t n);
+
+// dst holds n triples, each v[i] divided by its length (fix_div exact).
+// Zero vectors stay zero.  dst may be v.
+void fix_normalize3_array (fix *dst, const fix *v, int32_t n);
+
 // Returns 0 if x < 0
 /*  Fix this
 fix fix_sloppy_sqrt (fix x);
@@ -332,6 +422,15 @@ fix fix_fastsin (fixang theta);
 
 fix fix_fastcos (fixang theta);
 
+// Computes sin and cos of theta
+// Uses the high resolution table (FIX_TRIG_BITS at build time), which makes it
+// both more accurate and faster than fix_sincos()
+void fix_sincos_hr (fixang theta, fix *sin, fix *cos);
+
+fix fix_sin_hr (fixang theta);
+
+fix fix_cos_hr (fixang theta);
+
 // Computes the arcsin of x
 fixang fix_asin (fix x);
 
@@ -341,6 +440,53 @@ fixang fix_acos (fix x);
 // Computes the atan of y/x, in the correct quadrant and everything
 fixang fix_atan2 (fix y, fix x);
 
+// Polynomial versions of the above (fix_atan.c), in two accuracy tiers.
+// fix_atan2_fast is within 2 fixangs and only needs a 32 bit divide;
+// fix_atan2_hr is within half a fixang (plus a hair) and asin/acos_hr within
+// one.  Neither atan2 takes a square root and both work for any x and y.
+// fix_asin and fix_acos are already the fast tier for those.
+fixang fix_atan2_fast (fix y, fix x);
+fixang fix_atan2_hr (fix y, fix x);
+
+// These clamp x to -1..1
+fixang fix_asin_hr (fix x);
+fixang fix_acos_hr (fix x);
+
+
+//========================================
+//
+//  Array functions.  (fixvec.c)
+//
+//========================================
+
+// These do the same as the scalar functions above for n elements at a time,
+// and give bit-identical results.  SSE2 or AVX2 is used when the cpu has it.
+// The destination may be the same array as one of the sources.
+
+typedef enum {
+	FIX_ARRAY_SCALAR,
+	FIX_ARRAY_SSE2,
+	FIX_ARRAY_AVX2
+} FixArrayImpl;
+
+// Returns the implementation the array functions currently use
+FixArrayImpl fix_array_impl (void);
+
+// Forces an implementation, returns false if this cpu can't run it
+bool fix_array_select (FixArrayImpl impl);
+
+void fix_mul_array (fix *dst, const fix *a, const fix *b, int32_t n);
+void fix_div_array (fix *dst, const fix *a, const fix *b, int32_t n);
+void fix_mul_div_array (fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n);
+void fix_sincos_array (fix *sin, fix *cos, const fixang *theta, int32_t n);
+
+// The 3-vector functions work on n packed x,y,z triples (as in g3s_vector).
+// dst[i] = fix_mul(ax,bx) + fix_mul(ay,by) + fix_mul(az,bz)
+void fix_dot3_array (fix *dst, const fix *a, const fix *b, int32_t n);
+
+// dst holds n triples, each the cross product a[i] x b[i]
+void fix_cross3_array (fix *dst, const fix *a, const fix *b, int32_t n);
+
 
 //========================================
 //
@@ -366,6 +512,16 @@ extern fix fix_pow (fix x, fix y);
 //
 fix fix_exp (fix x);
 
+// Table and polynomial versions of fix_exp and fix_pow, in two accuracy
+// tiers.  The _fast ones are within about 1 part in 10000; the _hr ones are
+// within a couple of parts in a billion, so within a bit of exact apart from
+// the very biggest answers.  Both round, and saturate at FIX_MAX instead of
+// wrapping.  fix_pow of a negative x works for whole y, and is 0 otherwise.
+fix fix_exp_fast (fix x);
+fix fix_exp_hr (fix x);
+fix fix_pow_fast (fix x, fix y);
+fix fix_pow_hr (fix x, fix y);
+
 //////////////////////////////
 //
 // fix24 - 24 bits integer, 8 bits fraction
@@ -417,6 +573,14 @@ fix24 fix24_fastcos (fixang theta);
 fixang fix24_asin (fix24 x);
 fixang fix24_acos (fix24 x);
 fixang fix24_atan2 (fix24 y, fix24 x);
+fixang fix24_atan2_fast (fix24 y, fix24 x);
+fixang fix24_atan2_hr (fix24 y, fix24 x);
+fixang fix24_asin_hr (fix24 x);
+fixang fix24_acos_hr (fix24 x);
+fix24 fix24_exp_fast (fix24 x);
+fix24 fix24_exp_hr (fix24 x);
+fix24 fix24_pow_fast (fix24 x, fix24 y);
+fix24 fix24_pow_hr (fix24 x, fix24 y);
 fix24 atofix24(char *p);
 char *fix24_sprint (char *str, fix24 x);
 char *fix24_sprint_hex (char *str, fix24 x);
@@ -440,4 +604,8 @@ int32_t AsmWideDivide(int32_t hi, int32_t lo, int32_t divisor);
 AWide *AsmWideNegate(AWide *target);
 AWide *AsmWideBitShift(AWide *src, int32_t shift);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* !__fix24_H */
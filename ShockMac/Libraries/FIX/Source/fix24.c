@@ -33,13 +33,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <fix.h>
 #include <trigtab.h>
 
-fix24 fix24_pyth_dist (fix24 a, fix24 b)
-{
-	return fix24_sqrt (fix24_mul (a, a) + fix24_mul (b, b));
-}
-
 //////////////////////////////
 //
+// fix24_pyth_dist lives in fix_sqrt.c with fix_pyth_dist.
 // We can use the fix function because the difference in scale doesn't matter.
 //
 
@@ -107,6 +103,34 @@ fixang fix24_acos (fix24 x)
 	return (fix_acos (x << 8));
 }
 
+//////////////////////////////
+//
+// The polynomial versions only care about the ratio of y and x, and asin
+// clamps to -1..1 itself once x can be scaled up without overflowing.
+//
+
+fixang fix24_atan2_fast (fix24 y, fix24 x)
+{
+	return (fix_atan2_fast (y, x));
+}
+
+fixang fix24_atan2_hr (fix24 y, fix24 x)
+{
+	return (fix_atan2_hr (y, x));
+}
+
+fixang fix24_asin_hr (fix24 x)
+{
+	if (x >= fix24_make (1, 0)) return 0x4000;
+	if (x <= fix24_make (-1, 0)) return 0xc000;
+	return (fix_asin_hr (x << 8));
+}
+
+fixang fix24_acos_hr (fix24 x)
+{
+	return 0x4000 - fix24_asin_hr (x);
+}
+
 fixang fix24_atan2 (fix24 y, fix24 x)
 {
 	fix24 hyp;										// hypotenuse
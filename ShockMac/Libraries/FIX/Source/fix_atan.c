@@ -0,0 +1,137 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fix_atan.c
+**
+** Arctangents by polynomial, and the arcsines and arccosines built on them.
+** See fix.h for the accuracy of each.
+*/
+
+#include "fix.h"
+
+// atan(t) for 0 <= t <= 1, in 16.16 fixangs, as t * P(t^2).  Minimax fits;
+// the fast one is within .85 of a fixang, the hr one within .02.
+static const int64_t atan_fast_poly[4] = {
+	683027865, -219544057, 99981307, -26649826
+};
+
+static const int64_t atan_hr_poly[6] = {
+	683549703, -227369415, 132297481, -79585101, 35987902, -8010794
+};
+
+// |x| without a branch, since signs are a coin flip.  Right for FIX_MIN too.
+#define FIX_ABS_U(x)	(((uint32_t) (x) ^ (uint32_t) ((x) >> 31)) - (uint32_t) ((x) >> 31))
+
+//----------------------------------------------------------------------------
+// Puts the angle of the first octant, th for atan(t), where it belongs
+// given the signs of x and y and whether they were swapped
+//----------------------------------------------------------------------------
+static fixang atan_octant (fixang th, fix y, fix x, bool swapped)
+{
+	if (swapped) th = 0x4000 - th;
+	if (x < 0) th = 0x8000 - th;
+	if (y < 0) th = -th;
+	return th;
+}
+
+//----------------------------------------------------------------------------
+// Computes the atan of y/x, in the correct quadrant.  The ratio of the
+// smaller to the larger of x and y is taken to 15 bits after scaling both to
+// 16 bits, so it needs only a 32 bit divide.
+//----------------------------------------------------------------------------
+fixang fix_atan2_fast (fix y, fix x)
+{
+	uint32_t ax = FIX_ABS_U (x), ay = FIX_ABS_U (y);
+	uint32_t num, den;
+	int64_t t, s, p;
+	bool swapped = ay > ax;
+	int sh;
+
+	num = swapped ? ax : ay;
+	den = swapped ? ay : ax;
+	if (den == 0)
+		return 0;
+
+	sh = 16 - fix_clz (den);
+	sh &= ~(sh >> 31);								// max(sh, 0) without a branch
+	num >>= sh;
+	den >>= sh;
+	t = (int64_t) ((num << 15) / den);
+	s = (t * t) >> 15;
+
+	p = atan_fast_poly[3];
+	p = atan_fast_poly[2] + ((p * s) >> 15);
+	p = atan_fast_poly[1] + ((p * s) >> 15);
+	p = atan_fast_poly[0] + ((p * s) >> 15);
+
+	return atan_octant ((fixang) (((t * p >> 15) + 0x8000) >> 16), y, x, swapped);
+}
+
+//----------------------------------------------------------------------------
+// The same with the ratio to 31 bits and a longer polynomial.  Within half a
+// fixang (plus a hair) everywhere.
+//----------------------------------------------------------------------------
+fixang fix_atan2_hr (fix y, fix x)
+{
+	uint32_t ax = FIX_ABS_U (x), ay = FIX_ABS_U (y);
+	uint32_t num, den;
+	int64_t t, s, p;
+	bool swapped = ay > ax;
+
+	num = swapped ? ax : ay;
+	den = swapped ? ay : ax;
+	if (den == 0)
+		return 0;
+
+	t = (int64_t) (((uint64_t) num << 31) / den);
+	s = (t * t) >> 31;
+
+	p = atan_hr_poly[5];
+	p = atan_hr_poly[4] + ((p * s) >> 31);
+	p = atan_hr_poly[3] + ((p * s) >> 31);
+	p = atan_hr_poly[2] + ((p * s) >> 31);
+	p = atan_hr_poly[1] + ((p * s) >> 31);
+	p = atan_hr_poly[0] + ((p * s) >> 31);
+
+	return atan_octant ((fixang) (((t * p >> 31) + 0x8000) >> 16), y, x, swapped);
+}
+
+//----------------------------------------------------------------------------
+// asin(x) = atan2(x, sqrt(1 - x^2)), with 1 - x^2 done in 32.32 so the
+// square root loses nothing near the ends.  Clamps x to -1..1.
+// Returns 0xc000..0x4000 (-PI/2..PI/2)
+//----------------------------------------------------------------------------
+fixang fix_asin_hr (fix x)
+{
+	int64_t c2;
+
+	if (x >= FIX_UNIT) return 0x4000;
+	if (x <= -FIX_UNIT) return 0xc000;
+
+	c2 = ((int64_t) 1 << 32) - (int64_t) x * x;
+	return fix_atan2_hr (x, quad_sqrt ((int32_t) (c2 >> 32), (int32_t) c2));
+}
+
+//----------------------------------------------------------------------------
+// Returns 0x0000..0x8000 (0..PI)
+//----------------------------------------------------------------------------
+fixang fix_acos_hr (fix x)
+{
+	return 0x4000 - fix_asin_hr (x);
+}
@@ -0,0 +1,69 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fix_recip.c
+**
+** Reciprocals for dividing many numbers by the same denominator.
+** See fix.h for how and why it works.
+*/
+
+#include "fix.h"
+
+//----------------------------------------------------------------------------
+// Sets up r for dividing by d.
+//----------------------------------------------------------------------------
+void fix_recip_init (fix_recip *r, fix d)
+{
+	uint32_t ad, norm;
+	uint64_t q, rem;
+	int s;
+
+	if (d == 0)
+	{
+		r->recip = 0;
+		r->shift = 0;
+		r->sign = 0;
+		return;
+	}
+
+	r->sign = (d < 0) ? -1 : 0;
+	ad = (d < 0) ? 0u - (uint32_t) d : (uint32_t) d;
+
+	// normalize so the top bit is set
+	s = fix_clz (ad);
+	norm = ad << s;
+
+	// 2^94 / norm is done as (2^62 / norm) << 32 plus the remainder's share,
+	// so no step needs more than 64 bits.  Always round up.
+	q = ((uint64_t) 1 << 62) / norm;
+	rem = ((uint64_t) 1 << 62) % norm;
+	r->recip = (q << 32) + ((rem << 32) / norm) + 1;
+	r->shift = 46 - s;
+}
+
+//----------------------------------------------------------------------------
+// Divides n numbers by the same denominator.
+//----------------------------------------------------------------------------
+void fix_recip_div_array (const fix_recip *r, fix *dst, const fix *a, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i < n; ++i)
+		dst[i] = fix_recip_div (r, a[i]);
+}
@@ -29,41 +29,180 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //  Includes
 //--------------------
 #include "fix.h"
+#include "trigtab.h"
 #include <math.h>
 
+//-----------------------------------------------------------------
+//  Integer square root of a 64-bit number, rounded down.
+//
+//  With FIX_SQRT_INTEGER (cmake -DFIX_SQRT_INTEGER=ON), for machines without
+//  a quick fpu, it's all integer math.  The number is normalized with fix_clz
+//  so its top two bits are not both zero, which puts the answer in the top
+//  half of 32 bits.  A seed for 1/sqrt comes from rsqrttab (about 8 bits) and
+//  two Newton steps, which need no divides, bring it to about 26 bits.
+//  Multiplying back gives the root to within a few hundred; one more Newton
+//  step on the root itself, using the reciprocal for the divide, leaves it
+//  off by at most one (checked for every fix_sqrt argument), and the last
+//  step fixes that up.
+//-----------------------------------------------------------------
+#ifdef FIX_SQRT_INTEGER
+static uint32_t isqrt64(uint64_t x)
+{
+	uint64_t	xn, a, r, t, u, s;
+	int64_t		d;
+	int			z;
+
+	if (x == 0)
+		return 0;
+
+	z = (x >> 32) ? fix_clz((uint32_t) (x >> 32)) : 32 + fix_clz((uint32_t) x);
+	z &= ~1;
+	xn = x << z;									// now in [2^62, 2^64)
+	a = xn >> 32;									// a / 2^32 is in [1/4, 1)
+
+	// r is 1/sqrt(a / 2^32) in 2.30 format
+	r = (uint64_t) rsqrttab[(a >> 25) - 32] << 15;
+
+	t = (r * r) >> 30;
+	u = (a * t) >> 32;
+	r = (r * ((3ULL << 30) - u)) >> 31;
+
+	t = (r * r) >> 30;
+	u = (a * t) >> 32;
+	r = (r * ((3ULL << 30) - u)) >> 31;
+
+	s = (a * r) >> 30;
+	if (s > 0xffffffff)
+		s = 0xffffffff;
+
+	// s += (xn - s*s) / (2*s), with r / 2^62 standing in for 1 / s
+	d = (int64_t) (xn - s * s);
+	s += ((d >> 20) * (int64_t) (r >> 10) + (1LL << 32)) >> 33;
+
+	// now off by at most one either way; no branches, they'd be coin flips
+	if (s > 0xffffffff)
+		s = 0xffffffff;
+	s -= (s * s > xn);
+	s += ((s + 1) * (s + 1) <= xn) & (s < 0xffffffff);
+
+	return (uint32_t) (s >> (z >> 1));
+}
+#else
+// Otherwise the fpu's square root is the starting point.  A double holds
+// the argument to 53 bits, so that's off by at most one too.
+static uint32_t isqrt64(uint64_t x)
+{
+	uint64_t s = (uint64_t) sqrt((double) x);
+
+	if (s > 0xffffffff)
+		s = 0xffffffff;
+	s -= (s * s > x);
+	s += ((s + 1) * (s + 1) <= x) & (s < 0xffffffff);
+	return (uint32_t) s;
+}
+#endif
+
 //-----------------------------------------------------------------
 //  Calculate the square root of a fixed-point number.
 //-----------------------------------------------------------------
 fix fix_sqrt(fix num)
 {
-	// convert to float, use c-libraries sqrt function, convert back to fix
-	float fnum = fix_float(num);
-	if (fnum > 0.0f) {
-		return fix_from_float(sqrtf(fnum));
-	} else {
+	if (num <= 0)
 		return 0;
-	}
+	return (fix) isqrt64((uint64_t) num << 16);
 }
 
-fix24 fix24_sqrt (fix24 x) {
-	// convert to float, use c-libraries sqrt function, convert back to fix
-	float fnum = fix24_float(x);
-	if (fnum > 0.0f) {
-		return fix24_from_float(sqrtf(fnum));
-	} else {
+fix24 fix24_sqrt (fix24 x)
+{
+	if (x <= 0)
 		return 0;
-	}
+	return (fix24) isqrt64((uint64_t) x << 8);
+}
+
+uint16_t long_sqrt (int32_t x)
+{
+	if (x <= 0)
+		return 0;
+	return (uint16_t) isqrt64((uint64_t) x);
 }
 
 //-----------------------------------------------------------------
 //  Calculate the square root of a wide (64-bit) number.
+//  For the sum of fix squares, as in g3_vec_mag, the result is a fix.
+//  hi:lo is unsigned, since a sum of squares can use the top bit.
 //-----------------------------------------------------------------
 fix quad_sqrt(int32_t hi, int32_t lo)
 {
-	double num = (double) hi + ((double) lo / 4294967296.0);
-	if (num > 0.0f) {
-		return (fix) (sqrt(num) * 65536.0);
-	} else {
-		return 0;
+	return (fix) isqrt64(((uint64_t) (uint32_t) hi << 32) | (uint32_t) lo);
+}
+
+//-----------------------------------------------------------------
+//  Distances.  The squares are summed in 64 bits, so these can't overflow
+//  until the distance itself doesn't fit; then they return FIX_MAX and set
+//  gOVResult.
+//-----------------------------------------------------------------
+static fix dist_from_square(uint64_t sq)
+{
+	uint32_t d = isqrt64(sq);
+
+	if (d > FIX_MAX)
+	{
+		gOVResult = 1;
+		return FIX_MAX;
+	}
+	gOVResult = 0;
+	return (fix) d;
+}
+
+fix fix_pyth_dist (fix a, fix b)
+{
+	return dist_from_square((uint64_t) ((int64_t) a * a) + (uint64_t) ((int64_t) b * b));
+}
+
+// The sum of squares is 48.16, so its square root is a fix24.
+fix24 fix24_pyth_dist (fix24 a, fix24 b)
+{
+	return dist_from_square((uint64_t) ((int64_t) a * a) + (uint64_t) ((int64_t) b * b));
+}
+
+//-----------------------------------------------------------------
+//  Lengths and normalization of n packed x,y,z triples.
+//-----------------------------------------------------------------
+static fix mag3(const fix *v)
+{
+	uint64_t sq, sq2;
+
+	sq = (uint64_t) ((int64_t) v[0] * v[0]) + (uint64_t) ((int64_t) v[1] * v[1]);
+	sq2 = sq + (uint64_t) ((int64_t) v[2] * v[2]);
+	if (sq2 < sq)
+		return FIX_MAX;								// wrapped, so way too long anyway
+	sq = isqrt64(sq2);
+	return (sq > FIX_MAX) ? FIX_MAX : (fix) sq;
+}
+
+void fix_mag3_array(fix *dst, const fix *v, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i < n; i++, v += 3)
+		dst[i] = mag3(v);
+}
+
+void fix_normalize3_array(fix *dst, const fix *v, int32_t n)
+{
+	fix			m;
+	int32_t		i;
+
+	for (i = 0; i < n; i++, v += 3, dst += 3)
+	{
+		m = mag3(v);
+		if (m == 0)
+		{
+			dst[0] = dst[1] = dst[2] = 0;
+			continue;
+		}
+		dst[0] = fix_div(v[0], m);
+		dst[1] = fix_div(v[1], m);
+		dst[2] = fix_div(v[2], m);
 	}
 }
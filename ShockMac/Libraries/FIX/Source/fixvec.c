@@ -0,0 +1,196 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fixvec.c
+**
+** Array versions of fix_mul, fix_div, fix_mul_div, fix_sincos and 3-vector
+** dot and cross products.  The plain C kernels live here, along with the
+** code that picks the SSE2 (fixvec_sse2.c) or AVX2 (fixvec_avx2.c) kernels
+** when the cpu supports them.
+*/
+
+#include "fix.h"
+#include "fixvec_.h"
+
+//----------------------------------------------------------------------------
+// Scalar kernels
+//----------------------------------------------------------------------------
+static void mul_scalar(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+	for (i = 0; i < n; ++i)
+		dst[i] = fix_mul(a[i], b[i]);
+}
+
+static void div_scalar(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+	for (i = 0; i < n; ++i)
+		dst[i] = fix_div(a[i], b[i]);
+}
+
+static void mul_div_scalar(fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n)
+{
+	int32_t i;
+	for (i = 0; i < n; ++i)
+		dst[i] = fix_mul_div(m0[i], m1[i], d[i]);
+}
+
+static void sincos_scalar(fix *sin, fix *cos, const fixang *theta, int32_t n)
+{
+	int32_t i;
+	for (i = 0; i < n; ++i)
+		fix_sincos(theta[i], &sin[i], &cos[i]);
+}
+
+static void dot3_scalar(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+	for (i = 0; i < n; ++i, a += 3, b += 3)
+		dst[i] = fix_mul(a[0], b[0]) + fix_mul(a[1], b[1]) + fix_mul(a[2], b[2]);
+}
+
+static void cross3_scalar(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+	fix x, y, z;
+
+	for (i = 0; i < n; ++i, a += 3, b += 3, dst += 3)
+	{
+		// dst may be a or b, so don't store until all three are done
+		x = fix_mul(a[1], b[2]) - fix_mul(a[2], b[1]);
+		y = fix_mul(a[2], b[0]) - fix_mul(a[0], b[2]);
+		z = fix_mul(a[0], b[1]) - fix_mul(a[1], b[0]);
+		dst[0] = x;
+		dst[1] = y;
+		dst[2] = z;
+	}
+}
+
+const FixArrayKernels fix_array_kernels_scalar = {
+	mul_scalar,
+	div_scalar,
+	mul_div_scalar,
+	sincos_scalar,
+	dot3_scalar,
+	cross3_scalar
+};
+
+//----------------------------------------------------------------------------
+// Runtime selection
+//----------------------------------------------------------------------------
+// The chosen table may be picked by several threads at once, so it's read
+// and written atomically.  Relaxed is enough: the tables are constant.
+static const FixArrayKernels *gFixArray = NULL;
+static FixArrayImpl gFixArrayImpl = FIX_ARRAY_SCALAR;
+
+#ifdef __GNUC__
+#define FixArrayLoad(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#define FixArrayStore(var,val) __atomic_store_n(&(var), (val), __ATOMIC_RELAXED)
+#else
+#define FixArrayLoad(var) (var)
+#define FixArrayStore(var,val) ((var) = (val))
+#endif
+
+static const FixArrayKernels *fix_array_kernels(FixArrayImpl impl)
+{
+	switch (impl)
+	{
+		case FIX_ARRAY_SCALAR:
+			return &fix_array_kernels_scalar;
+#ifdef __SSE2__
+		case FIX_ARRAY_SSE2:
+			return &fix_array_kernels_sse2;		// part of the x86-64 baseline
+#endif
+#ifdef FIX_HAVE_AVX2
+		case FIX_ARRAY_AVX2:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? &fix_array_kernels_avx2 : NULL;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+bool fix_array_select(FixArrayImpl impl)
+{
+	const FixArrayKernels *k = fix_array_kernels(impl);
+
+	if (k == NULL)
+		return false;
+
+	FixArrayStore(gFixArrayImpl, impl);
+	FixArrayStore(gFixArray, k);
+	return true;
+}
+
+// Picks the best implementation the first time an array function is called.
+// Racing threads all come to the same answer and store the same table, so
+// no locking is needed.
+static const FixArrayKernels *fix_array_get(void)
+{
+	const FixArrayKernels *k = FixArrayLoad(gFixArray);
+
+	if (k == NULL)
+	{
+		if (!fix_array_select(FIX_ARRAY_AVX2) && !fix_array_select(FIX_ARRAY_SSE2))
+			fix_array_select(FIX_ARRAY_SCALAR);
+		k = FixArrayLoad(gFixArray);
+	}
+	return k;
+}
+
+FixArrayImpl fix_array_impl(void)
+{
+	fix_array_get();
+	return FixArrayLoad(gFixArrayImpl);
+}
+
+//----------------------------------------------------------------------------
+// Entry points
+//----------------------------------------------------------------------------
+void fix_mul_array(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix_array_get()->f_Mul(dst, a, b, n);
+}
+
+void fix_div_array(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix_array_get()->f_Div(dst, a, b, n);
+}
+
+void fix_mul_div_array(fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n)
+{
+	fix_array_get()->f_MulDiv(dst, m0, m1, d, n);
+}
+
+void fix_sincos_array(fix *sin, fix *cos, const fixang *theta, int32_t n)
+{
+	fix_array_get()->f_SinCos(sin, cos, theta, n);
+}
+
+void fix_dot3_array(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix_array_get()->f_Dot3(dst, a, b, n);
+}
+
+void fix_cross3_array(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix_array_get()->f_Cross3(dst, a, b, n);
+}
@@ -0,0 +1,52 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fixvec_.h
+**
+** Internal header for the array versions of the fixed-point routines.
+** Each instruction set provides a table of kernels, fixvec.c picks one
+** at runtime.
+*/
+
+#ifndef __FIXVEC__H
+#define __FIXVEC__H
+
+#include "fix.h"
+
+typedef struct {
+	void (*f_Mul)(fix *dst, const fix *a, const fix *b, int32_t n);
+	void (*f_Div)(fix *dst, const fix *a, const fix *b, int32_t n);
+	void (*f_MulDiv)(fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n);
+	void (*f_SinCos)(fix *sin, fix *cos, const fixang *theta, int32_t n);
+	void (*f_Dot3)(fix *dst, const fix *a, const fix *b, int32_t n);
+	void (*f_Cross3)(fix *dst, const fix *a, const fix *b, int32_t n);
+} FixArrayKernels;
+
+// the scalar kernels also handle the tails and overflow cases of the SIMD kernels
+extern const FixArrayKernels fix_array_kernels_scalar;
+
+#ifdef __SSE2__
+extern const FixArrayKernels fix_array_kernels_sse2;
+#endif
+
+#ifdef FIX_HAVE_AVX2
+extern const FixArrayKernels fix_array_kernels_avx2;
+#endif
+
+#endif /* !__FIXVEC__H */
@@ -0,0 +1,203 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fixvec_avx2.c
+**
+** AVX2 kernels for the fix array functions.  See fixvec.c, and
+** fixvec_sse2.c for the reasoning behind the division code.
+**
+** This file is compiled with AVX2 enabled, it must only be called after
+** fixvec.c has checked that the cpu supports it.
+*/
+
+#include "fix.h"
+#include "fixvec_.h"
+
+#ifdef FIX_HAVE_AVX2
+
+#include <immintrin.h>
+
+#define TWO_TO_52	4503599627370496.0
+
+//----------------------------------------------------------------------------
+// Multiply 8 fixes, rounding towards zero like fix_mul
+//----------------------------------------------------------------------------
+static inline __m256i mul8(__m256i a, __m256i b)
+{
+	const __m256i round = _mm256_set1_epi64x(0xffff);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i pe, po;
+
+	pe = _mm256_mul_epi32(a, b);
+	po = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+
+	// add 0xffff to negative products so the shift truncates towards zero
+	pe = _mm256_add_epi64(pe, _mm256_and_si256(_mm256_cmpgt_epi64(zero, pe), round));
+	po = _mm256_add_epi64(po, _mm256_and_si256(_mm256_cmpgt_epi64(zero, po), round));
+
+	pe = _mm256_srli_epi64(pe, 16);
+	po = _mm256_slli_epi64(_mm256_srli_epi64(po, 16), 32);
+	return _mm256_blend_epi32(pe, po, 0xaa);
+}
+
+//----------------------------------------------------------------------------
+// Divide 4 exact doubles, returns false if a lane needs the scalar code.
+//----------------------------------------------------------------------------
+static inline bool div4(__m256d n, __m256d d, __m128i *q)
+{
+	const __m256d absmask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+	const __m256d limit = _mm256_set1_pd(TWO_TO_52);
+
+	if (_mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(n, absmask), limit, _CMP_LT_OQ)) != 0xf)
+		return false;
+
+	// cvttpd gives 0x80000000 for overflow, inf and nan
+	*q = _mm256_cvttpd_epi32(_mm256_div_pd(n, d));
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(*q, _mm_set1_epi32(0x80000000))) == 0;
+}
+
+static inline __m256d lo_pd(__m256i v)
+{
+	return _mm256_cvtepi32_pd(_mm256_castsi256_si128(v));
+}
+
+static inline __m256d hi_pd(__m256i v)
+{
+	return _mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1));
+}
+
+//----------------------------------------------------------------------------
+// Kernels
+//----------------------------------------------------------------------------
+static void mul_avx2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+		_mm256_storeu_si256((__m256i *) (dst + i), mul8(va, vb));
+	}
+	fix_array_kernels_scalar.f_Mul(dst + i, a + i, b + i, n - i);
+}
+
+static void div_avx2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	const __m256d scale = _mm256_set1_pd(65536.0);
+	int32_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+		__m128i qlo, qhi;
+
+		if (div4(_mm256_mul_pd(lo_pd(va), scale), lo_pd(vb), &qlo) &&
+			div4(_mm256_mul_pd(hi_pd(va), scale), hi_pd(vb), &qhi))
+			_mm256_storeu_si256((__m256i *) (dst + i), _mm256_set_m128i(qhi, qlo));
+		else
+			fix_array_kernels_scalar.f_Div(dst + i, a + i, b + i, 8);
+	}
+	fix_array_kernels_scalar.f_Div(dst + i, a + i, b + i, n - i);
+}
+
+static void mul_div_avx2(fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		__m256i v0 = _mm256_loadu_si256((const __m256i *) (m0 + i));
+		__m256i v1 = _mm256_loadu_si256((const __m256i *) (m1 + i));
+		__m256i vd = _mm256_loadu_si256((const __m256i *) (d + i));
+		__m128i qlo, qhi;
+
+		if (div4(_mm256_mul_pd(lo_pd(v0), lo_pd(v1)), lo_pd(vd), &qlo) &&
+			div4(_mm256_mul_pd(hi_pd(v0), hi_pd(v1)), hi_pd(vd), &qhi))
+			_mm256_storeu_si256((__m256i *) (dst + i), _mm256_set_m128i(qhi, qlo));
+		else
+			fix_array_kernels_scalar.f_MulDiv(dst + i, m0 + i, m1 + i, d + i, 8);
+	}
+	fix_array_kernels_scalar.f_MulDiv(dst + i, m0 + i, m1 + i, d + i, n - i);
+}
+
+//----------------------------------------------------------------------------
+// 3-vectors, eight at a time (three registers' worth of x,y,z)
+//----------------------------------------------------------------------------
+static void dot3_avx2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix p[24];
+	int32_t i, j;
+
+	for (i = 0; i + 8 <= n; i += 8, a += 24, b += 24)
+	{
+		for (j = 0; j < 24; j += 8)
+		{
+			__m256i va = _mm256_loadu_si256((const __m256i *) (a + j));
+			__m256i vb = _mm256_loadu_si256((const __m256i *) (b + j));
+			_mm256_storeu_si256((__m256i *) (p + j), mul8(va, vb));
+		}
+		for (j = 0; j < 8; ++j)
+			dst[i + j] = p[3*j] + p[3*j + 1] + p[3*j + 2];
+	}
+	fix_array_kernels_scalar.f_Dot3(dst + i, a, b, n - i);
+}
+
+static void cross3_avx2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix a1[24], b1[24], a2[24], b2[24];
+	int32_t i, j;
+
+	for (i = 0; i + 8 <= n; i += 8, a += 24, b += 24, dst += 24)
+	{
+		// (y,z,x)*(z,x,y) - (z,x,y)*(y,z,x)
+		for (j = 0; j < 24; j += 3)
+		{
+			a1[j] = a[j+1]; a1[j+1] = a[j+2]; a1[j+2] = a[j];
+			b1[j] = b[j+2]; b1[j+1] = b[j];   b1[j+2] = b[j+1];
+			a2[j] = a[j+2]; a2[j+1] = a[j];   a2[j+2] = a[j+1];
+			b2[j] = b[j+1]; b2[j+1] = b[j+2]; b2[j+2] = b[j];
+		}
+		for (j = 0; j < 24; j += 8)
+		{
+			__m256i l = mul8(_mm256_loadu_si256((const __m256i *) (a1 + j)), _mm256_loadu_si256((const __m256i *) (b1 + j)));
+			__m256i r = mul8(_mm256_loadu_si256((const __m256i *) (a2 + j)), _mm256_loadu_si256((const __m256i *) (b2 + j)));
+			_mm256_storeu_si256((__m256i *) (dst + j), _mm256_sub_epi32(l, r));
+		}
+	}
+	fix_array_kernels_scalar.f_Cross3(dst, a, b, n - i);
+}
+
+// the table lookups dominate fix_sincos, so use the SSE2 kernel as is
+static void sincos_avx2(fix *sin, fix *cos, const fixang *theta, int32_t n)
+{
+	fix_array_kernels_sse2.f_SinCos(sin, cos, theta, n);
+}
+
+const FixArrayKernels fix_array_kernels_avx2 = {
+	mul_avx2,
+	div_avx2,
+	mul_div_avx2,
+	sincos_avx2,
+	dot3_avx2,
+	cross3_avx2
+};
+
+#endif /* FIX_HAVE_AVX2 */
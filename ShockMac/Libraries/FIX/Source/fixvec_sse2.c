@@ -0,0 +1,255 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+** fixvec_sse2.c
+**
+** SSE2 kernels for the fix array functions.  See fixvec.c.
+**
+** SSE2 has no signed 32x32->64 multiply, so fix_mul is done with pmuludq
+** and a correction of the high half for negative operands.  Division goes
+** through doubles, which is exact as long as the dividend stays below 2^52:
+** the quotient can then never round up to the next integer.  Anything
+** outside that range (or a quotient that overflows) is redone by the scalar
+** code, so overflow behaves the same as in fix_div/fix_mul_div.
+*/
+
+#include "fix.h"
+#include "trigtab.h"
+#include "fixvec_.h"
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+
+#define TWO_TO_52	4503599627370496.0
+
+//----------------------------------------------------------------------------
+// Multiply 4 fixes, rounding towards zero like the (int64_t) / (1 << 16)
+// in fix_mul.
+//----------------------------------------------------------------------------
+static inline __m128i mul4(__m128i a, __m128i b)
+{
+	const __m128i round = _mm_set_epi32(0, 0xffff, 0, 0xffff);
+	const __m128i lomask = _mm_set_epi32(0, -1, 0, -1);
+	__m128i corr, pe, po;
+
+	// pmuludq treats the operands as unsigned, take (a<0 ? b : 0) + (b<0 ? a : 0)
+	// off the high half of the product to make it signed.
+	corr = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(a, 31), b),
+						 _mm_and_si128(_mm_srai_epi32(b, 31), a));
+
+	pe = _mm_sub_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(corr, 32));
+	po = _mm_sub_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)),
+					   _mm_andnot_si128(lomask, corr));
+
+	// add 0xffff to negative products so the shift truncates towards zero
+	pe = _mm_add_epi64(pe, _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(pe, 31), _MM_SHUFFLE(3,3,1,1)), round));
+	po = _mm_add_epi64(po, _mm_and_si128(_mm_shuffle_epi32(_mm_srai_epi32(po, 31), _MM_SHUFFLE(3,3,1,1)), round));
+
+	pe = _mm_and_si128(_mm_srli_epi64(pe, 16), lomask);
+	po = _mm_slli_epi64(_mm_srli_epi64(po, 16), 32);
+	return _mm_or_si128(pe, po);
+}
+
+//----------------------------------------------------------------------------
+// Divide 2 exact doubles, returns false if a lane needs the scalar code.
+//----------------------------------------------------------------------------
+static inline bool div2(__m128d n, __m128d d, __m128i *q)
+{
+	const __m128d absmask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+	const __m128d limit = _mm_set1_pd(TWO_TO_52);
+	const __m128i overflow = _mm_set1_epi32(0x80000000);
+
+	if (_mm_movemask_pd(_mm_cmplt_pd(_mm_and_pd(n, absmask), limit)) != 3)
+		return false;
+
+	// cvttpd gives 0x80000000 for overflow, inf and nan
+	*q = _mm_cvttpd_epi32(_mm_div_pd(n, d));
+	return (_mm_movemask_epi8(_mm_cmpeq_epi32(*q, overflow)) & 0xff) == 0;
+}
+
+static inline __m128d lo_pd(__m128i v)
+{
+	return _mm_cvtepi32_pd(v);
+}
+
+static inline __m128d hi_pd(__m128i v)
+{
+	return _mm_cvtepi32_pd(_mm_srli_si128(v, 8));
+}
+
+//----------------------------------------------------------------------------
+// Kernels
+//----------------------------------------------------------------------------
+static void mul_sse2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+		_mm_storeu_si128((__m128i *) (dst + i), mul4(va, vb));
+	}
+	fix_array_kernels_scalar.f_Mul(dst + i, a + i, b + i, n - i);
+}
+
+static void div_sse2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	const __m128d scale = _mm_set1_pd(65536.0);
+	int32_t i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+		__m128i qlo, qhi;
+
+		if (div2(_mm_mul_pd(lo_pd(va), scale), lo_pd(vb), &qlo) &&
+			div2(_mm_mul_pd(hi_pd(va), scale), hi_pd(vb), &qhi))
+			_mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi64(qlo, qhi));
+		else
+			fix_array_kernels_scalar.f_Div(dst + i, a + i, b + i, 4);
+	}
+	fix_array_kernels_scalar.f_Div(dst + i, a + i, b + i, n - i);
+}
+
+static void mul_div_sse2(fix *dst, const fix *m0, const fix *m1, const fix *d, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		__m128i v0 = _mm_loadu_si128((const __m128i *) (m0 + i));
+		__m128i v1 = _mm_loadu_si128((const __m128i *) (m1 + i));
+		__m128i vd = _mm_loadu_si128((const __m128i *) (d + i));
+		__m128i qlo, qhi;
+
+		if (div2(_mm_mul_pd(lo_pd(v0), lo_pd(v1)), lo_pd(vd), &qlo) &&
+			div2(_mm_mul_pd(hi_pd(v0), hi_pd(v1)), hi_pd(vd), &qhi))
+			_mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi64(qlo, qhi));
+		else
+			fix_array_kernels_scalar.f_MulDiv(dst + i, m0 + i, m1 + i, d + i, 4);
+	}
+	fix_array_kernels_scalar.f_MulDiv(dst + i, m0 + i, m1 + i, d + i, n - i);
+}
+
+//----------------------------------------------------------------------------
+// Same interpolation as fix_sincos, eight angles at a time.  The table
+// lookups stay scalar, the interpolation is done on 16-bit lanes.
+//----------------------------------------------------------------------------
+static inline __m128i interp8(const int16_t *lo, const int16_t *hi, __m128i frac)
+{
+	__m128i vlo = _mm_loadu_si128((const __m128i *) lo);
+	__m128i diff = _mm_sub_epi16(_mm_loadu_si128((const __m128i *) hi), vlo);
+
+	// bits 8..23 of diff * frac
+	__m128i step = _mm_or_si128(_mm_srli_epi16(_mm_mullo_epi16(diff, frac), 8),
+								_mm_slli_epi16(_mm_mulhi_epi16(diff, frac), 8));
+	return _mm_add_epi16(vlo, step);
+}
+
+static inline void store_fix8(fix *dst, __m128i v)
+{
+	_mm_storeu_si128((__m128i *) dst, _mm_slli_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), 2));
+	_mm_storeu_si128((__m128i *) (dst + 4), _mm_slli_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), 2));
+}
+
+static void sincos_sse2(fix *sin, fix *cos, const fixang *theta, int32_t n)
+{
+	int16_t lowsin[8], hisin[8], lowcos[8], hicos[8];
+	int32_t i, j;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		__m128i vth = _mm_loadu_si128((const __m128i *) (theta + i));
+		__m128i frac = _mm_and_si128(vth, _mm_set1_epi16(0xff));
+
+		for (j = 0; j < 8; ++j)
+		{
+			uint8_t baseth = theta[i + j] >> 8;
+			lowsin[j] = sintab[baseth];
+			hisin[j] = sintab[baseth + 1];
+			lowcos[j] = sintab[baseth + 64];
+			hicos[j] = sintab[baseth + 65];
+		}
+
+		store_fix8(sin + i, interp8(lowsin, hisin, frac));
+		store_fix8(cos + i, interp8(lowcos, hicos, frac));
+	}
+	fix_array_kernels_scalar.f_SinCos(sin + i, cos + i, theta + i, n - i);
+}
+
+//----------------------------------------------------------------------------
+// 3-vectors, four at a time (three registers' worth of x,y,z)
+//----------------------------------------------------------------------------
+static void dot3_sse2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix p[12];
+	int32_t i, j;
+
+	for (i = 0; i + 4 <= n; i += 4, a += 12, b += 12)
+	{
+		for (j = 0; j < 12; j += 4)
+		{
+			__m128i va = _mm_loadu_si128((const __m128i *) (a + j));
+			__m128i vb = _mm_loadu_si128((const __m128i *) (b + j));
+			_mm_storeu_si128((__m128i *) (p + j), mul4(va, vb));
+		}
+		for (j = 0; j < 4; ++j)
+			dst[i + j] = p[3*j] + p[3*j + 1] + p[3*j + 2];
+	}
+	fix_array_kernels_scalar.f_Dot3(dst + i, a, b, n - i);
+}
+
+static void cross3_sse2(fix *dst, const fix *a, const fix *b, int32_t n)
+{
+	fix a1[12], b1[12], a2[12], b2[12];
+	int32_t i, j;
+
+	for (i = 0; i + 4 <= n; i += 4, a += 12, b += 12, dst += 12)
+	{
+		// (y,z,x)*(z,x,y) - (z,x,y)*(y,z,x)
+		for (j = 0; j < 12; j += 3)
+		{
+			a1[j] = a[j+1]; a1[j+1] = a[j+2]; a1[j+2] = a[j];
+			b1[j] = b[j+2]; b1[j+1] = b[j];   b1[j+2] = b[j+1];
+			a2[j] = a[j+2]; a2[j+1] = a[j];   a2[j+2] = a[j+1];
+			b2[j] = b[j+1]; b2[j+1] = b[j+2]; b2[j+2] = b[j];
+		}
+		for (j = 0; j < 12; j += 4)
+		{
+			__m128i l = mul4(_mm_loadu_si128((const __m128i *) (a1 + j)), _mm_loadu_si128((const __m128i *) (b1 + j)));
+			__m128i r = mul4(_mm_loadu_si128((const __m128i *) (a2 + j)), _mm_loadu_si128((const __m128i *) (b2 + j)));
+			_mm_storeu_si128((__m128i *) (dst + j), _mm_sub_epi32(l, r));
+		}
+	}
+	fix_array_kernels_scalar.f_Cross3(dst, a, b, n - i);
+}
+
+const FixArrayKernels fix_array_kernels_sse2 = {
+	mul_sse2,
+	div_sse2,
+	mul_div_sse2,
+	sincos_sse2,
+	dot3_sse2,
+	cross3_sse2
+};
+
+#endif /* __SSE2__ */
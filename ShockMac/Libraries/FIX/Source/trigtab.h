@@ -24,3 +24,19 @@ extern fixang asintab[128+1];
 extern uint32_t expinttab[INTEGER_EXP_OFFSET*2+1];
 
 extern uint32_t expfractab[16+1];
+
+// High resolution sine table for fix_sincos_hr, 2^FIX_TRIG_BITS entries per
+// circle.  The build generates it, see FIX/Utils/fmaketab.cpp.
+#ifndef FIX_TRIG_BITS
+#define FIX_TRIG_BITS 10
+#endif
+
+#define SINTAB_HR_SIZE (1 << FIX_TRIG_BITS)
+
+extern fix sintab_hr[SINTAB_HR_SIZE + SINTAB_HR_SIZE/4 + 1];
+
+extern uint16_t rsqrttab[96];
+
+extern uint32_t log2rctab[64];
+extern int64_t log2tab[64];
+extern uint32_t exp2tab[64];
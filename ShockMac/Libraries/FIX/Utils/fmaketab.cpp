@@ -50,6 +50,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <iostream>
+#include <fstream>
 #include <stdlib.h>
 #include <math.h>
 #include <stdint.h>
@@ -63,9 +64,34 @@ uint16_t sins[256];
 uint16_t asins[129];
 
 void do_exp_table (void);
-
-int main ()
+void do_hr_sin_table (int bits);
+void do_rsqrt_table (void);
+void do_log2_exp2_tables (void);
+
+// usage: fmaketab [table bits [output file]]
+// The build runs this to make MakeTables.c, table bits sets the size of the
+// high resolution sine table (FIX_TRIG_BITS).
+int main (int argc, char *argv[])
 {
+	int hr_bits = (argc > 1) ? atoi (argv[1]) : 10;
+	ofstream out_file;
+
+	if (hr_bits < 8 || hr_bits > 16)
+	{
+		cerr << "table bits must be 8..16" << endl;
+		return 1;
+	}
+
+	if (argc > 2)
+	{
+		out_file.open (argv[2]);
+		if (!out_file)
+		{
+			cerr << "can't write " << argv[2] << endl;
+			return 1;
+		}
+		cout.rdbuf (out_file.rdbuf ());
+	}
 
 	cout << "#include \"fix.h\"\n";
 	cout << "#include \"trigtab.h\"\n";
@@ -179,7 +205,14 @@ int main ()
 
 	do_exp_table ();
 
-	exit (0);
+	do_hr_sin_table (hr_bits);
+
+	do_rsqrt_table ();
+
+	do_log2_exp2_tables ();
+
+	cout.flush ();
+	return 0;
 }
 
 #define INTEGER_EXP_OFFSET 11
@@ -257,3 +290,118 @@ void do_exp_table (void)
 	}
 	cout << "};\n\n";
 }
+
+// The high resolution sine table has 2^bits entries per circle, plus a
+// quarter circle for cosines and one more for interpolating past the end.
+// Its units are plain fixes, rounded to nearest.
+
+void do_hr_sin_table (int bits)
+{
+	const double two_pi_exact = 8.0 * atan (1.0);	// two_pi above is a bit short
+	int size = 1 << bits;
+	int entries = size + size/4 + 1;
+
+	cout << "// The high resolution sine table, indexed by the top FIX_TRIG_BITS bits\n";
+	cout << "// of a fixang.  Its units are fixes.  cos[x] = sin[x + SINTAB_HR_SIZE/4].\n\n";
+
+	cout << "#if FIX_TRIG_BITS != " << dec << bits << endl;
+	cout << "#error \"generated for FIX_TRIG_BITS " << bits << "\"" << endl;
+	cout << "#endif" << endl << endl;
+
+	cout << "fix sintab_hr[SINTAB_HR_SIZE + SINTAB_HR_SIZE/4 + 1] = {" << endl;
+
+	int i = 0;
+	while (i < entries)
+	{
+		int j;
+
+		cout << "\t";
+		for (j = 0; j < entries_per_line && j+i < entries; j++)
+		{
+			double v = sin ((i+j) * two_pi_exact / size) * 65536.0;
+			int32_t n = (int32_t) ((v < 0) ? -floor (-v + 0.5) : floor (v + 0.5));
+			cout << dec << n << ", ";
+		}
+		cout << endl;
+		i += j;
+	}
+	cout << "};\n";
+}
+
+// The reciprocal square root table seeds the Newton iteration in fix_sqrt.c.
+// It is indexed by the top 7 bits of a number normalized to [1/4,1), minus 32,
+// and holds 1/sqrt of the middle of each interval in 1.15 format.
+
+void do_rsqrt_table (void)
+{
+	cout << "\n// Reciprocal square roots for seeding fix_sqrt, see fix_sqrt.c.\n";
+	cout << "uint16_t rsqrttab[96] = {" << endl;
+
+	int i = 0;
+	while (i < 96)
+	{
+		int j;
+
+		cout << "\t";
+		for (j = 0; j < entries_per_line; j++)
+		{
+			double a = (i + j + 32 + 0.5) / 128.0;
+			cout << dec << (int) floor (32768.0 / sqrt (a) + 0.5) << ", ";
+		}
+		cout << endl;
+		i += j;
+	}
+	cout << "};\n";
+}
+
+// The log2 and exp2 tables for fix_exp_hr and fix_pow_hr, see f_exp.c.
+// log2rctab[i] is 1/(1 + (i+.5)/64) in 0.32 format, and log2tab[i] is
+// -log2 of exactly that rounded value in 24.40, so a mantissa m in interval
+// i has log2(m) = log2(m * rc) + log2tab[i] with m * rc within 1/128 of 1.
+// exp2tab[j] is 2^(j/64) in 1.31 format.
+
+void do_log2_exp2_tables (void)
+{
+	uint32_t rc[64];
+	int i;
+
+	for (i = 0; i < 64; i++)
+		rc[i] = (uint32_t) floor (4294967296.0 / (1.0 + (i + 0.5) / 64.0) + 0.5);
+
+	cout << "\n// log2 and exp2 tables, see f_exp.c.\n";
+	cout << "uint32_t log2rctab[64] = {" << endl;
+	for (i = 0; i < 64; i += 4)
+	{
+		cout << "\t";
+		for (int j = 0; j < 4; j++)
+			cout << dec << rc[i+j] << "u, ";
+		cout << endl;
+	}
+	cout << "};\n\n";
+
+	cout << "int64_t log2tab[64] = {" << endl;
+	for (i = 0; i < 64; i += 4)
+	{
+		cout << "\t";
+		for (int j = 0; j < 4; j++)
+		{
+			long double l = -log2l (rc[i+j] / 4294967296.0L) * 1099511627776.0L;
+			cout << dec << (long long) floorl (l + 0.5L) << "LL, ";
+		}
+		cout << endl;
+	}
+	cout << "};\n\n";
+
+	cout << "uint32_t exp2tab[64] = {" << endl;
+	for (i = 0; i < 64; i += 4)
+	{
+		cout << "\t";
+		for (int j = 0; j < 4; j++)
+		{
+			long double e = exp2l ((i + j) / 64.0L) * 2147483648.0L;
+			cout << dec << (uint32_t) floorl (e + 0.5L) << "u, ";
+		}
+		cout << endl;
+	}
+	cout << "};\n";
+}
@@ -40,7 +40,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // so that the compiler cannot optimize it as much.
 // =========================================================
 
-void touch( Fixpoint& a )
+void touch( Q& a )
 {
    a = a;
 }
@@ -50,7 +50,7 @@ void touch( Fixpoint& a )
 // the address of the string.
 // ===========================================================
 
-char *bitdump( Fixpoint & a )
+char *bitdump( Q & a )
 {
    static char string[30];
 
@@ -63,63 +63,63 @@ char *bitdump( Fixpoint & a )
 #endif /* FIXDEBUG */
 
 // Moved here from header file - KC
-Fixpoint rawConstruct( long l )
+Q rawConstruct( long l )
 {
-	Fixpoint f;
+	Q f;
 	f.val = l;
 	return f;
 }
-#define f2Fixpoint(x) (rawConstruct( (long)((x)*SHIFTMULTIPLIER) ))
+#define f2Fixpoint(x) (rawConstruct( (long)((x)*(1L << SHIFTUP)) ))
 
 
-Fixpoint Fixpoint_one_over_two_pi = f2Fixpoint(0.159154943);
-Fixpoint Fixpoint_two_pi          = f2Fixpoint(6.283185306);
+Q Fixpoint_one_over_two_pi = f2Fixpoint(0.159154943);
+Q Fixpoint_two_pi          = f2Fixpoint(6.283185306);
 
 
 
 
 #ifdef FIXDEBUG
 
-bool  Fixpoint::click_bool = 1;
-
-uint32_t Fixpoint::constructor_void     = 0,
-      Fixpoint::constructor_Fixpoint = 0,
-      Fixpoint::constructor_int      = 0,
-      Fixpoint::constructor_uint     = 0,
-      Fixpoint::constructor_lint     = 0,
-      Fixpoint::constructor_ulint    = 0,
-      Fixpoint::constructor_double   = 0;
-
-uint32_t Fixpoint::ass_Fixpoint = 0,
-      Fixpoint::ass_int      = 0,
-      Fixpoint::ass_lint     = 0,
-      Fixpoint::ass_uint     = 0,
-      Fixpoint::ass_ulint    = 0,
-      Fixpoint::ass_double   = 0;
-
-uint32_t Fixpoint::binary_add = 0,
-      Fixpoint::binary_div = 0,
-      Fixpoint::binary_sub = 0,
-      Fixpoint::binary_mul = 0;
-
-uint32_t Fixpoint::add_eq = 0,
-      Fixpoint::sub_eq = 0,
-      Fixpoint::mul_eq = 0,
-      Fixpoint::div_eq = 0;
-
-uint32_t Fixpoint::unary_minus = 0,
-      Fixpoint::unary_plus  = 0;
-
-uint32_t Fixpoint::cond_l   = 0,
-      Fixpoint::cond_g   = 0,
-      Fixpoint::cond_le  = 0,
-      Fixpoint::cond_ge  = 0,
-      Fixpoint::cond_eq  = 0,
-      Fixpoint::cond_neq = 0;
-
-void Fixpoint::report( void ) { report( std::cout ); }
-
-void Fixpoint::report( std::ostream& os )
+bool  Fixpoint_debug::click_bool = 1;
+
+uint32_t Fixpoint_debug::constructor_void     = 0,
+      Fixpoint_debug::constructor_Fixpoint = 0,
+      Fixpoint_debug::constructor_int      = 0,
+      Fixpoint_debug::constructor_uint     = 0,
+      Fixpoint_debug::constructor_lint     = 0,
+      Fixpoint_debug::constructor_ulint    = 0,
+      Fixpoint_debug::constructor_double   = 0;
+
+uint32_t Fixpoint_debug::ass_Fixpoint = 0,
+      Fixpoint_debug::ass_int      = 0,
+      Fixpoint_debug::ass_lint     = 0,
+      Fixpoint_debug::ass_uint     = 0,
+      Fixpoint_debug::ass_ulint    = 0,
+      Fixpoint_debug::ass_double   = 0;
+
+uint32_t Fixpoint_debug::binary_add = 0,
+      Fixpoint_debug::binary_div = 0,
+      Fixpoint_debug::binary_sub = 0,
+      Fixpoint_debug::binary_mul = 0;
+
+uint32_t Fixpoint_debug::add_eq = 0,
+      Fixpoint_debug::sub_eq = 0,
+      Fixpoint_debug::mul_eq = 0,
+      Fixpoint_debug::div_eq = 0;
+
+uint32_t Fixpoint_debug::unary_minus = 0,
+      Fixpoint_debug::unary_plus  = 0;
+
+uint32_t Fixpoint_debug::cond_l   = 0,
+      Fixpoint_debug::cond_g   = 0,
+      Fixpoint_debug::cond_le  = 0,
+      Fixpoint_debug::cond_ge  = 0,
+      Fixpoint_debug::cond_eq  = 0,
+      Fixpoint_debug::cond_neq = 0;
+
+void Fixpoint_debug::report( void ) { report( std::cout ); }
+
+void Fixpoint_debug::report( std::ostream& os )
 {
    os << "Constructor     void: " << constructor_void     << '\n' ;
    os << "Constructor Fixpoint: " << constructor_Fixpoint << '\n' ;
@@ -157,7 +157,7 @@ void Fixpoint::report( std::ostream& os )
    os << "!=                    " << cond_neq << '\n' ;
 }
 
-void Fixpoint::reset_report( void )
+void Fixpoint_debug::reset_report( void )
 {
    constructor_void =
    constructor_Fixpoint =
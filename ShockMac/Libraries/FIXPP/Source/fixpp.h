@@ -35,7 +35,8 @@ bravery, and to C++ for being such a complex and neurotic language.
 #include "fix.h"                       // A big thank you to Dan and Matt.
 
 
-// How many bits to shift an integer up to make it a fixpoint.
+// How many bits to shift an integer up to make it a Q.
+// Other formats are spelled out, e.g. Fixpoint<24> for 8:24.
 // ===========================================================
 #ifdef FIXPOINT_SHIFTUP
 #define SHIFTUP FIXPOINT_SHIFTUP
@@ -43,8 +44,6 @@ bravery, and to C++ for being such a complex and neurotic language.
 #define SHIFTUP 16                     // 16:16 default format.
 #endif
 
-#define SHIFTMULTIPLIER (1 << SHIFTUP)
-
 
 // Here are some flags for your convenience.
 // =========================================
@@ -55,7 +54,7 @@ bravery, and to C++ for being such a complex and neurotic language.
 
 
 #ifdef FIXDEBUG
-#define CLICK(c) c+=(Fixpoint::click_bool)
+#define CLICK(c) c+=(Fixpoint_debug::click_bool)
 #else
 #define CLICK(c)
 #endif
@@ -64,22 +63,136 @@ bravery, and to C++ for being such a complex and neurotic language.
 // Here is a nice forward declaration.
 // ===================================
 
-class Fixpoint;
+template <int Shift> class Fixpoint;
+template <int Shift> class Fixpoint_wide;
 
-#define Q	Fixpoint		// Added by KC for Mac version
+typedef Fixpoint<SHIFTUP> Q;		// Added by KC for Mac version
 
 // Here are some nice constants.
 // ============================================
 
-extern Fixpoint Fixpoint_two_pi;
-extern Fixpoint Fixpoint_one_over_two_pi;
+extern Q Fixpoint_two_pi;
+extern Q Fixpoint_one_over_two_pi;
+
+
+
+// The arithmetic that depends on the format.  16:16 is the fix library's own
+// format, so it goes through fix_mul and friends (and gets FIX_INLINE); any
+// other format does the same thing with its own shift.  Results are cut to
+// 32 bits just like a fix.
+// ===========================================================================
+
+template <int Shift>
+struct Fixpoint_ops
+{
+   static long int mul( long int a, long int b )
+   { return (fix)(((int64_t) a * (int64_t) b) / ((int64_t) 1 << Shift)); }
+
+   static long int div( long int a, long int b )
+   { return (fix)(((int64_t) a * ((int64_t) 1 << Shift)) / b); }
 
+   static long int sqrt( long int a )
+   {
+      uint64_t x;
 
+      if (a <= 0)
+         return 0;
+      x = (uint64_t) a << Shift;
+      return quad_sqrt( (int32_t)(x >> 32), (int32_t) x );
+   }
+};
 
-class Fixpoint
+template <>
+struct Fixpoint_ops<16>
 {
+   static long int mul( long int a, long int b ) { return fix_mul(a, b); }
+   static long int div( long int a, long int b ) { return fix_div(a, b); }
+   static long int sqrt( long int a ) { return fix_sqrt(a); }
+};
+
+
+// Moves a value from From fraction bits to To fraction bits.  Dropping bits
+// rounds down, like to_int().
+// ==========================================================================
+
+template <int From, int To, bool Up = (To > From)>
+struct Fixpoint_rescale
+{
+   static long int apply( long int v ) { return v << (To - From); }
+};
+
+template <int From, int To>
+struct Fixpoint_rescale<From, To, false>
+{
+   static long int apply( long int v ) { return v >> (From - To); }
+};
+
+
+
+// The FIXDEBUG counters, shared by every format.
+// ==============================================
+
+class Fixpoint_debug
+{
+#ifdef FIXDEBUG
+
+public:
+
+   // Reporting.
+   // ==========
+
+   static bool click_bool;
+
+   static uint32_t constructor_void,
+                constructor_Fixpoint,
+                constructor_int,
+                constructor_uint,
+                constructor_lint,
+                constructor_ulint,
+                constructor_double;
+
+   static uint32_t ass_Fixpoint,
+                ass_int,
+                ass_uint,
+                ass_lint,
+                ass_ulint,
+                ass_double;
 
-friend Fixpoint rawConstruct( long );
+   static uint32_t binary_add,
+                binary_sub,
+                binary_mul,
+                binary_div;
+
+   static uint32_t add_eq,
+                sub_eq,
+                mul_eq,
+                div_eq;
+
+   static uint32_t unary_minus,
+                unary_plus ;
+
+   static uint32_t cond_l,
+                cond_g,
+                cond_le,
+                cond_ge,
+                cond_eq,
+                cond_neq;
+
+   static void  report_on( void ) { click_bool = 1; }
+   static void report_off( void ) { click_bool = 0; }
+
+   static void report( std::ostream& );
+   static void report( void );
+   static void reset_report( void );
+
+#endif /* FIXDEBUG */
+};
+
+
+
+template <int Shift>
+class Fixpoint : public Fixpoint_debug
+{
 
 public:
 
@@ -122,6 +235,25 @@ public:
    Fixpoint( double );
 
 
+   // From another format.  Only a shift, but explicit since going to fewer
+   // fraction bits throws some away.
+   // ======================================================================
+
+   template <int From>
+   explicit Fixpoint( const Fixpoint<From> & );
+
+
+   // 2pi and 1/2pi in this format.  These fold into the code that uses them
+   // instead of being loaded from Fixpoint_two_pi.
+   // ======================================================================
+
+   static long int two_pi_bits( void )
+   { return (long int)(6.283185306 * (1L << Shift)); }
+
+   static long int one_over_two_pi_bits( void )
+   { return (long int)(0.159154943 * (1L << Shift)); }
+
+
    // Conversions.
    // ============
 
@@ -191,141 +323,248 @@ public:
 
    int operator!= ( const Fixpoint & fp2 ) const ;
 
-   // Signed shifts
-   // =============
 
-   void shift(int);
-   Fixpoint shifted(int) const;
+   // The binary operators live in here so that "a * 2" still converts the 2,
+   // which a template operator outside the class wouldn't do.  A product
+   // comes back wide, see Fixpoint_wide below.
+   // ========================================================================
 
+   friend Fixpoint operator+(const Fixpoint& a, const Fixpoint& b)
+   {
+   //  CLICK (binary_add);
 
-   // Fast comparisons with zero (maybe... perhaps Q(0) isn't so slow after all)
-   // (and a trip down memory lane for FORTRAN-ites)
-   // ====================================
+      Fixpoint	c;
+      c.val = a.val + b.val;
+      return c;
+   }
 
-   int gt_zero() const;
+   friend Fixpoint operator-(const Fixpoint& a, const Fixpoint& b)
+   {
+   //  CLICK (binary_sub);
+      Fixpoint	c;
+      c.val = a.val - b.val;
+      return c;
+   }
 
-   int ge_zero() const;
+   friend Fixpoint_wide<Shift> operator*(const Fixpoint& a, const Fixpoint& b)
+   {
+   //  CLICK (binary_mul);
+      return Fixpoint_wide<Shift>((int64_t) a.val * b.val);
+   }
 
-   int eq_zero() const;
+   friend Fixpoint operator/(const Fixpoint& a, const Fixpoint& b)
+   {
+   //  CLICK (binary_div);
+   //   a.val=_fix_do_div(a.val,b.val);
+      Fixpoint	c;
+      c.val= Fixpoint_ops<Shift>::div(a.val,b.val);
+      return c;
+   }
 
-   int ne_zero() const;
+   // Friendly math functions.  These live in here too, so that
+   // sincos( 0, &sn, &cs ) still converts the 0.  The trig and exp
+   // functions work in 16:16 underneath, whatever the format; a*b/c
+   // doesn't care about the format.
+   // ====================================================
 
-   int le_zero() const;
+   friend Fixpoint mul_div(Fixpoint a,Fixpoint b,Fixpoint c)
+   {  Fixpoint r;
+      r.val = fix_mul_div(a.val,b.val,c.val);
+      return r;
+   }
 
-   int lt_zero() const;
 
+   friend Fixpoint sqrt( Fixpoint a )
+   {
+      Fixpoint ans;
 
+      ans.val = Fixpoint_ops<Shift>::sqrt( a.val );
 
-   // Friendly math function declarations.
-   // ====================================
+      return ans;
+   }
 
 
-   friend inline Fixpoint  sqrt( Fixpoint );
-   friend inline Fixpoint  exp( Fixpoint );
-   friend inline int floor( Fixpoint );
-   friend inline Fixpoint   sin( Fixpoint );
-   friend inline Fixpoint   cos( Fixpoint );
-   friend inline Fixpoint   tan( Fixpoint );
-   friend inline Fixpoint  acos( Fixpoint );
-   friend inline Fixpoint  asin( Fixpoint );
-   friend inline void       sincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs );
-   friend inline Fixpoint  atan2( Fixpoint, Fixpoint );
-   friend inline Fixpoint  fsin( Fixpoint );
-   friend inline Fixpoint  fcos( Fixpoint );
-   friend inline void      fsincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs );
-   friend inline Fixpoint   abs( Fixpoint );
+   friend Fixpoint exp(Fixpoint a)
+   {  Fixpoint ans;
+      ans.fix_to(fix_exp(a.to_fix()));
+      return ans;
+   }
 
+   friend int floor( Fixpoint a )
+   {
+      return a.val >> Shift;
+   }
 
+   friend Fixpoint sin( Fixpoint a )
+   {
+      Fixpoint ans;
 
+      ans.fix_to( fix_sin( a.to_fixang() ) );
 
+      return ans;
+   }
 
+   friend Fixpoint cos( Fixpoint a )
+   {
+      Fixpoint ans;
 
+      ans.fix_to( fix_cos( a.to_fixang() ) );
 
+      return ans;
+   }
 
+   friend Fixpoint tan( Fixpoint a )
+   {
+      Fixpoint sn, cs;
 
-#ifdef FIXDEBUG
+      sn = sin( a );
+      cs = cos( a );
+      if (cs == 0)
+         return 0;
+      else
+         return sn/cs;
+   }
 
-   friend char *bitdump( Fixpoint & );
+   friend Fixpoint asin( Fixpoint a )
+   {
+      Fixpoint ans;
 
+      ans.fixang_to( fix_asin( a.to_fix() ) );
 
-   // Reporting.
-   // ==========
+      return ans;
+   }
 
-   static bool click_bool;
+   friend Fixpoint acos( Fixpoint a )
+   {
+      Fixpoint ans;
 
-   static uint32_t constructor_void,
-                constructor_Fixpoint,
-                constructor_int,
-                constructor_uint,
-                constructor_lint,
-                constructor_ulint,
-                constructor_double;
+      ans.fixang_to( fix_acos( a.to_fix() ) );
 
-   static uint32_t ass_Fixpoint,
-                ass_int,
-                ass_uint,
-                ass_lint,
-                ass_ulint,
-                ass_double;
+      return ans;
+   }
 
-   static uint32_t binary_add,
-                binary_sub,
-                binary_mul,
-                binary_div;
+   friend void sincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs )
+   {
+      fix fsn, fcs;
+      fix_sincos( ang.to_fixang(), &fsn, &fcs );
+      sn->fix_to( fsn );
+      cs->fix_to( fcs );
+   }
 
-   static uint32_t add_eq,
-                sub_eq,
-                mul_eq,
-                div_eq;
+   friend Fixpoint atan2( Fixpoint y, Fixpoint x )
+   {
+      Fixpoint ans;
 
-   static uint32_t unary_minus,
-                unary_plus ;
+      ans.fixang_to( fix_atan2( y.to_fix(), x.to_fix() ) );
 
-   static uint32_t cond_l,
-                cond_g,
-                cond_le,
-                cond_ge,
-                cond_eq,
-                cond_neq;
+      return ans;
+   }
 
-   static void  report_on( void ) { click_bool = 1; }
-   static void report_off( void ) { click_bool = 0; }
 
-   static void report( std::ostream& );
-   static void report( void );
-   static void reset_report( void );
+   friend Fixpoint fsin( Fixpoint a )
+   {
+      Fixpoint ans;
 
-#endif /* FIXDEBUG */
+      ans.fix_to( fix_fastsin( a.to_fixang() ) );
+
+      return ans;
+   }
+
+   friend Fixpoint fcos( Fixpoint a )
+   {
+      Fixpoint ans;
+
+      ans.fix_to( fix_fastcos( a.to_fixang() ) );
+
+      return ans;
+   }
+
+   friend void fsincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs )
+   {
+      fix fsn, fcs;
+      fix_fastsincos( ang.to_fixang(), &fsn, &fcs );
+      sn->fix_to( fsn );
+      cs->fix_to( fcs );
+   }
+
+   friend Fixpoint abs( Fixpoint fp )
+   {
+      Fixpoint ans;
+
+      ans.val = labs( fp.val );
+
+      return ans;
+   }
+
+
+   // Signed shifts
+   // =============
+
+   void shift(int);
+   Fixpoint shifted(int) const;
+
+
+   // Fast comparisons with zero (maybe... perhaps Q(0) isn't so slow after all)
+   // (and a trip down memory lane for FORTRAN-ites)
+   // ====================================
+
+   int gt_zero() const;
+
+   int ge_zero() const;
+
+   int eq_zero() const;
+
+   int ne_zero() const;
+
+   int le_zero() const;
+
+   int lt_zero() const;
 
 } /* Blessed be!! */ ;
 
 
+Q rawConstruct( long );
+
+
 // Constructors
 // ============
 
-inline uint32_t Fixpoint::bits( void ) { return (uint32_t)val; }
-inline void Fixpoint::setbits( uint32_t ul ) { val = ul; }
+template <int Shift>
+inline uint32_t Fixpoint<Shift>::bits( void ) { return (uint32_t)val; }
+template <int Shift>
+inline void Fixpoint<Shift>::setbits( uint32_t ul ) { val = ul; }
 
-inline Fixpoint::Fixpoint()
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint()
 { CLICK( constructor_void ); }                      // Hey, why not define our own....
 
-inline Fixpoint::Fixpoint( const Fixpoint & fp )
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( const Fixpoint & fp )
 { CLICK( constructor_Fixpoint ); val = fp.val; }
 
-inline Fixpoint::Fixpoint( int i )
-{ CLICK( constructor_int ); val = i<<SHIFTUP; }
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( int i )
+{ CLICK( constructor_int ); val = i<<Shift; }
+
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( unsigned int i )
+{ CLICK( constructor_uint ); val = i<<Shift; }
 
-inline Fixpoint::Fixpoint( unsigned int i )
-{ CLICK( constructor_uint ); val = i<<SHIFTUP; }
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( long int i )
+{ CLICK( constructor_lint ); val = i<<Shift; }
 
-inline Fixpoint::Fixpoint( long int i )
-{ CLICK( constructor_lint ); val = i<<SHIFTUP; }
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( unsigned long int i )
+{ CLICK( constructor_ulint ); val = i<<Shift; }
 
-inline Fixpoint::Fixpoint( unsigned long int i )
-{ CLICK( constructor_ulint ); val = i<<SHIFTUP; }
+template <int Shift>
+inline Fixpoint<Shift>::Fixpoint( double d )
+{ CLICK( constructor_double); val = (long int)(d * (1L << Shift)); }
 
-inline Fixpoint::Fixpoint( double d )
-{ CLICK( constructor_double); val = (long int)(d * SHIFTMULTIPLIER); }
+template <int Shift> template <int From>
+inline Fixpoint<Shift>::Fixpoint( const Fixpoint<From> & fp )
+{ CLICK( constructor_Fixpoint ); val = Fixpoint_rescale<From, Shift>::apply( fp.val ); }
 
 
 //inline Fixpoint rawConstruct( long l )  Removed inline.  Put code in fixpp.cc
@@ -351,7 +590,8 @@ inline Fixpoint::Fixpoint( double d )
 //   +=   //
 //        //
 ////////////
-inline Fixpoint& Fixpoint::operator+=(Fixpoint fp2 )
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator+=(Fixpoint fp2 )
 {
 //   CLICK( add_eq );
 
@@ -365,7 +605,8 @@ inline Fixpoint& Fixpoint::operator+=(Fixpoint fp2 )
 //   -=   //
 //        //
 ////////////
-inline Fixpoint& Fixpoint::operator-=(Fixpoint fp2 )
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator-=(Fixpoint fp2 )
 {
    CLICK( sub_eq );
 
@@ -387,12 +628,14 @@ long int _fix_do_mult( long int val1, long int val2 );
 //   *=   //
 //        //
 ////////////
-inline Fixpoint& Fixpoint::operator*=(Fixpoint fp2 )
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator*=(Fixpoint fp2 )
 {
 //	CLICK( mul_eq );
 
 //   val = _fix_do_mult( val, fp2.val );
-	val = fix_mul(val, fp2.val);
+	// rounds to nearest, the same as a*b (see Fixpoint_wide)
+	val = Fixpoint_wide<Shift>((int64_t) val * fp2.val).val;
 	return *this;
 }
 
@@ -412,70 +655,38 @@ long int _fix_do_div( long int val1, long int val2 );
 //   /=   //
 //        //
 ////////////
-inline Fixpoint& Fixpoint::operator/=(Fixpoint fp2 )
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator/=(Fixpoint fp2 )
 {
    CLICK( div_eq );
 
 //   val = _fix_do_div(val, fp2.val);
-   val = fix_div(val, fp2.val);
+   val = Fixpoint_ops<Shift>::div(val, fp2.val);
    return *this;
 }
 
 
 
-inline Fixpoint& Fixpoint::operator<<=(unsigned int n)
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator<<=(unsigned int n)
 {  val<<=n;
    return *this;
 }
 
-inline Fixpoint& Fixpoint::operator>>=(unsigned int n)
+template <int Shift>
+inline Fixpoint<Shift>& Fixpoint<Shift>::operator>>=(unsigned int n)
 {  val>>=n;
    return *this;
 }
 
 
-
-inline Fixpoint operator+(const Fixpoint& a, const Fixpoint& b)
-{
-//  CLICK (Fixpoint::binary_add);
-
-   Fixpoint	c;
-   c.val = a.val + b.val;
-   return c;
-}
-
-inline Fixpoint operator-(const Fixpoint& a, const Fixpoint& b)
-{
-//  CLICK (Fixpoint::binary_sub);
-   Fixpoint	c;
-   c.val = a.val - b.val;
-   return c;
-}
-
-inline Fixpoint operator*(const Fixpoint& a, const Fixpoint& b)
-{
-//  CLICK (Fixpoint::binary_mul);
-   Fixpoint	c;
-   c.val = fix_mul(a.val,b.val);
-   return c;
-}
-
-inline Fixpoint operator/(const Fixpoint& a, const Fixpoint& b)
-{
-//  CLICK (Fixpoint::binary_div);
-//   a.val=_fix_do_div(a.val,b.val);
-   Fixpoint	c;
-   c.val= fix_div(a.val,b.val);
-   return c;
-}
-
-
 ///////////
 //       //
 //   -   //
 //       //
 ///////////
-inline Fixpoint Fixpoint::operator-( void ) const
+template <int Shift>
+inline Fixpoint<Shift> Fixpoint<Shift>::operator-( void ) const
 {
    Fixpoint ans;
 
@@ -491,31 +702,36 @@ inline Fixpoint Fixpoint::operator-( void ) const
 //   +   //
 //       //
 ///////////
-inline Fixpoint Fixpoint::operator+( void ) const
+template <int Shift>
+inline Fixpoint<Shift> Fixpoint<Shift>::operator+( void ) const
 {
    CLICK( unary_plus );
 
    return *this;
 }
 
-inline void Fixpoint::shift(int n)
+template <int Shift>
+inline void Fixpoint<Shift>::shift(int n)
 {  if (n>0) val<<=n;
    else if (n<0) val>>=(-n);
 }
 
-inline Fixpoint Fixpoint::shifted(int n) const
+template <int Shift>
+inline Fixpoint<Shift> Fixpoint<Shift>::shifted(int n) const
 {  Fixpoint r(*this);
    if (n>0) r.val<<=n;
    else if (n<0) r.val>>=(-n);
    return r;
 }
 
-inline Fixpoint operator<<(Fixpoint p,unsigned int n)
+template <int Shift>
+inline Fixpoint<Shift> operator<<(Fixpoint<Shift> p,unsigned int n)
 {  p.val<<=n;
    return p;
 }
 
-inline Fixpoint operator>>(Fixpoint p,unsigned int n)
+template <int Shift>
+inline Fixpoint<Shift> operator>>(Fixpoint<Shift> p,unsigned int n)
 {  p.val>>=n;
    return p;
 }
@@ -527,39 +743,47 @@ inline Fixpoint operator>>(Fixpoint p,unsigned int n)
 // Conversions.
 // ============
 
-inline double Fixpoint::to_double( void ) const
-{ return ((double) val) / SHIFTMULTIPLIER; }
+template <int Shift>
+inline double Fixpoint<Shift>::to_double( void ) const
+{ return ((double) val) / (1L << Shift); }
 
-inline float Fixpoint::to_float( void ) const
-{ return ((float) val) / SHIFTMULTIPLIER; }
+template <int Shift>
+inline float Fixpoint<Shift>::to_float( void ) const
+{ return ((float) val) / (1L << Shift); }
 
-inline long int Fixpoint::to_lint( void ) const
-{ return val >> SHIFTUP; }
+template <int Shift>
+inline long int Fixpoint<Shift>::to_lint( void ) const
+{ return val >> Shift; }
 
-inline int Fixpoint::to_int( void ) const
-{ return (int) (val >> SHIFTUP); }
+template <int Shift>
+inline int Fixpoint<Shift>::to_int( void ) const
+{ return (int) (val >> Shift); }
 
-inline fix Fixpoint::to_fix( void ) const
-{ return (fix) val; }
+template <int Shift>
+inline fix Fixpoint<Shift>::to_fix( void ) const
+{ return (fix) Fixpoint_rescale<Shift, 16>::apply( val ); }
 
-inline fixang Fixpoint::to_fixang( void ) const
+template <int Shift>
+inline fixang Fixpoint<Shift>::to_fixang( void ) const
 {
-   Fixpoint temp = *this * Fixpoint_one_over_two_pi;
+   long int temp = Fixpoint_ops<Shift>::mul( val, one_over_two_pi_bits() );
 
    // for temp, 360 degrees = 1.0.
-   // The lower 16 bits of the internal rep is the fixang.
+   // The top 16 bits of the fraction are the fixang.
 
-   return (uint16_t)temp.val;
+   return (uint16_t)Fixpoint_rescale<Shift, 16>::apply( temp );
 }
 
 
 
-inline void Fixpoint::fix_to( fix f ) { val = f; }
+template <int Shift>
+inline void Fixpoint<Shift>::fix_to( fix f ) { val = Fixpoint_rescale<16, Shift>::apply( f ); }
 
-inline void Fixpoint::fixang_to( fixang f )
+template <int Shift>
+inline void Fixpoint<Shift>::fixang_to( fixang f )
 {
-   val = ((long)(short)(f-1))+1;
-   *this *= Fixpoint_two_pi;
+   // f in 16:16 turns, times 2pi in our format
+   val = Fixpoint_ops<16>::mul( ((long)(short)(f-1))+1, two_pi_bits() );
 }
 
 
@@ -577,7 +801,8 @@ inline void Fixpoint::fixang_to( fixang f )
 //   <   //
 //       //
 ///////////
-inline int Fixpoint::operator< ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator< ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_l );
 
@@ -593,7 +818,8 @@ inline int Fixpoint::operator< ( const Fixpoint & fp2 ) const
 //   >   //
 //       //
 ///////////
-inline int Fixpoint::operator> ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator> ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_g );
 
@@ -609,7 +835,8 @@ inline int Fixpoint::operator> ( const Fixpoint & fp2 ) const
 //   <=   //
 //        //
 ////////////
-inline int Fixpoint::operator<= ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator<= ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_le );
 
@@ -624,7 +851,8 @@ inline int Fixpoint::operator<= ( const Fixpoint & fp2 ) const
 //   >=   //
 //        //
 ////////////
-inline int Fixpoint::operator>= ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator>= ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_ge );
 
@@ -638,7 +866,8 @@ inline int Fixpoint::operator>= ( const Fixpoint & fp2 ) const
 //   ==   //
 //        //
 ////////////
-inline int Fixpoint::operator== ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator== ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_eq );
 
@@ -653,7 +882,8 @@ inline int Fixpoint::operator== ( const Fixpoint & fp2 ) const
 //   !=   //
 //        //
 ////////////
-inline int Fixpoint::operator!= ( const Fixpoint & fp2 ) const
+template <int Shift>
+inline int Fixpoint<Shift>::operator!= ( const Fixpoint & fp2 ) const
 {
    CLICK( cond_neq );
 
@@ -667,27 +897,33 @@ inline int Fixpoint::operator!= ( const Fixpoint & fp2 ) const
 //
 // ======================================
 
-inline int Fixpoint::gt_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::gt_zero() const
 {  return (val>0);
 }
 
-inline int Fixpoint::ge_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::ge_zero() const
 {  return (val>=0);
 }
 
-inline int Fixpoint::eq_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::eq_zero() const
 {  return (val==0);
 }
 
-inline int Fixpoint::ne_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::ne_zero() const
 {  return (val!=0);
 }
 
-inline int Fixpoint::le_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::le_zero() const
 {  return (val<=0);
 }
 
-inline int Fixpoint::lt_zero() const
+template <int Shift>
+inline int Fixpoint<Shift>::lt_zero() const
 {  return (val<0);
 }
 
@@ -703,16 +939,19 @@ inline int Fixpoint::lt_zero() const
 
 
 
-inline Fixpoint operator* ( int i, Fixpoint fp ) { return Fixpoint(i) * fp ; }
-inline Fixpoint operator* ( unsigned int i, Fixpoint fp ) { return Fixpoint(i) * fp ; }
-inline Fixpoint operator* ( long int i, Fixpoint fp ) { return Fixpoint(i) * fp ; }
-inline Fixpoint operator* ( unsigned long int i, Fixpoint fp ) { return Fixpoint(i) * fp ; }
+template <int Shift>
+inline Fixpoint_wide<Shift> operator* ( int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) * fp ; }
+template <int Shift>
+inline Fixpoint_wide<Shift> operator* ( unsigned int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) * fp ; }
+template <int Shift>
+inline Fixpoint_wide<Shift> operator* ( long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) * fp ; }
+template <int Shift>
+inline Fixpoint_wide<Shift> operator* ( unsigned long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) * fp ; }
 //inline Fixpoint operator* ( double d, Fixpoint fp ) { return Fixpoint(d) * fp ; }
-inline Fixpoint operator* (const double& d, const Fixpoint& fp)
+template <int Shift>
+inline Fixpoint_wide<Shift> operator* (const double& d, const Fixpoint<Shift>& fp)
 {
-	Fixpoint c;
-	c.val = fix_mul((long int)(d * SHIFTMULTIPLIER), fp.val);
-	return c;
+	return Fixpoint_wide<Shift>((int64_t)(long int)(d * (1L << Shift)) * fp.val);
 }
 
 //inline Fixpoint operator- ( int i, Fixpoint fp ) { return Fixpoint(i) - fp ; }
@@ -720,48 +959,129 @@ inline Fixpoint operator* (const double& d, const Fixpoint& fp)
 //inline Fixpoint operator- ( long int i, Fixpoint fp ) { return Fixpoint(i) - fp ; }
 //inline Fixpoint operator- ( unsigned long int i, Fixpoint fp ) { return Fixpoint(i) - fp ; }
 //inline Fixpoint operator- ( double d, Fixpoint fp ) { return Fixpoint(d) - fp ; }
-inline Fixpoint operator- ( const int& i, const Fixpoint& fp )
+template <int Shift>
+inline Fixpoint<Shift> operator- ( const int& i, const Fixpoint<Shift>& fp )
 {
-	Fixpoint c;
-	c.val = (i << SHIFTUP) - fp.val;
+	Fixpoint<Shift> c;
+	c.val = (i << Shift) - fp.val;
 	return c;
 }
-inline Fixpoint operator- ( const unsigned int& i, const Fixpoint& fp )
+template <int Shift>
+inline Fixpoint<Shift> operator- ( const unsigned int& i, const Fixpoint<Shift>& fp )
 {
-	Fixpoint c;
-	c.val = (i << SHIFTUP) - fp.val;
+	Fixpoint<Shift> c;
+	c.val = (i << Shift) - fp.val;
 	return c;
 }
-inline Fixpoint operator- ( const long int& i, const Fixpoint& fp )
+template <int Shift>
+inline Fixpoint<Shift> operator- ( const long int& i, const Fixpoint<Shift>& fp )
 {
-	Fixpoint c;
-	c.val = (i << SHIFTUP) - fp.val;
+	Fixpoint<Shift> c;
+	c.val = (i << Shift) - fp.val;
 	return c;
 }
-inline Fixpoint operator- ( const unsigned long int& i, const Fixpoint& fp )
+template <int Shift>
+inline Fixpoint<Shift> operator- ( const unsigned long int& i, const Fixpoint<Shift>& fp )
 {
-	Fixpoint c;
-	c.val = (i << SHIFTUP) - fp.val;
+	Fixpoint<Shift> c;
+	c.val = (i << Shift) - fp.val;
 	return c;
 }
-inline Fixpoint operator- (const double& d, const Fixpoint& fp)
+template <int Shift>
+inline Fixpoint<Shift> operator- (const double& d, const Fixpoint<Shift>& fp)
 {
-	Fixpoint c;
-	c.val = (long int)(d * SHIFTMULTIPLIER) - fp.val;
+	Fixpoint<Shift> c;
+	c.val = (long int)(d * (1L << Shift)) - fp.val;
 	return c;
 }
 
-inline Fixpoint operator+ ( int i, Fixpoint fp ) { return Fixpoint(i) + fp ; }
-inline Fixpoint operator+ ( unsigned int i, Fixpoint fp ) { return Fixpoint(i) + fp ; }
-inline Fixpoint operator+ ( long int i, Fixpoint fp ) { return Fixpoint(i) + fp ; }
-inline Fixpoint operator+ ( unsigned long int i, Fixpoint fp ) { return Fixpoint(i) + fp ; }
-inline Fixpoint operator+ ( double d, Fixpoint fp ) { return Fixpoint(d) + fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator+ ( int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) + fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator+ ( unsigned int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) + fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator+ ( long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) + fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator+ ( unsigned long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) + fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator+ ( double d, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(d) + fp ; }
+
+template <int Shift>
+inline Fixpoint<Shift> operator/ ( int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) / fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator/ ( unsigned int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) / fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator/ ( long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) / fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator/ ( unsigned long int i, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(i) / fp ; }
+template <int Shift>
+inline Fixpoint<Shift> operator/ ( double d, Fixpoint<Shift> fp ) { return Fixpoint<Shift>(d) / fp ; }
 
-inline Fixpoint operator/ ( int i, Fixpoint fp ) { return Fixpoint(i) / fp ; }
-inline Fixpoint operator/ ( unsigned int i, Fixpoint fp ) { return Fixpoint(i) / fp ; }
-inline Fixpoint operator/ ( long int i, Fixpoint fp ) { return Fixpoint(i) / fp ; }
-inline Fixpoint operator/ ( unsigned long int i, Fixpoint fp ) { return Fixpoint(i) / fp ; }
-inline Fixpoint operator/ ( double d, Fixpoint fp ) { return Fixpoint(d) / fp ; }
+
+// ======================================
+//
+// Fused multiply-add.
+//
+// ======================================
+
+// a*b gives one of these: the product before it's shifted back down, along
+// with the ordinary result in val.  Adding or subtracting more products (or
+// plain values) keeps working on the wide value, so
+//
+//    x = x + h*v + .5*h*h*acc;
+//
+// is shifted once when it's stored instead of once per multiply.  Anywhere
+// else a product is just the Fixpoint in val.  Whichever half doesn't get
+// used is thrown away by the optimizer.
+//
+// The shift rounds to nearest, where fix_mul rounds toward zero, so a
+// product can be one bit off what fix_mul gives (the right way).  *= rounds
+// the same way, so a = a*b and a *= b always agree.
+//
+// As long as each product fits in the format, which it had to anyway, a sum
+// can have thousands of them before the 64 bits run out.
+
+template <int Shift>
+class Fixpoint_wide : public Fixpoint<Shift>
+{
+public:
+
+   // The unshifted value, with 2*Shift fraction bits.
+   // ================================================
+   int64_t wide;
+
+   explicit Fixpoint_wide( int64_t w )
+   : wide( w )
+   { this -> val = (fix)((w + ((int64_t) 1 << (Shift - 1))) >> Shift); }
+
+   static int64_t widen( const Fixpoint<Shift> & fp )
+   { return (int64_t) fp.val * ((int64_t) 1 << Shift); }
+
+   Fixpoint_wide operator-( void ) const
+   { return Fixpoint_wide( - wide ); }
+
+   friend Fixpoint_wide operator+( const Fixpoint_wide & a, const Fixpoint_wide & b )
+   { return Fixpoint_wide( a.wide + b.wide ); }
+
+   friend Fixpoint_wide operator+( const Fixpoint_wide & a, const Fixpoint<Shift> & b )
+   { return Fixpoint_wide( a.wide + widen( b ) ); }
+
+   friend Fixpoint_wide operator-( const Fixpoint_wide & a, const Fixpoint_wide & b )
+   { return Fixpoint_wide( a.wide - b.wide ); }
+
+   friend Fixpoint_wide operator-( const Fixpoint_wide & a, const Fixpoint<Shift> & b )
+   { return Fixpoint_wide( a.wide - widen( b ) ); }
+};
+
+// Plain value first.  These are templates, not friends, so that 2 + a*b
+// doesn't have two equally good ways to convert the 2.
+template <int Shift>
+inline Fixpoint_wide<Shift> operator+ ( const Fixpoint<Shift> & a, const Fixpoint_wide<Shift> & b )
+{ return Fixpoint_wide<Shift>( Fixpoint_wide<Shift>::widen( a ) + b.wide ); }
+
+template <int Shift>
+inline Fixpoint_wide<Shift> operator- ( const Fixpoint<Shift> & a, const Fixpoint_wide<Shift> & b )
+{ return Fixpoint_wide<Shift>( Fixpoint_wide<Shift>::widen( a ) - b.wide ); }
 
 
 #ifdef BADMIX
@@ -797,7 +1117,8 @@ inline Fixpoint operator*= ( double d, Fixpoint fp ) { return Fixpoint(d) *= fp
 // ======================================
 
 
-inline std::ostream& operator << ( std::ostream & os, const Fixpoint &fp )
+template <int Shift>
+inline std::ostream& operator << ( std::ostream & os, const Fixpoint<Shift> &fp )
 {
    os << fp.to_double();
 
@@ -805,7 +1126,8 @@ inline std::ostream& operator << ( std::ostream & os, const Fixpoint &fp )
 }
 
 
-inline std::istream& operator >> ( std::istream & is, Fixpoint &fp )
+template <int Shift>
+inline std::istream& operator >> ( std::istream & is, Fixpoint<Shift> &fp )
 {
    double temp;
 
@@ -826,6 +1148,8 @@ inline std::istream& operator >> ( std::istream & is, Fixpoint &fp )
 //
 // Math functions.
 //
+// They're friends, up in the class.
+//
 // ====================================================
 
 /*
@@ -837,134 +1161,6 @@ int _fix_do_mul_div(int a,int b,int c);
    modify [eax edx];
 */
 
-inline Fixpoint mul_div(Fixpoint a,Fixpoint b,Fixpoint c)
-{  Fixpoint r;
-   r.val = fix_mul_div(a.val,b.val,c.val);
-   return r;
-}
-
-
-inline Fixpoint sqrt( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.val = fix_sqrt( a.val );
-
-   return ans;
-}
-
-
-inline Fixpoint exp(Fixpoint a)
-{  Fixpoint ans;
-   ans.val=fix_exp(a.val);
-   return ans;
-}
-
-inline int floor( Fixpoint a )
-{
-   return a.val >> SHIFTUP;
-}
-
-inline Fixpoint sin( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.val = fix_sin( a.to_fixang() );
-
-   return ans;
-}
-
-inline Fixpoint cos( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.val = fix_cos( a.to_fixang() );
-
-   return ans;
-}
-
-inline Fixpoint tan( Fixpoint a )
-{
-   Fixpoint sn, cs;
-
-   sn = sin( a );
-   cs = cos( a );
-   if (cs == 0)
-      return 0;
-   else
-      return sn/cs;
-}
-
-inline Fixpoint asin( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.fixang_to( fix_asin( a.to_fix() ) );
-
-   return ans;
-}
-
-inline Fixpoint acos( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.fixang_to( fix_acos( a.to_fix() ) );
-
-   return ans;
-}
-
-inline void sincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs )
-{
-   fix fsn, fcs;
-   fix_sincos( ang.to_fixang(), &fsn, &fcs );
-   sn->val = fsn;
-   cs->val = fcs;
-}
-
-inline Fixpoint atan2( Fixpoint y, Fixpoint x )
-{
-   Fixpoint ans;
-
-   ans.fixang_to( fix_atan2( y.to_fix(), x.to_fix() ) );
-
-   return ans;
-}
-
-
-inline Fixpoint fsin( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.val = fix_fastsin( a.to_fixang() );
-
-   return ans;
-}
-
-inline Fixpoint fcos( Fixpoint a )
-{
-   Fixpoint ans;
-
-   ans.val = fix_fastcos( a.to_fixang() );
-
-   return ans;
-}
-
-inline void fsincos( Fixpoint ang, Fixpoint *sn, Fixpoint *cs )
-{
-   fix fsn, fcs;
-   fix_fastsincos( ang.to_fixang(), &fsn, &fcs );
-   sn->val = fsn;
-   cs->val = fcs;
-}
-
-inline Fixpoint abs( Fixpoint fp )
-{
-   Fixpoint ans;
-
-   ans.val = labs( fp.val );
-
-   return ans;
-}
 
 
 
@@ -977,7 +1173,9 @@ inline Fixpoint abs( Fixpoint fp )
 
 #ifdef FIXDEBUG
 
-void touch( Fixpoint& );
+void touch( Q& );
+
+char *bitdump( Q & );
 
 #endif /* FIXDEBUG */
 
@@ -0,0 +1,439 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+/*
+ * fixppvec.h
+ *
+ * 3- and 4-vectors and 3x3 matrices of Fixpoints: Q3, Q4 and Q3x3.
+ *
+ * The elements are packed 32-bit fixes, four to a vector (a Q3 has a zero
+ * in the fourth), so with SSE4.1 every operation is a handful of vector
+ * instructions.  Without it the same thing is done one element at a time:
+ * SSE2 alone has no signed 32x32->64 multiply, and patching up its unsigned
+ * one loses to plain 64-bit imuls.
+ *
+ * Products are rounded the way a Q expression rounds them: dot(a,b) gives
+ * exactly a[0]*b[0] + a[1]*b[1] + a[2]*b[2], rounded once, and so on for
+ * cross and matrix times vector.
+ */
+
+#ifndef __FIXPPVEC_H
+#define __FIXPPVEC_H
+
+#include "fixpp.h"
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+
+// ======================================
+//
+// The packed arithmetic.
+//
+// ======================================
+
+template <int Shift>
+struct Fixpoint_lanes
+{
+   // (w + half) >> Shift, like Fixpoint_wide.
+   static fix narrow( int64_t w )
+   { return (fix)((w + ((int64_t) 1 << (Shift - 1))) >> Shift); }
+
+   static fix mul( fix a, fix b )
+   { return narrow( (int64_t) a * b ); }
+
+   // dst = a + b, a - b, a * s
+   static void add( fix *dst, const fix *a, const fix *b );
+   static void sub( fix *dst, const fix *a, const fix *b );
+   static void scale( fix *dst, const fix *a, fix s );
+
+   // sum of a[i]*b[i] over the four lanes, rounded once
+   static fix dot( const fix *a, const fix *b );
+
+   // a x b in the first three lanes, 0 in the fourth
+   static void cross( fix *dst, const fix *a, const fix *b );
+
+   // dst[i] = dot( m[i], v ) for three rows
+   static void transform( fix *dst, const fix (*m)[4], const fix *v );
+};
+
+
+#ifdef __SSE4_1__
+
+// Signed 32x32->64 multiply of lanes 0 and 2.
+inline __m128i fixpp_mul_even( __m128i a, __m128i b )
+{
+   return _mm_mul_epi32( a, b );
+}
+
+inline __m128i fixpp_mul_odd( __m128i a, __m128i b )
+{
+   return fixpp_mul_even( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+}
+
+inline __m128i fixpp_load( const fix *p )
+{
+   return _mm_loadu_si128( (const __m128i *) p );
+}
+
+inline void fixpp_store( fix *p, __m128i v )
+{
+   _mm_storeu_si128( (__m128i *) p, v );
+}
+
+// Round and shift 64-bit lanes.  Only the low 32 bits of each result are
+// kept, so a logical shift does as well as an arithmetic one.
+template <int Shift>
+inline __m128i fixpp_narrow64( __m128i w )
+{
+   return _mm_srli_epi64( _mm_add_epi64( w, _mm_set1_epi64x( (int64_t) 1 << (Shift - 1) ) ), Shift );
+}
+
+// Back to four 32-bit lanes from the even and odd products.
+template <int Shift>
+inline __m128i fixpp_narrow( __m128i even, __m128i odd )
+{
+   const __m128i lomask = _mm_set_epi32( 0, -1, 0, -1 );
+
+   return _mm_or_si128( _mm_and_si128( fixpp_narrow64<Shift>( even ), lomask ),
+                        _mm_slli_epi64( fixpp_narrow64<Shift>( odd ), 32 ) );
+}
+
+// (lane 0 + lane 1, lane 2 + lane 3) of a times b, as two 64-bit sums.
+inline __m128i fixpp_pair_sums( __m128i a, __m128i b )
+{
+   return _mm_add_epi64( fixpp_mul_even( a, b ), fixpp_mul_odd( a, b ) );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::add( fix *dst, const fix *a, const fix *b )
+{
+   fixpp_store( dst, _mm_add_epi32( fixpp_load( a ), fixpp_load( b ) ) );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::sub( fix *dst, const fix *a, const fix *b )
+{
+   fixpp_store( dst, _mm_sub_epi32( fixpp_load( a ), fixpp_load( b ) ) );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::scale( fix *dst, const fix *a, fix s )
+{
+   __m128i va = fixpp_load( a ), vs = _mm_set1_epi32( s );
+
+   fixpp_store( dst, fixpp_narrow<Shift>( fixpp_mul_even( va, vs ), fixpp_mul_odd( va, vs ) ) );
+}
+
+template <int Shift>
+inline fix Fixpoint_lanes<Shift>::dot( const fix *a, const fix *b )
+{
+   __m128i s = fixpp_pair_sums( fixpp_load( a ), fixpp_load( b ) );
+
+   s = _mm_add_epi64( s, _mm_unpackhi_epi64( s, s ) );
+   return _mm_cvtsi128_si32( fixpp_narrow64<Shift>( s ) );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::cross( fix *dst, const fix *a, const fix *b )
+{
+   __m128i va = fixpp_load( a ), vb = fixpp_load( b );
+
+   // (y,z,x) * (z,x,y) - (z,x,y) * (y,z,x), the fourth lanes stay w*w - w*w
+   __m128i a1 = _mm_shuffle_epi32( va, _MM_SHUFFLE(3,0,2,1) );
+   __m128i b1 = _mm_shuffle_epi32( vb, _MM_SHUFFLE(3,1,0,2) );
+   __m128i a2 = _mm_shuffle_epi32( va, _MM_SHUFFLE(3,1,0,2) );
+   __m128i b2 = _mm_shuffle_epi32( vb, _MM_SHUFFLE(3,0,2,1) );
+
+   __m128i even = _mm_sub_epi64( fixpp_mul_even( a1, b1 ), fixpp_mul_even( a2, b2 ) );
+   __m128i odd = _mm_sub_epi64( fixpp_mul_odd( a1, b1 ), fixpp_mul_odd( a2, b2 ) );
+
+   fixpp_store( dst, _mm_and_si128( fixpp_narrow<Shift>( even, odd ), _mm_set_epi32( 0, -1, -1, -1 ) ) );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::transform( fix *dst, const fix (*m)[4], const fix *v )
+{
+   __m128i vv = fixpp_load( v );
+   __m128i s0 = fixpp_pair_sums( fixpp_load( m[0] ), vv );
+   __m128i s1 = fixpp_pair_sums( fixpp_load( m[1] ), vv );
+   __m128i s2 = fixpp_pair_sums( fixpp_load( m[2] ), vv );
+
+   // rows 0 and 1 side by side, then row 2
+   __m128i r01 = fixpp_narrow64<Shift>( _mm_add_epi64( _mm_unpacklo_epi64( s0, s1 ), _mm_unpackhi_epi64( s0, s1 ) ) );
+   __m128i r2 = fixpp_narrow64<Shift>( _mm_add_epi64( s2, _mm_unpackhi_epi64( s2, s2 ) ) );
+
+   fixpp_store( dst, _mm_unpacklo_epi64( _mm_shuffle_epi32( r01, _MM_SHUFFLE(3,1,2,0) ),
+                                         _mm_and_si128( r2, _mm_set_epi32( 0, 0, 0, -1 ) ) ) );
+}
+
+#else /* !__SSE4_1__ */
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::add( fix *dst, const fix *a, const fix *b )
+{
+   for (int i = 0; i < 4; ++i)
+      dst[i] = a[i] + b[i];
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::sub( fix *dst, const fix *a, const fix *b )
+{
+   for (int i = 0; i < 4; ++i)
+      dst[i] = a[i] - b[i];
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::scale( fix *dst, const fix *a, fix s )
+{
+   for (int i = 0; i < 4; ++i)
+      dst[i] = mul( a[i], s );
+}
+
+template <int Shift>
+inline fix Fixpoint_lanes<Shift>::dot( const fix *a, const fix *b )
+{
+   return narrow( (int64_t) a[0] * b[0] + (int64_t) a[1] * b[1]
+                + (int64_t) a[2] * b[2] + (int64_t) a[3] * b[3] );
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::cross( fix *dst, const fix *a, const fix *b )
+{
+   fix x = narrow( (int64_t) a[1] * b[2] - (int64_t) a[2] * b[1] );
+   fix y = narrow( (int64_t) a[2] * b[0] - (int64_t) a[0] * b[2] );
+   fix z = narrow( (int64_t) a[0] * b[1] - (int64_t) a[1] * b[0] );
+
+   dst[0] = x;  dst[1] = y;  dst[2] = z;  dst[3] = 0;
+}
+
+template <int Shift>
+inline void Fixpoint_lanes<Shift>::transform( fix *dst, const fix (*m)[4], const fix *v )
+{
+   fix x = dot( m[0], v ), y = dot( m[1], v ), z = dot( m[2], v );
+
+   dst[0] = x;  dst[1] = y;  dst[2] = z;  dst[3] = 0;
+}
+
+#endif /* __SSE4_1__ */
+
+
+
+// ======================================
+//
+// Fixpoint3
+//
+// ======================================
+
+template <int Shift>
+class Fixpoint3
+{
+public:
+
+   // x, y, z and a zero, so the whole thing is one 128-bit load.
+   // ============================================================
+   fix v[4];
+
+   Fixpoint3() {}
+
+   Fixpoint3( Fixpoint<Shift> x, Fixpoint<Shift> y, Fixpoint<Shift> z )
+   { v[0] = x.val; v[1] = y.val; v[2] = z.val; v[3] = 0; }
+
+   // From an EDMS-style array of Fixpoints.
+   explicit Fixpoint3( const Fixpoint<Shift> *p )
+   { v[0] = p[0].val; v[1] = p[1].val; v[2] = p[2].val; v[3] = 0; }
+
+   Fixpoint<Shift> operator[]( int i ) const
+   { Fixpoint<Shift> r; r.val = v[i]; return r; }
+
+   void set( int i, Fixpoint<Shift> q ) { v[i] = q.val; }
+
+   void to( Fixpoint<Shift> *p ) const
+   { p[0].val = v[0]; p[1].val = v[1]; p[2].val = v[2]; }
+
+   Fixpoint3& operator+=( const Fixpoint3 & b )
+   { Fixpoint_lanes<Shift>::add( v, v, b.v ); return *this; }
+
+   Fixpoint3& operator-=( const Fixpoint3 & b )
+   { Fixpoint_lanes<Shift>::sub( v, v, b.v ); return *this; }
+
+   Fixpoint3& operator*=( Fixpoint<Shift> s )
+   { Fixpoint_lanes<Shift>::scale( v, v, s.val ); return *this; }
+
+   friend Fixpoint3 operator+( const Fixpoint3 & a, const Fixpoint3 & b )
+   { Fixpoint3 r; Fixpoint_lanes<Shift>::add( r.v, a.v, b.v ); return r; }
+
+   friend Fixpoint3 operator-( const Fixpoint3 & a, const Fixpoint3 & b )
+   { Fixpoint3 r; Fixpoint_lanes<Shift>::sub( r.v, a.v, b.v ); return r; }
+
+   Fixpoint3 operator-( void ) const
+   { Fixpoint3 r; Fixpoint3 zero( 0, 0, 0 ); Fixpoint_lanes<Shift>::sub( r.v, zero.v, v ); return r; }
+
+   friend Fixpoint3 operator*( const Fixpoint3 & a, Fixpoint<Shift> s )
+   { Fixpoint3 r; Fixpoint_lanes<Shift>::scale( r.v, a.v, s.val ); return r; }
+
+   friend Fixpoint3 operator*( Fixpoint<Shift> s, const Fixpoint3 & a )
+   { Fixpoint3 r; Fixpoint_lanes<Shift>::scale( r.v, a.v, s.val ); return r; }
+
+   friend Fixpoint<Shift> dot( const Fixpoint3 & a, const Fixpoint3 & b )
+   { Fixpoint<Shift> r; r.val = Fixpoint_lanes<Shift>::dot( a.v, b.v ); return r; }
+
+   friend Fixpoint3 cross( const Fixpoint3 & a, const Fixpoint3 & b )
+   { Fixpoint3 r; Fixpoint_lanes<Shift>::cross( r.v, a.v, b.v ); return r; }
+
+   int operator==( const Fixpoint3 & b ) const
+   { return v[0] == b.v[0] && v[1] == b.v[1] && v[2] == b.v[2]; }
+
+   int operator!=( const Fixpoint3 & b ) const
+   { return !(*this == b); }
+};
+
+
+
+// ======================================
+//
+// Fixpoint4
+//
+// ======================================
+
+template <int Shift>
+class Fixpoint4
+{
+public:
+
+   fix v[4];
+
+   Fixpoint4() {}
+
+   Fixpoint4( Fixpoint<Shift> x, Fixpoint<Shift> y, Fixpoint<Shift> z, Fixpoint<Shift> w )
+   { v[0] = x.val; v[1] = y.val; v[2] = z.val; v[3] = w.val; }
+
+   explicit Fixpoint4( const Fixpoint<Shift> *p )
+   { v[0] = p[0].val; v[1] = p[1].val; v[2] = p[2].val; v[3] = p[3].val; }
+
+   Fixpoint<Shift> operator[]( int i ) const
+   { Fixpoint<Shift> r; r.val = v[i]; return r; }
+
+   void set( int i, Fixpoint<Shift> q ) { v[i] = q.val; }
+
+   void to( Fixpoint<Shift> *p ) const
+   { p[0].val = v[0]; p[1].val = v[1]; p[2].val = v[2]; p[3].val = v[3]; }
+
+   Fixpoint4& operator+=( const Fixpoint4 & b )
+   { Fixpoint_lanes<Shift>::add( v, v, b.v ); return *this; }
+
+   Fixpoint4& operator-=( const Fixpoint4 & b )
+   { Fixpoint_lanes<Shift>::sub( v, v, b.v ); return *this; }
+
+   Fixpoint4& operator*=( Fixpoint<Shift> s )
+   { Fixpoint_lanes<Shift>::scale( v, v, s.val ); return *this; }
+
+   friend Fixpoint4 operator+( const Fixpoint4 & a, const Fixpoint4 & b )
+   { Fixpoint4 r; Fixpoint_lanes<Shift>::add( r.v, a.v, b.v ); return r; }
+
+   friend Fixpoint4 operator-( const Fixpoint4 & a, const Fixpoint4 & b )
+   { Fixpoint4 r; Fixpoint_lanes<Shift>::sub( r.v, a.v, b.v ); return r; }
+
+   Fixpoint4 operator-( void ) const
+   { Fixpoint4 r; Fixpoint4 zero( 0, 0, 0, 0 ); Fixpoint_lanes<Shift>::sub( r.v, zero.v, v ); return r; }
+
+   friend Fixpoint4 operator*( const Fixpoint4 & a, Fixpoint<Shift> s )
+   { Fixpoint4 r; Fixpoint_lanes<Shift>::scale( r.v, a.v, s.val ); return r; }
+
+   friend Fixpoint4 operator*( Fixpoint<Shift> s, const Fixpoint4 & a )
+   { Fixpoint4 r; Fixpoint_lanes<Shift>::scale( r.v, a.v, s.val ); return r; }
+
+   friend Fixpoint<Shift> dot( const Fixpoint4 & a, const Fixpoint4 & b )
+   { Fixpoint<Shift> r; r.val = Fixpoint_lanes<Shift>::dot( a.v, b.v ); return r; }
+
+   int operator==( const Fixpoint4 & b ) const
+   { return v[0] == b.v[0] && v[1] == b.v[1] && v[2] == b.v[2] && v[3] == b.v[3]; }
+
+   int operator!=( const Fixpoint4 & b ) const
+   { return !(*this == b); }
+};
+
+
+
+// ======================================
+//
+// Fixpoint3x3
+//
+// ======================================
+
+template <int Shift>
+class Fixpoint3x3
+{
+public:
+
+   // Rows, each padded like a Fixpoint3.
+   // ===================================
+   fix m[3][4];
+
+   Fixpoint3x3() {}
+
+   Fixpoint3x3( const Fixpoint3<Shift> & r0, const Fixpoint3<Shift> & r1, const Fixpoint3<Shift> & r2 )
+   {
+      for (int i = 0; i < 4; ++i)
+      {
+         m[0][i] = r0.v[i];  m[1][i] = r1.v[i];  m[2][i] = r2.v[i];
+      }
+   }
+
+   Fixpoint3<Shift> row( int i ) const
+   { Fixpoint3<Shift> r; for (int j = 0; j < 4; ++j) r.v[j] = m[i][j]; return r; }
+
+   Fixpoint<Shift> operator()( int i, int j ) const
+   { Fixpoint<Shift> r; r.val = m[i][j]; return r; }
+
+   void set( int i, int j, Fixpoint<Shift> q ) { m[i][j] = q.val; }
+
+   Fixpoint3x3 transpose( void ) const
+   {
+      Fixpoint3x3 t;
+      for (int i = 0; i < 3; ++i)
+      {
+         for (int j = 0; j < 3; ++j)
+            t.m[i][j] = m[j][i];
+         t.m[i][3] = 0;
+      }
+      return t;
+   }
+
+   friend Fixpoint3<Shift> operator*( const Fixpoint3x3 & a, const Fixpoint3<Shift> & b )
+   { Fixpoint3<Shift> r; Fixpoint_lanes<Shift>::transform( r.v, a.m, b.v ); return r; }
+
+   friend Fixpoint3x3 operator*( const Fixpoint3x3 & a, const Fixpoint3x3 & b )
+   {
+      Fixpoint3x3 bt = b.transpose(), r;
+
+      // row i of a*b is bt times row i of a
+      for (int i = 0; i < 3; ++i)
+         Fixpoint_lanes<Shift>::transform( r.m[i], bt.m, a.m[i] );
+      return r;
+   }
+};
+
+
+typedef Fixpoint3<SHIFTUP> Q3;
+typedef Fixpoint4<SHIFTUP> Q4;
+typedef Fixpoint3x3<SHIFTUP> Q3x3;
+
+
+#endif /* !__FIXPPVEC_H */
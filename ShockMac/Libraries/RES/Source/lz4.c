@@ -0,0 +1,391 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		LZ4.C		LZ4 compressor/expander
+
+//	This is the LZ4 block format: a run of sequences, each a token byte,
+//	literal bytes, and a match to copy from earlier output.
+//
+//		token:   high 4 bits literal count, low 4 bits match length - 4
+//					(15 in either means more count bytes follow, each added
+//					in, until one isn't 255)
+//		literals
+//		offset:  2 bytes, little-endian, how far back the match starts
+//		match length count bytes, if any
+//
+//	The last sequence has literals only, and the last 5 bytes of data are
+//	always literals, so the expander can stop on running out of input.
+//	The compressor is the greedy single-hash one; it keeps no state
+//	between calls, so threads may use it freely.
+
+#include <string.h>
+
+#include "lz4.h"
+
+#define LZ4_HASHBITS 12					// size of compressor's hash table
+#define LZ4_MINMATCH 4					// shortest match
+#define LZ4_LASTLITERALS 5				// last bytes always literals
+#define LZ4_MFLIMIT 12					// last match starts this far from end
+#define LZ4_MAXOFFSET 65535			// farthest back match can be
+
+#define Lz4Read32(p) Lz4GetU32(p)
+#define Lz4Hash(v) ((uint32_t) ((v) * 2654435761U) >> (32 - LZ4_HASHBITS))
+
+//	# count bytes after token for a length
+
+#define Lz4CountBytes(count) ((count) >= 15 ? ((count) - 15) / 255 + 1 : 0)
+
+//	Output count bytes for a length of 15 or more
+
+#define Lz4PutCount(op,count) { \
+	int32_t n = (count) - 15; \
+	while (n >= 255) \
+		{ \
+		*op++ = 255; \
+		n -= 255; \
+		} \
+	*op++ = n; \
+	}
+
+//	Input count bytes for a length of 15, giving up if run out
+
+#define Lz4GetCount(ip,ipEnd,count) { \
+	uint8_t b; \
+	do \
+		{ \
+		if (ip >= ipEnd) \
+			return(-1); \
+		b = *ip++; \
+		count += b; \
+		} \
+	while (b == 255); \
+	}
+
+//	-----------------------------------------------------------
+//
+//	Lz4Compress() compresses a buffer.
+//
+//		psrc        = ptr to data to compress
+//		srcSize     = # bytes to compress
+//		pdest       = ptr to output buffer
+//		destSizeMax = size of output buffer (LZ4_MAXSIZE(srcSize) always fits)
+//
+//	Returns: # bytes of compressed data, header included, or -1 if it
+//		doesn't fit
+
+int32_t Lz4Compress(uint8_t *psrc, int32_t srcSize, uint8_t *pdest,
+	int32_t destSizeMax)
+{
+	int32_t table[1 << LZ4_HASHBITS];
+	uint8_t *ip, *ipEnd, *anchor, *ref;
+	uint8_t *mfLimit, *matchLimit;
+	uint8_t *op, *opEnd, *token;
+	int32_t litLength, matchLength, size;
+	uint32_t h;
+
+//	Set up
+
+	if (destSizeMax < LZ4_HEADERSIZE + 1)
+		return(-1);
+	memset(table, 0, sizeof(table));
+	ip = anchor = psrc;
+	ipEnd = psrc + srcSize;
+	mfLimit = ipEnd - LZ4_MFLIMIT;
+	matchLimit = ipEnd - LZ4_LASTLITERALS;
+	op = pdest + LZ4_HEADERSIZE;
+	opEnd = pdest + destSizeMax;
+
+//	Find matches, where there's room for them
+
+	if (srcSize > LZ4_MFLIMIT)
+		{
+		while (ip <= mfLimit)
+			{
+			h = Lz4Hash(Lz4Read32(ip));
+			ref = psrc + table[h];
+			table[h] = ip - psrc;
+			if (ref >= ip || ip - ref > LZ4_MAXOFFSET || Lz4Read32(ref) != Lz4Read32(ip))
+				{
+				ip += 1 + ((ip - anchor) >> 6);		// skip faster thru junk
+				continue;
+				}
+
+//	Got one, stretch it backwards over literals and forwards
+
+			while (ip > anchor && ref > psrc && ip[-1] == ref[-1])
+				{
+				ip--;
+				ref--;
+				}
+			matchLength = LZ4_MINMATCH;
+			while (ip + matchLength < matchLimit && ip[matchLength] == ref[matchLength])
+				matchLength++;
+
+//	Output sequence
+
+			litLength = ip - anchor;
+			if (op + 1 + Lz4CountBytes(litLength) + litLength + 2 +
+				Lz4CountBytes(matchLength - LZ4_MINMATCH) > opEnd)
+				return(-1);
+			token = op++;
+			*token = (litLength >= 15 ? 15 : litLength) << 4;
+			if (litLength >= 15)
+				Lz4PutCount(op, litLength);
+			memcpy(op, anchor, litLength);
+			op += litLength;
+			*op++ = (ip - ref) & 0xFF;
+			*op++ = (ip - ref) >> 8;
+			*token |= (matchLength - LZ4_MINMATCH >= 15 ? 15 : matchLength - LZ4_MINMATCH);
+			if (matchLength - LZ4_MINMATCH >= 15)
+				Lz4PutCount(op, matchLength - LZ4_MINMATCH);
+
+//	Skip past match, hashing a spot inside it for the next one
+
+			ip += matchLength;
+			anchor = ip;
+			if (ip <= mfLimit)
+				table[Lz4Hash(Lz4Read32(ip - 2))] = ip - 2 - psrc;
+			}
+		}
+
+//	Output last literals
+
+	litLength = ipEnd - anchor;
+	if (op + 1 + Lz4CountBytes(litLength) + litLength > opEnd)
+		return(-1);
+	token = op++;
+	*token = (litLength >= 15 ? 15 : litLength) << 4;
+	if (litLength >= 15)
+		Lz4PutCount(op, litLength);
+	memcpy(op, anchor, litLength);
+	op += litLength;
+
+//	Fill in header
+
+	size = op - pdest - LZ4_HEADERSIZE;
+	pdest[0] = size;
+	pdest[1] = size >> 8;
+	pdest[2] = size >> 16;
+	pdest[3] = size >> 24;
+
+	return(op - pdest);
+}
+
+//	-----------------------------------------------------------
+//
+//	Lz4Expand() expands compressed data.  Bad data can't make it read or
+//	write outside the buffers given.
+//
+//		psrc     = ptr to compressed data
+//		srcSize  = # bytes there (more than the header says is fine)
+//		pdest    = ptr to output buffer
+//		destSize = size of output buffer, expansion stops when full
+//
+//	Returns: # bytes expanded, or -1 if data is bad
+
+int32_t Lz4Expand(uint8_t *psrc, int32_t srcSize, uint8_t *pdest,
+	int32_t destSize)
+{
+	uint8_t *ip, *ipEnd, *op, *opEnd, *match;
+	int32_t length, offset;
+	uint8_t token;
+	uint64_t w;
+
+//	Set up
+
+	if (srcSize < LZ4_HEADERSIZE)
+		return(-1);
+	ip = psrc + LZ4_HEADERSIZE;
+	ipEnd = psrc + srcSize;
+	if (Lz4Size(psrc) >= LZ4_HEADERSIZE && Lz4Size(psrc) < srcSize)
+		ipEnd = psrc + Lz4Size(psrc);
+	op = pdest;
+	opEnd = pdest + destSize;
+
+	while (ip < ipEnd)
+		{
+
+//	Get literals.  With room to spare both sides, copy 16 at a time.
+
+		token = *ip++;
+		length = token >> 4;
+		if (length == 15)
+			Lz4GetCount(ip, ipEnd, length);
+		if (length > ipEnd - ip)
+			return(-1);
+		if (length > opEnd - op)
+			{
+			memcpy(op, ip, opEnd - op);
+			return(destSize);
+			}
+		if (length <= 16 && ipEnd - ip >= 16 && opEnd - op >= 16)
+			{
+			memcpy(&w, ip, 8);
+			memcpy(op, &w, 8);
+			memcpy(&w, ip + 8, 8);
+			memcpy(op + 8, &w, 8);
+			}
+		else
+			memcpy(op, ip, length);
+		ip += length;
+		op += length;
+
+//	Last sequence has no match
+
+		if (ip >= ipEnd)
+			break;
+
+//	Get match
+
+		if (ipEnd - ip < 2)
+			return(-1);
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op - pdest)
+			return(-1);
+		match = op - offset;
+		length = token & 15;
+		if (length == 15)
+			Lz4GetCount(ip, ipEnd, length);
+		length += LZ4_MINMATCH;
+
+//	Copy it.  Matches 8 or more back can go 8 bytes at a time, since
+//	each load is done before the store which could overlap it.
+
+		if (length > opEnd - op)
+			{
+			while (op < opEnd)
+				*op++ = *match++;
+			return(destSize);
+			}
+		if (offset >= 8 && opEnd - op >= length + 8)
+			{
+			uint8_t *opStop = op + length;
+			do
+				{
+				memcpy(&w, match, 8);
+				memcpy(op, &w, 8);
+				op += 8;
+				match += 8;
+				}
+			while (op < opStop);
+			op = opStop;
+			}
+		else
+			{
+			while (length-- > 0)
+				*op++ = *match++;
+			}
+		}
+
+	return(op - pdest);
+}
+
+//	-----------------------------------------------------------
+//
+//	Lz4CompressItems() compresses items one by one (see lz4.h).
+//
+//		psrc        = ptr to data holding items
+//		offsets     = offset of each item from psrc, and of end (numItems + 1)
+//		numItems    = # items
+//		pdest       = ptr to output buffer
+//		destSizeMax = size of output buffer
+//
+//	Returns: # bytes of compressed data, table included, or -1 if it
+//		doesn't fit
+
+int32_t Lz4CompressItems(uint8_t *psrc, int32_t *offsets, int32_t numItems,
+	uint8_t *pdest, int32_t destSizeMax)
+{
+	int32_t item, pos, size;
+
+	pos = LZ4_ITEMTABLESIZE(numItems);
+	if (pos > destSizeMax)
+		return(-1);
+
+	for (item = 0; item <= numItems; item++)
+		{
+		pdest[item * 4] = pos;
+		pdest[item * 4 + 1] = pos >> 8;
+		pdest[item * 4 + 2] = pos >> 16;
+		pdest[item * 4 + 3] = pos >> 24;
+		if (item == numItems)
+			break;
+		size = Lz4Compress(psrc + offsets[item], offsets[item + 1] - offsets[item],
+			pdest + pos, destSizeMax - pos);
+		if (size < 0)
+			return(-1);
+		pos += size;
+		}
+
+	return(pos);
+}
+
+//	-----------------------------------------------------------
+//
+//	Lz4ExpandItem() expands one item compressed by Lz4CompressItems().
+//
+//		psrc     = ptr to compressed items (item table)
+//		srcSize  = # bytes there
+//		item     = which item
+//		pdest    = ptr to output buffer
+//		destSize = size of output buffer, expansion stops when full
+//
+//	Returns: # bytes expanded, or -1 if data is bad
+
+int32_t Lz4ExpandItem(uint8_t *psrc, int32_t srcSize, int32_t item,
+	uint8_t *pdest, int32_t destSize)
+{
+	int32_t pos, end;
+
+	if (item < 0 || LZ4_ITEMTABLESIZE(item + 1) > srcSize)
+		return(-1);
+	pos = LZ4_ITEMOFFSET(psrc, item);
+	end = LZ4_ITEMOFFSET(psrc, item + 1);
+	if (pos < LZ4_ITEMTABLESIZE(item + 1) || end < pos || end > srcSize)
+		return(-1);
+
+	return(Lz4Expand(psrc + pos, end - pos, pdest, destSize));
+}
+
+//	-----------------------------------------------------------
+//
+//	Lz4ExpandItems() expands all items compressed by Lz4CompressItems().
+//
+//		psrc     = ptr to compressed items (item table)
+//		srcSize  = # bytes there
+//		offsets  = offset of each item from pdest, and of end (numItems + 1)
+//		numItems = # items
+//		pdest    = ptr to output buffer
+//
+//	Returns: 0 if all expanded, -1 if data is bad
+
+int32_t Lz4ExpandItems(uint8_t *psrc, int32_t srcSize, int32_t *offsets,
+	int32_t numItems, uint8_t *pdest)
+{
+	int32_t item, size;
+
+	for (item = 0; item < numItems; item++)
+		{
+		size = offsets[item + 1] - offsets[item];
+		if (Lz4ExpandItem(psrc, srcSize, item, pdest + offsets[item], size) != size)
+			return(-1);
+		}
+
+	return(0);
+}
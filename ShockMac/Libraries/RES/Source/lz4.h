@@ -0,0 +1,68 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		LZ4.H		Header file for LZ4 compressor/expander (see lz4.c for info)
+
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#include "lg.h"
+
+//	An LZ4 resource is a 4-byte little-endian count of the bytes that
+//	follow it, then one block in the LZ4 block format.  It expands a few
+//	times faster than LZW, at some cost in size.
+
+#define LZ4_HEADERSIZE 4			// size of byte count before block
+
+//	Most bytes compressing srcSize bytes can take (incompressible data)
+
+#define LZ4_MAXSIZE(srcSize) (LZ4_HEADERSIZE + (srcSize) + ((srcSize) / 255) + 16)
+
+int32_t Lz4Compress(uint8_t *psrc, int32_t srcSize, uint8_t *pdest,
+	int32_t destSizeMax);						// compress, returns size or -1
+int32_t Lz4Expand(uint8_t *psrc, int32_t srcSize, uint8_t *pdest,
+	int32_t destSize);							// expand, returns size or -1
+
+//	4-byte little-endian value, built unsigned so a high top byte is safe
+
+#define Lz4GetU32(p) ((uint32_t) (p)[0] | ((uint32_t) (p)[1] << 8) | \
+	((uint32_t) (p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+
+//	Total size of compressed data, header included, from its header
+
+#define Lz4Size(psrc) ((int32_t) (LZ4_HEADERSIZE + Lz4GetU32(psrc)))
+
+//	Items (of a compound resource) can be compressed one by one, so any one
+//	can be expanded alone.  Compressed items start with a table of
+//	numItems + 1 4-byte little-endian offsets, from the table start, of
+//	each item's compressed data and of the end; each item's data is as
+//	above.  Item offsets are from psrc, or pdest on expanding.
+
+#define LZ4_ITEMTABLESIZE(numItems) (((numItems) + 1) * 4)
+#define LZ4_ITEMOFFSET(ptab,item) Lz4Get32((ptab) + (item) * 4)
+#define Lz4Get32(p) ((int32_t) Lz4GetU32(p))
+
+int32_t Lz4CompressItems(uint8_t *psrc, int32_t *offsets, int32_t numItems,
+	uint8_t *pdest, int32_t destSizeMax);	// compress items, returns size or -1
+int32_t Lz4ExpandItem(uint8_t *psrc, int32_t srcSize, int32_t item,
+	uint8_t *pdest, int32_t destSize);		// expand one item, returns size or -1
+int32_t Lz4ExpandItems(uint8_t *psrc, int32_t srcSize, int32_t *offsets,
+	int32_t numItems, uint8_t *pdest);		// expand all, returns 0 or -1
+
+#endif
+
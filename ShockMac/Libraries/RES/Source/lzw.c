@@ -70,6 +70,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //						skipping the first n1 destination bytes and then taking
 //						the next n2).
 //
+//		LzwExpandBlock() - Expands a compressed block which is already in
+//						memory into a flat buffer.  Same output as LzwExpand(),
+//						but no callbacks: codes come straight out of a bit
+//						buffer, and whole strings are copied from earlier output.
+//
+//		LzwContextCreate(), LzwContextDestroy() - Make and free a context,
+//						which holds all the tables and state of compression
+//						and expansion.  LzwContextCompress(), LzwContextExpand()
+//						and LzwContextExpandBlock() work just like the routines
+//						above with a context of their own, so they may run on
+//						several threads at once.  The plain routines use a
+//						default context (whose buffer is the one set above).
+//
 //		Lzw.h supplies a large set of macros of the form:
 //
 //			LzwCompressSrc2Dest(...)  and  LzweExpandSrc2Dest(...)
@@ -85,7 +98,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 //		User sources supply two functions of the form:
 //
-//		void f_SrcCtrl(int32_t srcLoc, LzwCtrl ctrl);
+//		void f_SrcCtrl(intptr_t srcLoc, LzwCtrl ctrl);
 //		uint8_t f_SrcGet();
 //
 //		The control function is used to set up and tear down the Get()
@@ -100,7 +113,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 //		User destinations work similarly.  Again, two functions:
 //
-//		void f_DestCtrl(int32_t destLoc, LzwCtrl ctrl);
+//		void f_DestCtrl(intptr_t destLoc, LzwCtrl ctrl);
 //		void f_DestPut(uint8_t byte);
 //
 //		The control function is called with BEGIN and END just like the
@@ -140,25 +153,86 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define HASHING_SHIFT (LZW_BITS-8)			// # bits to shift when hashing
 #define FLUSH_PAUSE 1000						// wait on full table before flush
 
-//	Overall lzw buffer info
+//	Per-thread variables, for the context the standard sources and
+//	destinations are working for
+
+#if defined(__GNUC__)
+#define LZW_THREAD __thread
+#elif defined(_MSC_VER)
+#define LZW_THREAD __declspec(thread)
+#else
+#define LZW_THREAD
+#endif
 
-void *lzwBuffer;						// total buffer
-bool lzwBufferMalloced;				// buffer malloced?
+//	Compression state
 
-//	Global tables used for compression & expansion
+typedef struct {
+	uint32_t next_code;		// next available string code
+	uint32_t character;		// current character read from source
+	uint32_t string_code;	// current string compress code
+	uint32_t index;			// index into string table
+	int32_t lzwInputCharCount;		// input character count
+	int32_t lzwOutputSize;			// current size of output
+	int32_t lzwOutputBitCount;		// current bit location in output
+	uint32_t lzwOutputBitBuffer;	// 32-bit buffer holding output bits
+} LzwC;
 
-int16_t *lzwCodeValue;					// code value array
-uint16_t *lzwPrefixCode;				// prefix code array
-uint8_t *lzwAppendChar;				// appended chars array
-uint8_t *lzwDecodeStack;				// decoded string
+//	Expansion state
+
+typedef struct {
+	int32_t lzwInputBitCount;
+	uint32_t lzwInputBitBuffer;
+	uint32_t next_code;		// next available string code
+	uint32_t new_code;		// next code from source
+	uint32_t old_code;		// last code gotten from source
+	uint32_t character;		// current char for string stack
+	uint8_t *string;					// used to output string in reverse order
+	int32_t outputSize;				// size of uncompressed data
+	int32_t destSkip;					// # bytes to skip over
+	int32_t destSize;					// destination size
+} LzwE;
 
-uint8_t *lzwFdReadBuff;				// buffer for file descriptor source
-uint8_t *lzwFdWriteBuff;				// buffer for file descriptor dest
+//	An lzw context holds all the state of one compression or expansion
+
+struct LzwContext_ {
+	void *buffer;						// total buffer
+	bool bufferMalloced;				// buffer malloced?
+
+	int16_t *codeValue;				// code value array
+	uint16_t *prefixCode;			// prefix code array
+	uint8_t *appendChar;				// appended chars array
+	uint8_t *decodeStack;			// decoded string
+	uint8_t *fdReadBuff;				// buffer for file descriptor source
+	uint8_t *fdWriteBuff;			// buffer for file descriptor dest
+
+	LzwC c;								// current compress state
+	LzwE e;								// current expand state
+
+	uint8_t *buffSrcPtr;				// standard sources and destinations
+	int32_t fdSrc;
+	int32_t readBuffIndex;
+	FILE *fpSrc;
+	uint8_t *buffDestPtr;
+	intptr_t fdDest;
+	int32_t writeBuffIndex;
+	FILE *fpDest;
+
+	uint8_t *stringPtr[MAX_VALUE + 1];		// block expand: where each code's string is
+	uint16_t stringLength[MAX_VALUE + 1];	// block expand: length of each code's string
+	uint8_t charString[256 + 16];			// block expand: strings for codes 0-255
+};
+
+static LzwContext lzwDefault;					// used by the plain routines
+static LZW_THREAD LzwContext *lzwCurr;		// used by standard srcs & dests
 
 //	Prototypes of internal routines
 
-int32_t LzwFindMatch(int32_t hash_prefix, uint32_t hash_character);
-uint8_t *LzwDecodeString(uint8_t *buffer, uint32_t code);
+static int32_t LzwSetContextBuffer(LzwContext *plc, void *buff, int32_t buffSize);
+static int32_t LzwMallocContextBuffer(LzwContext *plc);
+static void LzwFreeContextBuffer(LzwContext *plc);
+static void LzwInitBlockTable(LzwContext *plc);
+int32_t LzwFindMatch(LzwContext *plc, int32_t hash_prefix, uint32_t hash_character);
+uint8_t *LzwDecodeString(LzwContext *plc, uint8_t *buffer, uint32_t code);
 
 //	--------------------------------------------------------
 //		INITIALIZATION AND TERMINATION
@@ -182,6 +256,44 @@ void LzwTerm( void )
 	LzwFreeBuffer();
 }
 
+//	------------------------------------------------------------
+//		CONTEXTS
+//	------------------------------------------------------------
+//
+//	LzwContextCreate() allocates a new context and its buffer.  Each
+//	context may be used by one thread at a time.
+//
+//	Returns: ptr to context, or NULL if out of memory
+
+LzwContext *LzwContextCreate(void)
+{
+	LzwContext *plc;
+
+	plc = (LzwContext *) calloc(1, sizeof(LzwContext));
+	if (plc == NULL)
+		return(NULL);
+	if (LzwMallocContextBuffer(plc) < 0)
+		{
+		free(plc);
+		return(NULL);
+		}
+	LzwInitBlockTable(plc);
+	return(plc);
+}
+
+//	------------------------------------------------------------
+//
+//	LzwContextDestroy() frees a context and its buffer.
+
+void LzwContextDestroy(LzwContext *plc)
+{
+	if (plc)
+		{
+		LzwFreeContextBuffer(plc);
+		free(plc);
+		}
+}
+
 //	------------------------------------------------------------
 //		BUFFER SETTING
 //	--------------------------------------------------------
@@ -191,6 +303,35 @@ void LzwTerm( void )
 //	Returns: 0 if ok, -1 if buffer not ok
 
 int32_t LzwSetBuffer(void *buff, int32_t buffSize)
+{
+	return(LzwSetContextBuffer(&lzwDefault, buff, buffSize));
+}
+
+//	------------------------------------------------------------
+//
+//	LzwMallocBuffer() allocates buffer with Malloc.
+//
+//	Returns: 0 if success, -1 if error.
+
+int32_t LzwMallocBuffer()
+{
+	return(LzwMallocContextBuffer(&lzwDefault));
+}
+
+//	------------------------------------------------------------
+//
+//	LzwFreeBuffer() frees buffer.
+
+void LzwFreeBuffer()
+{
+	LzwFreeContextBuffer(&lzwDefault);
+}
+
+//	------------------------------------------------------------
+//
+//	LzwSetContextBuffer() splits a buffer up into a context's tables.
+
+static int32_t LzwSetContextBuffer(LzwContext *plc, void *buff, int32_t buffSize)
 {
 //	Check buffer size
 
@@ -202,32 +343,30 @@ int32_t LzwSetBuffer(void *buff, int32_t buffSize)
 
 //	De-allocate current buffer if malloced
 
-	LzwTerm();
+	LzwFreeContextBuffer(plc);
 
 //	Set buffer pointers
 
-	lzwBuffer = buff;
-	lzwDecodeStack = lzwBuffer;
-	lzwFdReadBuff = ((uint8_t *) lzwDecodeStack) + LZW_DECODE_STACK_SIZE;
-	lzwFdWriteBuff = ((uint8_t *) lzwFdWriteBuff) + LZW_FD_READ_BUFF_SIZE;
-	lzwCodeValue = (int16_t *) (((uint8_t *) lzwDecodeStack) + LZW_FD_WRITE_BUFF_SIZE);
-	lzwPrefixCode = (uint16_t *) (((uint8_t *) lzwCodeValue) + (LZW_TABLE_SIZE * sizeof(uint16_t)));
-	lzwAppendChar = ((uint8_t *) lzwPrefixCode) + (LZW_TABLE_SIZE * sizeof(uint16_t));
-	lzwBufferMalloced = FALSE;
+	plc->buffer = buff;
+	plc->decodeStack = plc->buffer;
+	plc->fdReadBuff = plc->decodeStack + LZW_DECODE_STACK_SIZE;
+	plc->fdWriteBuff = plc->fdReadBuff + LZW_FD_READ_BUFF_SIZE;
+	plc->codeValue = (int16_t *) (plc->fdWriteBuff + LZW_FD_WRITE_BUFF_SIZE);
+	plc->prefixCode = (uint16_t *) (((uint8_t *) plc->codeValue) + (LZW_TABLE_SIZE * sizeof(uint16_t)));
+	plc->appendChar = ((uint8_t *) plc->prefixCode) + (LZW_TABLE_SIZE * sizeof(uint16_t));
+	plc->bufferMalloced = FALSE;
 	return(0);
 }
 
 //	------------------------------------------------------------
 //
-//	LzwMallocBuffer() allocates buffer with Malloc.
-//
-//	Returns: 0 if success, -1 if error.
+//	LzwMallocContextBuffer() allocates a context's buffer with Malloc.
 
-int32_t LzwMallocBuffer()
+static int32_t LzwMallocContextBuffer(LzwContext *plc)
 {
 	void *buff;
 
-	if ((lzwBuffer == NULL) || (!lzwBufferMalloced))
+	if ((plc->buffer == NULL) || (!plc->bufferMalloced))
 		{
 		buff = malloc(LZW_BUFF_SIZE);
 		if (buff == NULL)
@@ -237,8 +376,8 @@ int32_t LzwMallocBuffer()
 			}
 		else
 			{
-			LzwSetBuffer(buff, LZW_BUFF_SIZE);
-			lzwBufferMalloced = TRUE;
+			LzwSetContextBuffer(plc, buff, LZW_BUFF_SIZE);
+			plc->bufferMalloced = TRUE;
 			}
 		}
 	return(0);
@@ -246,15 +385,15 @@ int32_t LzwMallocBuffer()
 
 //	------------------------------------------------------------
 //
-//	LzwFreeBuffer() frees buffer.
+//	LzwFreeContextBuffer() frees a context's buffer.
 
-void LzwFreeBuffer()
+static void LzwFreeContextBuffer(LzwContext *plc)
 {
-	if (lzwBufferMalloced)
+	if (plc->bufferMalloced)
 		{
-		free(lzwBuffer);
-		lzwBuffer = NULL;
-		lzwBufferMalloced = FALSE;
+		free(plc->buffer);
+		plc->buffer = NULL;
+		plc->bufferMalloced = FALSE;
 		}
 }
 
@@ -278,76 +417,86 @@ void LzwFreeBuffer()
 //
 //	Returns: actual output compressed size, or -1 if exceeded outputSizeMax
 //		(in which case compression has been aborted)
+//
+//	LzwContextCompress() is the same, using the given context.
+
+int32_t LzwCompress(
+	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
+	uint8_t (*f_SrcGet)(),						// func to get bytes from source
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
+	int32_t srcSize,								// size of source in bytes
+	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
+	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
+	int32_t destSizeMax							// max size of dest (or LZW_MAXSIZE)
+)
+{
+	return(LzwContextCompress(&lzwDefault, f_SrcCtrl, f_SrcGet, srcLoc, srcSize,
+		f_DestCtrl, f_DestPut, destLoc, destSizeMax));
+}
 
 //	This macro is used to accumulate output codes into a bit buffer
 //	and call the destination put routine whenever more than 8 bits
 //	are available.  If the output data size ever exceeds the alloted
 //	size, the source and destination are shut down and -1 is returned.
 
-typedef struct {
-	uint32_t next_code;		// next available string code
-	uint32_t character;		// current character read from source
-	uint32_t string_code;	// current string compress code
-	uint32_t index;			// index into string table
-	int32_t lzwInputCharCount;		// input character count
-	int32_t lzwOutputSize;			// current size of output
-	int32_t lzwOutputBitCount;		// current bit location in output
-	uint32_t lzwOutputBitBuffer;	// 32-bit buffer holding output bits
-} LzwC;
-
-LzwC lzwc;		// current compress state
-
 #define LzwOutputCode(code) { \
-	lzwc.lzwOutputBitBuffer |= ((uint32_t) code) << (32-LZW_BITS-lzwc.lzwOutputBitCount); \
-	lzwc.lzwOutputBitCount += LZW_BITS; \
-	while (lzwc.lzwOutputBitCount >= 8) \
+	plc->c.lzwOutputBitBuffer |= ((uint32_t) code) << (32-LZW_BITS-plc->c.lzwOutputBitCount); \
+	plc->c.lzwOutputBitCount += LZW_BITS; \
+	while (plc->c.lzwOutputBitCount >= 8) \
 		{ \
-		(*f_DestPut)(lzwc.lzwOutputBitBuffer >> 24); \
-		if (++lzwc.lzwOutputSize > destSizeMax) \
+		(*f_DestPut)(plc->c.lzwOutputBitBuffer >> 24); \
+		if (++plc->c.lzwOutputSize > destSizeMax) \
 			{ \
 			(*f_SrcCtrl)(srcLoc, END); \
 			(*f_DestCtrl)(destLoc, END); \
+			lzwCurr = prevCurr; \
 			return -1L; \
 			} \
-		lzwc.lzwOutputBitBuffer <<= 8; \
-		lzwc.lzwOutputBitCount -= 8; \
+		plc->c.lzwOutputBitBuffer <<= 8; \
+		plc->c.lzwOutputBitCount -= 8; \
 		} \
 }
 
-int32_t LzwCompress(
+int32_t LzwContextCompress(
+	LzwContext *plc,								// context to compress with
 	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
 	uint8_t (*f_SrcGet)(),						// func to get bytes from source
-	int32_t srcLoc,								// source "location" (ptr, FILE *, etc.)
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
 	int32_t srcSize,								// size of source in bytes
 	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
 	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
-	int32_t destLoc,								// dest "location" (ptr, FILE *, etc.)
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
 	int32_t destSizeMax							// max size of dest (or LZW_MAXSIZE)
 )
 {
+	LzwContext *prevCurr;
 
 //	If not already initialized, do it
 
-	if (lzwBuffer == NULL)
+	if (plc->buffer == NULL)
 		{
-		if (LzwMallocBuffer() < 0)
+		if (LzwMallocContextBuffer(plc) < 0)
 			return(0);
 		}
 
 //	Set up for compress loop
 
-	lzwc.next_code = 256;             // skip over real 256 char values
-	memset(lzwCodeValue, -1, sizeof(int16_t) * LZW_TABLE_SIZE);
+	prevCurr = lzwCurr;
+	lzwCurr = plc;
+
+	plc->c.next_code = 256;             // skip over real 256 char values
+	memset(plc->codeValue, -1, sizeof(int16_t) * LZW_TABLE_SIZE);
 
-	lzwc.lzwOutputSize = 0;
-	lzwc.lzwOutputBitCount = 0;
-	lzwc.lzwOutputBitBuffer = 0;
+	plc->c.lzwOutputSize = 0;
+	plc->c.lzwOutputBitCount = 0;
+	plc->c.lzwOutputBitBuffer = 0;
 
 	(*f_SrcCtrl)(srcLoc, BEGIN);
 	(*f_DestCtrl)(destLoc, BEGIN);
 
-	lzwc.string_code = (*f_SrcGet)();
-	lzwc.lzwInputCharCount = 1;
+	plc->c.string_code = (*f_SrcGet)();
+	plc->c.lzwInputCharCount = 1;
 
 // This is the main loop where it all happens.  This loop runs until all of
 // the input has been exhausted.  Note that it stops adding codes to the
@@ -358,48 +507,48 @@ int32_t LzwCompress(
 
 //	Get next input char, if read all data then exit loop
 
-		lzwc.character = (*f_SrcGet)();
-		if (lzwc.lzwInputCharCount++ >= srcSize)
+		plc->c.character = (*f_SrcGet)();
+		if (plc->c.lzwInputCharCount++ >= srcSize)
 			break;
 
 //	See if string is in string table.  If it is, get the code value.
 
-		lzwc.index = LzwFindMatch(lzwc.string_code, lzwc.character);
-		if (lzwCodeValue[lzwc.index] != -1)
-			lzwc.string_code = lzwCodeValue[lzwc.index];
+		plc->c.index = LzwFindMatch(plc, plc->c.string_code, plc->c.character);
+		if (plc->codeValue[plc->c.index] != -1)
+			plc->c.string_code = plc->codeValue[plc->c.index];
 
 //	Else if string not in string table, try to add it.
 
 		else
 			{
-			if (lzwc.next_code <= MAX_CODE)
+			if (plc->c.next_code <= MAX_CODE)
 				{
-				lzwCodeValue[lzwc.index] = lzwc.next_code++;
-				lzwPrefixCode[lzwc.index] = lzwc.string_code;
-				lzwAppendChar[lzwc.index] = lzwc.character;
-				LzwOutputCode(lzwc.string_code);
-				lzwc.string_code = lzwc.character;
+				plc->codeValue[plc->c.index] = plc->c.next_code++;
+				plc->prefixCode[plc->c.index] = plc->c.string_code;
+				plc->appendChar[plc->c.index] = plc->c.character;
+				LzwOutputCode(plc->c.string_code);
+				plc->c.string_code = plc->c.character;
 				}
 
 //	Else if table is full and has been for a while, flush it, and drain
 //	the code value table too.
 
-			else if (lzwc.next_code > MAX_CODE + FLUSH_PAUSE)
+			else if (plc->c.next_code > MAX_CODE + FLUSH_PAUSE)
 				{
-				LzwOutputCode(lzwc.string_code);
+				LzwOutputCode(plc->c.string_code);
 				LzwOutputCode(FLUSH_CODE);
-				memset(lzwCodeValue, -1, sizeof(int16_t) * LZW_TABLE_SIZE);
-			   lzwc.string_code = lzwc.character;
-				lzwc.next_code = 256;
+				memset(plc->codeValue, -1, sizeof(int16_t) * LZW_TABLE_SIZE);
+			   plc->c.string_code = plc->c.character;
+				plc->c.next_code = 256;
 				}
 
 //	Else if can't add but table not full, just output the code.
 
 			else
 				{
-				lzwc.next_code++;
-				LzwOutputCode(lzwc.string_code);
-				lzwc.string_code = lzwc.character;
+				plc->c.next_code++;
+				LzwOutputCode(plc->c.string_code);
+				plc->c.string_code = plc->c.character;
 				}
 			}
 		}
@@ -407,7 +556,7 @@ int32_t LzwCompress(
 //	Done with processing loop, output current code, end-of-data code,
 //	and a final 0 to flush the buffer.
 
-	LzwOutputCode(lzwc.string_code);
+	LzwOutputCode(plc->c.string_code);
 	LzwOutputCode(MAX_VALUE);
 	LzwOutputCode(0);
 
@@ -416,7 +565,8 @@ int32_t LzwCompress(
 	(*f_SrcCtrl)(srcLoc, END);
 	(*f_DestCtrl)(destLoc, END);
 
-	return(lzwc.lzwOutputSize);
+	lzwCurr = prevCurr;
+	return(plc->c.lzwOutputSize);
 }
 
 //	-----------------------------------------------------------
@@ -438,69 +588,75 @@ int32_t LzwCompress(
 //		destSize     = # bytes of output to store (if 0, everything)
 //
 //	Returns: # bytes in uncompressed output
+//
+//	LzwContextExpand() is the same, using the given context.
 
-typedef struct {
-	int32_t lzwInputBitCount;
-	uint32_t lzwInputBitBuffer;
-	uint32_t next_code;		// next available string code
-	uint32_t new_code;		// next code from source
-	uint32_t old_code;		// last code gotten from source
-	uint32_t character;		// current char for string stack
-	uint8_t *string;					// used to output string in reverse order
-	int32_t outputSize;				// size of uncompressed data
-	int32_t destSkip;					// # bytes to skip over
-	int32_t destSize;					// destination size
-} LzwE;
-
-LzwE lzwe;		// current expand state
-
+int32_t LzwExpand(
+	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
+	uint8_t (*f_SrcGet)(),						// func to get bytes from source
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
+	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
+	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
+	int32_t destSkip,								// # dest bytes to skip over (or 0)
+	int32_t destSize								// # dest bytes to capture (if 0, all)
+)
+{
+	return(LzwContextExpand(&lzwDefault, f_SrcCtrl, f_SrcGet, srcLoc,
+		f_DestCtrl, f_DestPut, destLoc, destSkip, destSize));
+}
 
-static uint32_t LzwInputCode(uint8_t (*f_SrcGet)())
+static uint32_t LzwInputCode(LzwContext *plc, uint8_t (*f_SrcGet)())
 {
 	uint32_t return_value;
 
-	while (lzwe.lzwInputBitCount <= 24)
+	while (plc->e.lzwInputBitCount <= 24)
 		{
-		lzwe.lzwInputBitBuffer |= ((uint32_t) (*f_SrcGet)()) << (24 - lzwe.lzwInputBitCount);
-		lzwe.lzwInputBitCount += 8;
+		plc->e.lzwInputBitBuffer |= ((uint32_t) (*f_SrcGet)()) << (24 - plc->e.lzwInputBitCount);
+		plc->e.lzwInputBitCount += 8;
 		}
-	return_value = lzwe.lzwInputBitBuffer >> (32 - LZW_BITS);
+	return_value = plc->e.lzwInputBitBuffer >> (32 - LZW_BITS);
 
-	lzwe.lzwInputBitBuffer <<= LZW_BITS;
-	lzwe.lzwInputBitCount -= LZW_BITS;
+	plc->e.lzwInputBitBuffer <<= LZW_BITS;
+	plc->e.lzwInputBitCount -= LZW_BITS;
 
 	return(return_value);
 }
 
-
-int32_t LzwExpand(
+int32_t LzwContextExpand(
+	LzwContext *plc,								// context to expand with
 	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
 	uint8_t (*f_SrcGet)(),						// func to get bytes from source
-	int32_t srcLoc,								// source "location" (ptr, FILE *, etc.)
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
 	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
 	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
-	int32_t destLoc,								// dest "location" (ptr, FILE *, etc.)
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
 	int32_t destSkip,								// # dest bytes to skip over (or 0)
 	int32_t destSize								// # dest bytes to capture (if 0, all)
 )
 {
+	LzwContext *prevCurr;
+	LzwE *pe = &plc->e;
 
 //	If not already initialized, do it
 
-	if (lzwBuffer == NULL)
+	if (plc->buffer == NULL)
 		{
-		if (LzwMallocBuffer() < 0)
+		if (LzwMallocContextBuffer(plc) < 0)
 			return(0);
 		}
 
 //	Set up for expansion loop
 
-	lzwe.lzwInputBitCount = 0;
-	lzwe.lzwInputBitBuffer = 0;
-	lzwe.next_code = 256;			// next available char after regular 256 chars
-	lzwe.outputSize = 0;
-	lzwe.destSkip = destSkip;
-	lzwe.destSize = destSize ? destSize : LZW_MAXSIZE;
+	prevCurr = lzwCurr;
+	lzwCurr = plc;
+
+	pe->lzwInputBitCount = 0;
+	pe->lzwInputBitBuffer = 0;
+	pe->next_code = 256;			// next available char after regular 256 chars
+	pe->outputSize = 0;
+	pe->destSkip = destSkip;
+	pe->destSize = destSize ? destSize : LZW_MAXSIZE;
 
 //	Notify the control routines
 
@@ -509,32 +665,32 @@ int32_t LzwExpand(
 
 //	Get first code & output it.
 
-	lzwe.old_code = LzwInputCode(f_SrcGet);
-	lzwe.character = lzwe.old_code;
+	pe->old_code = LzwInputCode(plc, f_SrcGet);
+	pe->character = pe->old_code;
 
-	if (--lzwe.destSkip < 0)
+	if (--pe->destSkip < 0)
 		{
-		(*f_DestPut)(lzwe.old_code); lzwe.outputSize++;
+		(*f_DestPut)(pe->old_code); pe->outputSize++;
 		}
 
 //	This is the expansion loop.  It reads in codes from the source until
 //	it sees the special end-of-data code.
 
-	while ((lzwe.new_code = LzwInputCode(f_SrcGet)) != MAX_VALUE)
+	while ((pe->new_code = LzwInputCode(plc, f_SrcGet)) != MAX_VALUE)
 		{
 
 //	If flush code, flush the string table & restart from top of loop
 
-		if (lzwe.new_code == FLUSH_CODE)
+		if (pe->new_code == FLUSH_CODE)
 			{
-			lzwe.next_code = 256;
-			lzwe.old_code = LzwInputCode(f_SrcGet);
-			lzwe.character = lzwe.old_code;
-			if (--lzwe.destSkip < 0)
+			pe->next_code = 256;
+			pe->old_code = LzwInputCode(plc, f_SrcGet);
+			pe->character = pe->old_code;
+			if (--pe->destSkip < 0)
 				{
-				if (lzwe.outputSize++ >= lzwe.destSize)
+				if (pe->outputSize++ >= pe->destSize)
 					break;
-				(*f_DestPut)(lzwe.old_code);
+				(*f_DestPut)(pe->old_code);
 				}
 			continue;
 			}
@@ -543,42 +699,42 @@ int32_t LzwExpand(
 //	generates an undefined code.  Handle it by decoding the last code,
 //	adding a single character to the end of the decode string.
 
-		if (lzwe.new_code >= lzwe.next_code)
+		if (pe->new_code >= pe->next_code)
 			{
-			*lzwDecodeStack = lzwe.character;
-			lzwe.string = LzwDecodeString(lzwDecodeStack + 1, lzwe.old_code);
+			*plc->decodeStack = pe->character;
+			pe->string = LzwDecodeString(plc, plc->decodeStack + 1, pe->old_code);
 			}
 
 //	Otherwise we do a straight decode of the new code.
 
 		else
 			{
-			lzwe.string = LzwDecodeString(lzwDecodeStack, lzwe.new_code);
+			pe->string = LzwDecodeString(plc, plc->decodeStack, pe->new_code);
 			}
 
 //	Output the decode string to the destination, in reverse order.
 
-		lzwe.character = *lzwe.string;
-		while (lzwe.string >= lzwDecodeStack)
+		pe->character = *pe->string;
+		while (pe->string >= plc->decodeStack)
 			{
-			if (--lzwe.destSkip < 0)
+			if (--pe->destSkip < 0)
 				{
-				if (lzwe.outputSize++ >= lzwe.destSize)
+				if (pe->outputSize++ >= pe->destSize)
 					goto DONE_EXPAND;
-				(*f_DestPut)(*lzwe.string);
+				(*f_DestPut)(*pe->string);
 				}
-			--lzwe.string;
+			--pe->string;
 			}
 
 //	If possible, add a new code to the string table.
 
-		if (lzwe.next_code <= MAX_CODE)
+		if (pe->next_code <= MAX_CODE)
 			{
-			lzwPrefixCode[lzwe.next_code] = lzwe.old_code;
-			lzwAppendChar[lzwe.next_code] = lzwe.character;
-			lzwe.next_code++;
+			plc->prefixCode[pe->next_code] = pe->old_code;
+			plc->appendChar[pe->next_code] = pe->character;
+			pe->next_code++;
 			}
-		lzwe.old_code = lzwe.new_code;
+		pe->old_code = pe->new_code;
 		}
 
 //	When break out of expansion loop, shut down source & dest & return size.
@@ -588,7 +744,188 @@ DONE_EXPAND:
 	(*f_SrcCtrl)(srcLoc, END);
 	(*f_DestCtrl)(destLoc, END);
 
-	return(lzwe.outputSize);
+	lzwCurr = prevCurr;
+	return(pe->outputSize);
+}
+
+//	-----------------------------------------------------------
+//
+//	LzwExpandBlock() expands a compressed block in memory into a flat
+//	buffer.  Since all output is in one place, every code's string is
+//	already sitting in the destination (it was output once before, and
+//	extended by one char on the next output), so the string table just
+//	records where and how long, and decoding a code is a copy.
+//
+//		psrc     = ptr to compressed data
+//		srcSize  = size of compressed data (reads past this see 0 bits)
+//		pdest    = ptr to destination buffer
+//		destSize = # bytes of output to store (if 0, everything)
+//
+//	Returns: # bytes in uncompressed output
+//
+//	LzwContextExpandBlock() is the same, using the given context.
+
+int32_t LzwExpandBlock(uint8_t *psrc, int32_t srcSize, uint8_t *pdest, int32_t destSize)
+{
+	return(LzwContextExpandBlock(&lzwDefault, psrc, srcSize, pdest, destSize));
+}
+
+//	Gets next code from the 64-bit bit buffer, topping it up 7 bytes at
+//	a time (the unused low bits after a top-up are the next source bits,
+//	so or-ing them in again on the next top-up is harmless).
+
+#define LzwBlockInputCode(code) { \
+	if (bitCount < LZW_BITS) \
+		{ \
+		if (srcEnd - src >= 8) \
+			{ \
+			bitBuffer |= LzwLoad64(src) >> bitCount; \
+			src += (63 - bitCount) >> 3; \
+			bitCount |= 56; \
+			} \
+		else \
+			{ \
+			while (bitCount <= 56) \
+				{ \
+				bitBuffer |= ((uint64_t) (src < srcEnd ? *src++ : 0)) << (56 - bitCount); \
+				bitCount += 8; \
+				} \
+			} \
+		} \
+	code = (uint32_t) (bitBuffer >> (64 - LZW_BITS)); \
+	bitBuffer <<= LZW_BITS; \
+	bitCount -= LZW_BITS; \
+}
+
+static inline uint64_t LzwLoad64(const uint8_t *p)
+{
+	return ((uint64_t) p[0] << 56) | ((uint64_t) p[1] << 48) |
+		((uint64_t) p[2] << 40) | ((uint64_t) p[3] << 32) |
+		((uint64_t) p[4] << 24) | ((uint64_t) p[5] << 16) |
+		((uint64_t) p[6] << 8) | (uint64_t) p[7];
+}
+
+int32_t LzwContextExpandBlock(LzwContext *plc, uint8_t *psrc, int32_t srcSize,
+	uint8_t *pdest, int32_t destSize)
+{
+	uint8_t *src, *srcEnd;
+	uint8_t *out, *outEnd, *from;
+	uint64_t bitBuffer, w0, w1;
+	int32_t bitCount;
+	uint32_t next_code, new_code, code;
+	uint8_t *oldString;
+	uint32_t oldLength, length;
+
+//	First time through, point the single char codes at their strings
+
+	if (plc->stringLength[0] == 0)
+		LzwInitBlockTable(plc);
+
+//	Set up, get first code & output it
+
+	src = psrc;
+	srcEnd = psrc + srcSize;
+	out = pdest;
+	outEnd = pdest + (destSize ? destSize : LZW_MAXSIZE);
+	bitBuffer = 0;
+	bitCount = 0;
+
+	LzwBlockInputCode(code);
+	next_code = 256;
+	oldString = out;
+	oldLength = 1;
+	*out++ = code;
+
+//	Expansion loop, until end-of-data code
+
+	while (TRUE)
+		{
+		LzwBlockInputCode(new_code);
+		if (new_code == MAX_VALUE)
+			break;
+
+//	If flush code, flush the string table & output next code as a char
+
+		if (new_code == FLUSH_CODE)
+			{
+			LzwBlockInputCode(code);
+			if (out >= outEnd)
+				break;
+			next_code = 256;
+			oldString = out;
+			oldLength = 1;
+			*out++ = code;
+			continue;
+			}
+
+//	Find string: in the table, or for the special STRING+CHARACTER+STRING+
+//	CHARACTER+STRING case, the last string plus its own first char.
+
+		if (new_code < next_code)
+			{
+			from = plc->stringPtr[new_code];
+			length = plc->stringLength[new_code];
+			}
+		else
+			{
+			from = oldString;
+			length = oldLength + 1;
+			}
+
+//	Copy it.  Short strings are copied 16 bytes at a time, which is safe
+//	since all loads are done before the stores.  The special case string
+//	overlaps its last char with its own first one, fixed up afterwards.
+
+		if ((int32_t) length > outEnd - out)
+			{
+			while (out < outEnd)
+				*out++ = *from++;
+			break;
+			}
+		if (length <= 16 && outEnd - out >= 16)
+			{
+			memcpy(&w0, from, 8);
+			memcpy(&w1, from + 8, 8);
+			memcpy(out, &w0, 8);
+			memcpy(out + 8, &w1, 8);
+			}
+		else
+			memmove(out, from, length);
+		if (new_code >= next_code)
+			out[length - 1] = *from;
+
+//	If possible, add a new code to the string table: the last string
+//	plus the first char of this one, which is right where it was output.
+
+		if (next_code <= MAX_CODE)
+			{
+			plc->stringPtr[next_code] = oldString;
+			plc->stringLength[next_code] = oldLength + 1;
+			next_code++;
+			}
+		oldString = out;
+		oldLength = length;
+		out += length;
+		}
+
+	return(out - pdest);
+}
+
+//	-----------------------------------------------------------
+//
+//	LzwInitBlockTable() points a context's single char codes at their
+//	strings, for the block expander.
+
+static void LzwInitBlockTable(LzwContext *plc)
+{
+	uint32_t code;
+
+	for (code = 0; code < 256; code++)
+		{
+		plc->charString[code] = code;
+		plc->stringPtr[code] = &plc->charString[code];
+		plc->stringLength[code] = 1;
+		}
 }
 
 //	--------------------------------------------------------------
@@ -598,17 +935,15 @@ DONE_EXPAND:
 //	LzwBuffSrcCtrl() and LzwBuffSrcGet() implement a memory buffer
 //	source for lzw compression and expansion.
 
-static uint8_t *lzwBuffSrcPtr;
-
 void LzwBuffSrcCtrl(intptr_t srcLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
-		lzwBuffSrcPtr = (uint8_t *) srcLoc;
+		lzwCurr->buffSrcPtr = (uint8_t *) srcLoc;
 }
 
 uint8_t LzwBuffSrcGet()
 {
-	return(*lzwBuffSrcPtr++);
+	return(*lzwCurr->buffSrcPtr++);
 }
 
 //	---------------------------------------------------------------
@@ -616,26 +951,23 @@ uint8_t LzwBuffSrcGet()
 //	LzwFdSrcCtrl() and LzwFdSrcGet() implement a file-descriptor
 //	source (fd = open()) for lzw compression and expansion.
 
-static int32_t lzwFdSrc;
-static int32_t lzwReadBuffIndex;
-
 void LzwFdSrcCtrl(intptr_t srcLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
 		{
-		lzwFdSrc = (int) srcLoc;
-		lzwReadBuffIndex = LZW_FD_READ_BUFF_SIZE;
+		lzwCurr->fdSrc = (int) srcLoc;
+		lzwCurr->readBuffIndex = LZW_FD_READ_BUFF_SIZE;
 		}
 }
 
 uint8_t LzwFdSrcGet()
 {
-	if (lzwReadBuffIndex == LZW_FD_READ_BUFF_SIZE)
+	if (lzwCurr->readBuffIndex == LZW_FD_READ_BUFF_SIZE)
 		{
-		read(lzwFdSrc, lzwFdReadBuff, LZW_FD_READ_BUFF_SIZE);
-		lzwReadBuffIndex = 0;
+		read(lzwCurr->fdSrc, lzwCurr->fdReadBuff, LZW_FD_READ_BUFF_SIZE);
+		lzwCurr->readBuffIndex = 0;
 		}
-	return(lzwFdReadBuff[lzwReadBuffIndex++]);
+	return(lzwCurr->fdReadBuff[lzwCurr->readBuffIndex++]);
 }
 
 //	---------------------------------------------------------------
@@ -643,17 +975,15 @@ uint8_t LzwFdSrcGet()
 //	LzwFpSrcCtrl() and LzwFpSrcGet() implement a file-ptr source
 //	(fp = fopen()) for lzw compression and expansion.
 
-static FILE *lzwFpSrc;
-
 void LzwFpSrcCtrl(intptr_t srcLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
-		lzwFpSrc = (FILE *) srcLoc;
+		lzwCurr->fpSrc = (FILE *) srcLoc;
 }
 
 uint8_t LzwFpSrcGet()
 {
-	return(fgetc(lzwFpSrc));
+	return(fgetc(lzwCurr->fpSrc));
 }
 
 //	---------------------------------------------------------------
@@ -663,17 +993,15 @@ uint8_t LzwFpSrcGet()
 //	LzwBuffDestCtrl() and LzwBuffDestPut() implement a memory
 //	buffer destination for lzw compression and expansion.
 
-static uint8_t *lzwBuffDestPtr;
-
 void LzwBuffDestCtrl(intptr_t destLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
-		lzwBuffDestPtr = (uint8_t *) destLoc;
+		lzwCurr->buffDestPtr = (uint8_t *) destLoc;
 }
 
 void LzwBuffDestPut(uint8_t byte)
 {
-	*lzwBuffDestPtr++ = byte;
+	*lzwCurr->buffDestPtr++ = byte;
 }
 
 //	---------------------------------------------------------------
@@ -681,30 +1009,27 @@ void LzwBuffDestPut(uint8_t byte)
 //	LzwFdDestCtrl() and LzwFdDestPut() implement a file-descriptor
 //	destination (fd = open()) for lzw compression and expansion.
 
-static intptr_t lzwFdDest;
-static int32_t lzwWriteBuffIndex;
-
 void LzwFdDestCtrl(intptr_t destLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
 		{
-		lzwFdDest = (int) destLoc;
-		lzwWriteBuffIndex = 0;
+		lzwCurr->fdDest = (int) destLoc;
+		lzwCurr->writeBuffIndex = 0;
 		}
 	else if (ctrl == END)
 		{
-		if (lzwWriteBuffIndex)
-			write(lzwFdDest, lzwFdWriteBuff, lzwWriteBuffIndex);
+		if (lzwCurr->writeBuffIndex)
+			write(lzwCurr->fdDest, lzwCurr->fdWriteBuff, lzwCurr->writeBuffIndex);
 		}
 }
 
 void LzwFdDestPut(uint8_t byte)
 {
-	lzwFdWriteBuff[lzwWriteBuffIndex++] = byte;
-	if (lzwWriteBuffIndex == LZW_FD_WRITE_BUFF_SIZE)
+	lzwCurr->fdWriteBuff[lzwCurr->writeBuffIndex++] = byte;
+	if (lzwCurr->writeBuffIndex == LZW_FD_WRITE_BUFF_SIZE)
 		{
-		write(lzwFdDest, lzwFdWriteBuff, LZW_FD_WRITE_BUFF_SIZE);
-		lzwWriteBuffIndex = 0;
+		write(lzwCurr->fdDest, lzwCurr->fdWriteBuff, LZW_FD_WRITE_BUFF_SIZE);
+		lzwCurr->writeBuffIndex = 0;
 		}
 }
 
@@ -713,17 +1038,15 @@ void LzwFdDestPut(uint8_t byte)
 //	LzwFpDestCtrl() and LzwFpDestPut() implement a file-ptr destination
 //	(fp = fopen()) for lzw compression and expansion.
 
-static FILE *lzwFpDest;
-
 void LzwFpDestCtrl(intptr_t destLoc, LzwCtrl ctrl)
 {
 	if (ctrl == BEGIN)
-		lzwFpDest = (FILE *) destLoc;
+		lzwCurr->fpDest = (FILE *) destLoc;
 }
 
 void LzwFpDestPut(uint8_t byte)
 {
-	fputc(byte, lzwFpDest);
+	fputc(byte, lzwCurr->fpDest);
 }
 
 //	---------------------------------------------------------------
@@ -754,7 +1077,7 @@ void LzwNullDestPut(uint8_t byte)
 //
 //	Returns: string table index
 
-int32_t LzwFindMatch(int32_t hash_prefix, uint32_t hash_character)
+int32_t LzwFindMatch(LzwContext *plc, int32_t hash_prefix, uint32_t hash_character)
 {
 	int32_t index;
 	int32_t offset;
@@ -766,10 +1089,10 @@ int32_t LzwFindMatch(int32_t hash_prefix, uint32_t hash_character)
 		offset = LZW_TABLE_SIZE - index;
 	while (1)
 		{
-		if (lzwCodeValue[index] == -1)
+		if (plc->codeValue[index] == -1)
 			return(index);
-		if ((lzwPrefixCode[index] == hash_prefix) &&
-			(lzwAppendChar[index] == hash_character))
+		if ((plc->prefixCode[index] == hash_prefix) &&
+			(plc->appendChar[index] == hash_character))
 				return(index);
 		index -= offset;
 		if (index < 0)
@@ -785,7 +1108,7 @@ int32_t LzwFindMatch(int32_t hash_prefix, uint32_t hash_character)
 //	storing it in a buffer.  The buffer can then be output in
 //	reverse order by the expansion program.
 
-uint8_t *LzwDecodeString(uint8_t *buffer, uint32_t code)
+uint8_t *LzwDecodeString(LzwContext *plc, uint8_t *buffer, uint32_t code)
 {
 #ifdef DBG_ON
 	int32_t i = 0;
@@ -793,8 +1116,8 @@ uint8_t *LzwDecodeString(uint8_t *buffer, uint32_t code)
 
 	while (code > 255)
 		{
-		*buffer++ = lzwAppendChar[code];
-		code = lzwPrefixCode[code];
+		*buffer++ = plc->appendChar[code];
+		code = plc->prefixCode[code];
 
 #ifdef DBG_ON
 		if (i++ >= 4094)
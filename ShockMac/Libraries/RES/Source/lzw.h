@@ -98,11 +98,11 @@ typedef enum {BEGIN,END} LzwCtrl;	// LzwCtrl's used to start/stop lzw
 int32_t LzwCompress(
 	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
 	uint8_t (*f_SrcGet)(),						// func to get bytes from source
-	int32_t srcLoc,								// source "location" (ptr, FILE *, etc.)
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
 	int32_t srcSize,								// size of source in bytes
 	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
 	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
-	int32_t destLoc,								// dest "location" (ptr, FILE *, etc.)
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
 	int32_t destSizeMax							// max size of dest (or LZW_MAXSIZE)
 	);
 
@@ -111,14 +111,58 @@ int32_t LzwCompress(
 int32_t LzwExpand(
 	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl),	// func to control source
 	uint8_t (*f_SrcGet)(),						// func to get bytes from source
-	int32_t srcLoc,								// source "location" (ptr, FILE *, etc.)
+	intptr_t srcLoc,							// source "location" (ptr, FILE *, etc.)
 	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl),	// func to control dest
 	void (*f_DestPut)(uint8_t byte),		// func to put bytes to dest
-	int32_t destLoc,								// dest "location" (ptr, FILE *, etc.)
+	intptr_t destLoc,							// dest "location" (ptr, FILE *, etc.)
 	int32_t destSkip,								// # dest bytes to skip over (or 0)
 	int32_t destSize								// # dest bytes to capture (if 0, all)
 	);
 
+//	And a quick expander for the common case of a compressed block which
+//	is already in memory (or mapped) going to a flat buffer.  It gives the
+//	same output as LzwExpandBuff2Buff(psrc, pdest, 0, destSize).
+
+int32_t LzwExpandBlock(
+	uint8_t *psrc,									// compressed data
+	int32_t srcSize,								// size of compressed data in bytes
+	uint8_t *pdest,								// dest buffer
+	int32_t destSize								// # dest bytes to capture (if 0, all)
+	);
+
+//	Lzw contexts.  All of the state of a compression or expansion lives
+//	in a context, so separate threads may compress or expand at the same
+//	time, each with its own context.  The routines above all use a default
+//	context.  User sources and destinations have to look after their own
+//	state if they are to be used by more than one thread.
+
+typedef struct LzwContext_ LzwContext;
+
+LzwContext *LzwContextCreate(void);			// malloc context & buffer (or NULL)
+void LzwContextDestroy(LzwContext *plc);		// free context & buffer
+
+int32_t LzwContextCompress(LzwContext *plc,
+	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl), uint8_t (*f_SrcGet)(),
+	intptr_t srcLoc, int32_t srcSize,
+	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl), void (*f_DestPut)(uint8_t byte),
+	intptr_t destLoc, int32_t destSizeMax);
+int32_t LzwContextExpand(LzwContext *plc,
+	void (*f_SrcCtrl)(intptr_t srcLoc, LzwCtrl ctrl), uint8_t (*f_SrcGet)(),
+	intptr_t srcLoc,
+	void (*f_DestCtrl)(intptr_t destLoc, LzwCtrl ctrl), void (*f_DestPut)(uint8_t byte),
+	intptr_t destLoc, int32_t destSkip, int32_t destSize);
+int32_t LzwContextExpandBlock(LzwContext *plc, uint8_t *psrc, int32_t srcSize,
+	uint8_t *pdest, int32_t destSize);
+
+//	Any of the macros below may be used with a context by calling the
+//	context routine with their arguments, for instance:
+
+#define LzwContextCompressBuff2Buff(plc, psrc, srcSize, pdest, destSizeMax) \
+	LzwContextCompress(plc, LzwBuffSrcC(psrc, srcSize), LzwBuffDestC(pdest, destSizeMax))
+
+#define LzwContextExpandBuff2Buff(plc, psrc, pdest, destSkip, destSize) \
+	LzwContextExpand(plc, LzwBuffSrcE(psrc), LzwBuffDestE(pdest, destSkip, destSize))
+
 //	Macros which implement all the varied compression forms, using the
 //	standard supplied sources and destinations, or user-supplied ones.
 //
@@ -220,7 +264,7 @@ int32_t LzwExpand(
 #define LzwBuffDestC(pdest,destSizeMax) LzwBuffDestCtrl, LzwBuffDestPut, (intptr_t) pdest, destSizeMax
 #define LzwFdDestC(fdDest) LzwFdDestCtrl, LzwFdDestPut, (intptr_t) fdDest, LZW_MAXSIZE
 #define LzwFpDestC(fpDest) LzwFpDestCtrl, LzwFpDestPut, (intptr_t) fpDest, LZW_MAXSIZE
-#define LzwNullDestC() LzwNullDestCtrl, LzwNullDestPut, NULL, LZW_MAXSIZE
+#define LzwNullDestC() LzwNullDestCtrl, LzwNullDestPut, (intptr_t) NULL, LZW_MAXSIZE
 
 
 //	Macros which implement all the varied expansionn forms, using the
@@ -331,7 +375,7 @@ int32_t LzwExpandFd2Buff(int fdSrc, uint8_t *pdest, int32_t destSkip, int32_t de
 #define LzwFpDestE(fpDest, destSkip, destSize) \
 	LzwFpDestCtrl, LzwFpDestPut, (intptr_t) fpDest, destSkip, destSize
 #define LzwNullDestE(destSkip, destSize) \
-	LzwNullDestCtrl, LzwNullDestPut, NULL, destSkip, destSize
+	LzwNullDestCtrl, LzwNullDestPut, (intptr_t) NULL, destSkip, destSize
 
 //	Prototypes of standard sources
 
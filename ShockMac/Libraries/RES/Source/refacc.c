@@ -35,11 +35,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
 */
 
-//#include <string.h>
+#include <string.h>
 
 #include "res.h"
 #include "res_.h"
 #include "lzw.h"
+#include "lz4.h"
 
 
 //	---------------------------------------------------------
@@ -64,12 +65,14 @@ void *RefLock(Ref ref)
 	//	Add to cumulative stats
 //	CUMSTATS(REFID(ref),numLocks);
 
-	//	Load block if not in RAM
+	//	Load item (or whole block) if not in RAM, else tell cache it's been used
 	prd = RESDESC(REFID(ref));
-	if (ResLoadResource(REFID(ref)) == NULL)
+	if (prd->ptr)
+		ResCacheUse(REFID(ref));
+	if (RefLoadItem(ref) == NULL)
 		return(NULL);
 	if (prd->lock == 0)
-		ResRemoveFromLRU(prd);
+		ResCacheLock(REFID(ref));
 
 	//	Tally stats
 //	DBG(DSRC_RES_Stat, {if (prd->lock == 0) resStat.numLocked++;});
@@ -116,13 +119,12 @@ void *RefGet(Ref ref)
 	//	Add to cumulative stats
 //	CUMSTATS(REFID(ref),numGets);
 
-	//	Get hold of ref
+	//	Get hold of ref (loading just its item, if it can be)
 	prd = RESDESC(REFID(ref));
-	if (ResLoadResource(REFID(ref)) == NULL) {
-		ResAddToTail(prd);
-	} else if (prd->lock == 0) {
-		ResMoveToTail(prd);
-	}
+	if (prd->ptr)
+		ResCacheUse(REFID(ref));
+	if (RefLoadItem(ref) == NULL)
+		return(NULL);
 
 	//	Index into ref table
 
@@ -205,11 +207,14 @@ RefTable *ResReadRefTable(Id id)
 	}
 
 	//	Seek to data, read numrefs, allocate table, read in offsets
+	//	(workers may be reading the same file)
+	ResLockFiles();
 	fseek(fd, RES_OFFSET_DESC2REAL(prd->offset), SEEK_SET);
 	fread(&numRefs, sizeof(RefIndex), 1, fd);
 	prt = malloc(REFTABLESIZE(numRefs));
 	prt->numRefs = numRefs;
 	fread(&prt->offset[0], sizeof(int32_t) * (numRefs + 1), 1, fd);
+	ResUnlockFiles();
 
 	return(prt);
 
@@ -248,14 +253,17 @@ int ResExtractRefTable(Id id, RefTable *prt, int32_t size)
 	}
 
 //	Seek to data, read numrefs, check table size, read in offsets
+	ResLockFiles();
 	fseek(fd, RES_OFFSET_DESC2REAL(prd->offset), SEEK_SET);
 	fread(&prt->numRefs, sizeof(RefIndex), 1, fd);
 	if (REFTABLESIZE(prt->numRefs) > size)
 	{
+		ResUnlockFiles();
 		Warning(("ResExtractRefTable: ref table too large for buffer\n"));
 		return -1 ;
 	}
 	fread(&prt->offset[0], sizeof(int32_t) * (prt->numRefs + 1), 1, fd);
+	ResUnlockFiles();
 
 	return(0);
 }
@@ -292,8 +300,10 @@ int ResNumRefs(Id id)
 	   	Warning(("ResNumRefs: id $%x doesn't exist\n", id)); \
 		   return(-1); \
 		   }});
+		ResLockFiles();
 		fseek(fd, RES_OFFSET_DESC2REAL(prd->offset), SEEK_SET);
 		fread(&result, sizeof(RefIndex), 1, fd);
+		ResUnlockFiles();
 		return result;
 	}
 }
@@ -361,6 +371,9 @@ void *RefExtract(RefTable *prt, Ref ref, void *buff)
 	int32_t refsize;
 	RefIndex numrefs;
 	int32_t offset;
+	int32_t pos, csize, skip;
+	uint8_t head[8];
+	uint8_t *pcomp, *pexp;
 
 //	Check id, get file number
 
@@ -378,11 +391,13 @@ void *RefExtract(RefTable *prt, Ref ref, void *buff)
 	else
 	{
 		// seek into the file and find the stuff.
+		ResLockFiles();
 		fseek(fd, RES_OFFSET_DESC2REAL(prd->offset), SEEK_SET);
 		fread(&numrefs, sizeof(RefIndex), 1, fd);
 		fseek(fd, index*sizeof(int32_t), SEEK_CUR);
 		fread(&offset,sizeof(int32_t), 1, fd);
 		fread(&refsize,sizeof(int32_t), 1, fd);
+		ResUnlockFiles();
 		refsize -= offset;
 		Warning("Null reftable size = %d offset = %d numrefs = %d\n", refsize, offset, numrefs);
    }
@@ -397,23 +412,83 @@ void *RefExtract(RefTable *prt, Ref ref, void *buff)
 //	Add to cumulative stats
 	CUMSTATS(REFID(ref),numExtracts);
 
-//	Seek to start of all data in compound resource
+//	Seek to start of all data in compound resource (workers may be reading
+//	the same file)
+	ResLockFiles();
 	fseek(fd, RES_OFFSET_DESC2REAL(prd->offset) + REFTABLESIZE(numrefs),
 		SEEK_SET);
 
-//	If LZW, extract with skipping, else seek & read
+//	If LZW, read the compressed data & expand up to the end of the item once
+//	the file is free (skipping the items before it), if LZ4 look up the
+//	item's compressed data & expand just it, else seek & read
 	if (ResFlags(REFID(ref)) & RDF_LZW)
 	{
-		LzwExpandFd2Buff(fd, buff,
-			offset - REFTABLESIZE(numrefs),	// skip amt
-			refsize);										// data amt
+		skip = offset - REFTABLESIZE(numrefs);
+		csize = prd->csize - REFTABLESIZE(numrefs);
+		pcomp = (csize > 0) ? malloc(csize) : NULL;
+		if (pcomp && fread(pcomp, csize, 1, fd) != 1)
+		{
+			free(pcomp);
+			pcomp = NULL;
+		}
+		ResUnlockFiles();
+		if (pcomp == NULL)
+			return(NULL);
+		pexp = (skip > 0 && refsize > 0) ? malloc(skip + refsize) : buff;
+		if (pexp == NULL || (refsize > 0 &&
+			LzwExpandBlock(pcomp, csize, pexp, skip + refsize) != skip + refsize))
+		{
+			if (pexp != buff)
+				free(pexp);
+			free(pcomp);
+			return(NULL);
+		}
+		if (pexp != buff)
+		{
+			memcpy(buff, pexp + skip, refsize);
+			free(pexp);
+		}
+		free(pcomp);
+	}
+	else if (ResFlags(REFID(ref)) & RDF_LZ4)
+	{
+		pcomp = NULL;
+		fseek(fd, index * 4, SEEK_CUR);
+		if (fread(head, sizeof(head), 1, fd) == 1)
+		{
+			pos = LZ4_ITEMOFFSET(head, 0);
+			csize = LZ4_ITEMOFFSET(head, 1) - pos;
+			if (csize > 0 && (pcomp = malloc(csize)) != NULL)
+			{
+				fseek(fd, pos - (index + 2) * 4, SEEK_CUR);
+				if (fread(pcomp, csize, 1, fd) != 1)
+				{
+					free(pcomp);
+					pcomp = NULL;
+				}
+			}
+		}
+		ResUnlockFiles();
+		if (pcomp == NULL)
+			return(NULL);
+		if (Lz4Expand(pcomp, csize, buff, refsize) != refsize)
+		{
+			free(pcomp);
+			return(NULL);
+		}
+		free(pcomp);
 	}
 	else
 	{
 		fseek(fd, offset - REFTABLESIZE(numrefs), SEEK_CUR);
 		fread(buff, refsize, 1, fd);
+		ResUnlockFiles();
 	}
 
+//	Put in this machine's byte order, as loaded items are
+	if (ResTypeLayout(ResType(REFID(ref))))
+		ResSwapRecords(ResTypeLayout(ResType(REFID(ref))), buff, refsize);
+
 	return(buff);
 
 }
@@ -0,0 +1,320 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		RefLoad.c		Load compound resources an item at a time
+
+//	A big compound resource which isn't LZW compressed (LZW can't be
+//	entered midway) needn't be loaded whole to get at one item.  It gets
+//	its full-size buffer, as usual, but only its ref table is read in; each
+//	item is read (and expanded, if LZ4) into place the first time it's
+//	locked or gotten.  Pages of the buffer no item has touched yet cost no
+//	memory.  Locking or getting the resource whole loads whatever's left.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "res.h"
+#include "res_.h"
+#include "lz4.h"
+
+ResPartial **resPartial;			// partial load state by id, NULL if none
+Id resPartialMax;						// highest id resPartial[] has room for
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+void *ResLoadPartial(Id id);
+bool RefRetrieveItem(Id id, uint8_t flags, RefIndex index, uint8_t *pres);
+
+
+//	---------------------------------------------------------
+//
+//	RefLoadItem() makes sure a compound resource item is in memory,
+//		loading just it if the resource can be loaded an item at a time,
+//		else the whole resource.
+//
+//		ref = resource reference
+//
+//	Returns: ptr to resource, or NULL if problem
+
+void *RefLoadItem(Ref ref)
+{
+	Id id = REFID(ref);
+	RefIndex index = REFINDEX(ref);
+	ResDesc *prd = RESDESC(id);
+	ResPartial *ppa;
+	uint64_t start;
+
+	//	If whole thing in memory, done
+	if (prd->ptr && !ResIsPartial(id))
+		return prd->ptr;
+
+	//	If not in memory, small, LZW, or already on its way in, load whole
+	if (prd->ptr == NULL)
+	{
+		if ((ResFlags(id) & (RDF_COMPOUND | RDF_LZW | RDF_PREFETCH)) != RDF_COMPOUND ||
+			prd->size < RES_PARTIAL_MINSIZE)
+				return ResLoadResource(id);
+		if (ResLoadPartial(id) == NULL)
+			return NULL;
+	}
+
+	//	Load item if not yet in (bad index is caller's to catch)
+	ppa = resPartial[id];
+	if (index < ppa->numRefs && (ppa->loaded[index >> 3] & (1 << (index & 7))) == 0)
+	{
+		start = ResTelemNow();
+		if (!RefRetrieveItem(id, ResFlags(id), index, prd->ptr))
+			return NULL;
+		ResSwapLoadedItem(ResType(id), (RefTable *) prd->ptr, index);
+		ResTelemLoaded(id, ResType(id), start);
+		ppa->loaded[index >> 3] |= 1 << (index & 7);
+		if (++ppa->numLoaded == ppa->numRefs)
+			ResPartialForget(id);
+	}
+
+	return prd->ptr;
+}
+
+//	---------------------------------------------------------
+//
+//	ResLoadRest() loads the items of a partially loaded compound resource
+//		which aren't in yet, making it whole.
+//
+//		id = resource id
+//
+//	Returns: TRUE if whole, FALSE if an item couldn't be loaded (the
+//		resource is left partially loaded)
+
+bool ResLoadRest(Id id)
+{
+	ResPartial *ppa = resPartial[id];
+	RefIndex index;
+
+	for (index = 0; index < ppa->numRefs; index++)
+	{
+		if ((ppa->loaded[index >> 3] & (1 << (index & 7))) == 0)
+		{
+			if (!RefRetrieveItem(id, ResFlags(id), index, RESDESC(id)->ptr))
+				return FALSE;
+			ResSwapLoadedItem(ResType(id), (RefTable *) RESDESC(id)->ptr, index);
+			ppa->loaded[index >> 3] |= 1 << (index & 7);
+			ppa->numLoaded++;
+		}
+	}
+	ResPartialForget(id);
+	return TRUE;
+}
+
+//	---------------------------------------------------------
+//
+//	ResPartialForget() forgets which items of a resource are loaded, as it
+//		leaves memory or becomes whole.
+//
+//		id = resource id
+
+void ResPartialForget(Id id)
+{
+	if (ResIsPartial(id))
+	{
+		free(resPartial[id]);
+		resPartial[id] = NULL;
+	}
+}
+
+//	---------------------------------------------------------
+//		INTERNAL ROUTINES
+//	---------------------------------------------------------
+//
+//	ResLoadPartial() allocates a compound resource's buffer, reads its ref
+//		table into it, and sets it up to load items one at a time.
+//
+//		id = resource id
+//
+//	Returns: ptr to resource, or NULL if problem
+
+void *ResLoadPartial(Id id)
+{
+	ResDesc *prd = RESDESC(id);
+	ResFile *prf = &resFile[prd->filenum];
+	int32_t offset = RES_OFFSET_DESC2REAL(prd->offset);
+	RefTable *prt;
+	RefIndex numRefs, index;
+	ResPartial *ppa, **ppnew;
+	int32_t numOld;
+	bool ok;
+
+	//	Make room in cache budget, then allocate memory as ResLoadResource()
+	resPrefetchStat.numMisses++;
+	ResCacheMakeRoom(prd->size);
+	idBeingLoaded = id;
+	prt = malloc(prd->size);
+	idBeingLoaded = ID_NULL;
+	if (prt == NULL)
+		return NULL;
+
+	//	Read in ref table, from file image or file
+	if (prf->pmap)
+	{
+		memcpy(&numRefs, prf->pmap + offset, sizeof(RefIndex));
+		ok = REFTABLESIZE(numRefs) <= prd->size;
+		if (ok)
+			memcpy(prt, prf->pmap + offset, REFTABLESIZE(numRefs));
+	}
+	else
+	{
+		ResLockFiles();
+		fseek(prf->fd, offset, SEEK_SET);
+		ok = fread(&numRefs, sizeof(RefIndex), 1, prf->fd) == 1 &&
+			REFTABLESIZE(numRefs) <= prd->size;
+		if (ok)
+		{
+			fseek(prf->fd, offset, SEEK_SET);
+			ok = fread(prt, REFTABLESIZE(numRefs), 1, prf->fd) == 1;
+		}
+		ResUnlockFiles();
+	}
+
+	//	Make sure items lie within resource, items are read straight in
+	for (index = 0; ok && index < numRefs; index++)
+	{
+		ok = prt->offset[index] >= (int32_t) REFTABLESIZE(numRefs) &&
+			prt->offset[index] <= prt->offset[index + 1] &&
+			prt->offset[index + 1] <= prd->size;
+	}
+
+	//	Set up record of which items are loaded
+	ppa = NULL;
+	if (ok)
+		ppa = calloc(1, sizeof(ResPartial) + (numRefs >> 3));
+	if (ppa && (resPartial == NULL || id > resPartialMax))
+	{
+		numOld = resPartial ? resPartialMax + 1 : 0;
+		ppnew = realloc(resPartial, (resDescMax + 1) * sizeof(ResPartial *));
+		if (ppnew == NULL)
+		{
+			free(ppa);
+			ppa = NULL;
+		}
+		else
+		{
+			memset(ppnew + numOld, 0, (resDescMax + 1 - numOld) * sizeof(ResPartial *));
+			resPartial = ppnew;
+			resPartialMax = resDescMax;
+		}
+	}
+	if (ppa == NULL)
+	{
+		free(prt);
+		return NULL;
+	}
+	ppa->numRefs = numRefs;
+	resPartial[id] = ppa;
+
+	prd->ptr = prt;
+	ResCacheAdd(id);
+	CUMSTATS(id, numLoads);
+
+	return prd->ptr;
+}
+
+//	---------------------------------------------------------
+//
+//	RefRetrieveItem() reads one item of a compound resource into place.
+//		LZ4 compound resources have their items compressed one by one, so
+//		just the one is read & expanded.
+//
+//		id    = resource id
+//		flags = resource flags (RDF_XXX)
+//		index = item index
+//		pres  = ptr to resource buffer, holding ref table
+//
+//	Returns: TRUE if retrieved, FALSE if problem
+
+bool RefRetrieveItem(Id id, uint8_t flags, RefIndex index, uint8_t *pres)
+{
+	ResDesc *prd = RESDESC(id);
+	ResFile *prf = &resFile[prd->filenum];
+	RefTable *prt = (RefTable *) pres;
+	int32_t offset = RES_OFFSET_DESC2REAL(prd->offset);
+	int32_t size = RefSize(prt, index);
+	uint8_t *pdest = pres + prt->offset[index];
+	uint8_t head[8];
+	uint8_t *pcomp;
+	int32_t pos, end;
+	uint64_t start;
+	bool ok;
+
+	//	Uncompressed item is where the ref table says, in the file too
+	if ((flags & RDF_LZ4) == 0)
+	{
+		offset += prt->offset[index];
+		if (prf->pmap)
+		{
+			if ((size_t) (offset + size) > prf->mapSize)
+				return FALSE;
+			memcpy(pdest, prf->pmap + offset, size);
+			return TRUE;
+		}
+		ResLockFiles();
+		fseek(prf->fd, offset, SEEK_SET);
+		ok = size == 0 || fread(pdest, size, 1, prf->fd) == 1;
+		ResUnlockFiles();
+		ResTelemCount(id, ResType(id), RES_TELEM_BYTESREAD, size);
+		return ok;
+	}
+
+	//	LZ4 items follow the ref table, starting with their own table
+	offset += REFTABLESIZE(prt->numRefs);
+	start = ResTelemNow();
+	if (prf->pmap)
+	{
+		if ((size_t) offset > prf->mapSize)
+			return FALSE;
+		ok = Lz4ExpandItem(prf->pmap + offset, (int32_t) (prf->mapSize - offset), index,
+			pdest, size) == size;
+		ResCountExpanded(id, ResType(id), flags, start, size);
+		return ok;
+	}
+
+	//	From a file, look up the item's compressed data & read just it,
+	//	expanding it after the file is free for others
+	ResLockFiles();
+	fseek(prf->fd, offset + index * 4, SEEK_SET);
+	ok = fread(head, sizeof(head), 1, prf->fd) == 1;
+	pos = LZ4_ITEMOFFSET(head, 0);
+	end = LZ4_ITEMOFFSET(head, 1);
+	pcomp = NULL;
+	if (ok && pos < end)
+		pcomp = malloc(end - pos);
+	if (pcomp)
+	{
+		fseek(prf->fd, offset + pos, SEEK_SET);
+		ok = fread(pcomp, end - pos, 1, prf->fd) == 1;
+	}
+	ResUnlockFiles();
+	if (pcomp == NULL)
+		return FALSE;
+	ResTelemCount(id, ResType(id), RES_TELEM_BYTESREAD, sizeof(head) + end - pos);
+	start = ResTelemNow();
+	ok = ok && Lz4Expand(pcomp, end - pos, pdest, size) == size;
+	ResCountExpanded(id, ResType(id), flags, start, size);
+	free(pcomp);
+
+	return ok;
+}
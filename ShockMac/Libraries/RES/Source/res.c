@@ -82,14 +82,14 @@ void ResInit()
 	if (!gResDesc)
 		Error("ResInit: Can't allocate the global resource descriptor table.\n");
 
-	gResDesc[ID_HEAD].prev = 0;
-	gResDesc[ID_HEAD].next = ID_TAIL;
-	gResDesc[ID_TAIL].prev = ID_HEAD;
-	gResDesc[ID_TAIL].next = 0;
+	(*resCachePolicy->f_Init)();
 
 //	Clear file descriptor array
 	for (i = 0; i <= MAX_RESFILENUM; i++)
+	{
 		resFile[i].fd = NULL;
+		resFile[i].pmap = NULL;
+	}
 
 //	Add directory pointed to by RES env var to search path
 	p = getenv("RES");
@@ -108,6 +108,9 @@ void ResInit()
 
 void ResTerm()
 {
+//	Stop prefetch workers before their files go away
+	ResPrefetchStop();
+
 //	Close all open resource files
 	for (int i = 0; i <= MAX_RESFILENUM; i++)
 	{
@@ -125,6 +128,9 @@ void ResTerm()
 		gResDesc = NULL;
 		resDescMax = 0;
 	}
+	free(resPartial);
+	resPartial = NULL;
+	resPartialMax = 0;
 
 //	Pop allocators
 	if (resPushedAllocators)
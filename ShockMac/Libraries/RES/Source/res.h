@@ -87,6 +87,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //	---------------------------------------------------------
 int32_t SwapLongBytes(int32_t in);
 int16_t SwapShortBytes(int16_t in);
+void ResSwap16(void *p, int32_t n);		// swap bytes of n 16-bit values (resswap.c)
+void ResSwap32(void *p, int32_t n);		// swap bytes of n 32-bit values
 
 //	---------------------------------------------------------
 //		ID AND REF DEFINITIONS AND MACROS
@@ -124,12 +126,16 @@ void ResDelete(Id id);				// delete resource forever
 //		ACCESS TO ITEMS IN COMPOUND RESOURCES (REF'S)  (refacc.c)
 //	------------------------------------------------------------
 
-//	Each compound resource starts with a Ref Table
+//	Each compound resource starts with a Ref Table.  It's laid out as on
+//	disk (and on the 68K Mac), offsets right after numRefs, which is what
+//	REFTABLESIZE() counts.
 
+#pragma pack(push, 2)
 typedef struct {
 	RefIndex numRefs;			// # items in compound resource
 	int32_t offset[1];			// offset to each item (numRefs + 1 of them)
 } RefTable;
+#pragma pack(pop)
 
 void *RefLock(Ref ref);				// lock compound res, get ptr to item
 #define RefUnlock(ref) ResUnlock(REFID(ref))	// unlock compound res item
@@ -140,6 +146,12 @@ RefTable *ResReadRefTable(Id id);				// alloc & read ref table
 int32_t ResExtractRefTable(Id id, RefTable *prt, int32_t size); // extract reftable
 void *RefExtract(RefTable *prt, Ref ref, void *buff);	// extract ref
 
+//	Big compound resources which aren't LZW compressed load an item at a
+//	time through RefLock() & RefGet(); the rest comes in if the resource
+//	is locked or gotten whole.
+
+#define RES_PARTIAL_MINSIZE 16384		// smaller compound resources load whole
+
 #define RefIndexValid(prt,index) ((index) < (prt)->numRefs)
 #define RefSize(prt,index) (prt->offset[(index)+1]-prt->offset[index])
 
@@ -148,6 +160,32 @@ int32_t ResNumRefs(Id id); // returns the number of refs in a resource, extracti
 #define REFTABLESIZE(numrefs) (sizeof(RefIndex) + (((numrefs)+1) * sizeof(int32_t)))
 #define REFPTR(prt,index) (((uint8_t *) prt) + prt->offset[index])
 
+//	-----------------------------------------------------------
+//		BACKGROUND PREFETCH OF RESOURCES  (resfetch.c)
+//	-----------------------------------------------------------
+
+//	ResPrefetch() hands a resource to a pool of worker threads, which read
+//	and decompress it while the game goes on.  The next ResLock() (etc.)
+//	picks up the loaded data, waiting only if a worker is still on it.
+//	Without threads prefetching does nothing, and resources load as usual.
+
+int32_t ResPrefetchStart(int32_t numThreads);	// start workers, returns # started
+void ResPrefetchStop();								// cancel prefetches, stop workers
+void ResPrefetch(Id id);							// start loading resource
+#define RefPrefetch(ref) ResPrefetch(REFID(ref))	// start loading compound res
+
+#define DEFAULT_RES_PREFETCH_THREADS 2			// # workers started by 1st prefetch
+
+typedef struct {
+	uint32_t numIssued;					// # prefetches handed to workers
+	uint32_t numDropped;				// # prefetches dropped, too many pending
+	uint32_t numHits;						// # loads already done by a prefetch
+	uint32_t numLateHits;				// # loads which waited on a prefetch
+	uint32_t numMisses;					// # loads done on the spot
+} ResPrefetchStat;
+
+extern ResPrefetchStat resPrefetchStat;	// prefetch stats, always kept
+
 //	-----------------------------------------------------------
 //		BLOCK-AT-A-TIME ACCESS TO RESOURCES  (resexblk.c)
 //	-----------------------------------------------------------
@@ -157,8 +195,22 @@ void ResExtractInBlocks(Id id, void *buff, int32_t blockSize,
 void RefExtractInBlocks(RefTable *prt, Ref ref, void *buff, int32_t blockSize,
 	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock));
 
+//	Pipelined: reading & expanding run ahead of f_ProcBlock, which is
+//	called on a consumer thread with fixed size blocks (its return value
+//	is ignored), up to queueDepth of them in flight.
+
+void ResExtractInBlocksPiped(Id id, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock));
+void RefExtractInBlocksPiped(RefTable *prt, Ref ref, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock));
+
+#define DEFAULT_RES_BLOCKQUEUE 2	// queue depth for double-buffering
+
+//	iblock passed to f_ProcBlock is the block # (from 0) and these flags
+
 #define REBF_FIRST 0x01		// set for 1st block passed to f_ProcBlock
 #define REBF_LAST  0x02		// set for last block (may also be first!)
+#define REBF_BLOCKNUM(iblock) ((iblock) >> 2)	// get block # from iblock
 
 //	-----------------------------------------------------------
 //		IN-MEMORY RESOURCE DESCRIPTORS, AND INFORMATION ROUTINES
@@ -174,6 +226,7 @@ typedef struct {
 	uint32_t offset:28;	// offset in file
 	Id next;				// next resource in LRU order
 	Id prev;				// previous resource in LRU order
+	int32_t csize;		// size in file (compressed size if compressed)
 } ResDesc;
 
 typedef struct {
@@ -189,12 +242,14 @@ typedef struct {
 
 #define RDF_LZW			0x01		// if 1, LZW compressed
 #define RDF_COMPOUND		0x02		// if 1, compound resource
-#define RDF_RESERVED		0x04		// reserved
+#define RDF_LZ4			0x04		// if 1, LZ4 compressed (see lz4.h), by item if compound
 #define RDF_LOADONOPEN	0x08		// if 1, load block when open file
 #define RDF_CDSPOOF     0x10     // is this resource on a virtual CD rom drive?
-#define RDF_UNUSED1     0x20     // hey look, some open flags
-#define RDF_UNUSED2     0x40     // betcha cant use just one
-#define RDF_UNUSED3     0x80     // that's right, yet another
+#define RDF_MAPPED      0x20     // if 1, ptr points into a mapped resfile
+#define RDF_PREFETCH    0x40     // if 1, being prefetched in background
+#define RDF_REFERENCED  0x80     // if 1, used since cache last looked
+
+#define RDF_RUNTIME (RDF_MAPPED | RDF_PREFETCH | RDF_REFERENCED)	// never on disk
 
 #define RES_MAXLOCK 255				// max locks on a resource
 
@@ -210,8 +265,9 @@ extern ResDesc2 *gResDesc2;	// ptr to array of ResDesc2 (shared buff with resdes
 #define ResFilenum(id) (gResDesc[id].filenum)
 #define ResType(id) (gResDesc2[id].type)
 #define ResFlags(id) (gResDesc2[id].flags)
-#define ResCompressed(id) (gResDesc2[id].flags & RDF_LZW)
+#define ResCompressed(id) (gResDesc2[id].flags & (RDF_LZW | RDF_LZ4))
 #define ResIsCompound(id) (gResDesc2[id].flags & RDF_COMPOUND)
+#define ResIsMapped(id) (gResDesc2[id].flags & RDF_MAPPED)
 
 //	------------------------------------------------------------
 //		RESOURCE MANAGER GENERAL ROUTINES  (res.c)
@@ -228,9 +284,14 @@ typedef enum {
 	ROM_READ,			// open for reading only
 	ROM_EDIT,			// open for editing (r/w) only
 	ROM_EDITCREATE,	// open for editing, create if not found
-	ROM_CREATE			// open for creation (deletes existing)
+	ROM_CREATE,			// open for creation (deletes existing)
+	ROM_MAP			// open for reading, map whole file into memory
 } ResOpenMode;
 
+//	A mapped file is mapped copy-on-write, so a locked resource in it may be
+//	changed in place, like a loaded one.  But the change lives in the file
+//	image, not a copy: dropping and reloading the resource doesn't undo it.
+
 void ResAddPath(char *path);		// add search path for resfiles
 int32_t ResOpenResFile(char *fname, ResOpenMode mode, bool auxinfo);	// openfile
 void ResCloseFile(int32_t filenum);	// close res file
@@ -240,6 +301,7 @@ void ResSetCDSpoof(char *path, void (*spoof_cb)(int32_t size, Id id));
 #define ResEditFile(fname,creat) ResOpenResFile(fname, \
 	(creat) ? ROM_EDITCREATE : ROM_EDIT, TRUE)
 #define ResCreateFile(fname) ResOpenResFile(fname, ROM_CREATE, TRUE)
+#define ResMapFile(fname) ResOpenResFile(fname, ROM_MAP, FALSE)
 
 #define MAX_RESFILENUM 15			// maximum file number
 
@@ -268,6 +330,87 @@ typedef struct {
 
 extern ResStat resStat;				// stats computed if proper DBG bit set
 
+//	---------------------------------------------------------
+//		RESOURCE CACHE  (rescache.c)
+//	---------------------------------------------------------
+
+//	Resources stay in memory until dropped, or until room is needed under
+//	the cache budget.  The policy picks which unlocked resource goes.
+
+typedef struct {
+	char *name;								// "clock", "lru", etc.
+	void (*f_Init)();						// set up empty list
+	void (*f_Add)(Id id);				// resource came into memory
+	void (*f_Remove)(Id id);			// resource leaving memory
+	void (*f_Use)(Id id);				// resource in memory locked or gotten
+	void (*f_Lock)(Id id);				// lock count going 0 -> 1
+	void (*f_Unlock)(Id id);			// lock count gone 1 -> 0
+	Id (*f_Victim)();						// pick resource to drop, or ID_NULL
+} ResCachePolicy;
+
+extern ResCachePolicy resCacheClock;	// CLOCK, scan-resistant (default)
+extern ResCachePolicy resCacheLRU;		// least-recently-used
+
+#define RES_CACHE_NORMAL 0				// type priorities: dropped as policy says
+#define RES_CACHE_LOW 1					// dropped without a second chance
+#define RES_CACHE_RESIDENT 2			// never dropped to stay in budget
+
+void ResCacheSetPolicy(ResCachePolicy *policy);		// switch policy
+void ResCacheSetBudget(int32_t budget);				// max bytes, 0 = no limit
+void ResCacheSetTypePriority(uint8_t type, uint8_t pri);	// RES_CACHE_XXX for type
+bool ResCacheMakeRoom(int32_t size);					// drop till size bytes fit
+
+typedef struct {
+	int32_t numResources;				// # resources in cache
+	int32_t totBytes;						// total bytes of resources in cache
+	uint32_t numHits;						// # locks & gets already in memory
+	uint32_t numEvictions;				// # resources dropped to stay in budget
+	uint32_t totBytesEvicted;			// total bytes of those
+	uint32_t numOverBudget;				// # times nothing left to drop
+} ResCacheStat;
+
+extern ResCacheStat resCacheStat;	// cache stats, always kept
+
+//	---------------------------------------------------------
+//		RESOURCE TELEMETRY  (restelem.c)
+//	---------------------------------------------------------
+
+//	Counts by type & by id, and latency histograms, always kept.  Bytes
+//	read are those read from resfiles; mapped resfiles are paged in, not
+//	read, and don't count.
+
+#define RES_TELEM_LOADS 0				// # loads (whole or by item)
+#define RES_TELEM_HITS 1				// # locks & gets already in memory
+#define RES_TELEM_EVICTIONS 2			// # times dropped to stay in budget
+#define RES_TELEM_BYTESREAD 3			// # bytes read from resfile
+#define RES_TELEM_BYTESEXPANDED 4		// # bytes decompressed
+#define RES_TELEM_LOADNS 5				// total ns spent loading
+#define RES_TELEM_MAXLOADNS 6			// longest load, ns
+#define RES_TELEM_NUMCOUNTS 7
+
+#define RES_TELEM_LOADTIME 0			// histogram of ResLoadResource() loads
+#define RES_TELEM_LZWTIME 1			// of LZW expansions
+#define RES_TELEM_LZ4TIME 2			// of LZ4 expansions
+#define RES_TELEM_NUMHISTS 3
+
+#define RES_TELEM_BUCKETS 32			// bucket n: under 2^(n+1) ns (& 2^n up)
+
+typedef struct {
+	uint64_t count[RES_TELEM_NUMCOUNTS];	// RES_TELEM_XXX counts
+} ResTelemCounts;
+
+typedef struct {
+	uint64_t count[RES_TELEM_BUCKETS];		// # latencies in each bucket
+	uint64_t totNs;								// total of them
+	uint64_t maxNs;								// longest of them
+} ResTelemHist;
+
+ResTelemCounts *ResTelemType(uint8_t type);	// counts for type
+ResTelemCounts *ResTelemId(Id id);				// counts for id, NULL if none
+ResTelemHist *ResTelemHistogram(int hist);		// RES_TELEM_XXXTIME histogram
+void ResTelemReset();									// zero it all
+int32_t ResTelemDumpJson(FILE *fp, int32_t maxIds);	// write JSON, worst ids first
+
 //	----------------------------------------------------------
 //		PUBLIC INTERFACE FOR CREATORS OF RESOURCES
 //	----------------------------------------------------------
@@ -324,6 +467,8 @@ typedef struct {
 typedef struct {
 	FILE* fd;						// file descriptor (from open())
 	ResEditInfo *pedit;		// editing info, or NULL if read-only file
+	uint8_t *pmap;				// file image if opened with ROM_MAP, else NULL
+	size_t mapSize;			// size of file image in bytes
 } ResFile;
 
 #define RFF_NEEDSPACK	0x0001			// resfile has holes, needs packing
@@ -348,6 +493,7 @@ extern Id resDescMax;						// max id in res desc
 
 void ResSetComment(int32_t filenum, char *comment);	// set comment
 int32_t ResWrite(Id id);						// write resource to file
+int32_t ResWriteBatch(Id *pids, int32_t numIds, int32_t numThreads);	// write many
 void ResKill(Id id);							// delete resource & remove from file
 int32_t ResPack(int32_t filenum);					// remove empty entries
 
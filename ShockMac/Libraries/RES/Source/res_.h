@@ -41,6 +41,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef __RES_H
 #include "res.h"
 #endif
+#include "lzw.h"
 //#ifndef ___RES_H
 //#include <_res.h>
 //#endif
@@ -58,6 +59,80 @@ bool RefCheckRef(Ref ref);			// returns TRUE if ref ok, else FALSE & warns
 
 void *ResLoadResource(Id id);
 bool ResRetrieve(Id id, void *buffer);
+bool ResRetrieveDesc(Id id, ResDesc *prd, uint8_t flags, uint8_t type, void *buffer,
+	LzwContext *plc);
+uint8_t *ResReadLz4(FILE *fd, int32_t *pcsize);	// read LZ4 data into new buffer
+uint8_t *ResReadLz4Items(FILE *fd, RefIndex numItems, int32_t *pcsize);	// same, by item
+bool ResExpandLz4Items(uint8_t *pcomp, int32_t csize, RefTable *prt);	// expand items in place
+void ResCountRead(Id id, uint8_t type, FILE *fd, int32_t offset);	// telemetry: bytes read
+void ResCountExpanded(Id id, uint8_t type, uint8_t flags, uint64_t start,
+	int32_t size);										// & expanded
+
+//	Loading compound resources an item at a time (refload.c)
+
+typedef struct {
+	RefIndex numRefs;						// # items in resource
+	RefIndex numLoaded;					// # of them loaded so far
+	uint8_t loaded[1];					// bit per item, set once loaded
+} ResPartial;
+
+extern ResPartial **resPartial;
+extern Id resPartialMax;
+
+#define ResIsPartial(id) (resPartial && (id) <= resPartialMax && resPartial[id])
+
+void *RefLoadItem(Ref ref);			// load item of compound res, if need be
+bool ResLoadRest(Id id);				// load rest of partially loaded res
+void ResPartialForget(Id id);			// res leaving memory or now whole
+
+//	Background prefetch (resfetch.c)
+
+void *ResPrefetchTake(Id id);				// collect prefetched data, or NULL
+void ResPrefetchCancel(Id id);			// forget prefetch, free its data
+void ResPrefetchCancelFile(int32_t filenum);	// forget prefetches from file
+
+#ifdef RES_THREADS
+void ResLockFiles();							// serialize seek & read of resfiles
+void ResUnlockFiles();						// with prefetch workers
+#else
+#define ResLockFiles()
+#define ResUnlockFiles()
+#endif
+
+//	Compressing resources to write, in batches on worker threads (rescomp.c)
+
+typedef struct {
+	uint8_t *pres;						// resource data, ref table first if compound
+	int32_t size;						// size of resource
+	int32_t sizeTable;				// size of ref table if compound, else 0
+	int32_t numItems;					// # items if compound
+	int32_t *offsets;					// item offsets if compound (numItems + 1)
+	uint8_t flags;						// RDF_LZW/RDF_LZ4 wanted, cleared if no gain
+	uint8_t *pcomp;					// compressed data past ref table, or NULL
+	int32_t compSize;					// size of compressed data, or -1
+} ResCompJob;
+
+void ResCompress(ResCompJob *pj, LzwContext *plc);		// compress, plc may be NULL
+void ResCompressJobs(ResCompJob *pjobs, int32_t numJobs, int32_t numThreads);
+
+//	Streaming bytes to a block routine, maybe through a queue (resstream.c)
+
+typedef struct ResStream_ ResStream;
+
+ResStream *ResStreamOpen(int32_t size, void *buff, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock));
+uint8_t *ResStreamSpace(ResStream *ps, int32_t *pavail);	// where next bytes go
+void ResStreamAdvance(ResStream *ps, int32_t n);			// n bytes put there
+void ResStreamWrite(ResStream *ps, void *p, int32_t n);	// copy bytes in
+bool ResStreamClose(ResStream *ps);							// finish, TRUE if all in
+
+//	Byte swapping loaded data into this machine's order, by type (resswap.c).
+//	These take the type, not the id, since workers mustn't look it up.
+
+#define ResSwapLoaded(type,flags,p,size) {ResLayout *pl_ = ResTypeLayout(type); \
+	if (pl_) ResSwapData(pl_, flags, p, size);}
+#define ResSwapLoadedItem(type,prt,index) {ResLayout *pl_ = ResTypeLayout(type); \
+	if (pl_) ResSwapRecords(pl_, (uint8_t *) (prt) + (prt)->offset[index], RefSize((prt),(index)));}
 
 //	Resource paging (resmem.c)
 
@@ -66,6 +141,44 @@ extern void *(*f_pager)(int32_t size);
 extern Id idBeingLoaded;
 #define RES_PAGER(size) (*f_pager)(size)
 
+//	Telemetry (restelem.c)
+
+uint64_t ResTelemNow();							// timestamp, ns
+void ResTelemCount(Id id, uint8_t type, int counter, uint64_t n);
+uint64_t ResTelemTime(int hist, uint64_t start);	// record latency since start
+void ResTelemLoaded(Id id, uint8_t type, uint64_t start);	// record a load
+
+//	Resource file directory index (resindex.c)
+
+typedef struct {
+	char signature[16];		// "LG ResIndex v2\r\n"
+	uint32_t byteOrder;		// RES_INDEX_BYTEORDER, as written
+	int32_t fileSize;			// size of resource file indexed
+	int64_t fileTime;			// its modification time, 0 if unknown
+	int32_t dirOffset;		// its directory offset
+	int32_t numEntries;		// # entries following header, sorted by id
+	uint32_t checksum;		// checksum of entries
+	uint32_t reserved;		// must be 0
+} ResIndexHeader;				// total 48 bytes
+
+typedef struct {
+	Id id;						// resource id
+	uint8_t flags;				// resource flags (RDF_XXX) from directory
+	uint8_t type;				// resource type
+	int32_t size;				// uncompressed size
+	int32_t csize;				// size in file (compressed size)
+	int32_t offset;			// file offset of data
+} ResIndexEntry;				// total 16 bytes
+
+#define RES_INDEX_EXT ".rix"					// index file is resfile name + this
+#define RES_INDEX_BYTEORDER 0x01020304
+
+void ResIndexStamp(FILE *fd, int32_t dirOffset, ResIndexHeader *pstamp);
+ResIndexHeader *ResIndexLoad(char *fname, ResIndexHeader *pstamp, size_t *psize);
+void ResIndexFree(ResIndexHeader *phead, size_t size);
+bool ResIndexSave(char *fname, ResIndexHeader *pstamp, ResIndexEntry *pentries,
+	int32_t numEntries);
+
 //	Grow descriptor table (res.c)
 
 void ResGrowResDescTable(Id id);
@@ -87,7 +200,23 @@ void ResGrowResDescTable(Id id);
 
 #define RES_OFFSET_PENDING 1	// offset of resource not yet written
 
-//	LRU chain link management macros
+//	Resource cache (rescache.c), for resources whose memory res owns
+
+extern ResCachePolicy *resCachePolicy;
+
+void ResCacheAdd(Id id);				// resource came into memory
+void ResCacheRemove(Id id);			// resource leaving memory
+
+#define ResCacheUse(id) { \
+	resCacheStat.numHits++; \
+	ResTelemCount(id, gResDesc2[id].type, RES_TELEM_HITS, 1); \
+	if (!ResIsMapped(id)) (*resCachePolicy->f_Use)(id); }
+#define ResCacheLock(id) { \
+	if (!ResIsMapped(id)) (*resCachePolicy->f_Lock)(id); }
+#define ResCacheUnlock(id) { \
+	if (!ResIsMapped(id)) (*resCachePolicy->f_Unlock)(id); }
+
+//	LRU chain link management macros (also used by CLOCK ring)
 
 #define ResRemoveFromLRU(prd) { \
 	gResDesc[(prd)->next].prev = (prd)->prev; \
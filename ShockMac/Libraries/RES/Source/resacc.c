@@ -60,12 +60,18 @@ void *ResLock(Id id)
 	//	Add to cumulative stats
 //	CUMSTATS(id,numLocks);
 
-	//	If resource not loaded, load it
+	//	If resource not loaded (or only some items of it), load it, else
+	//	tell cache it's been used
 	prd = RESDESC(id);
-	if (ResLoadResource(id) == NULL)
-		return NULL;
-	else if (prd->lock == 0)
-		ResRemoveFromLRU(prd);
+	if (prd->ptr == NULL || ResIsPartial(id))
+	{
+		if (ResLoadResource(id) == NULL)
+			return NULL;
+	}
+	else
+		ResCacheUse(id);
+	if (prd->lock == 0)
+		ResCacheLock(id);
 
 	//	Tally stats, check for over-lock
 //	DBG(DSRC_RES_Stat, {if (prd->lock == 0) resStat.numLocked++;});
@@ -99,14 +105,16 @@ void ResUnlock(Id id)
 //	DBG(DSRC_RES_ChkLock, {if (prd->lock == 0) { \
 //		Warning(("ResUnlock: id $%x already unlocked\n", id)); return;} });
 
-	//	Else decrement lock, if 0 move to tail and tally stats
+	//	Else decrement lock, if 0 hand back to cache and tally stats
 
 	if (prd->lock > 0)
-		prd->lock--;
-	if (prd->lock == 0)
 	{
-		ResAddToTail(prd);
-//		DBG(DSRC_RES_Stat, {resStat.numLocked--;});
+		prd->lock--;
+		if (prd->lock == 0 && prd->ptr)
+		{
+			ResCacheUnlock(id);
+//			DBG(DSRC_RES_Stat, {resStat.numLocked--;});
+		}
 	}
 }
 
@@ -133,14 +141,15 @@ void *ResGet(Id id)
 
 //	CUMSTATS(id,numGets);
 
-//	Load resource or move to tail
-
-	if (ResLoadResource(id) == NULL)
-		return(NULL);
+//	Load resource (or rest of it), or tell cache it's been used
 
-	ResAddToTail(prd);
-	if (prd->lock == 0)
-		ResMoveToTail(prd);
+	if (prd->ptr == NULL || ResIsPartial(id))
+	{
+		if (ResLoadResource(id) == NULL)
+			return(NULL);
+	}
+	else
+		ResCacheUse(id);
 
 	//	Return ptr
 	return prd->ptr;
@@ -201,10 +210,15 @@ void ResDrop(Id id)
 
 //	Spew(DSRC_RES_DelDrop, ("ResDrop: dropping $%x\n", id));
 
-	//	Remove from LRU chain
+	//	Forget any prefetch in progress
 
-	if (prd->lock == 0)
-		ResRemoveFromLRU(prd);
+	if (ResFlags(id) & RDF_PREFETCH)
+		ResPrefetchCancel(id);
+
+	//	Take out of cache
+
+	if (prd->ptr && !ResIsMapped(id))
+		ResCacheRemove(id);
 
 	//	Tally stats
 
@@ -213,10 +227,11 @@ void ResDrop(Id id)
 //		Spew(DSRC_RES_Stat, ("ResDrop: free %d, total now %d bytes\n",
 //			prd->size, resStat.totMemAlloc));});
 
-	//	Free memory and set ptr to NULL
+	//	Free memory and set ptr to NULL (mapped resources own no memory)
 	if (prd->ptr)
 	{
-		free(prd->ptr);
+		if (!ResIsMapped(id))
+			free(prd->ptr);
 		prd->ptr = NULL;
 	}
 }
@@ -245,6 +260,8 @@ void ResDelete(Id id)
 	//	If in use: if in ram, free memory & LRU, then in any case zap entry
 	if (prd->offset)
 	{
+		if (ResFlags(id) & RDF_PREFETCH)
+			ResPrefetchCancel(id);
 		// Spew(DSRC_RES_DelDrop, ("ResDelete: deleting $%x\n", id));
 		if (prd->ptr)
 		{
@@ -254,8 +271,8 @@ void ResDelete(Id id)
 //				Spew(DSRC_RES_Stat, ("ResDelete: free %d, total now %d bytes\n",
 //					prd->size, resStat.totMemAlloc));});
 
-			if (prd->lock == 0)
-				ResRemoveFromLRU(prd);
+			if (!ResIsMapped(id))
+				ResCacheRemove(id);
 		}
 		LG_memset(prd, 0, sizeof(ResDesc));
 	}
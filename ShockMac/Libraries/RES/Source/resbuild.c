@@ -36,6 +36,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "res.h"
 #include "res_.h"
 #include "lzw.h"
+#include "lz4.h"
 //#include <_res.h>
 
 #define CTRL_Z 26		// make sure comment ends with one, so can type a file
@@ -43,6 +44,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //	Internal prototypes
 
 bool ResEraseIfInFile(Id id);				// erase item from file
+static void ResSetupCompJob(Id id, ResCompJob *pj);	// set up to compress res
+static int32_t ResWriteCompressed(Id id, ResCompJob *pj);	// write it out
 
 //	-------------------------------------------------------
 //
@@ -150,15 +153,126 @@ int ResWrite(Id id)
 		return (-1);
 #endif
 
+	ResCompJob job;
+	int32_t size;
+
+	ResSetupCompJob(id, &job);
+	ResCompress(&job, NULL);
+	size = ResWriteCompressed(id, &job);
+	free(job.pcomp);
+	free(job.offsets);
+	if (job.pres != RESDESC(id)->ptr)
+		free(job.pres);
+
+	return size;
+}
+
+//	-------------------------------------------------------
+//
+//	ResWriteBatch() writes a bunch of resources to open resource files,
+//	just as ResWrite() on each in turn would, byte for byte.  Compressing
+//	them, which is most of the work, is spread over worker threads; they
+//	are then written in the order given.  All compressed data is held
+//	until the writing, so batches should be no bigger than need be.
+//	Returns the total number of bytes of data written.
+//
+//		pids       = ptr to array of ids to write
+//		numIds     = # ids
+//		numThreads = # threads to compress on (1 = just this one)
+
+int32_t ResWriteBatch(Id *pids, int32_t numIds, int32_t numThreads)
+{
+	ResCompJob *pjobs;
+	int32_t i, total;
+
+	total = 0;
+	pjobs = malloc(numIds * sizeof(ResCompJob));
+	if (pjobs == NULL)		// do them one at a time with ResWrite()
+	{
+		for (i = 0; i < numIds; i++)
+			total += ResWrite(pids[i]);
+		return total;
+	}
+
+	for (i = 0; i < numIds; i++)
+		ResSetupCompJob(pids[i], &pjobs[i]);
+	ResCompressJobs(pjobs, numIds, numThreads);
+	for (i = 0; i < numIds; i++)
+	{
+		total += ResWriteCompressed(pids[i], &pjobs[i]);
+		free(pjobs[i].pcomp);
+		free(pjobs[i].offsets);
+		if (pjobs[i].pres != RESDESC(pids[i])->ptr)
+			free(pjobs[i].pres);
+	}
+
+	free(pjobs);
+	return total;
+}
+
+//	-------------------------------------------------------
+//
+//	ResSetupCompJob() sets up a compression job for a resource in memory.
+//	If its type has a layout, it's written from a copy swapped back into
+//	file byte order.  A compound resource's item offsets are copied out
+//	of its (packed) ref table, the caller frees them with the job.
+//
+//		id = id of resource
+//		pj = ptr to job to fill in
+
+static void ResSetupCompJob(Id id, ResCompJob *pj)
+{
+	ResDesc *prd = RESDESC(id);
+	RefTable *prt = (RefTable *) prd->ptr;
+	ResLayout *pl = ResTypeLayout(RESDESC2(id)->type);
+	int32_t i;
+
+	if (pl && (pj->pres = malloc(prd->size)) != NULL)
+	{
+		memcpy(pj->pres, prd->ptr, prd->size);
+		ResSwapData(pl, RESDESC2(id)->flags, pj->pres, prd->size);
+	}
+	else
+		pj->pres = prd->ptr;
+	pj->size = prd->size;
+	pj->flags = RESDESC2(id)->flags & (RDF_LZW | RDF_LZ4);
+	pj->sizeTable = 0;
+	pj->numItems = 0;
+	pj->offsets = NULL;
+	if (RESDESC2(id)->flags & RDF_COMPOUND)
+	{
+		pj->sizeTable = REFTABLESIZE(prt->numRefs);
+		pj->numItems = prt->numRefs;
+		pj->offsets = malloc((prt->numRefs + 1) * sizeof(int32_t));	// table is packed
+		if (pj->offsets)
+		{
+			for (i = 0; i <= prt->numRefs; i++)
+				pj->offsets[i] = prt->offset[i];
+		}
+		else
+			pj->flags &= ~RDF_LZ4;
+	}
+	pj->pcomp = NULL;
+	pj->compSize = -1;
+}
+
+//	-------------------------------------------------------
+//
+//	ResWriteCompressed() writes a resource, already put through
+//	ResCompress(), to its file.  Returns the number of bytes of data
+//	written, not counting the ref table.
+//
+//		id = id of resource
+//		pj = ptr to its compression job
+
+static int32_t ResWriteCompressed(Id id, ResCompJob *pj)
+{
 	static uint8_t pad[] = {0,0,0,0,0,0,0,0};
 	ResDesc *prd;
 	ResDesc2 *prd2;
 	ResFile *prf;
 	ResDirEntry *pDirEntry;
-	uint8_t *p;
-	long size,sizeTable;
-	void *pcompbuff;
-	long compsize;
+	int32_t size;
 	int padBytes;
 
 //	Check for errors
@@ -192,54 +306,34 @@ int ResWrite(Id id)
 //	Set resource's file offset
 	prd->offset = RES_OFFSET_REAL2DESC(prf->pedit->currDataOffset);
 
-//	Fill in directory entry
+//	Fill in directory entry, with compression flags only if it worked out
 	pDirEntry = ((ResDirEntry *) (prf->pedit->pdir + 1)) +
 		prf->pedit->pdir->numEntries;
 
 	pDirEntry->id = id;
-	pDirEntry->flags = prd2->flags;
+	pDirEntry->flags = (prd2->flags & ~(RDF_RUNTIME | RDF_LZW | RDF_LZ4)) | pj->flags;
 	pDirEntry->type = prd2->type;
 	pDirEntry->size = prd->size;
 
 	// Spew(DSRC_RES_Write, ("ResWrite: writing $%x\n", id));
 
-//	If compound, write out reftable without compression
+//	If compound, write out reftable without compression, then the data,
+//	compressed if it shrank (workers may be reading the same file)
 
+	ResLockFiles();
 	fseek(prf->fd, prf->pedit->currDataOffset, SEEK_SET);
-	p = prd->ptr;
-	sizeTable = 0;
-	size = prd->size;
-	if (prd2->flags & RDF_COMPOUND)
+	if (pj->sizeTable)
+		fwrite(pj->pres, pj->sizeTable, 1, prf->fd);
+	size = pj->size - pj->sizeTable;
+	if (pj->pcomp)
 	{
-		sizeTable = REFTABLESIZE(((RefTable *) p)->numRefs);
-		fwrite(p, sizeTable, 1, prf->fd);
-		p += sizeTable;
-		size -= sizeTable;
+		pDirEntry->csize = pj->sizeTable + pj->compSize;
+		fwrite(pj->pcomp, pj->compSize, 1, prf->fd);
 	}
-
-//	If compression, try it (may not work out)
-	if (pDirEntry->flags & RDF_LZW)
-	{
-		pcompbuff = malloc(size + EXTRA);
-		compsize = LzwCompressBuff2Buff(p, size, pcompbuff, size);
-		if (compsize < 0)
-		{
-			pDirEntry->flags &= ~RDF_LZW;
-		}
-		else
-		{
-			pDirEntry->csize = sizeTable + compsize;
-			fwrite(pcompbuff, compsize, 1, prf->fd);
-		}
-		free(pcompbuff);
-	}
-
-//	If no compress (or failed to compress well), just write out
-
-	if (!(pDirEntry->flags & RDF_LZW))
+	else
 	{
 		pDirEntry->csize = prd->size;
-		fwrite(p, size, 1, prf->fd);
+		fwrite(pj->pres + pj->sizeTable, size, 1, prf->fd);
 	}
 
 //	Pad to align on data boundary
@@ -249,8 +343,10 @@ int ResWrite(Id id)
 
 	if (ftell(prf->fd) & 3)
 		Warning(("ResWrite: misaligned writing!\n"));
+	ResUnlockFiles();
 
 //	Advance dir num entries, current data offset
+	prd->csize = pDirEntry->csize;
 	prf->pedit->pdir->numEntries++;
 	prf->pedit->currDataOffset =
 		RES_OFFSET_ALIGN(prf->pedit->currDataOffset + pDirEntry->csize);
@@ -0,0 +1,304 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResCache.c	Keep resources in memory within a budget
+
+//	Every resource whose memory the res system owns is "in the cache":
+//	ResCacheAdd() when it comes into memory, ResCacheRemove() when it
+//	leaves.  Which one to drop to stay in budget is up to the cache
+//	policy, which threads its own list through the next & prev fields of
+//	the resource descriptors, using ID_HEAD (and ID_TAIL) as sentinels.
+//
+//	Two policies are supplied:
+//
+//	resCacheClock - (default) CLOCK, or second chance.  All cached
+//		resources sit in a ring; locking or getting one just sets its
+//		RDF_REFERENCED bit.  The hand sweeps the ring, clearing bits,
+//		and drops the first unlocked resource found without one.  A
+//		resource comes in unreferenced, so a one-time scan through many
+//		resources is dropped before the ones which get used again.
+//
+//	resCacheLRU - the original least-recently-used list.  Locked
+//		resources are off the list, so every lock & unlock moves them.
+
+#include <string.h>
+
+#include "res.h"
+#include "res_.h"
+
+ResCacheStat resCacheStat;
+
+static int32_t resCacheBudget;					// max bytes, 0 if no limit
+static uint8_t resCacheTypePri[256];			// RES_CACHE_XXX by resource type
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void ResLRUInit();
+static void ResLRUAdd(Id id);
+static void ResLRURemove(Id id);
+static void ResLRUUse(Id id);
+static void ResLRULock(Id id);
+static void ResLRUUnlock(Id id);
+static Id ResLRUVictim();
+static void ResClockInit();
+static void ResClockAdd(Id id);
+static void ResClockRemove(Id id);
+static void ResClockUse(Id id);
+static void ResClockNoop(Id id);
+static Id ResClockVictim();
+
+ResCachePolicy resCacheLRU = {"lru", ResLRUInit, ResLRUAdd, ResLRURemove,
+	ResLRUUse, ResLRULock, ResLRUUnlock, ResLRUVictim};
+ResCachePolicy resCacheClock = {"clock", ResClockInit, ResClockAdd, ResClockRemove,
+	ResClockUse, ResClockNoop, ResClockNoop, ResClockVictim};
+
+ResCachePolicy *resCachePolicy = &resCacheClock;
+
+#define ResCachePri(id) (resCacheTypePri[ResType(id)])
+
+//	---------------------------------------------------------
+//
+//	ResCacheSetPolicy() switches cache policy, handing every cached
+//		resource over to the new one.
+//
+//		policy = ptr to policy (&resCacheClock, &resCacheLRU, or your own)
+
+void ResCacheSetPolicy(ResCachePolicy *policy)
+{
+	Id id;
+
+	resCachePolicy = policy;
+	(*policy->f_Init)();
+	for (id = ID_MIN; id <= resDescMax; id++)
+	{
+		gResDesc[id].next = gResDesc[id].prev = ID_NULL;
+		if (gResDesc[id].ptr && !ResIsMapped(id))
+			(*policy->f_Add)(id);
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResCacheSetBudget() sets the most memory resources may use, and drops
+//		resources right away if they're over it.
+//
+//		budget = max bytes, or 0 for no limit
+
+void ResCacheSetBudget(int32_t budget)
+{
+	resCacheBudget = budget;
+	ResCacheMakeRoom(0);
+}
+
+//	---------------------------------------------------------
+//
+//	ResCacheSetTypePriority() sets how hard resources of a type cling to
+//		memory.
+//
+//		type = resource type (RTYPE_XXX)
+//		pri  = RES_CACHE_NORMAL, RES_CACHE_LOW (no second chance), or
+//				RES_CACHE_RESIDENT (never dropped to stay in budget)
+
+void ResCacheSetTypePriority(uint8_t type, uint8_t pri)
+{
+	resCacheTypePri[type] = pri;
+}
+
+//	---------------------------------------------------------
+//
+//	ResCacheMakeRoom() drops resources until another size bytes fit in
+//		the budget.  Resources which are locked, or resident by type,
+//		aren't dropped, so it may not manage.
+//
+//		size = # bytes about to be loaded
+//
+//	Returns: TRUE if they fit, FALSE if over budget anyway
+
+bool ResCacheMakeRoom(int32_t size)
+{
+	Id id;
+
+	if (resCacheBudget == 0)
+		return TRUE;
+
+	while (resCacheStat.totBytes + size > resCacheBudget)
+	{
+		id = (*resCachePolicy->f_Victim)();
+		if (id == ID_NULL)
+		{
+			resCacheStat.numOverBudget++;
+			return FALSE;
+		}
+		resCacheStat.numEvictions++;
+		resCacheStat.totBytesEvicted += ResSize(id);
+		ResTelemCount(id, ResType(id), RES_TELEM_EVICTIONS, 1);
+		ResDrop(id);
+	}
+	return TRUE;
+}
+
+//	---------------------------------------------------------
+//
+//	ResCacheAdd() puts a resource just brought into memory in the cache.
+//
+//		id = resource id
+
+void ResCacheAdd(Id id)
+{
+	resCacheStat.numResources++;
+	resCacheStat.totBytes += ResSize(id);
+	gResDesc2[id].flags &= ~RDF_REFERENCED;
+	(*resCachePolicy->f_Add)(id);
+}
+
+//	---------------------------------------------------------
+//
+//	ResCacheRemove() takes a resource leaving memory out of the cache.
+//
+//		id = resource id
+
+void ResCacheRemove(Id id)
+{
+	resCacheStat.numResources--;
+	resCacheStat.totBytes -= ResSize(id);
+	(*resCachePolicy->f_Remove)(id);
+	gResDesc[id].next = gResDesc[id].prev = ID_NULL;
+	ResPartialForget(id);
+}
+
+//	--------------------------------------------------------
+//		LRU POLICY
+//	--------------------------------------------------------
+//
+//	The list runs from ID_HEAD (least recently used) to ID_TAIL, and holds
+//	only unlocked resources.
+
+static void ResLRUInit()
+{
+	gResDesc[ID_HEAD].prev = 0;
+	gResDesc[ID_HEAD].next = ID_TAIL;
+	gResDesc[ID_TAIL].prev = ID_HEAD;
+	gResDesc[ID_TAIL].next = 0;
+}
+
+static void ResLRUAdd(Id id)
+{
+	if (gResDesc[id].lock == 0)
+		ResAddToTail(RESDESC(id));
+}
+
+static void ResLRURemove(Id id)
+{
+	if (gResDesc[id].lock == 0)
+		ResRemoveFromLRU(RESDESC(id));
+}
+
+static void ResLRUUse(Id id)
+{
+	if (gResDesc[id].lock == 0)
+		ResMoveToTail(RESDESC(id));
+}
+
+static void ResLRULock(Id id)
+{
+	ResRemoveFromLRU(RESDESC(id));
+}
+
+static void ResLRUUnlock(Id id)
+{
+	ResAddToTail(RESDESC(id));
+}
+
+static Id ResLRUVictim()
+{
+	Id id;
+
+	for (id = gResDesc[ID_HEAD].next; id != ID_TAIL; id = gResDesc[id].next)
+	{
+		if (ResCachePri(id) != RES_CACHE_RESIDENT)
+			return id;
+	}
+	return ID_NULL;
+}
+
+//	--------------------------------------------------------
+//		CLOCK POLICY
+//	--------------------------------------------------------
+//
+//	The ring runs through ID_HEAD, which the hand skips.  New resources go
+//	just behind the hand, so they get a full sweep before being looked at.
+
+static Id clockHand;
+
+static void ResClockInit()
+{
+	gResDesc[ID_HEAD].prev = gResDesc[ID_HEAD].next = ID_HEAD;
+	clockHand = ID_HEAD;
+}
+
+static void ResClockAdd(Id id)
+{
+	ResDesc *prd = RESDESC(id);
+
+	prd->next = clockHand;
+	prd->prev = gResDesc[clockHand].prev;
+	gResDesc[prd->prev].next = id;
+	gResDesc[clockHand].prev = id;
+}
+
+static void ResClockRemove(Id id)
+{
+	ResDesc *prd = RESDESC(id);
+
+	if (clockHand == id)
+		clockHand = prd->next;
+	ResRemoveFromLRU(prd);
+}
+
+static void ResClockUse(Id id)
+{
+	gResDesc2[id].flags |= RDF_REFERENCED;
+}
+
+//	Clock keeps locked resources in the ring (the victim search skips them)
+
+static void ResClockNoop(Id id)
+{
+	(void) id;
+}
+
+static Id ResClockVictim()
+{
+	Id id;
+	int32_t steps;
+
+	//	Two trips round clear every bit, so if nothing then, nothing ever
+	for (steps = 2 * resCacheStat.numResources + 2; steps > 0; steps--)
+	{
+		id = clockHand;
+		clockHand = gResDesc[id].next;
+		if (id == ID_HEAD || gResDesc[id].lock || ResCachePri(id) == RES_CACHE_RESIDENT)
+			continue;
+		if ((ResFlags(id) & RDF_REFERENCED) && ResCachePri(id) != RES_CACHE_LOW)
+			gResDesc2[id].flags &= ~RDF_REFERENCED;
+		else
+			return id;
+	}
+	return ID_NULL;
+}
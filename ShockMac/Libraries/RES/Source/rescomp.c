@@ -0,0 +1,188 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResComp.c	Compress resources for writing, on worker threads
+
+//	A compression job is one resource's data in, its compressed data (past
+//	any ref table, which is never compressed) out, with the compression
+//	flags cleared if it didn't pay.  Jobs are independent, so a batch can
+//	be handed out to worker threads in any order, each with its own LZW
+//	context, and the results are the same bytes as compressing them one at
+//	a time: the writer then puts them in the file in order.
+
+#include <stdlib.h>
+#ifdef RES_THREADS
+#include <pthread.h>
+#endif
+
+#include "res.h"
+#include "res_.h"
+#include "lz4.h"
+
+#define RES_COMP_LZWEXTRA 250			// LZW may run over a bit before it quits
+#define RES_COMP_MAXTHREADS 64		// max worker threads for a batch
+
+#ifdef RES_THREADS
+
+typedef struct {
+	ResCompJob *pjobs;				// the batch
+	int32_t numJobs;					// # jobs in it
+	int32_t next;						// next job to hand out
+	pthread_mutex_t mutex;			// guards next
+} ResCompQueue;
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void *ResCompressWorker(void *arg);
+
+#endif
+
+//	---------------------------------------------------------
+//
+//	ResCompress() compresses a resource the way ResWrite() always has.
+//		LZ4 wins if both are asked for, and compresses a compound
+//		resource item by item, so it can be loaded an item at a time.
+//		Anything that doesn't shrink is left uncompressed.
+//
+//		pj  = ptr to job, with pres, size, sizeTable, numItems, offsets
+//			  and flags filled in
+//		plc = LZW context to use, or NULL for the shared one
+
+void ResCompress(ResCompJob *pj, LzwContext *plc)
+{
+	uint8_t *p = pj->pres + pj->sizeTable;
+	int32_t size = pj->size - pj->sizeTable;
+
+	pj->pcomp = NULL;
+	pj->compSize = -1;
+
+	if (pj->flags & RDF_LZ4)
+	{
+		pj->flags &= ~RDF_LZW;
+		pj->pcomp = malloc(size);
+		if (pj->pcomp && pj->sizeTable)
+			pj->compSize = Lz4CompressItems(pj->pres, pj->offsets, pj->numItems,
+				pj->pcomp, size);
+		else if (pj->pcomp)
+			pj->compSize = Lz4Compress(p, size, pj->pcomp, size);
+		if (pj->compSize < 0)
+			pj->flags &= ~RDF_LZ4;
+	}
+	if (pj->flags & RDF_LZW)
+	{
+		pj->pcomp = malloc(size + RES_COMP_LZWEXTRA);
+		if (pj->pcomp && plc)
+			pj->compSize = LzwContextCompressBuff2Buff(plc, p, size, pj->pcomp, size);
+		else if (pj->pcomp)
+			pj->compSize = LzwCompressBuff2Buff(p, size, pj->pcomp, size);
+		if (pj->compSize < 0)
+			pj->flags &= ~RDF_LZW;
+	}
+
+	if (pj->compSize < 0)
+	{
+		free(pj->pcomp);
+		pj->pcomp = NULL;
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResCompressJobs() does a batch of compression jobs, on worker threads
+//		if there are any to be had.  The calling thread works too.  If
+//		threads or their LZW contexts can't be had, the jobs left over are
+//		done here, one by one.
+//
+//		pjobs      = ptr to array of jobs
+//		numJobs    = # jobs
+//		numThreads = # threads to use in all (1 = just this one)
+
+void ResCompressJobs(ResCompJob *pjobs, int32_t numJobs, int32_t numThreads)
+{
+	int32_t i = 0;
+
+#ifdef RES_THREADS
+	pthread_t workers[RES_COMP_MAXTHREADS];
+	ResCompQueue queue;
+	int32_t numWorkers;
+
+	if (numThreads > RES_COMP_MAXTHREADS)
+		numThreads = RES_COMP_MAXTHREADS;
+	if (numThreads > numJobs)
+		numThreads = numJobs;
+
+	if (numThreads > 1)
+	{
+		queue.pjobs = pjobs;
+		queue.numJobs = numJobs;
+		queue.next = 0;
+		pthread_mutex_init(&queue.mutex, NULL);
+
+		for (numWorkers = 0; numWorkers < numThreads - 1; numWorkers++)
+		{
+			if (pthread_create(&workers[numWorkers], NULL, ResCompressWorker, &queue) != 0)
+				break;
+		}
+		ResCompressWorker(&queue);
+		while (numWorkers > 0)
+			pthread_join(workers[--numWorkers], NULL);
+
+		pthread_mutex_destroy(&queue.mutex);
+		i = queue.next;
+	}
+#endif
+
+	for (; i < numJobs; i++)
+		ResCompress(&pjobs[i], NULL);
+}
+
+#ifdef RES_THREADS
+
+//	---------------------------------------------------------
+//
+//	ResCompressWorker() takes jobs off the queue until it's empty.  Jobs
+//		already taken are always finished, so those past the queue's
+//		next are all that can be left when every worker quits.
+
+static void *ResCompressWorker(void *arg)
+{
+	ResCompQueue *pq = arg;
+	LzwContext *plc = LzwContextCreate();
+	int32_t i;
+
+	if (plc == NULL)
+		return NULL;
+
+	while (TRUE)
+	{
+		pthread_mutex_lock(&pq->mutex);
+		i = pq->next;
+		if (i < pq->numJobs)
+			pq->next++;
+		pthread_mutex_unlock(&pq->mutex);
+		if (i >= pq->numJobs)
+			break;
+		ResCompress(&pq->pjobs[i], plc);
+	}
+
+	LzwContextDestroy(plc);
+	return NULL;
+}
+
+#endif
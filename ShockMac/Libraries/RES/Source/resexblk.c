@@ -0,0 +1,410 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResExBlk.c	Extract resources a block at a time
+
+//	A resource, or an item of a compound one, is passed to a block routine
+//	a block at a time as it's read or expanded, so big ones (movies, audio
+//	logs) never need to be in memory whole.  It goes through a ResStream,
+//	called in place or, pipelined, through a queue of blocks and a consumer
+//	thread.  Files are read a chunk at a time, each under ResLockFiles(),
+//	so the block routine may load other resources from the same file.
+//	LZW is expanded straight into the blocks with an LZW context of its
+//	own; LZ4 is quick enough that it's expanded whole, then passed on.
+//	Blocks are in file byte order, even for types with a layout.
+//
+//	Not reentrant: a block routine mustn't extract in blocks itself.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "res.h"
+#include "res_.h"
+#include "lz4.h"
+
+#define RES_EXBLK_READSIZE 16384		// bytes read from file at a time
+
+//	State of LZW source & destination (they don't get passed any)
+
+static Id resExId;						// resource being extracted
+static FILE *resExFd;					// its file, if not mapped
+static int32_t resExPos;				// file position of next read
+static uint8_t resExBuff[RES_EXBLK_READSIZE];	// bytes read from file
+static int32_t resExNext;				// next byte to use in resExBuff
+static int32_t resExEnd;				// # bytes in resExBuff
+
+static ResStream *resExStream;		// stream being expanded into
+static uint8_t *resExSpace;			// where next byte goes
+static int32_t resExAvail;				// # bytes left there
+static int32_t resExUsed;				// # bytes put there
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void ResExtractBlocks(Id id, RefTable *prt, int32_t index, void *buff,
+	int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock));
+static void ResExRead(Id id, int32_t pos, void *p, int32_t size);
+static void ResExCopy(Id id, ResStream *ps, int32_t pos, int32_t size);
+static bool ResExLz4Item(Id id, ResStream *ps, int32_t pos, int32_t index, int32_t size);
+static void ResExFileSrcCtrl(intptr_t srcLoc, LzwCtrl ctrl);
+static uint8_t ResExFileSrcGet();
+static void ResExStreamDestCtrl(intptr_t destLoc, LzwCtrl ctrl);
+static void ResExStreamDestPut(uint8_t byte);
+
+//	---------------------------------------------------------
+//
+//	ResExtractInBlocks() extracts a resource a block at a time, calling
+//		the block routine on each in turn.
+//
+//		id          = id of resource
+//		buff        = block buffer
+//		blockSize   = size of buffer, & of 1st block
+//		f_ProcBlock = block routine: gets buff, # bytes in it, and iblock
+//						  (block # & REBF_XXX flags), returns # bytes wanted
+//						  in the next block (0 or too many = blockSize)
+
+void ResExtractInBlocks(Id id, void *buff, int32_t blockSize,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResExtractBlocks(id, NULL, -1, buff, blockSize, 1, f_ProcBlock);
+}
+
+//	---------------------------------------------------------
+//
+//	RefExtractInBlocks() extracts an item of a compound resource a block
+//		at a time.
+//
+//		prt  = ptr to ref table, or NULL to get it from the file
+//		ref  = ref
+//		(rest as in ResExtractInBlocks())
+
+void RefExtractInBlocks(RefTable *prt, Ref ref, void *buff, int32_t blockSize,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResExtractBlocks(REFID(ref), prt, REFINDEX(ref), buff, blockSize, 1, f_ProcBlock);
+}
+
+//	---------------------------------------------------------
+//
+//	ResExtractInBlocksPiped() extracts a resource a block at a time, with
+//		reading & expanding running ahead of the block routine.  It is
+//		called on a consumer thread, in order, on blocks of blockSize
+//		(but the last), and its return value is ignored.  Where there are
+//		no threads, this is ResExtractInBlocks() with a buffer of its own.
+//
+//		id          = id of resource
+//		blockSize   = size of blocks
+//		queueDepth  = # blocks that may be in flight (2 = double-buffered)
+//		f_ProcBlock = block routine
+
+void ResExtractInBlocksPiped(Id id, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResExtractBlocks(id, NULL, -1, NULL, blockSize, queueDepth, f_ProcBlock);
+}
+
+//	---------------------------------------------------------
+//
+//	RefExtractInBlocksPiped() is the same for an item of a compound
+//		resource.
+
+void RefExtractInBlocksPiped(RefTable *prt, Ref ref, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResExtractBlocks(REFID(ref), prt, REFINDEX(ref), NULL, blockSize, queueDepth, f_ProcBlock);
+}
+
+//	--------------------------------------------------------
+//		INTERNAL ROUTINES
+//	--------------------------------------------------------
+//
+//	ResExtractBlocks() streams out a resource, or an item of one.
+//
+//		id    = id of resource
+//		prt   = ptr to ref table, or NULL
+//		index = item index, or -1 for whole resource
+//		(rest as passed to ResStreamOpen())
+
+static void ResExtractBlocks(Id id, RefTable *prt, int32_t index, void *buff,
+	int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResDesc *prd = RESDESC(id);
+	uint8_t flags = ResFlags(id);
+	ResStream *ps;
+	LzwContext *plc;
+	uint8_t *p;
+	int32_t pos, sizeTable, skip, size;
+	int32_t offsets[2];
+	RefIndex numRefs;
+
+	CUMSTATS(id,numExtracts);
+
+	//	In memory (and whole, and not swapped from file order), just pass
+	//	the bytes on
+	if (prd->ptr && !ResIsPartial(id) && ResTypeLayout(ResType(id)) == NULL)
+	{
+		p = prd->ptr;
+		skip = (index >= 0) ? ((RefTable *) p)->offset[index] : 0;
+		size = (index >= 0) ? RefSize(((RefTable *) p), index) : prd->size;
+		ps = ResStreamOpen(size, buff, blockSize, queueDepth, f_ProcBlock);
+		if (ps)
+		{
+			ResStreamWrite(ps, p + skip, size);
+			ResStreamClose(ps);
+		}
+		return;
+	}
+
+	//	Whole LZ4 resources are expanded whole
+	if ((flags & RDF_LZ4) && index < 0)
+	{
+		p = malloc(prd->size);
+		ps = p ? ResStreamOpen(prd->size, buff, blockSize, queueDepth, f_ProcBlock) : NULL;
+		if (ps)
+		{
+			if (ResRetrieveDesc(id, prd, flags, ResType(id), p, NULL))
+			{
+				ResSwapLoaded(ResType(id), flags, p, prd->size);		// back to file order
+				ResStreamWrite(ps, p, prd->size);
+			}
+			ResStreamClose(ps);
+		}
+		free(p);
+		return;
+	}
+
+	//	Find the data: the item wanted, or all past the ref table (which is
+	//	passed on as is)
+	pos = RES_OFFSET_DESC2REAL(prd->offset);
+	sizeTable = 0;
+	skip = 0;
+	size = prd->size;
+	if (flags & RDF_COMPOUND)
+	{
+		ResExRead(id, pos, &numRefs, sizeof(RefIndex));
+		sizeTable = REFTABLESIZE(numRefs);
+		if (index >= 0)
+		{
+			if (prt)
+			{
+				offsets[0] = prt->offset[index];
+				offsets[1] = prt->offset[index + 1];
+			}
+			else
+				ResExRead(id, pos + sizeof(RefIndex) + index * sizeof(int32_t), offsets,
+					sizeof(offsets));
+			skip = offsets[0] - sizeTable;
+			size = offsets[1] - offsets[0];
+		}
+	}
+
+	ps = ResStreamOpen(size, buff, blockSize, queueDepth, f_ProcBlock);
+	if (ps == NULL)
+		return;
+	if (index < 0 && sizeTable)
+	{
+		ResExCopy(id, ps, pos, sizeTable);
+		size -= sizeTable;
+	}
+	pos += sizeTable;
+
+	//	An LZ4 item is expanded from its own block, LZW is expanded into
+	//	the stream (skipping up to the item), and the rest just copied
+	if (flags & RDF_LZ4)
+		ResExLz4Item(id, ps, pos, index, size);
+	else if ((flags & RDF_LZW) && size > 0 && (plc = LzwContextCreate()) != NULL)
+	{
+		resExId = id;
+		resExFd = resFile[prd->filenum].fd;
+		if (resFile[prd->filenum].pmap)
+			LzwContextExpand(plc, LzwBuffSrcE(resFile[prd->filenum].pmap + pos),
+				ResExStreamDestCtrl, ResExStreamDestPut, (intptr_t) ps, skip, size);
+		else
+			LzwContextExpand(plc, ResExFileSrcCtrl, ResExFileSrcGet, pos,
+				ResExStreamDestCtrl, ResExStreamDestPut, (intptr_t) ps, skip, size);
+		LzwContextDestroy(plc);
+	}
+	else if (!(flags & RDF_LZW))
+		ResExCopy(id, ps, pos + skip, size);
+
+	ResStreamClose(ps);
+}
+
+//	---------------------------------------------------------
+//
+//	ResExRead() reads bytes of a resource's file, mapped or not.
+//
+//		id   = id of resource
+//		pos  = file position
+//		p    = where to put them
+//		size = # bytes
+
+static void ResExRead(Id id, int32_t pos, void *p, int32_t size)
+{
+	ResFile *prf = &resFile[RESDESC(id)->filenum];
+
+	if (prf->pmap)
+		memcpy(p, prf->pmap + pos, size);
+	else
+	{
+		ResLockFiles();
+		fseek(prf->fd, pos, SEEK_SET);
+		fread(p, size, 1, prf->fd);
+		ResUnlockFiles();
+		ResTelemCount(id, ResType(id), RES_TELEM_BYTESREAD, size);
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResExCopy() copies bytes of a resource's file into a stream, a block
+//		(or less) at a time, straight into the blocks.
+//
+//		id   = id of resource
+//		ps   = ptr to stream
+//		pos  = file position
+//		size = # bytes
+
+static void ResExCopy(Id id, ResStream *ps, int32_t pos, int32_t size)
+{
+	ResFile *prf = &resFile[RESDESC(id)->filenum];
+	uint8_t *pspace;
+	int32_t avail;
+
+	if (prf->pmap)
+	{
+		ResStreamWrite(ps, prf->pmap + pos, size);
+		return;
+	}
+
+	while (size > 0)
+	{
+		pspace = ResStreamSpace(ps, &avail);
+		if (avail == 0)
+			break;
+		if (avail > size)
+			avail = size;
+		ResExRead(id, pos, pspace, avail);
+		ResStreamAdvance(ps, avail);
+		pos += avail;
+		size -= avail;
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResExLz4Item() expands an item of an LZ4 compound resource, from its
+//		own LZ4 block, into a stream.
+//
+//		id    = id of resource
+//		ps    = ptr to stream
+//		pos   = file position of LZ4 item table (past ref table)
+//		index = item index
+//		size  = item size
+//
+//	Returns: TRUE if ok, FALSE if data bad or out of memory
+
+static bool ResExLz4Item(Id id, ResStream *ps, int32_t pos, int32_t index, int32_t size)
+{
+	uint8_t head[8];
+	uint8_t *pcomp, *pexp;
+	int32_t csize;
+	bool ok;
+
+	ResExRead(id, pos + index * sizeof(int32_t), head, sizeof(head));
+	csize = LZ4_ITEMOFFSET(head, 1) - LZ4_ITEMOFFSET(head, 0);
+	if (csize <= 0)
+		return FALSE;
+	pcomp = malloc(csize);
+	pexp = malloc(size + 1);
+	ok = (pcomp && pexp);
+	if (ok)
+	{
+		ResExRead(id, pos + LZ4_ITEMOFFSET(head, 0), pcomp, csize);
+		ok = (Lz4Expand(pcomp, csize, pexp, size) == size);
+	}
+	if (ok)
+		ResStreamWrite(ps, pexp, size);
+	free(pexp);
+	free(pcomp);
+	return ok;
+}
+
+//	---------------------------------------------------------
+//
+//	LZW source: a resfile, read a chunk at a time from where the last
+//		chunk left off (others may seek the file in between).
+
+static void ResExFileSrcCtrl(intptr_t srcLoc, LzwCtrl ctrl)
+{
+	if (ctrl == BEGIN)
+	{
+		resExPos = srcLoc;
+		resExNext = resExEnd = 0;
+	}
+}
+
+static uint8_t ResExFileSrcGet()
+{
+	if (resExNext == resExEnd)
+	{
+		ResLockFiles();
+		fseek(resExFd, resExPos, SEEK_SET);
+		resExEnd = fread(resExBuff, 1, sizeof(resExBuff), resExFd);
+		ResUnlockFiles();
+		ResTelemCount(resExId, ResType(resExId), RES_TELEM_BYTESREAD, resExEnd);
+		resExPos += resExEnd;
+		resExNext = 0;
+		if (resExEnd == 0)
+			return 0;
+	}
+	return resExBuff[resExNext++];
+}
+
+//	---------------------------------------------------------
+//
+//	LZW destination: a stream, bytes going straight into its blocks.
+
+static void ResExStreamDestCtrl(intptr_t destLoc, LzwCtrl ctrl)
+{
+	if (ctrl == BEGIN)
+	{
+		resExStream = (ResStream *) destLoc;
+		resExAvail = resExUsed = 0;
+	}
+	else if (resExUsed)
+		ResStreamAdvance(resExStream, resExUsed);
+}
+
+static void ResExStreamDestPut(uint8_t byte)
+{
+	if (resExAvail == 0)
+	{
+		if (resExUsed)
+			ResStreamAdvance(resExStream, resExUsed);
+		resExUsed = 0;
+		resExSpace = ResStreamSpace(resExStream, &resExAvail);
+		if (resExAvail == 0)
+			return;
+	}
+	*resExSpace++ = byte;
+	resExAvail--;
+	resExUsed++;
+}
@@ -0,0 +1,416 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResFetch.c	Prefetch resources in background
+
+//	Prefetches are jobs in a small fixed table.  The game thread issues
+//	them and takes them back; worker threads only ever touch the job they
+//	are loading, from a private copy of the resource descriptor, so the
+//	descriptor table can grow and change underneath them.  Seeks and reads
+//	of resfiles are serialized between everybody (ResLockFiles()), but
+//	compressed data is read whole and expanded after the file is let go,
+//	so expansion runs fully in parallel, mapped resfiles or not.
+
+#include <string.h>
+#ifdef RES_THREADS
+#include <pthread.h>
+#endif
+
+#include "res.h"
+#include "res_.h"
+
+ResPrefetchStat resPrefetchStat;
+
+#ifdef RES_THREADS
+
+#define RES_PREFETCH_MAX 256			// max prefetches pending (power of 2)
+#define RES_PREFETCH_MAXTHREADS 8	// max worker threads
+
+typedef enum {
+	PF_FREE,				// job slot not in use
+	PF_QUEUED,			// waiting for a worker
+	PF_LOADING,			// worker is loading it
+	PF_DONE,				// loaded (ptr NULL if failed), waiting to be taken
+	PF_CANCELLED		// cancelled while queued, worker frees slot
+} ResPrefetchState;
+
+typedef struct {
+	Id id;					// resource id
+	uint8_t state;			// PF_XXX
+	uint8_t flags;			// copy of resource flags
+	uint8_t type;			// & type
+	ResDesc desc;			// copy of resource descriptor
+	void *ptr;				// loaded data, once done
+} ResPrefetchJob;
+
+static ResPrefetchJob resJobs[RES_PREFETCH_MAX];
+static int16_t resQueue[RES_PREFETCH_MAX];		// job indices, in order issued
+static uint32_t resQueueHead;						// next to hand to a worker
+static uint32_t resQueueTail;						// next free queue entry
+
+static pthread_t resWorkers[RES_PREFETCH_MAXTHREADS];
+static int32_t resNumWorkers;
+static bool resWorkersStop;						// set to tell workers to quit
+static bool resFilesShared;						// set while workers may read files
+
+static pthread_mutex_t resJobMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resJobQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t resJobDone = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t resFileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void *ResPrefetchWorker(void *arg);
+static ResPrefetchJob *ResFindJob(Id id);
+static void *ResFinishJob(ResPrefetchJob *pj);
+
+//	---------------------------------------------------------
+//
+//	ResPrefetchStart() starts prefetch worker threads.  ResPrefetch()
+//		starts DEFAULT_RES_PREFETCH_THREADS itself if none are running,
+//		so this need only be called to pick another number.
+//
+//		numThreads = # worker threads wanted
+//
+//	Returns: # worker threads running
+
+int32_t ResPrefetchStart(int32_t numThreads)
+{
+	if (numThreads > RES_PREFETCH_MAXTHREADS)
+		numThreads = RES_PREFETCH_MAXTHREADS;
+
+	resFilesShared = TRUE;
+	while (resNumWorkers < numThreads)
+	{
+		if (pthread_create(&resWorkers[resNumWorkers], NULL, ResPrefetchWorker, NULL) != 0)
+			break;
+		resNumWorkers++;
+	}
+	resFilesShared = (resNumWorkers > 0);
+
+	return resNumWorkers;
+}
+
+//	---------------------------------------------------------
+//
+//	ResPrefetchStop() stops the worker threads, and throws away all
+//		prefetches not yet taken.
+
+void ResPrefetchStop()
+{
+	ResPrefetchJob *pj;
+	int32_t i;
+
+	if (resNumWorkers == 0)
+		return;
+
+	//	Workers finish the job in hand, then quit
+	pthread_mutex_lock(&resJobMutex);
+	resWorkersStop = TRUE;
+	pthread_cond_broadcast(&resJobQueued);
+	pthread_mutex_unlock(&resJobMutex);
+	for (i = 0; i < resNumWorkers; i++)
+		pthread_join(resWorkers[i], NULL);
+	resNumWorkers = 0;
+	resWorkersStop = FALSE;
+	resFilesShared = FALSE;
+
+	//	Free whatever they left behind
+	for (pj = resJobs; pj < resJobs + RES_PREFETCH_MAX; pj++)
+	{
+		if (pj->state != PF_FREE && pj->state != PF_CANCELLED)
+			gResDesc2[pj->id].flags &= ~RDF_PREFETCH;
+		if (pj->ptr)
+			free(pj->ptr);
+		pj->ptr = NULL;
+		pj->state = PF_FREE;
+	}
+	resQueueHead = resQueueTail = 0;
+}
+
+//	---------------------------------------------------------
+//
+//	ResPrefetch() queues a resource to be loaded by a worker thread.
+//		Resources which are already in memory, already being prefetched,
+//		or used in place in a mapped resfile are left alone.  If too many
+//		prefetches are pending, the resource just loads when used.
+//
+//		id = resource id
+
+void ResPrefetch(Id id)
+{
+	ResPrefetchJob *pj;
+
+	if (!ResInUse(id) || ResPtr(id) || (ResFlags(id) & (RDF_PREFETCH | RDF_MAPPED)))
+		return;
+	if (resNumWorkers == 0 && ResPrefetchStart(DEFAULT_RES_PREFETCH_THREADS) == 0)
+		return;
+
+	//	Grab a free job slot, else drop it
+	pthread_mutex_lock(&resJobMutex);
+	for (pj = resJobs; pj < resJobs + RES_PREFETCH_MAX; pj++)
+	{
+		if (pj->state == PF_FREE)
+			break;
+	}
+	if (pj == resJobs + RES_PREFETCH_MAX)
+	{
+		pthread_mutex_unlock(&resJobMutex);
+		resPrefetchStat.numDropped++;
+		return;
+	}
+
+	//	Fill it in and queue it (queue can't overflow, it holds every slot)
+	pj->id = id;
+	pj->state = PF_QUEUED;
+	pj->flags = ResFlags(id);
+	pj->type = ResType(id);
+	pj->desc = *RESDESC(id);
+	pj->ptr = NULL;
+	resQueue[resQueueTail++ & (RES_PREFETCH_MAX - 1)] = pj - resJobs;
+	gResDesc2[id].flags |= RDF_PREFETCH;
+	pthread_cond_signal(&resJobQueued);
+	pthread_mutex_unlock(&resJobMutex);
+
+	resPrefetchStat.numIssued++;
+}
+
+//	---------------------------------------------------------
+//
+//	ResPrefetchTake() collects a prefetched resource, for ResLoadResource().
+//		If a worker is loading it, waits for it.  If no worker has got
+//		to it yet, cancels it, since loading it right away is quicker.
+//
+//		id = resource id (with RDF_PREFETCH set)
+//
+//	Returns: ptr to loaded resource, or NULL if caller must load it
+
+void *ResPrefetchTake(Id id)
+{
+	ResPrefetchJob *pj;
+	void *ptr = NULL;
+
+	gResDesc2[id].flags &= ~RDF_PREFETCH;
+
+	pthread_mutex_lock(&resJobMutex);
+	pj = ResFindJob(id);
+	if (pj && pj->state == PF_QUEUED)
+		pj->state = PF_CANCELLED;
+	else if (pj)
+	{
+		if (pj->state == PF_LOADING)
+			resPrefetchStat.numLateHits++;
+		else
+			resPrefetchStat.numHits++;
+		ptr = ResFinishJob(pj);
+	}
+	pthread_mutex_unlock(&resJobMutex);
+
+	return ptr;
+}
+
+//	---------------------------------------------------------
+//
+//	ResPrefetchCancel() forgets a prefetch, freeing anything loaded.
+//
+//		id = resource id (with RDF_PREFETCH set)
+
+void ResPrefetchCancel(Id id)
+{
+	ResPrefetchJob *pj;
+
+	gResDesc2[id].flags &= ~RDF_PREFETCH;
+
+	pthread_mutex_lock(&resJobMutex);
+	pj = ResFindJob(id);
+	if (pj && pj->state == PF_QUEUED)
+		pj->state = PF_CANCELLED;
+	else if (pj)
+		free(ResFinishJob(pj));
+	pthread_mutex_unlock(&resJobMutex);
+}
+
+//	---------------------------------------------------------
+//
+//	ResPrefetchCancelFile() forgets all prefetches from a resfile, so it
+//		can be closed.
+//
+//		filenum = resfile number
+
+void ResPrefetchCancelFile(int32_t filenum)
+{
+	ResPrefetchJob *pj;
+
+	if (resNumWorkers == 0)
+		return;
+
+	pthread_mutex_lock(&resJobMutex);
+	for (pj = resJobs; pj < resJobs + RES_PREFETCH_MAX; pj++)
+	{
+		if (pj->state == PF_FREE || pj->state == PF_CANCELLED || pj->desc.filenum != filenum)
+			continue;
+		gResDesc2[pj->id].flags &= ~RDF_PREFETCH;
+		if (pj->state == PF_QUEUED)
+			pj->state = PF_CANCELLED;
+		else
+			free(ResFinishJob(pj));
+	}
+	pthread_mutex_unlock(&resJobMutex);
+}
+
+//	---------------------------------------------------------
+//
+//	ResLockFiles() and ResUnlockFiles() bracket each seek & read of
+//		a resfile, while workers are around to share them.
+
+void ResLockFiles()
+{
+	if (resFilesShared)
+		pthread_mutex_lock(&resFileMutex);
+}
+
+void ResUnlockFiles()
+{
+	if (resFilesShared)
+		pthread_mutex_unlock(&resFileMutex);
+}
+
+//	--------------------------------------------------------
+//		INTERNAL ROUTINES
+//	--------------------------------------------------------
+//
+//	ResPrefetchWorker() is a worker thread.  Each has its own LZW context,
+//		so they can all be expanding at once.
+
+static void *ResPrefetchWorker(void *arg)
+{
+	LzwContext *plc = LzwContextCreate();
+	ResPrefetchJob *pj;
+	void *ptr;
+
+	(void) arg;
+	pthread_mutex_lock(&resJobMutex);
+	while (TRUE)
+	{
+		//	Wait for a job, or to be told to quit
+		while (resQueueHead == resQueueTail && !resWorkersStop)
+			pthread_cond_wait(&resJobQueued, &resJobMutex);
+		if (resWorkersStop)
+			break;
+		pj = &resJobs[resQueue[resQueueHead++ & (RES_PREFETCH_MAX - 1)]];
+		if (pj->state == PF_CANCELLED)
+		{
+			pj->state = PF_FREE;
+			continue;
+		}
+
+		//	Load it, with nobody else touching the job meanwhile
+		pj->state = PF_LOADING;
+		pthread_mutex_unlock(&resJobMutex);
+
+		ptr = plc ? malloc(pj->desc.size) : NULL;
+		if (ptr && !ResRetrieveDesc(pj->id, &pj->desc, pj->flags, pj->type, ptr, plc))
+		{
+			free(ptr);
+			ptr = NULL;
+		}
+
+		pthread_mutex_lock(&resJobMutex);
+		pj->ptr = ptr;
+		pj->state = PF_DONE;
+		pthread_cond_broadcast(&resJobDone);
+	}
+	pthread_mutex_unlock(&resJobMutex);
+
+	if (plc)
+		LzwContextDestroy(plc);
+	return NULL;
+}
+
+//	---------------------------------------------------------
+//
+//	ResFindJob() finds the live job for a resource (call with job mutex).
+//
+//	Returns: ptr to job, or NULL if none
+
+static ResPrefetchJob *ResFindJob(Id id)
+{
+	ResPrefetchJob *pj;
+
+	for (pj = resJobs; pj < resJobs + RES_PREFETCH_MAX; pj++)
+	{
+		if (pj->id == id && pj->state != PF_FREE && pj->state != PF_CANCELLED)
+			return pj;
+	}
+	return NULL;
+}
+
+//	---------------------------------------------------------
+//
+//	ResFinishJob() waits for a job being loaded to be done, and frees
+//		its slot (call with job mutex).
+//
+//	Returns: ptr to loaded data, now owned by caller
+
+static void *ResFinishJob(ResPrefetchJob *pj)
+{
+	void *ptr;
+
+	while (pj->state == PF_LOADING)
+		pthread_cond_wait(&resJobDone, &resJobMutex);
+	ptr = pj->ptr;
+	pj->ptr = NULL;
+	pj->state = PF_FREE;
+	return ptr;
+}
+
+#else
+
+//	Without threads there's nobody to prefetch, so resources are
+//	always loaded when used.
+
+int32_t ResPrefetchStart(int32_t numThreads)
+{
+	return 0;
+}
+
+void ResPrefetchStop()
+{
+}
+
+void ResPrefetch(Id id)
+{
+}
+
+void *ResPrefetchTake(Id id)
+{
+	gResDesc2[id].flags &= ~RDF_PREFETCH;
+	return NULL;
+}
+
+void ResPrefetchCancel(Id id)
+{
+	gResDesc2[id].flags &= ~RDF_PREFETCH;
+}
+
+void ResPrefetchCancelFile(int32_t filenum)
+{
+}
+
+#endif
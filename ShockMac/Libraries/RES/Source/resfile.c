@@ -38,10 +38,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *
 */
 
+#ifdef RES_MMAP
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 //#include <fcntl.h>
 //#include <sys\stat.h>
 //#include <io.h>
 #include <string.h>
+#ifdef RES_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "res.h"
 #include "res_.h"
@@ -67,7 +75,10 @@ ResSpoofDrive gSpoofDrive;
 //	Internal prototypes
 
 int ResFindFreeFilenum();
-void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags);
+void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags,
+	ResIndexEntry *pindex);
+void ResReadDirIndexed(int filenum, char *fname, int32_t dirOffset,
+	ResDirHeader *pDirHead, uint32_t add_flags);
 void ResProcDirEntry(ResDirEntry *pDirEntry, int filenum, long dataOffset, uint32_t add_flags);
 void ResReadEditInfo(ResFile *prf);
 void ResReadDir(ResFile *prf, int filenum);
@@ -75,6 +86,8 @@ void ResCreateEditInfo(ResFile *prf, int filenum);
 void ResCreateDir(ResFile *prf);
 void ResWriteDir(int filenum);
 void ResWriteHeader(int filenum);
+void ResMapFileImage(ResFile *prf);
+void ResUnmapFileImage(ResFile *prf);
 
 //	---------------------------------------------------------
 //
@@ -96,7 +109,12 @@ void ResAddPath(char *path)
 //		fname   = ptr to filename
 //		mode    = ROM_XXX (see res.h)
 //		auxinfo = if TRUE, allocate aux info, including directory
-//						(applies to mode 0, other modes automatically get it)
+//						(applies to ROM_READ and ROM_MAP, other modes
+//						automatically get it)
+//
+//	With ROM_MAP the whole file is mapped copy-on-write, and uncompressed
+//	simple resources are used in place instead of being loaded.  Where
+//	files can't be mapped, ROM_MAP acts just like ROM_READ.
 //
 //	Returns:
 //
@@ -180,7 +198,7 @@ int ResOpenResFile(char *fname, ResOpenMode mode, bool auxinfo)
 
 	prf = &resFile[filenum];
 	prf->pedit = NULL;
-	if (mode || auxinfo)
+	if ((mode != ROM_READ && mode != ROM_MAP) || auxinfo)
 		{
 		prf->pedit = (ResEditInfo *)malloc(sizeof(ResEditInfo));
 		if (prf->pedit == NULL)
@@ -198,6 +216,13 @@ int ResOpenResFile(char *fname, ResOpenMode mode, bool auxinfo)
 //	Spew(DSRC_RES_General, ("ResOpenResFile: opening: %s at filenum %d\n",
 //		fname, filenum));
 
+//	If asked to, map file image before directory is processed
+
+	prf->pmap = NULL;
+	prf->mapSize = 0;
+	if (mode == ROM_MAP)
+		ResMapFileImage(prf);
+
 //	Switch based on mode
 
 	switch (mode)
@@ -207,6 +232,7 @@ int ResOpenResFile(char *fname, ResOpenMode mode, bool auxinfo)
 //	if no edit info then process piecemeal.
 
 		case ROM_READ:
+		case ROM_MAP:
 		case ROM_EDIT:
 		case ROM_EDITCREATE:
 			if (prf->pedit)
@@ -222,7 +248,8 @@ int ResOpenResFile(char *fname, ResOpenMode mode, bool auxinfo)
 				fread(&dirHead, 1, sizeof(ResDirHeader), fd);
 				dirHead.numEntries = SwapShortBytes(dirHead.numEntries); 	//
 				dirHead.dataOffset = SwapLongBytes(dirHead.dataOffset);		//
-//				ResReadDirEntries(filenum, &dirHead, (cd_spoof) ? RDF_CDSPOOF : 0);
+				ResReadDirIndexed(filenum, fname, fileHead.dirOffset, &dirHead,
+					(cd_spoof) ? RDF_CDSPOOF : 0);
 				}
 			break;
 
@@ -275,6 +302,26 @@ void ResCloseFile(int filenum)
 			ResDelete(id);
 		}
 */
+//	Forget prefetches from this file, workers may be reading it
+
+	ResPrefetchCancelFile(filenum);
+
+//	If mapped, drop resources which live in the file image, then unmap it
+
+	if (resFile[filenum].pmap)
+		{
+		for (id = ID_MIN; id <= resDescMax; id++)
+			{
+			if (ResInUse(id) && (ResFilenum(id) == filenum) && ResIsMapped(id))
+				{
+				if (ResPtr(id))
+					ResDrop(id);
+				gResDesc2[id].flags &= ~RDF_MAPPED;
+				}
+			}
+		ResUnmapFileImage(&resFile[filenum]);
+		}
+
 //	Free up memory
 
 	if (resFile[filenum].pedit)
@@ -318,8 +365,10 @@ int ResFindFreeFilenum()
 //		pDirHead = ptr to directory header
 //    add_flags = additional flags to OR into RDF flags for all
 //                resources in this file.
+//		pindex   = ptr to array to record entries in for index, or NULL
 
-void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags)
+void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags,
+	ResIndexEntry *pindex)
 {
 #define NUM_DIRENTRY_BLOCK 64		// (12 bytes each)
 	int entry;
@@ -355,6 +404,19 @@ void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags)
 
 		ResProcDirEntry(pDirEntry, filenum, dataOffset, add_flags);
 
+//	Record it for index, if one's being made
+
+		if (pindex && pDirEntry->id != 0)
+			{
+			pindex->id = pDirEntry->id;
+			pindex->flags = pDirEntry->flags & ~RDF_RUNTIME;
+			pindex->type = pDirEntry->type;
+			pindex->size = pDirEntry->size;
+			pindex->csize = pDirEntry->csize;
+			pindex->offset = dataOffset;
+			pindex++;
+			}
+
 //	Advance file offset and get next
 
 		dataOffset = RES_OFFSET_ALIGN(dataOffset + pDirEntry->csize);
@@ -362,6 +424,69 @@ void ResReadDirEntries(int filenum, ResDirHeader *pDirHead, uint32_t add_flags)
 		}
 }
 
+//	----------------------------------------------------------
+//
+//	ResReadDirIndexed() reads in a directory from the resource file's index
+//		if it's up to date, in one pass.  Else reads in the directory
+//		entry by entry, and indexes what it gave for next time.
+//		(file seek should be set to 1st directory entry)
+//
+//		filenum   = file number
+//		fname     = resource file name
+//		dirOffset = file offset of directory
+//		pDirHead  = ptr to directory header
+//    add_flags = additional flags to OR into RDF flags for all
+//                resources in this file.
+
+void ResReadDirIndexed(int filenum, char *fname, int32_t dirOffset,
+	ResDirHeader *pDirHead, uint32_t add_flags)
+{
+	ResIndexHeader stamp;
+	ResIndexHeader *phead;
+	ResIndexEntry *pie, *pieEnd, *piePut;
+	ResDirEntry dirEntry;
+	size_t size;
+
+//	If index good, grow table once for highest id, and apply entries
+
+	ResIndexStamp(resFile[filenum].fd, dirOffset, &stamp);
+	phead = ResIndexLoad(fname, &stamp, &size);
+	if (phead)
+		{
+		pie = (ResIndexEntry *) (phead + 1);
+		pieEnd = pie + phead->numEntries;
+		if (pie < pieEnd)
+			ResExtendDesc(pieEnd[-1].id);
+		for (; pie < pieEnd; pie++)
+			{
+			dirEntry.id = pie->id;
+			dirEntry.size = pie->size;
+			dirEntry.csize = pie->csize;
+			dirEntry.flags = pie->flags;
+			dirEntry.type = pie->type;
+			ResProcDirEntry(&dirEntry, filenum, pie->offset, add_flags);
+			}
+		ResIndexFree(phead, size);
+		return;
+		}
+
+//	Else read directory, recording entries, and index them.  If an id
+//	comes up twice in the directory, the last one counts, as it does in
+//	the resource descriptor.
+
+	pie = calloc(pDirHead->numEntries + 1, sizeof(ResIndexEntry));
+	ResReadDirEntries(filenum, pDirHead, add_flags, pie);
+	if (pie == NULL)
+		return;
+	for (pieEnd = piePut = pie; pieEnd->id != 0; pieEnd++)
+		{
+		if (RES_OFFSET_DESC2REAL(gResDesc[pieEnd->id].offset) == pieEnd->offset)
+			*piePut++ = *pieEnd;
+		}
+	ResIndexSave(fname, &stamp, pie, piePut - pie);
+	free(pie);
+}
+
 //	-----------------------------------------------------------
 //
 //	ResProcDirEntry() processes directory entry, sets res desc.
@@ -394,20 +519,37 @@ void ResProcDirEntry(ResDirEntry *pDirEntry, int filenum, long dataOffset, uint3
 //      Warning(("RESOURCE ID COLLISION AT ID %x!!\n",pDirEntry->id));
 		CUMSTATS(pDirEntry->id,numOverwrites);
 //		ResDelete(pDirEntry->id);
+		if (!(prd2->flags & RDF_MAPPED))
+			ResCacheRemove(pDirEntry->id);
 		}
 
+//	Forget any prefetch of the resource this one replaces
+
+	if (prd2->flags & RDF_PREFETCH)
+		ResPrefetchCancel(pDirEntry->id);
+
 //	Fill in resource descriptor
 
 	prd->ptr = NULL;
 	prd->size = pDirEntry->size;
+	prd->csize = pDirEntry->csize;
 	prd->filenum = filenum;
 	prd->lock = 0;
 	prd->offset = RES_OFFSET_REAL2DESC(dataOffset);
-	prd2->flags = pDirEntry->flags | add_flags;
+	prd2->flags = (pDirEntry->flags & ~RDF_RUNTIME) | add_flags;
 	prd2->type = pDirEntry->type;
 	prd->next = 0;
 	prd->prev = 0;
 
+//	If file is mapped, uncompressed simple resources are used in place, if
+//	they needn't be byte swapped
+
+	if (resFile[filenum].pmap && !(prd2->flags & (RDF_LZW | RDF_LZ4 | RDF_COMPOUND)) &&
+		dataOffset >= 0 && pDirEntry->size >= 0 &&
+		((size_t) (dataOffset + pDirEntry->size) <= resFile[filenum].mapSize) &&
+		ResTypeLayout(prd2->type) == NULL)
+		prd2->flags |= RDF_MAPPED;
+
 //	If loadonopen flag set, load resource
 
 //	if (pDirEntry->flags & RDF_LOADONOPEN)
@@ -550,8 +692,10 @@ void ResWriteDir(int filenum)
 	// Spew(DSRC_RES_Write, ("ResWriteDir: writing directory for filenum %d\n", filenum));
 
 	prf = &resFile[filenum];
+	ResLockFiles();
 	fseek(prf->fd, prf->pedit->currDataOffset, SEEK_SET);
 	fwrite(prf->pedit->pdir, sizeof(ResDirHeader) + (prf->pedit->pdir->numEntries * sizeof(ResDirEntry)), 1, prf->fd);
+	ResUnlockFiles();
 }
 
 //	--------------------------------------------------------
@@ -571,8 +715,47 @@ void ResWriteHeader(int filenum)
 	prf = &resFile[filenum];
 	prf->pedit->hdr.dirOffset = prf->pedit->currDataOffset;
 
+	ResLockFiles();
 	fseek(prf->fd, 0L, SEEK_SET);
 	fwrite(&prf->pedit->hdr, sizeof(ResFileHeader), 1, prf->fd);
+	ResUnlockFiles();
+}
+
+//	--------------------------------------------------------
+//
+//	ResMapFileImage() maps an open resource file copy-on-write, so that
+//	resources used in place can be changed in place, as loaded ones can.
+//	On failure pmap is left NULL, and resources are read from the file
+//	as usual.
+
+void ResMapFileImage(ResFile *prf)
+{
+#ifdef RES_MMAP
+	struct stat st;
+	void *p;
+
+	if (fstat(fileno(prf->fd), &st) != 0 || st.st_size <= 0)
+		return;
+	p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(prf->fd), 0);
+	if (p == MAP_FAILED)
+		return;
+	prf->pmap = (uint8_t *) p;
+	prf->mapSize = st.st_size;
+#endif
+}
+
+//	--------------------------------------------------------
+//
+//	ResUnmapFileImage() releases the file image of a mapped resource file.
+
+void ResUnmapFileImage(ResFile *prf)
+{
+#ifdef RES_MMAP
+	if (prf->pmap)
+		munmap(prf->pmap, prf->mapSize);
+#endif
+	prf->pmap = NULL;
+	prf->mapSize = 0;
 }
 
 // Sets the path that the resource system will treat as a virtual CD
@@ -0,0 +1,305 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResIndex.C		Resource file directory index
+//
+//	Opening a resource file walks its whole directory, entry by entry.
+//	To save that at startup, the directory is also kept in an index file
+//	beside the resource file (name + ".rix"): a snapshot of its entries,
+//	sorted by id and checksummed, which can be mapped and applied in one
+//	pass.  The index is stamped with the size, modification time, and
+//	directory offset of the resource file it was made from; if they don't
+//	match (or the index is damaged), it's ignored and made anew.
+//
+//	The index is a cache for this machine, so it's in native byte order
+//	and layout; one from elsewhere fails the byte order check.
+
+#ifdef RES_MMAP
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef RES_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "res.h"
+#include "res_.h"
+
+//	Index files start with this signature
+
+char resIndexSignature[16] = {
+	'L','G',' ','R','e','s','I','n','d','e','x',' ','v','2',13,10};
+
+//	Internal prototypes
+
+char *ResIndexName(char *fname);
+uint32_t ResIndexChecksum(ResIndexEntry *pentries, int32_t numEntries);
+int ResIndexCompare(const void *p1, const void *p2);
+
+//	---------------------------------------------------------
+//
+//	ResIndexStamp() fills in an index header for an open resource file,
+//		to write with an index of it or check one against.  The file
+//		position is left alone.
+//
+//		fd        = open resource file
+//		dirOffset = file offset of its directory
+//		pstamp    = ptr to index header to fill in
+//
+//	Without POSIX file status, the modification time is left 0, and only
+//	size & directory offset tell if an index is stale.
+
+void ResIndexStamp(FILE *fd, int32_t dirOffset, ResIndexHeader *pstamp)
+{
+#ifdef RES_MMAP
+	struct stat st;
+#endif
+	long pos;
+
+	memset(pstamp, 0, sizeof(ResIndexHeader));
+	memcpy(pstamp->signature, resIndexSignature, sizeof(resIndexSignature));
+	pstamp->byteOrder = RES_INDEX_BYTEORDER;
+	pstamp->dirOffset = dirOffset;
+
+#ifdef RES_MMAP
+	if (fstat(fileno(fd), &st) == 0)
+		{
+		pstamp->fileSize = (int32_t) st.st_size;
+		pstamp->fileTime = (int64_t) st.st_mtime;
+		return;
+		}
+#endif
+	pos = ftell(fd);
+	fseek(fd, 0, SEEK_END);
+	pstamp->fileSize = (int32_t) ftell(fd);
+	fseek(fd, pos, SEEK_SET);
+}
+
+//	---------------------------------------------------------
+//
+//	ResIndexLoad() gets the index of a resource file, if there's one
+//		and it's up to date and intact.
+//
+//		fname  = resource file name
+//		pstamp = ptr to header from ResIndexStamp(), to check against
+//		psize  = ptr to size of index, filled in
+//
+//	Returns: ptr to index header, followed by its entries (free with
+//		ResIndexFree()), or NULL if no good index
+
+ResIndexHeader *ResIndexLoad(char *fname, ResIndexHeader *pstamp, size_t *psize)
+{
+	char *idxName;
+	FILE *fd;
+	ResIndexHeader *phead;
+	ResIndexEntry *pie;
+	int32_t entry;
+	bool ok;
+#ifdef RES_MMAP
+	struct stat st;
+	void *p;
+#endif
+
+//	Open index, get it into memory: mapped if possible, else read in
+
+	idxName = ResIndexName(fname);
+	if (idxName == NULL)
+		return(NULL);
+	fd = fopen(idxName, "rb");
+	free(idxName);
+	if (fd == NULL)
+		return(NULL);
+
+	phead = NULL;
+#ifdef RES_MMAP
+	if (fstat(fileno(fd), &st) == 0 && st.st_size >= (off_t) sizeof(ResIndexHeader))
+		{
+		p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(fd), 0);
+		if (p != MAP_FAILED)
+			{
+			phead = (ResIndexHeader *) p;
+			*psize = st.st_size;
+			}
+		}
+#else
+	fseek(fd, 0, SEEK_END);
+	*psize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+	if (*psize >= sizeof(ResIndexHeader))
+		{
+		phead = malloc(*psize);
+		if (phead && fread(phead, *psize, 1, fd) != 1)
+			{
+			free(phead);
+			phead = NULL;
+			}
+		}
+#endif
+	fclose(fd);
+	if (phead == NULL)
+		return(NULL);
+
+//	Check that it's from this resource file as it is now, and all there
+
+	ok = memcmp(phead, pstamp, offsetof(ResIndexHeader, numEntries)) == 0 &&
+		phead->numEntries >= 0 && phead->reserved == 0 &&
+		*psize == sizeof(ResIndexHeader) + phead->numEntries * sizeof(ResIndexEntry);
+
+//	Check it's intact, and sorted
+
+	pie = (ResIndexEntry *) (phead + 1);
+	if (ok)
+		ok = ResIndexChecksum(pie, phead->numEntries) == phead->checksum;
+	for (entry = 1; ok && entry < phead->numEntries; entry++)
+		ok = pie[entry - 1].id < pie[entry].id;
+
+	if (!ok)
+		{
+		ResIndexFree(phead, *psize);
+		return(NULL);
+		}
+	return(phead);
+}
+
+//	---------------------------------------------------------
+//
+//	ResIndexFree() frees an index gotten with ResIndexLoad().
+//
+//		phead = ptr to index header
+//		size  = size of index
+
+void ResIndexFree(ResIndexHeader *phead, size_t size)
+{
+#ifdef RES_MMAP
+	munmap(phead, size);
+#else
+	free(phead);
+#endif
+}
+
+//	---------------------------------------------------------
+//
+//	ResIndexSave() writes the index of a resource file.  It's written
+//		under a temporary name & renamed into place, so a reader never
+//		sees half of one.  Failing to write it (read-only directory,
+//		etc.) is no problem, the directory is just read again next time.
+//
+//		fname      = resource file name
+//		pstamp     = ptr to header from ResIndexStamp()
+//		pentries   = ptr to entries (sorted here, ids must be unique)
+//		numEntries = # entries
+//
+//	Returns: TRUE if written, FALSE if not
+
+bool ResIndexSave(char *fname, ResIndexHeader *pstamp, ResIndexEntry *pentries,
+	int32_t numEntries)
+{
+	char *idxName, *tmpName;
+	FILE *fd;
+	ResIndexHeader head;
+	bool ok;
+
+//	Sort entries, fill in header
+
+	qsort(pentries, numEntries, sizeof(ResIndexEntry), ResIndexCompare);
+	head = *pstamp;
+	head.numEntries = numEntries;
+	head.checksum = ResIndexChecksum(pentries, numEntries);
+	head.reserved = 0;
+
+//	Write to temporary name, then rename over old index
+
+	idxName = ResIndexName(fname);
+	tmpName = idxName ? malloc(strlen(idxName) + 2) : NULL;
+	if (tmpName == NULL)
+		{
+		free(idxName);
+		return FALSE;
+		}
+	strcpy(tmpName, idxName);
+	strcat(tmpName, "~");
+
+	ok = FALSE;
+	fd = fopen(tmpName, "wb");
+	if (fd)
+		{
+		ok = fwrite(&head, sizeof(ResIndexHeader), 1, fd) == 1 &&
+			(numEntries == 0 || fwrite(pentries, sizeof(ResIndexEntry) * numEntries, 1, fd) == 1);
+		ok = (fclose(fd) == 0) && ok;
+		if (ok)
+			ok = rename(tmpName, idxName) == 0;
+		if (!ok)
+			remove(tmpName);
+		}
+
+	free(tmpName);
+	free(idxName);
+	return(ok);
+}
+
+//	--------------------------------------------------------------
+//		INTERNAL ROUTINES
+//	---------------------------------------------------------
+//
+//	ResIndexName() makes the name of a resource file's index.
+//
+//	Returns: ptr to malloc'ed name (caller frees), or NULL
+
+char *ResIndexName(char *fname)
+{
+	char *idxName;
+
+	idxName = malloc(strlen(fname) + sizeof(RES_INDEX_EXT));
+	if (idxName)
+		{
+		strcpy(idxName, fname);
+		strcat(idxName, RES_INDEX_EXT);
+		}
+	return(idxName);
+}
+
+//	---------------------------------------------------------
+//
+//	ResIndexChecksum() computes checksum (32-bit FNV-1a) of index entries.
+
+uint32_t ResIndexChecksum(ResIndexEntry *pentries, int32_t numEntries)
+{
+	uint8_t *p, *pend;
+	uint32_t sum;
+
+	sum = 2166136261u;
+	p = (uint8_t *) pentries;
+	pend = p + numEntries * sizeof(ResIndexEntry);
+	while (p < pend)
+		sum = (sum ^ *p++) * 16777619u;
+	return(sum);
+}
+
+//	---------------------------------------------------------
+//
+//	ResIndexCompare() orders index entries by id, for qsort().
+
+int ResIndexCompare(const void *p1, const void *p2)
+{
+	return((int) ((ResIndexEntry *) p1)->id - (int) ((ResIndexEntry *) p2)->id);
+}
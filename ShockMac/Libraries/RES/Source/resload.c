@@ -40,10 +40,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 //#include <io.h>
+#include <string.h>
 
 #include "res.h"
 #include "res_.h"
 #include "lzw.h"
+#include "lz4.h"
 //#include <_res.h>
 
 
@@ -56,7 +58,9 @@ void LoadCompressedResource(ResDesc *prd, Id id);
 //	-----------------------------------------------------------
 //
 //	ResLoadResource() loads a resource object, decompressing it if it is
-//		compressed.
+//		compressed.  Uncompressed simple resources in a mapped resfile
+//		aren't loaded at all, they're used in place in the file image.
+//		Resources already in memory, or prefetched, aren't loaded again.
 //
 //		id = resource id
 //	-----------------------------------------------------------
@@ -65,6 +69,7 @@ void LoadCompressedResource(ResDesc *prd, Id id);
 void *ResLoadResource(Id id)
 {
 	ResDesc *prd = RESDESC(id);
+	uint64_t start = ResTelemNow();
 
 	//	If doesn't exit, forget it
 
@@ -73,12 +78,57 @@ void *ResLoadResource(Id id)
 
 //	Spew(DSRC_RES_Read, ("ResLoadResource: loading $%x\n", id));
 
-	//	Allocate memory, setting magic id so pager can tell who it is if need be.
+	//	If prefetched, collect it (this waits if a worker is still loading it)
+	if (ResFlags(id) & RDF_PREFETCH)
+	{
+		prd->ptr = ResPrefetchTake(id);
+		if (prd->ptr)
+		{
+			ResCacheMakeRoom(prd->size);
+			ResCacheAdd(id);
+			CUMSTATS(id, numLoads);
+			ResTelemLoaded(id, ResType(id), start);
+			return prd->ptr;
+		}
+	}
+
+	//	If already in memory, done (once the rest of it is, if only some
+	//	items of it are).  If the rest won't come in, forget it unless
+	//	somebody has the items that did locked.
+	if (prd->ptr)
+	{
+		if (ResIsPartial(id))
+		{
+			if (!ResLoadRest(id))
+			{
+				Warning("ResLoadResource: can't load rest of $%x\n", id);
+				if (prd->lock == 0)
+					ResDrop(id);
+				return NULL;
+			}
+			ResTelemLoaded(id, ResType(id), start);
+		}
+		return prd->ptr;
+	}
+
+	//	If mapped, point into file image, nothing to allocate or read
+	if (ResIsMapped(id))
+	{
+		prd->ptr = resFile[prd->filenum].pmap + RES_OFFSET_DESC2REAL(prd->offset);
+		CUMSTATS(id, numLoads);
+		return prd->ptr;
+	}
+
+	//	Make room in cache budget, then allocate memory, setting magic id so
+	//	pager can tell who it is if need be.
+	resPrefetchStat.numMisses++;
+	ResCacheMakeRoom(prd->size);
 	idBeingLoaded = id;
 	prd->ptr = malloc(prd->size);
 	idBeingLoaded = ID_NULL;
 	if (prd->ptr == NULL)
 		return NULL ;
+	ResCacheAdd(id);
 
 	//	Tally memory allocated to resources
 //	DBG(DSRC_RES_Stat, {resStat.totMemAlloc += prd->size;});
@@ -88,8 +138,14 @@ void *ResLoadResource(Id id)
 	//	Add to cumulative stats
 	CUMSTATS(id, numLoads);
 
-	//	Load from disk
-	ResRetrieve(id, prd->ptr);
+	//	Load from disk, forgetting it if it's bad
+	if (!ResRetrieve(id, prd->ptr))
+	{
+		Warning("ResLoadResource: can't load $%x\n", id);
+		ResDrop(id);
+		return NULL;
+	}
+	ResTelemLoaded(id, ResType(id), start);
 
 	//	Tally stats
 //	DBG(DSRC_RES_Stat, {resStat.numLoaded++;});
@@ -109,29 +165,91 @@ void *ResLoadResource(Id id)
 
 bool ResRetrieve(Id id, void *buffer)
 {
-	ResDesc *prd;
+	//	Check id and file number
+
+//	DBG(DSRC_RES_ChkIdRef, {if (!ResCheckId(id)) return FALSE;});
+
+	return ResRetrieveDesc(id, RESDESC(id), ResFlags(id), ResType(id), buffer, NULL);
+}
+
+//	---------------------------------------------------------
+//
+//	ResRetrieveDesc() retrieves a resource from disk, given its descriptor.
+//		Prefetch workers call this with their own copy of the descriptor,
+//		flags & type, and their own LZW context, so it never looks at the
+//		descriptor tables.  Bytes read & expanded are counted for
+//		telemetry, and expansions timed.
+//
+//		id     = id of resource
+//		prd    = ptr to resource descriptor
+//		flags  = resource flags (RDF_XXX)
+//		type   = resource type (RTYPE_XXX)
+//		buffer = ptr to buffer to load into (must be big enough)
+//		plc    = LZW context to expand with, or NULL for default
+//
+//	Returns: TRUE if retrieved, FALSE if problem
+
+bool ResRetrieveDesc(Id id, ResDesc *prd, uint8_t flags, uint8_t type, void *buffer,
+	LzwContext *plc)
+{
 	FILE *fd;
 	uint8_t *p;
-	int32_t size;
+	uint8_t *pmap, *pmapEnd;
+	uint8_t *pcomp;
+	int32_t size, csize;
 	RefIndex numRefs;
+	uint64_t start;
+	bool ok;
 
-	//	Check id and file number
-
-//	DBG(DSRC_RES_ChkIdRef, {if (!ResCheckId(id)) return FALSE;});
-	prd = RESDESC(id);
 	fd = resFile[prd->filenum].fd;
 //	DBG(DSRC_RES_ChkIdRef, {if (fd < 0) { \
 //		Warning(("ResRetrieve: id $%x doesn't exist\n", id)); \
 //		return FALSE; \
 //		}});
 
-	//	Seek to data, set up
+	//	If file is mapped, copy or expand straight out of the file image
+	pmap = resFile[prd->filenum].pmap;
+	if (pmap)
+	{
+		pmapEnd = pmap + resFile[prd->filenum].mapSize;
+		pmap += RES_OFFSET_DESC2REAL(prd->offset);
+		p = buffer;
+		size = prd->size;
+		if (flags & RDF_COMPOUND)
+		{
+			memcpy(&numRefs, pmap, sizeof(RefIndex));
+			memcpy(p, pmap, REFTABLESIZE(numRefs));
+			p += REFTABLESIZE(numRefs);
+			pmap += REFTABLESIZE(numRefs);
+			size -= REFTABLESIZE(numRefs);
+		}
+		start = ResTelemNow();
+		ok = TRUE;
+		if ((flags & RDF_LZ4) && (flags & RDF_COMPOUND))
+			ok = ResExpandLz4Items(pmap, pmapEnd - pmap, (RefTable *) buffer);
+		else if (flags & RDF_LZ4)
+			ok = Lz4Expand(pmap, pmapEnd - pmap, p, size) == size;
+		else if ((flags & RDF_LZW) && plc)
+			ok = LzwContextExpandBlock(plc, pmap, pmapEnd - pmap, p, size) == size;
+		else if (flags & RDF_LZW)
+			ok = LzwExpandBlock(pmap, pmapEnd - pmap, p, size) == size;
+		else
+			memcpy(p, pmap, size);
+		ResCountExpanded(id, type, flags, start, size);
+		if (!ok)
+			return FALSE;
+		ResSwapLoaded(type, flags, buffer, prd->size);
+		return TRUE;
+	}
+
+	//	Seek to data, set up (workers may be reading the same file)
+	ResLockFiles();
 	fseek(fd, RES_OFFSET_DESC2REAL(prd->offset), SEEK_SET);
 	p = buffer;
 	size = prd->size;
 
 	//	If compound, read in ref table
-	if (ResFlags(id) & RDF_COMPOUND)
+	if (flags & RDF_COMPOUND)
 	{
 		fread(p, sizeof(int16_t), 1, fd);
 		numRefs = *(int16_t *)p;
@@ -141,11 +259,198 @@ bool ResRetrieve(Id id, void *buffer)
 		size -= REFTABLESIZE(numRefs);
 	}
 
-	//	Read in data
-	if (ResFlags(id) & RDF_LZW)
-		LzwExpandFd2Buff(fd, p, 0, 0);
-	else
-		fread(p, size, 1, fd);
+	//	Read in data.  Compressed data is read whole, and expanded after the
+	//	file is free for others.
+	if (flags & RDF_LZ4)
+	{
+		if (flags & RDF_COMPOUND)
+			pcomp = ResReadLz4Items(fd, numRefs, &csize);
+		else
+			pcomp = ResReadLz4(fd, &csize);
+		ResCountRead(id, type, fd, prd->offset);
+		ResUnlockFiles();
+		if (pcomp == NULL)
+			return FALSE;
+		start = ResTelemNow();
+		if (flags & RDF_COMPOUND)
+			ok = ResExpandLz4Items(pcomp, csize, (RefTable *) buffer);
+		else
+			ok = Lz4Expand(pcomp, csize, p, size) == size;
+		ResCountExpanded(id, type, flags, start, size);
+		free(pcomp);
+		if (!ok)
+			return FALSE;
+		ResSwapLoaded(type, flags, buffer, prd->size);
+		return TRUE;
+	}
+	//	LZW data is read whole too, so workers expand at the same time
+	if (flags & RDF_LZW)
+	{
+		csize = prd->csize - (p - (uint8_t *) buffer);
+		pcomp = (csize > 0) ? malloc(csize) : NULL;
+		if (pcomp && fread(pcomp, csize, 1, fd) != 1)
+		{
+			free(pcomp);
+			pcomp = NULL;
+		}
+		ResCountRead(id, type, fd, prd->offset);
+		ResUnlockFiles();
+		if (pcomp == NULL)
+			return FALSE;
+		start = ResTelemNow();
+		if (plc)
+			ok = LzwContextExpandBlock(plc, pcomp, csize, p, size) == size;
+		else
+			ok = LzwExpandBlock(pcomp, csize, p, size) == size;
+		ResCountExpanded(id, type, flags, start, size);
+		free(pcomp);
+		if (!ok)
+			return FALSE;
+		ResSwapLoaded(type, flags, buffer, prd->size);
+		return TRUE;
+	}
+	ok = size == 0 || fread(p, size, 1, fd) == 1;
+	ResCountRead(id, type, fd, prd->offset);
+	ResUnlockFiles();
+	if (!ok)
+		return FALSE;
+	ResSwapLoaded(type, flags, buffer, prd->size);
+
+	return TRUE;
+}
 
+//	---------------------------------------------------------
+//
+//	ResCountRead() counts bytes read from a resfile for telemetry: from
+//		a resource's start to where the file is now.
+//
+//		id     = id of resource
+//		type   = its type
+//		fd     = resfile
+//		offset = resource's offset (as in descriptor)
+
+void ResCountRead(Id id, uint8_t type, FILE *fd, int32_t offset)
+{
+	ResTelemCount(id, type, RES_TELEM_BYTESREAD,
+		ftell(fd) - RES_OFFSET_DESC2REAL(offset));
+}
+
+//	---------------------------------------------------------
+//
+//	ResCountExpanded() counts & times a decompression for telemetry, if
+//		the resource is compressed.
+//
+//		id    = id of resource
+//		type  = its type
+//		flags = resource flags (RDF_XXX)
+//		start = timestamp from ResTelemNow() at start of expansion
+//		size  = # bytes expanded
+
+void ResCountExpanded(Id id, uint8_t type, uint8_t flags, uint64_t start, int32_t size)
+{
+	if (flags & (RDF_LZW | RDF_LZ4))
+	{
+		ResTelemTime((flags & RDF_LZ4) ? RES_TELEM_LZ4TIME : RES_TELEM_LZWTIME, start);
+		ResTelemCount(id, type, RES_TELEM_BYTESEXPANDED, size);
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResReadLz4() reads LZ4 compressed data, header and all, from the
+//		current position in a resfile.
+//
+//		fd     = resfile
+//		pcsize = ptr to size read, filled in
+//
+//	Returns: ptr to malloc'ed data (caller frees), or NULL if problem
+
+uint8_t *ResReadLz4(FILE *fd, int32_t *pcsize)
+{
+	uint8_t head[LZ4_HEADERSIZE];
+	uint8_t *pcomp;
+
+	if (fread(head, LZ4_HEADERSIZE, 1, fd) != 1)
+		return NULL;
+	*pcsize = Lz4Size(head);
+	if (*pcsize < LZ4_HEADERSIZE)
+		return NULL;
+	pcomp = malloc(*pcsize);
+	if (pcomp == NULL)
+		return NULL;
+	memcpy(pcomp, head, LZ4_HEADERSIZE);
+	if (*pcsize > LZ4_HEADERSIZE && fread(pcomp + LZ4_HEADERSIZE, *pcsize - LZ4_HEADERSIZE, 1, fd) != 1)
+	{
+		free(pcomp);
+		return NULL;
+	}
+	return pcomp;
+}
+
+//	---------------------------------------------------------
+//
+//	ResReadLz4Items() reads LZ4 compressed items, item table and all, from
+//		the current position in a resfile (just past the ref table).
+//
+//		fd       = resfile
+//		numItems = # items
+//		pcsize   = ptr to size read, filled in
+//
+//	Returns: ptr to malloc'ed data (caller frees), or NULL if problem
+
+uint8_t *ResReadLz4Items(FILE *fd, RefIndex numItems, int32_t *pcsize)
+{
+	int32_t sizeTable = LZ4_ITEMTABLESIZE(numItems);
+	uint8_t *pcomp, *pnew;
+
+	pcomp = malloc(sizeTable);
+	if (pcomp == NULL)
+		return NULL;
+	if (fread(pcomp, sizeTable, 1, fd) != 1)
+	{
+		free(pcomp);
+		return NULL;
+	}
+	*pcsize = LZ4_ITEMOFFSET(pcomp, numItems);
+	pnew = NULL;
+	if (*pcsize >= sizeTable)
+		pnew = realloc(pcomp, *pcsize);
+	if (pnew == NULL)
+	{
+		free(pcomp);
+		return NULL;
+	}
+	pcomp = pnew;
+	if (*pcsize > sizeTable && fread(pcomp + sizeTable, *pcsize - sizeTable, 1, fd) != 1)
+	{
+		free(pcomp);
+		return NULL;
+	}
+	return pcomp;
+}
+
+//	---------------------------------------------------------
+//
+//	ResExpandLz4Items() expands LZ4 compressed items into place in a
+//		compound resource, where its ref table says.  The ref table is
+//		packed as on disk, so its offsets are taken from it one by one.
+//
+//		pcomp = ptr to compressed items (item table)
+//		csize = # bytes there
+//		prt   = ptr to resource buffer, holding ref table
+//
+//	Returns: TRUE if all expanded, FALSE if data is bad
+
+bool ResExpandLz4Items(uint8_t *pcomp, int32_t csize, RefTable *prt)
+{
+	RefIndex index;
+	int32_t size;
+
+	for (index = 0; index < prt->numRefs; index++)
+	{
+		size = RefSize(prt, index);
+		if (Lz4ExpandItem(pcomp, csize, index, REFPTR(prt, index), size) != size)
+			return FALSE;
+	}
 	return TRUE;
 }
@@ -76,6 +76,8 @@ void ResMake(Id id, void *ptr, int32_t size, uint8_t type, int32_t filenum, uint
 
 	prd2->flags = flags;
 	prd2->type = type;
+	if (ptr)
+		ResCacheAdd(id);
 }
 
 #if 0
@@ -258,7 +260,8 @@ void ResAddRef(Ref ref, void *pitem, long itemSize)
 void ResUnmake(Id id)
 {
 	ResDesc *prd;
-	// JSXXX: should anything be done to fix up the LRU list?
 	prd = RESDESC(id);
+	if (prd->ptr && !ResIsMapped(id))
+		ResCacheRemove(id);
 	LG_memset(prd, 0, sizeof(ResDesc));
 }
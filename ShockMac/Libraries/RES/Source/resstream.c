@@ -0,0 +1,329 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResStream.c	Stream bytes out to a consumer a block at a time
+
+//	A stream takes the bytes of a resource as they are read or expanded,
+//	and hands them to a block routine a block at a time, flagged first and
+//	last (REBF_XXX).  With a queue depth of 1 the block routine is called
+//	right there, and says how big it wants the next block.  Deeper, blocks
+//	are of fixed size and are queued to a consumer thread which calls the
+//	block routine, so reading & expanding the next blocks goes on while
+//	the last ones are consumed.  The producer only waits when every block
+//	in the queue is full.
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef RES_THREADS
+#include <pthread.h>
+#endif
+
+#include "res.h"
+#include "res_.h"
+
+struct ResStream_ {
+	uint8_t *pbuff;						// the blocks, end to end
+	bool ownBuff;							// set if pbuff is ours to free
+	int32_t blockSize;					// max bytes per block
+	int32_t depth;							// # blocks in queue (1 = no queue)
+	int32_t left;							// # bytes yet to be put in
+	int32_t want;							// # bytes wanted in current block
+	int32_t fill;							// # bytes in current block so far
+	int32_t iblock;						// # of current block
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock);
+#ifdef RES_THREADS
+	int32_t *pnumBytes;					// # bytes in each queued block
+	int32_t *pinfo;						// block # & REBF_XXX of each
+	int32_t numQueued;					// # blocks full & waiting
+	int32_t head;							// next block to consume
+	bool done;								// set when no more are coming
+	pthread_t consumer;					// calls f_ProcBlock on queued blocks
+	pthread_mutex_t mutex;
+	pthread_cond_t queued;				// signalled when a block is queued
+	pthread_cond_t consumed;			// signalled when a block is free
+#endif
+};
+
+#define ResStreamBlock(ps,n) ((ps)->pbuff + (n) * (ps)->blockSize)
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void ResStreamPass(ResStream *ps);
+#ifdef RES_THREADS
+static void *ResStreamConsumer(void *arg);
+#endif
+
+//	---------------------------------------------------------
+//
+//	ResStreamOpen() starts a stream.
+//
+//		size        = # bytes which will be put in
+//		buff        = block buffer (for depth 1), or NULL to allocate one
+//		blockSize   = max # bytes per block
+//		queueDepth  = # blocks in queue (1 = call f_ProcBlock in place)
+//		f_ProcBlock = block routine: gets block, # bytes in it, block #
+//						  & REBF_XXX flags, returns size of next block
+//
+//	Returns: ptr to stream, or NULL if out of memory
+
+ResStream *ResStreamOpen(int32_t size, void *buff, int32_t blockSize, int32_t queueDepth,
+	int32_t (*f_ProcBlock)(void *buff, int32_t numBytes, int32_t iblock))
+{
+	ResStream *ps;
+
+	ps = malloc(sizeof(ResStream));
+	if (ps == NULL)
+		return NULL;
+	if (blockSize < 1)
+		blockSize = 1;
+	if (queueDepth < 1)
+		queueDepth = 1;
+#ifndef RES_THREADS
+	queueDepth = 1;
+#endif
+
+	ps->blockSize = blockSize;
+	ps->depth = queueDepth;
+	ps->left = size;
+	ps->fill = 0;
+	ps->iblock = 0;
+	ps->f_ProcBlock = f_ProcBlock;
+	ps->want = (size < blockSize) ? size : blockSize;
+
+	//	A queue of blocks is always ours, a single one may be supplied
+	ps->ownBuff = (buff == NULL || queueDepth > 1);
+	ps->pbuff = ps->ownBuff ? malloc((size_t) blockSize * queueDepth) : buff;
+	if (ps->pbuff == NULL && queueDepth > 1 && buff != NULL)
+	{
+		ps->depth = 1;
+		ps->ownBuff = FALSE;
+		ps->pbuff = buff;
+	}
+	if (ps->pbuff == NULL)
+	{
+		free(ps);
+		return NULL;
+	}
+
+#ifdef RES_THREADS
+	if (ps->depth > 1)
+	{
+		ps->pnumBytes = malloc(ps->depth * 2 * sizeof(int32_t));
+		ps->pinfo = ps->pnumBytes + ps->depth;
+		ps->numQueued = 0;
+		ps->head = 0;
+		ps->done = FALSE;
+		pthread_mutex_init(&ps->mutex, NULL);
+		pthread_cond_init(&ps->queued, NULL);
+		pthread_cond_init(&ps->consumed, NULL);
+		if (ps->pnumBytes == NULL ||
+			pthread_create(&ps->consumer, NULL, ResStreamConsumer, ps) != 0)
+		{
+			//	No consumer thread to be had, consume in place out of 1st block
+			free(ps->pnumBytes);
+			pthread_mutex_destroy(&ps->mutex);
+			pthread_cond_destroy(&ps->queued);
+			pthread_cond_destroy(&ps->consumed);
+			ps->depth = 1;
+		}
+	}
+#endif
+
+	return ps;
+}
+
+//	---------------------------------------------------------
+//
+//	ResStreamSpace() gets where the next bytes go, in the current block.
+//		Once they're there, call ResStreamAdvance().
+//
+//		ps     = ptr to stream
+//		pavail = ptr to # bytes that fit there, filled in (0 when all in)
+//
+//	Returns: ptr to space
+
+uint8_t *ResStreamSpace(ResStream *ps, int32_t *pavail)
+{
+	*pavail = ps->want - ps->fill;
+	return ResStreamBlock(ps, ps->iblock % ps->depth) + ps->fill;
+}
+
+//	---------------------------------------------------------
+//
+//	ResStreamAdvance() takes note of bytes put in the current block, and
+//		passes it on when it's full.
+//
+//		ps = ptr to stream
+//		n  = # bytes put in (no more than ResStreamSpace() said)
+
+void ResStreamAdvance(ResStream *ps, int32_t n)
+{
+	ps->fill += n;
+	ps->left -= n;
+	if (ps->fill == ps->want && ps->want > 0)
+		ResStreamPass(ps);
+}
+
+//	---------------------------------------------------------
+//
+//	ResStreamWrite() copies bytes into a stream.  Bytes past the size
+//		the stream was opened with are dropped.
+//
+//		ps = ptr to stream
+//		p  = ptr to bytes
+//		n  = # bytes
+
+void ResStreamWrite(ResStream *ps, void *p, int32_t n)
+{
+	uint8_t *pspace;
+	int32_t avail;
+
+	while (n > 0)
+	{
+		pspace = ResStreamSpace(ps, &avail);
+		if (avail == 0)
+			break;
+		if (avail > n)
+			avail = n;
+		memcpy(pspace, p, avail);
+		p = (uint8_t *) p + avail;
+		n -= avail;
+		ResStreamAdvance(ps, avail);
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResStreamClose() ends a stream: the last block is passed on if it
+//		hasn't been (short, if fewer bytes came than were promised),
+//		all blocks are consumed, and the stream is freed.
+//
+//		ps = ptr to stream
+//
+//	Returns: TRUE if all the bytes promised were put in
+
+bool ResStreamClose(ResStream *ps)
+{
+	bool ok = (ps->left == 0);
+
+	//	Pass on what's left, flagged last.  A stream of nothing still
+	//	gets its one (empty) block.
+	if (ps->fill > 0 || ps->iblock == 0 || !ok)
+	{
+		ps->left = 0;
+		ResStreamPass(ps);
+	}
+
+#ifdef RES_THREADS
+	if (ps->depth > 1)
+	{
+		pthread_mutex_lock(&ps->mutex);
+		ps->done = TRUE;
+		pthread_cond_signal(&ps->queued);
+		pthread_mutex_unlock(&ps->mutex);
+		pthread_join(ps->consumer, NULL);
+		pthread_mutex_destroy(&ps->mutex);
+		pthread_cond_destroy(&ps->queued);
+		pthread_cond_destroy(&ps->consumed);
+		free(ps->pnumBytes);
+	}
+#endif
+
+	if (ps->ownBuff)
+		free(ps->pbuff);
+	free(ps);
+	return ok;
+}
+
+//	--------------------------------------------------------
+//		INTERNAL ROUTINES
+//	--------------------------------------------------------
+//
+//	ResStreamPass() passes on the current block, to the block routine or
+//		the queue, and sets up the next one.
+
+static void ResStreamPass(ResStream *ps)
+{
+	int32_t info, next;
+
+	info = (ps->iblock << 2) | (ps->iblock == 0 ? REBF_FIRST : 0) |
+		(ps->left == 0 ? REBF_LAST : 0);
+
+#ifdef RES_THREADS
+	if (ps->depth > 1)
+	{
+		//	Queue it, then wait for the next block to be free
+		pthread_mutex_lock(&ps->mutex);
+		ps->pnumBytes[ps->iblock % ps->depth] = ps->fill;
+		ps->pinfo[ps->iblock % ps->depth] = info;
+		ps->numQueued++;
+		pthread_cond_signal(&ps->queued);
+		while (ps->numQueued == ps->depth)
+			pthread_cond_wait(&ps->consumed, &ps->mutex);
+		pthread_mutex_unlock(&ps->mutex);
+		next = ps->blockSize;
+	}
+	else
+#endif
+	{
+		next = (*ps->f_ProcBlock)(ps->pbuff, ps->fill, info);
+		if (next <= 0 || next > ps->blockSize)
+			next = ps->blockSize;
+	}
+
+	ps->iblock++;
+	ps->fill = 0;
+	ps->want = (ps->left < next) ? ps->left : next;
+}
+
+#ifdef RES_THREADS
+
+//	---------------------------------------------------------
+//
+//	ResStreamConsumer() is the consumer thread, passing queued blocks to
+//		the block routine in order until told there are no more.
+
+static void *ResStreamConsumer(void *arg)
+{
+	ResStream *ps = arg;
+	int32_t n;
+
+	pthread_mutex_lock(&ps->mutex);
+	while (TRUE)
+	{
+		while (ps->numQueued == 0 && !ps->done)
+			pthread_cond_wait(&ps->queued, &ps->mutex);
+		if (ps->numQueued == 0)
+			break;
+		n = ps->head;
+		pthread_mutex_unlock(&ps->mutex);
+
+		(*ps->f_ProcBlock)(ResStreamBlock(ps, n), ps->pnumBytes[n], ps->pinfo[n]);
+
+		pthread_mutex_lock(&ps->mutex);
+		ps->head = (n + 1) % ps->depth;
+		ps->numQueued--;
+		pthread_cond_signal(&ps->consumed);
+	}
+	pthread_mutex_unlock(&ps->mutex);
+
+	return NULL;
+}
+
+#endif
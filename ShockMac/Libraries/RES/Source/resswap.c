@@ -0,0 +1,324 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResSwap.c	Bulk byte swapping of resource data
+
+//	Resource data is in the byte order of the machine that made it.  A
+//	type's layout (see restypes.h) says what its data is made of, and is
+//	compiled here into what to swap.  Data is then swapped a whole array
+//	at a time, with SIMD where there is some: all 16 or all 32 bit fields
+//	by byte reversal, and mixed records that fit 16 bytes evenly by one
+//	byte shuffle per 16 bytes.  Anything else is done field by field.
+
+#include <string.h>
+#include <ctype.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "res.h"
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static void ResSwapShuffle(ResLayout *pl, uint8_t *p, int32_t size);
+static void ResSwapFields(ResLayout *pl, uint8_t *p, int32_t numRecs);
+
+//	---------------------------------------------------------
+//
+//	ResLayoutCompile() compiles a layout: a byte order, '>' big-endian or
+//		'<' little-endian, then fields of a record, each 'b' or 'x' byte,
+//		'h' 16 bits or 'l' 32 bits, with an optional count ("4h").
+//
+//		layout = layout string
+//		pl     = ptr to compiled layout, filled in (recSize 0 if the
+//					data is in this machine's order already)
+//
+//	Returns: TRUE if ok, FALSE if bad layout
+
+bool ResLayoutCompile(char *layout, ResLayout *pl)
+{
+	static const uint16_t one = 1;
+	bool bigData, bigMachine;
+	int32_t count, size, recSize, i, j;
+	char *p;
+
+	memset(pl, 0, sizeof(ResLayout));
+	if (layout == NULL || (layout[0] != '>' && layout[0] != '<'))
+		return FALSE;
+	bigData = (layout[0] == '>');
+	bigMachine = (*(uint8_t *) &one == 0);
+
+	//	Walk fields, noting those to swap
+	recSize = 0;
+	for (p = layout + 1; *p; p++)
+	{
+		count = 0;
+		while (isdigit((uint8_t) *p) && count <= RES_LAYOUT_MAXREC)
+			count = count * 10 + (*p++ - '0');
+		if (count == 0)
+			count = 1;
+		size = (*p == 'b' || *p == 'x') ? 1 : (*p == 'h') ? 2 : (*p == 'l') ? 4 : 0;
+		if (size == 0 || recSize + count * size > RES_LAYOUT_MAXREC)
+			return FALSE;
+		while (count-- > 0)
+		{
+			if (size > 1)
+			{
+				if (pl->numFields == RES_LAYOUT_MAXFIELDS)
+					return FALSE;
+				pl->field[pl->numFields][0] = recSize;
+				pl->field[pl->numFields][1] = size;
+				pl->numFields++;
+			}
+			recSize += size;
+		}
+	}
+	if (recSize == 0)
+		return FALSE;
+	if (bigData == bigMachine || pl->numFields == 0)
+	{
+		pl->numFields = 0;
+		return TRUE;
+	}
+	pl->recSize = recSize;
+
+	//	All one size of field?
+	pl->unit = pl->field[0][1];
+	for (i = 0; i < pl->numFields; i++)
+	{
+		if (pl->field[i][1] != pl->unit || pl->field[i][0] != i * pl->unit)
+			pl->unit = 0;
+	}
+	if (pl->unit && pl->numFields * pl->unit != recSize)
+		pl->unit = 0;
+
+	//	Shuffle for 16 bytes of records, if they fit evenly
+	if ((16 % recSize) == 0)
+	{
+		for (i = 0; i < 16; i++)
+			pl->shuffle[i] = i;
+		for (j = 0; j < 16; j += recSize)
+		{
+			for (i = 0; i < pl->numFields; i++)
+			{
+				for (size = 0; size < pl->field[i][1]; size++)
+				{
+					pl->shuffle[j + pl->field[i][0] + size] =
+						j + pl->field[i][0] + pl->field[i][1] - 1 - size;
+				}
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+//	---------------------------------------------------------
+//
+//	ResSwapRecords() swaps records laid out by a compiled layout.  Bytes
+//		past the last whole record are left alone.  Swapping twice puts
+//		them back.
+//
+//		pl   = ptr to compiled layout
+//		p    = ptr to data
+//		size = size of data
+
+void ResSwapRecords(ResLayout *pl, void *p, int32_t size)
+{
+	int32_t numRecs;
+
+	if (pl->recSize == 0)
+		return;
+	numRecs = size / pl->recSize;
+	if (pl->unit == 2)
+		ResSwap16(p, numRecs * pl->recSize / 2);
+	else if (pl->unit == 4)
+		ResSwap32(p, numRecs * pl->recSize / 4);
+	else if ((16 % pl->recSize) == 0)
+		ResSwapShuffle(pl, p, numRecs * pl->recSize);
+	else
+		ResSwapFields(pl, p, numRecs);
+}
+
+//	---------------------------------------------------------
+//
+//	ResSwapData() swaps a resource's data, each item's if compound (the
+//		ref table is left alone).
+//
+//		pl    = ptr to compiled layout
+//		flags = resource flags (RDF_XXX)
+//		p     = ptr to resource data
+//		size  = size of resource
+
+void ResSwapData(ResLayout *pl, uint8_t flags, void *p, int32_t size)
+{
+	RefTable *prt = p;
+	RefIndex index;
+
+	if (!(flags & RDF_COMPOUND))
+	{
+		ResSwapRecords(pl, p, size);
+		return;
+	}
+	if (size < (int32_t) sizeof(RefIndex) || size < (int32_t) REFTABLESIZE(prt->numRefs))
+		return;
+	for (index = 0; index < prt->numRefs; index++)
+	{
+		if (prt->offset[index] >= 0 && prt->offset[index + 1] <= size)
+			ResSwapRecords(pl, (uint8_t *) p + prt->offset[index], RefSize(prt, index));
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResSwap16() swaps the bytes of an array of 16-bit values.
+//
+//		p = ptr to values (any alignment)
+//		n = # values
+
+void ResSwap16(void *p, int32_t n)
+{
+	uint8_t *pb = p;
+	uint8_t t;
+
+#if defined(__SSE2__)
+	__m128i v;
+	for (; n >= 8; n -= 8, pb += 16)
+	{
+		v = _mm_loadu_si128((__m128i *) pb);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *) pb, v);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	for (; n >= 8; n -= 8, pb += 16)
+		vst1q_u8(pb, vrev16q_u8(vld1q_u8(pb)));
+#endif
+	for (; n > 0; n--, pb += 2)
+	{
+		t = pb[0];
+		pb[0] = pb[1];
+		pb[1] = t;
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResSwap32() swaps the bytes of an array of 32-bit values.
+//
+//		p = ptr to values (any alignment)
+//		n = # values
+
+void ResSwap32(void *p, int32_t n)
+{
+	uint8_t *pb = p;
+	uint8_t t;
+
+#if defined(__SSE2__)
+	__m128i v;
+	for (; n >= 4; n -= 4, pb += 16)
+	{
+		v = _mm_loadu_si128((__m128i *) pb);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflelo_epi16(_mm_shufflehi_epi16(v, 0xB1), 0xB1);
+		_mm_storeu_si128((__m128i *) pb, v);
+	}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	for (; n >= 4; n -= 4, pb += 16)
+		vst1q_u8(pb, vrev32q_u8(vld1q_u8(pb)));
+#endif
+	for (; n > 0; n--, pb += 4)
+	{
+		t = pb[0];
+		pb[0] = pb[3];
+		pb[3] = t;
+		t = pb[1];
+		pb[1] = pb[2];
+		pb[2] = t;
+	}
+}
+
+//	--------------------------------------------------------
+//		INTERNAL ROUTINES
+//	--------------------------------------------------------
+//
+//	ResSwapShuffle() swaps records which fit 16 bytes evenly, 16 bytes
+//		at a time by the layout's shuffle where there's a byte shuffle
+//		instruction.
+//
+//		pl   = ptr to compiled layout
+//		p    = ptr to data
+//		size = size of data, a whole # records
+
+static void ResSwapShuffle(ResLayout *pl, uint8_t *p, int32_t size)
+{
+#if defined(__SSSE3__)
+	__m128i shuf = _mm_loadu_si128((__m128i *) pl->shuffle);
+	for (; size >= 16; size -= 16, p += 16)
+		_mm_storeu_si128((__m128i *) p, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *) p), shuf));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	uint8x16_t shuf = vld1q_u8(pl->shuffle);
+	for (; size >= 16; size -= 16, p += 16)
+		vst1q_u8(p, vqtbl1q_u8(vld1q_u8(p), shuf));
+#endif
+	ResSwapFields(pl, p, size / pl->recSize);
+}
+
+//	---------------------------------------------------------
+//
+//	ResSwapFields() swaps records a field at a time.
+//
+//		pl      = ptr to compiled layout
+//		p       = ptr to data
+//		numRecs = # records
+
+static void ResSwapFields(ResLayout *pl, uint8_t *p, int32_t numRecs)
+{
+	uint8_t *pf;
+	uint8_t t;
+	int32_t i;
+
+	for (; numRecs > 0; numRecs--, p += pl->recSize)
+	{
+		for (i = 0; i < pl->numFields; i++)
+		{
+			pf = p + pl->field[i][0];
+			if (pl->field[i][1] == 2)
+			{
+				t = pf[0];
+				pf[0] = pf[1];
+				pf[1] = t;
+			}
+			else
+			{
+				t = pf[0];
+				pf[0] = pf[3];
+				pf[3] = t;
+				t = pf[1];
+				pf[1] = pf[2];
+				pf[2] = t;
+			}
+		}
+	}
+}
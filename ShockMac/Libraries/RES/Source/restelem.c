@@ -0,0 +1,327 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResTelem.c	Resource telemetry, always kept
+
+//	Counts of loads, hits, evictions and bytes moved are kept per type and
+//	per id, and latencies of loads and expansions in log2 histograms, so
+//	the resources behind hitches can be found in the field.  Counting is
+//	cheap: relaxed atomic adds (prefetch workers count too), and per-id
+//	counts in pages of ids allocated on first use, which never move.
+//	ResTelemDumpJson() writes it all out.
+
+#ifdef RES_CLOCK
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef RES_CLOCK
+#include <time.h>
+#endif
+
+#include "res.h"
+#include "res_.h"
+
+#define RES_TELEM_PAGEBITS 8							// ids per page is 2^this
+#define RES_TELEM_PAGESIZE (1 << RES_TELEM_PAGEBITS)
+#define RES_TELEM_NUMPAGES (0x10000 >> RES_TELEM_PAGEBITS)
+
+static ResTelemCounts resTelemType[256];						// by type
+static ResTelemCounts *resTelemPage[RES_TELEM_NUMPAGES];	// by id, in pages
+static ResTelemHist resTelemHist[RES_TELEM_NUMHISTS];
+
+static char *resTelemCountNames[RES_TELEM_NUMCOUNTS] = {
+	"loads", "hits", "evictions", "bytesRead", "bytesExpanded", "loadNs", "maxLoadNs"};
+static char *resTelemHistNames[RES_TELEM_NUMHISTS] = {
+	"load", "lzwExpand", "lz4Expand"};
+
+//-------------------------------
+//  Private Prototypes
+//-------------------------------
+static int ResTelemCompareLoadNs(const void *p1, const void *p2);
+
+//	Relaxed atomic add & max where there can be workers.  Pages are
+//	installed with release and loaded with acquire, so whoever sees a page
+//	sees it zeroed.
+
+#if defined(RES_THREADS) && defined(__GNUC__)
+#define ResTelemAtomicAdd(var,n) __atomic_fetch_add(&(var), (n), __ATOMIC_RELAXED)
+#define ResTelemAtomicLoadPage(var) __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define ResTelemAtomicMax(var,n) { \
+	uint64_t old = __atomic_load_n(&(var), __ATOMIC_RELAXED); \
+	while ((n) > old && !__atomic_compare_exchange_n(&(var), &old, (n), TRUE, \
+		__ATOMIC_RELAXED, __ATOMIC_RELAXED)) ; }
+#define ResTelemAtomicInstall(var,p) __atomic_compare_exchange_n(&(var), &(ResTelemCounts *){NULL}, \
+	(p), FALSE, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)
+#else
+#define ResTelemAtomicAdd(var,n) ((var) += (n))
+#define ResTelemAtomicLoadPage(var) (var)
+#define ResTelemAtomicMax(var,n) { if ((n) > (var)) (var) = (n); }
+#define ResTelemAtomicInstall(var,p) ((var) = (p), TRUE)
+#endif
+
+//	---------------------------------------------------------
+//
+//	ResTelemNow() gets a timestamp for latencies.
+//
+//	Returns: monotonic time in nanoseconds, or 0 if no clock (latencies
+//		all land in the first bucket then)
+
+uint64_t ResTelemNow()
+{
+#ifdef RES_CLOCK
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemCount() adds to one of a resource's counts, and its type's.
+//
+//		id      = resource id
+//		type    = resource type
+//		counter = RES_TELEM_XXX count
+//		n       = amount to add
+
+void ResTelemCount(Id id, uint8_t type, int counter, uint64_t n)
+{
+	ResTelemCounts *page;
+
+	ResTelemAtomicAdd(resTelemType[type].count[counter], n);
+	page = ResTelemAtomicLoadPage(resTelemPage[id >> RES_TELEM_PAGEBITS]);
+	if (page == NULL)
+	{
+		page = calloc(RES_TELEM_PAGESIZE, sizeof(ResTelemCounts));
+		if (page == NULL)
+			return;
+		if (!ResTelemAtomicInstall(resTelemPage[id >> RES_TELEM_PAGEBITS], page))
+		{
+			free(page);
+			page = ResTelemAtomicLoadPage(resTelemPage[id >> RES_TELEM_PAGEBITS]);
+		}
+	}
+	ResTelemAtomicAdd(page[id & (RES_TELEM_PAGESIZE - 1)].count[counter], n);
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemTime() records a latency in a histogram.
+//
+//		hist  = RES_TELEM_XXXTIME histogram
+//		start = timestamp from ResTelemNow() at start
+//
+//	Returns: latency in nanoseconds
+
+uint64_t ResTelemTime(int hist, uint64_t start)
+{
+	uint64_t ns;
+	int bucket;
+
+	ns = ResTelemNow() - start;
+	for (bucket = 0; bucket < RES_TELEM_BUCKETS - 1 && (ns >> (bucket + 1)) != 0; bucket++)
+		;
+	ResTelemAtomicAdd(resTelemHist[hist].count[bucket], 1);
+	ResTelemAtomicAdd(resTelemHist[hist].totNs, ns);
+	ResTelemAtomicMax(resTelemHist[hist].maxNs, ns);
+	return ns;
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemLoaded() records a resource load: count, time & worst time.
+//
+//		id    = resource id
+//		type  = resource type
+//		start = timestamp from ResTelemNow() at start of load
+
+void ResTelemLoaded(Id id, uint8_t type, uint64_t start)
+{
+	ResTelemCounts *pc;
+	uint64_t ns;
+
+	ns = ResTelemTime(RES_TELEM_LOADTIME, start);
+	ResTelemCount(id, type, RES_TELEM_LOADS, 1);
+	ResTelemCount(id, type, RES_TELEM_LOADNS, ns);
+	ResTelemAtomicMax(resTelemType[type].count[RES_TELEM_MAXLOADNS], ns);
+	pc = ResTelemId(id);
+	if (pc)
+		ResTelemAtomicMax(pc->count[RES_TELEM_MAXLOADNS], ns);
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemType() gets the counts for a resource type.
+
+ResTelemCounts *ResTelemType(uint8_t type)
+{
+	return &resTelemType[type];
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemId() gets the counts for a resource.
+//
+//	Returns: ptr to counts, or NULL if nothing counted for it yet
+
+ResTelemCounts *ResTelemId(Id id)
+{
+	ResTelemCounts *page;
+
+	page = ResTelemAtomicLoadPage(resTelemPage[id >> RES_TELEM_PAGEBITS]);
+	if (page == NULL)
+		return NULL;
+	return &page[id & (RES_TELEM_PAGESIZE - 1)];
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemHistogram() gets a latency histogram.
+//
+//		hist = RES_TELEM_XXXTIME
+
+ResTelemHist *ResTelemHistogram(int hist)
+{
+	return &resTelemHist[hist];
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemReset() zeroes all counts & histograms.  Counts made by
+//		workers while it runs may be lost.
+
+void ResTelemReset()
+{
+	int i;
+
+	memset(resTelemType, 0, sizeof(resTelemType));
+	memset(resTelemHist, 0, sizeof(resTelemHist));
+	for (i = 0; i < RES_TELEM_NUMPAGES; i++)
+	{
+		if (resTelemPage[i])
+			memset(resTelemPage[i], 0, RES_TELEM_PAGESIZE * sizeof(ResTelemCounts));
+	}
+}
+
+//	---------------------------------------------------------
+//
+//	ResTelemDumpJson() writes telemetry as JSON: histograms, then types
+//		and ids with anything counted.  Ids come worst first, by total
+//		load time.
+//
+//		fp     = file to write to
+//		maxIds = max # ids to write, 0 for all
+//
+//	Returns: # ids written
+
+int32_t ResTelemDumpJson(FILE *fp, int32_t maxIds)
+{
+	ResTelemCounts *pc;
+	uint32_t *ids;
+	int32_t numIds, i;
+	int hist, bucket, counter, type;
+	char *sep;
+
+//	Histograms: bucket n counts latencies below 2^(n+1) ns
+
+	fprintf(fp, "{\n\"histograms\": {");
+	for (hist = 0; hist < RES_TELEM_NUMHISTS; hist++)
+	{
+		fprintf(fp, "%s\n  \"%s\": {\"totNs\": %llu, \"maxNs\": %llu, \"buckets\": [",
+			hist ? "," : "", resTelemHistNames[hist],
+			(unsigned long long) resTelemHist[hist].totNs,
+			(unsigned long long) resTelemHist[hist].maxNs);
+		for (bucket = 0; bucket < RES_TELEM_BUCKETS; bucket++)
+			fprintf(fp, "%s%llu", bucket ? ", " : "",
+				(unsigned long long) resTelemHist[hist].count[bucket]);
+		fprintf(fp, "]}");
+	}
+	fprintf(fp, "\n},\n\"types\": [");
+
+//	Types with anything counted
+
+	sep = "";
+	for (type = 0; type < 256; type++)
+	{
+		pc = &resTelemType[type];
+		for (counter = 0; counter < RES_TELEM_NUMCOUNTS && pc->count[counter] == 0; counter++)
+			;
+		if (counter == RES_TELEM_NUMCOUNTS)
+			continue;
+		fprintf(fp, "%s\n  {\"type\": %d, \"name\": \"%s\"", sep, type,
+			(type < NUM_RESTYPENAMES && resTypeNames[type]) ? resTypeNames[type] : "");
+		for (counter = 0; counter < RES_TELEM_NUMCOUNTS; counter++)
+			fprintf(fp, ", \"%s\": %llu", resTelemCountNames[counter],
+				(unsigned long long) pc->count[counter]);
+		fprintf(fp, "}");
+		sep = ",";
+	}
+	fprintf(fp, "\n],\n\"ids\": [");
+
+//	Ids with anything counted, worst first
+
+	numIds = 0;
+	ids = malloc(0x10000 * sizeof(uint32_t));
+	for (i = 0; ids && i < 0x10000; i++)
+	{
+		pc = ResTelemId((Id) i);
+		if (pc == NULL)
+		{
+			i |= RES_TELEM_PAGESIZE - 1;
+			continue;
+		}
+		for (counter = 0; counter < RES_TELEM_NUMCOUNTS && pc->count[counter] == 0; counter++)
+			;
+		if (counter < RES_TELEM_NUMCOUNTS)
+			ids[numIds++] = i;
+	}
+	qsort(ids, numIds, sizeof(uint32_t), ResTelemCompareLoadNs);
+	if (maxIds > 0 && numIds > maxIds)
+		numIds = maxIds;
+	for (i = 0; i < numIds; i++)
+	{
+		pc = ResTelemId((Id) ids[i]);
+		fprintf(fp, "%s\n  {\"id\": %u", i ? "," : "", ids[i]);
+		for (counter = 0; counter < RES_TELEM_NUMCOUNTS; counter++)
+			fprintf(fp, ", \"%s\": %llu", resTelemCountNames[counter],
+				(unsigned long long) pc->count[counter]);
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n]\n}\n");
+
+	free(ids);
+	return numIds;
+}
+
+//	Orders ids by total load time, most first, for qsort()
+
+static int ResTelemCompareLoadNs(const void *p1, const void *p2)
+{
+	uint64_t ns1 = ResTelemId(*(uint32_t *) p1)->count[RES_TELEM_LOADNS];
+	uint64_t ns2 = ResTelemId(*(uint32_t *) p2)->count[RES_TELEM_LOADNS];
+
+	if (ns1 != ns2)
+		return (ns1 > ns2) ? -1 : 1;
+	return (*(uint32_t *) p1 > *(uint32_t *) p2) ? 1 : -1;
+}
@@ -25,6 +25,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 * $log: $
 */
 
+#include <string.h>
+
 #include "res.h"
 
 //	Resource type names
@@ -95,3 +97,33 @@ char *resTypeNames[NUM_RESTYPENAMES] = {
 	"APP15",
 	"APP16",
 };
+
+//	Type layouts, and the same compiled (none to start with)
+
+char *resTypeLayouts[NUM_RESTYPENAMES];
+ResLayout resLayouts[NUM_RESTYPENAMES];
+
+//	---------------------------------------------------------
+//
+//	ResSetTypeLayout() sets the layout of a type's data, so it's swapped
+//	into this machine's byte order when loaded (see restypes.h).
+//
+//		type   = resource type
+//		layout = layout string (kept, not copied), or NULL for none
+//
+//	Returns: TRUE if set, FALSE if bad type or layout
+
+bool ResSetTypeLayout(uint8_t type, char *layout)
+{
+	ResLayout rl;
+
+	if (type >= NUM_RESTYPENAMES)
+		return(FALSE);
+	if (layout == NULL)
+		memset(&rl, 0, sizeof(rl));
+	else if (!ResLayoutCompile(layout, &rl))
+		return(FALSE);
+	resTypeLayouts[type] = layout;
+	resLayouts[type] = rl;
+	return(TRUE);
+}
@@ -98,5 +98,35 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 extern char *resTypeNames[NUM_RESTYPENAMES];
 
+//	Type layouts, so data can be put in this machine's byte order as it's
+//	loaded, and back as it's written (see resswap.c).  A layout is a byte
+//	order, '>' big-endian or '<' little, then the fields of a record which
+//	repeats through the data (through each item, if compound): 'b' or 'x'
+//	byte, 'h' 16 bits, 'l' 32 bits, each with an optional count, so a rect
+//	is ">4h".  Types have none until given one.  Give them before opening
+//	files, as mapped resources of types without one are used in place.
+
+#define RES_LAYOUT_MAXREC 255			// max bytes in a record
+#define RES_LAYOUT_MAXFIELDS 32		// max 16 & 32 bit fields in a record
+
+typedef struct {
+	uint8_t recSize;						// bytes per record, 0 if nothing to swap
+	uint8_t unit;							// 2 or 4 if all fields that size, else 0
+	uint8_t numFields;					// # fields to swap
+	uint8_t shuffle[16];					// byte shuffle of 16 bytes of records
+	uint8_t field[RES_LAYOUT_MAXFIELDS][2];	// offset & size of each field
+} ResLayout;
+
+extern char *resTypeLayouts[NUM_RESTYPENAMES];	// layout of each type, or NULL
+extern ResLayout resLayouts[NUM_RESTYPENAMES];	// compiled, for swapping
+
+#define ResTypeLayout(type) (((type) < NUM_RESTYPENAMES && resLayouts[type].recSize) ? \
+	&resLayouts[type] : NULL)
+
+bool ResSetTypeLayout(uint8_t type, char *layout);		// set (or clear) type's layout
+bool ResLayoutCompile(char *layout, ResLayout *pl);		// compile a layout
+void ResSwapRecords(ResLayout *pl, void *p, int32_t size);	// swap records
+void ResSwapData(ResLayout *pl, uint8_t flags, void *p, int32_t size);	// swap resource
+
 #endif
 
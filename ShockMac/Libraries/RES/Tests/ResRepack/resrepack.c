@@ -0,0 +1,316 @@
+/*
+
+Copyright (C) 2015-2018 Night Dive Studios, LLC.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+//		ResRepack.C		Resource File Recompression Utility
+//
+//	This tool rewrites a resource file with its compressed resources
+//	transcoded, LZW to LZ4 (the default) or back.  Uncompressed resources
+//	are copied as is, and deleted entries are dropped.  A resource that
+//	doesn't shrink in the new format is stored uncompressed.
+//
+//		resrepack [-lz4 | -lzw] [-j threads] infile outfile
+//
+//	The whole file is read into memory; the directory is read and written
+//	a field at a time, little-endian, as laid out on disk.  Resources are
+//	expanded one by one, compressed in a batch on -j threads (one by
+//	default), and written in order, so the output is the same whatever
+//	the number of threads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lg.h"
+#include "res.h"
+#include "res_.h"
+#include "lzw.h"
+#include "lz4.h"
+
+#define HEADER_SIZE 128				// sizeof(ResFileHeader) on disk
+#define DIRHEADER_SIZE 6			// sizeof(ResDirHeader) on disk
+#define DIRENTRY_SIZE 10			// sizeof(ResDirEntry) on disk
+
+#define GET16(p) ((p)[0] | ((p)[1] << 8))
+#define GET24(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16))
+#define GET32(p) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t) (p)[3] << 24))
+
+static void Put16(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; }
+static void Put24(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; }
+static void Put32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+static bool Expand(uint8_t *pin, int32_t csize, int32_t size, uint8_t flags,
+	ResCompJob *pj);
+
+//	------------------------------------------
+//		THE REPACK PROGRAM
+//	------------------------------------------
+
+int main(int argc, char **argv)
+{
+	FILE *fd;
+	uint8_t *pfile, *pout, *pdir, *pent, *poutDir;
+	ResCompJob *pjobs, *pj;
+	long fileSize;
+	int32_t dirOffset, dataOffset, outOffset, outSize;
+	int32_t numEntries, numOut, numTranscoded, numThreads;
+	int32_t size, csize, newcsize, i;
+	int32_t totcsize, totnewcsize;
+	uint8_t flags, newFlag;
+
+//	Get args
+
+	newFlag = RDF_LZ4;
+	numThreads = 1;
+	for (i = 1; i < argc - 2; i++)
+		{
+		if (strcmp(argv[i], "-lzw") == 0)
+			newFlag = RDF_LZW;
+		else if (strcmp(argv[i], "-lz4") == 0)
+			newFlag = RDF_LZ4;
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc - 2 && atoi(argv[i + 1]) > 0)
+			numThreads = atoi(argv[++i]);
+		else
+			break;
+		}
+	if (argc < 3 || i != argc - 2)
+		{
+		printf("usage: resrepack [-lz4 | -lzw] [-j threads] infile outfile\n");
+		return(1);
+		}
+
+//	Read in whole file, check it
+
+	fd = fopen(argv[argc - 2], "rb");
+	if (fd == NULL)
+		{
+		printf("resrepack: can't open %s\n", argv[argc - 2]);
+		return(1);
+		}
+	fseek(fd, 0, SEEK_END);
+	fileSize = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+	pfile = malloc(fileSize + 1);
+	if (pfile == NULL || fread(pfile, 1, fileSize, fd) != (size_t) fileSize)
+		{
+		printf("resrepack: can't read %s\n", argv[argc - 2]);
+		return(1);
+		}
+	fclose(fd);
+
+	dirOffset = (fileSize >= HEADER_SIZE) ? (int32_t) GET32(pfile + HEADER_SIZE - 4) : -1;
+	if (dirOffset < HEADER_SIZE || dirOffset + DIRHEADER_SIZE > fileSize ||
+		memcmp(pfile, "LG Res", 6) != 0)
+		{
+		printf("resrepack: %s is not a resource file\n", argv[argc - 2]);
+		return(1);
+		}
+	pdir = pfile + dirOffset;
+	numEntries = GET16(pdir);
+	dataOffset = GET32(pdir + 2);
+	if (dirOffset + DIRHEADER_SIZE + numEntries * DIRENTRY_SIZE > fileSize)
+		{
+		printf("resrepack: %s has a bad directory\n", argv[argc - 2]);
+		return(1);
+		}
+
+//	Allocate output: a resource takes at most its expanded size (anything
+//	that doesn't shrink is stored uncompressed), or its old size, plus pad
+
+	outSize = dataOffset + DIRHEADER_SIZE;
+	for (i = 0, pent = pdir + DIRHEADER_SIZE; i < numEntries; i++, pent += DIRENTRY_SIZE)
+		{
+		size = GET24(pent + 2);
+		csize = GET24(pent + 6);
+		outSize += ((size > csize) ? size : csize) + 4;
+		}
+	pout = calloc(1, outSize);
+	poutDir = malloc(numEntries * DIRENTRY_SIZE);
+	memcpy(pout, pfile, dataOffset);
+	outOffset = dataOffset;
+
+//	Expand each compressed resource that's to be transcoded, checking
+//	that they all fit in the file
+
+	pjobs = malloc((numEntries + 1) * sizeof(ResCompJob));
+	numTranscoded = 0;
+	for (i = 0, pent = pdir + DIRHEADER_SIZE; i < numEntries; i++, pent += DIRENTRY_SIZE)
+		{
+		size = GET24(pent + 2);
+		flags = pent[5];
+		csize = GET24(pent + 6);
+		if (dataOffset + csize > dirOffset)
+			{
+			printf("resrepack: resource $%x runs off end of data\n", GET16(pent));
+			return(1);
+			}
+		if (GET16(pent) != 0 && (flags & (RDF_LZW | RDF_LZ4)) && !(flags & newFlag))
+			{
+			if (!Expand(pfile + dataOffset, csize, size, flags, &pjobs[numTranscoded]))
+				{
+				printf("resrepack: resource $%x won't expand\n", GET16(pent));
+				return(1);
+				}
+			pjobs[numTranscoded++].flags = newFlag;
+			}
+		dataOffset = RES_OFFSET_ALIGN(dataOffset + csize);
+		}
+
+//	Compress them the new way, all at once
+
+	ResCompressJobs(pjobs, numTranscoded, numThreads);
+
+//	Copy each resource, or its transcoded data, stored as is if it didn't
+//	shrink in the new format
+
+	dataOffset = GET32(pdir + 2);
+	numOut = 0;
+	totcsize = totnewcsize = 0;
+	pj = pjobs;
+	for (i = 0, pent = pdir + DIRHEADER_SIZE; i < numEntries; i++, pent += DIRENTRY_SIZE)
+		{
+		flags = pent[5];
+		csize = GET24(pent + 6);
+
+		if (GET16(pent) != 0)
+			{
+			if ((flags & (RDF_LZW | RDF_LZ4)) && !(flags & newFlag))
+				{
+				memcpy(pout + outOffset, pj->pres, pj->sizeTable);
+				if (pj->pcomp)
+					memcpy(pout + outOffset + pj->sizeTable, pj->pcomp, pj->compSize);
+				else
+					memcpy(pout + outOffset + pj->sizeTable, pj->pres + pj->sizeTable,
+						pj->size - pj->sizeTable);
+				newcsize = pj->sizeTable + (pj->pcomp ? pj->compSize : pj->size - pj->sizeTable);
+				flags = (flags & ~(RDF_LZW | RDF_LZ4)) | pj->flags;
+				free(pj->pres);
+				free(pj->offsets);
+				free(pj->pcomp);
+				pj++;
+				}
+			else
+				{
+				memcpy(pout + outOffset, pfile + dataOffset, csize);
+				newcsize = csize;
+				}
+			totcsize += csize;
+			totnewcsize += newcsize;
+
+			memcpy(poutDir + numOut * DIRENTRY_SIZE, pent, DIRENTRY_SIZE);
+			poutDir[numOut * DIRENTRY_SIZE + 5] = flags;
+			Put24(poutDir + numOut * DIRENTRY_SIZE + 6, newcsize);
+			numOut++;
+			outOffset = RES_OFFSET_ALIGN(outOffset + newcsize);
+			}
+		dataOffset = RES_OFFSET_ALIGN(dataOffset + csize);
+		}
+
+//	Directory goes after data, then fill in header's pointer to it
+
+	Put16(pout + outOffset, numOut);
+	Put32(pout + outOffset + 2, GET32(pdir + 2));
+	Put32(pout + HEADER_SIZE - 4, outOffset);
+	outSize = outOffset + DIRHEADER_SIZE;
+
+	fd = fopen(argv[argc - 1], "wb");
+	if (fd == NULL ||
+		fwrite(pout, 1, outSize, fd) != (size_t) outSize ||
+		fwrite(poutDir, DIRENTRY_SIZE, numOut, fd) != (size_t) numOut)
+		{
+		printf("resrepack: can't write %s\n", argv[argc - 1]);
+		return(1);
+		}
+	fclose(fd);
+
+	printf("%s: %d resources, %d transcoded to %s, data %d -> %d bytes\n",
+		argv[argc - 1], numOut, numTranscoded, newFlag == RDF_LZ4 ? "LZ4" : "LZW",
+		totcsize, totnewcsize);
+
+	free(pjobs);
+	free(poutDir);
+	free(pout);
+	free(pfile);
+	return(0);
+}
+
+//	-------------------------------------------------------
+//
+//	Expand() expands a resource into a compression job, to be compressed
+//	the other way.  A compound resource's ref table stays uncompressed in
+//	front, and its item offsets are pulled out of it.
+//
+//		pin     = ptr to resource data in file
+//		csize   = size in file
+//		size    = expanded size
+//		flags   = resource flags
+//		pj      = job to set up, all but flags (pres & offsets malloc'ed)
+//
+//	Returns: TRUE if ok, FALSE if data is bad
+
+static bool Expand(uint8_t *pin, int32_t csize, int32_t size, uint8_t flags,
+	ResCompJob *pj)
+{
+	uint8_t *pexp;
+	int32_t *offsets;
+	int32_t numItems, item, sizeTable, expSize;
+
+	numItems = (flags & RDF_COMPOUND) ? GET16(pin) : -1;
+	sizeTable = (flags & RDF_COMPOUND) ? REFTABLESIZE(numItems) : 0;
+	if (sizeTable > csize || sizeTable > size)
+		return(FALSE);
+
+//	Get item offsets of a compound resource, making sure they're in order
+
+	offsets = malloc((numItems + 2) * sizeof(int32_t));
+	for (item = 0; item <= numItems; item++)
+		{
+		offsets[item] = GET32(pin + sizeof(RefIndex) + item * sizeof(int32_t));
+		if (offsets[item] < (item ? offsets[item - 1] : sizeTable) || offsets[item] > size)
+			{
+			free(offsets);
+			return(FALSE);
+			}
+		}
+
+//	Expand the old way
+
+	pexp = malloc(size + 1);
+	memcpy(pexp, pin, sizeTable);
+	if (size == sizeTable)
+		expSize = 0;
+	else if (flags & RDF_LZW)
+		expSize = LzwExpandBlock(pin + sizeTable, csize - sizeTable, pexp + sizeTable, size - sizeTable);
+	else if (numItems >= 0)
+		expSize = Lz4ExpandItems(pin + sizeTable, csize - sizeTable, offsets, numItems, pexp) ?
+			-1 : size - sizeTable;
+	else
+		expSize = Lz4Expand(pin + sizeTable, csize - sizeTable, pexp + sizeTable, size - sizeTable);
+	if (expSize != size - sizeTable)
+		{
+		free(pexp);
+		free(offsets);
+		return(FALSE);
+		}
+
+	pj->pres = pexp;
+	pj->size = size;
+	pj->sizeTable = sizeTable;
+	pj->numItems = (numItems >= 0) ? numItems : 0;
+	pj->offsets = offsets;
+	return(TRUE);
+}
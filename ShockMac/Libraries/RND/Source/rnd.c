@@ -75,6 +75,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //		fix rval = RndRangeFix(&myRs,low,high);	// get next value as fix,
 //												// scaled into range from low to high
 //
+//		RndFill(&myRs,buff,n);			// get the next n values at once
+//
+//		RndFillRange(&myRs,buff,n,low,high);	// the same, scaled into range
+//
+//		Each of these calls the generator through the stream's f_Next.  If
+//		you know the class of the stream, the class's own versions (see
+//		RndLc16Next() and friends in rnd.h) inline into your loop instead.
+//
 //	CREATING A NEW RANDOM STREAM CLASS
 //
 //		To create a new random stream class, you only need to define one
@@ -83,7 +91,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //
 //		(in rnd.h):
 //
-//		#define RNDSTREAM_WHIZ(name) RndStream name = {0,RndWhiz,RndWhizSeed};
+//		#define RNDSTREAM_WHIZ(name) RndStream name = {0,RndWhiz,RndWhizSeed,NULL,{0}};
 //		uint32_t RndWhiz(RndStream *prs);
 //		void RndWhizSeed(RndStream *prs, uint32_t seed);
 //
@@ -103,8 +111,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 //		If your random number generator normally works in 32-bit values, fine.
 //		If it works in values less than 32 bits wide, you must ensure that
 //		the values returned by your generator move those bits into the high
-//		bits of the uint32_t.  Generators which use more than 32 bits are not
-//		currently supported.
+//		bits of the uint32_t.  Generators which need more than 32 bits of
+//		state keep it in state[] and may leave curr alone; give them an
+//		f_Jump too if they can skip ahead to independent substreams.
+//
+//		RndFill() gets values from an unknown class one f_Next call at a time.
+//		If your generator can do better in bulk, add a RndWhizFill() and
+//		teach RndFill() about it.
 /*
 * $Header: n:/project/lib/src/rnd/RCS/rnd.c 1.2 1993/06/01 10:59:38 rex Exp $
 * $Log: rnd.c $
@@ -119,6 +132,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "lg.h"
 #include "rnd.h"
 
+#include <math.h>
 #include <stdlib.h>
 
 //	For gruesome interrupt routines, let 'em have their way:
@@ -152,6 +166,72 @@ int32_t RndRange(RndStream *prs, int32_t low, int32_t high)
 	return low + high_umpy(Rnd(prs), (high - low + 1));
 }
 
+//	----------------------------------------------------------------
+//
+//	RndFill() gets the next n random values of a stream into dst.  The
+//	classes defined here are recognized and filled by their own routine;
+//	any other goes through f_Next for each value.
+//
+//		prs = ptr to random stream
+//		dst = where to put them
+//		n   = how many
+
+void RndFill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	if (prs->f_Next == RndLc16)
+		RndLc16Fill(prs, dst, n);
+	else if (prs->f_Next == RndGauss16Fast)
+		RndGauss16FastFill(prs, dst, n);
+	else if (prs->f_Next == RndGauss16)
+		RndGauss16Fill(prs, dst, n);
+	else if (prs->f_Next == RndXoshiro128)
+		RndXoshiro128Fill(prs, dst, n);
+	else if (prs->f_Next == RndPcg32)
+		RndPcg32Fill(prs, dst, n);
+	else if (prs->f_Next == RndZiggurat)
+		RndZigguratFill(prs, dst, n);
+	else if (prs->f_Next == RndCounter)
+		RndCounterFill(prs, dst, n);
+	else
+	{
+		while (n-- > 0)
+			*dst++ = Rnd(prs);
+	}
+}
+
+//	----------------------------------------------------------------
+//
+//	RndSplit() hands out substreams, for instance one per worker thread.
+//
+//		prs  = ptr to random stream (jumped past all the substreams)
+//		subs = ptr to n streams to set up
+//		n    = how many
+
+void RndSplit(RndStream *prs, RndStream *subs, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		RndJump(prs);
+		subs[i] = *prs;
+	}
+	RndJump(prs);
+}
+
+//	----------------------------------------------------------------
+//
+//	RndFillRange() is RndFill() with each value scaled as by RndRange().
+
+void RndFillRange(RndStream *prs, int32_t *dst, int32_t n, int32_t low, int32_t high)
+{
+	int32_t i;
+
+	RndFill(prs, (uint32_t *) dst, n);
+	for (i = 0; i < n; i++)
+		dst[i] = RndScale((uint32_t) dst[i], low, high);
+}
+
 //	----------------------------------------------------------------
 //
 //	RndRangeFix() returns the next random value, scaled into fixed-point range.
@@ -171,10 +251,8 @@ fix RndRangeFix(RndStream *prs, fix low, fix high)
 //		RANDOM GENERATORS
 //	-----------------------------------------------------------------
 //
-//	RndLc16() uses a 16-bit linear conguential method.
-
-#define LC16_MULT 2053
-#define LC16_ADD 13849
+//	RndLc16() uses a 16-bit linear conguential method (LC16_MULT and
+//	LC16_ADD are in rnd.h, for RndLc16Next()).
 
 uint32_t RndLc16(RndStream *prs)
 {
@@ -182,6 +260,44 @@ uint32_t RndLc16(RndStream *prs)
 	return(prs->curr << 16);								// move them to high 16
 }
 
+//	Four steps at once: x(n+4) = x(n) * LC16_MULT4 + LC16_ADD4.  Each fill
+//	keeps four states going one step apart, so the loop has no chain of
+//	dependent multiplies and vectorizes.
+
+#define LC16_MULT2 ((uint32_t) LC16_MULT * LC16_MULT)
+#define LC16_MULT4 (LC16_MULT2 * LC16_MULT2)
+#define LC16_ADD4 ((uint32_t) LC16_ADD * (1 + LC16_MULT + LC16_MULT2 + LC16_MULT2 * LC16_MULT))
+
+static inline void lc16_lanes(uint32_t curr, uint32_t lane[4])
+{
+	int j;
+
+	for (j = 0; j < 4; j++)
+		lane[j] = curr = (curr * LC16_MULT) + LC16_ADD;
+}
+
+void RndLc16Fill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint32_t lane[4], last;
+	int32_t i;
+	int j;
+
+	last = prs->curr;
+	lc16_lanes(last, lane);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		last = lane[3];
+		for (j = 0; j < 4; j++)
+		{
+			dst[i + j] = lane[j] << 16;
+			lane[j] = (lane[j] * LC16_MULT4) + LC16_ADD4;
+		}
+	}
+	for (j = 0; i < n; i++, j++)
+		dst[i] = (last = lane[j]) << 16;
+	prs->curr = last;
+}
+
 void RndLc16Seed(RndStream *prs, uint32_t seed)
 {
 	prs->curr = seed ^ (seed >> 16);		// make sure something in low 16 bits
@@ -222,6 +338,17 @@ uint32_t RndGauss16(RndStream *prs)
 	return(prs->curr << 16);			// return in high 16 bits
 }
 
+//	Each value starts from the last one, so there is nothing to overlap;
+//	this just saves the calls.
+
+void RndGauss16Fill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	int32_t i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = RndGauss16(prs);
+}
+
 void RndGauss16Seed(RndStream *prs, uint32_t seed)
 {
 	prs->curr = seed ^ (seed >> 16);	// make sure something in low 16 bits
@@ -233,10 +360,9 @@ void RndGauss16Seed(RndStream *prs, uint32_t seed)
 //	time it is called, and then does a single lc random number to
 //	look up into the table with.
 
-#define NUM_GAUSSBITS 13			// we'll use 13 bits of our 16 bit rnums
-#define SIZE_GAUSSTABLE (1<<NUM_GAUSSBITS)	// # entries in table = 8192
-#define MASK_GAUSSTABLE (SIZE_GAUSSTABLE-1)	// mask for lookup
-static uint16_t *gaussTable;			// ptr to our 16K (gasp) table
+//	(NUM_GAUSSBITS, SIZE_GAUSSTABLE and MASK_GAUSSTABLE are in rnd.h)
+
+uint16_t *gRndGaussTable;				// ptr to our 16K (gasp) table
 
 uint32_t RndGauss16Fast(RndStream *prs)
 {
@@ -244,7 +370,31 @@ uint32_t RndGauss16Fast(RndStream *prs)
 //	Return it in high 16 bits.
 
 	prs->curr = (prs->curr * LC16_MULT) + LC16_ADD;
-	return((uint32_t)(gaussTable[prs->curr & MASK_GAUSSTABLE]) << 16);
+	return((uint32_t)(gRndGaussTable[prs->curr & MASK_GAUSSTABLE]) << 16);
+}
+
+//	The same lc sequence as RndLc16Fill(), looked up.
+
+void RndGauss16FastFill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint32_t lane[4], last;
+	int32_t i;
+	int j;
+
+	last = prs->curr;
+	lc16_lanes(last, lane);
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		last = lane[3];
+		for (j = 0; j < 4; j++)
+		{
+			dst[i + j] = (uint32_t)(gRndGaussTable[lane[j] & MASK_GAUSSTABLE]) << 16;
+			lane[j] = (lane[j] * LC16_MULT4) + LC16_ADD4;
+		}
+	}
+	for (j = 0; i < n; i++, j++)
+		dst[i] = (uint32_t)(gRndGaussTable[(last = lane[j]) & MASK_GAUSSTABLE]) << 16;
+	prs->curr = last;
 }
 
 void RndGauss16FastSeed(RndStream *prs, uint32_t seed)
@@ -255,9 +405,9 @@ void RndGauss16FastSeed(RndStream *prs, uint32_t seed)
 //	If table not allocated, allocate it and fill it using the RndGauss16
 //	generator.
 
-	if (gaussTable == NULL)
+	if (gRndGaussTable == NULL)
 	{
-		pg = gaussTable = malloc(SIZE_GAUSSTABLE * sizeof(int16_t));
+		pg = gRndGaussTable = malloc(SIZE_GAUSSTABLE * sizeof(int16_t));
 		for (i = 0; i < SIZE_GAUSSTABLE; i++)
 		{
 			prs->curr = i;
@@ -267,3 +417,466 @@ void RndGauss16FastSeed(RndStream *prs, uint32_t seed)
 
 	prs->curr = seed ^ (seed >> 16);		// make sure something in low 16 bits
 }
+
+//	----------------------------------------------------------------
+//
+//	RndXoshiro128() is xoshiro128** (see RndXoshiro128Next() in rnd.h).
+//	The seed is spread over the 128-bit state with splitmix64, which never
+//	leaves it all zero.
+
+static uint64_t splitmix64(uint64_t *px)
+{
+	uint64_t z = (*px += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return(z ^ (z >> 31));
+}
+
+uint32_t RndXoshiro128(RndStream *prs)
+{
+	return(RndXoshiro128Next(prs));
+}
+
+void RndXoshiro128Seed(RndStream *prs, uint32_t seed)
+{
+	uint64_t x = seed;
+	uint64_t a = splitmix64(&x);
+	uint64_t b = splitmix64(&x);
+
+	prs->state[0] = (uint32_t) a;
+	prs->state[1] = (uint32_t)(a >> 32);
+	prs->state[2] = (uint32_t) b;
+	prs->state[3] = (uint32_t)(b >> 32);
+}
+
+//	The state is kept in locals, so it stays in registers.
+
+void RndXoshiro128Fill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint32_t s0 = prs->state[0], s1 = prs->state[1], s2 = prs->state[2], s3 = prs->state[3];
+	int32_t i;
+
+	for (i = 0; i < n; i++)
+		RND_XOSHIRO128_STEP(dst[i], s0, s1, s2, s3);
+	prs->state[0] = s0;
+	prs->state[1] = s1;
+	prs->state[2] = s2;
+	prs->state[3] = s3;
+}
+
+//	Jump 2^64 values: the state the stream would have after that many
+//	calls, as a sum over GF(2) of the states along the way.
+
+void RndXoshiro128Jump(RndStream *prs)
+{
+	static const uint32_t jump[4] = { 0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B };
+	uint32_t s[4] = { 0, 0, 0, 0 };
+	int i, b, j;
+
+	for (i = 0; i < 4; i++)
+	{
+		for (b = 0; b < 32; b++)
+		{
+			if (jump[i] & (1U << b))
+			{
+				for (j = 0; j < 4; j++)
+					s[j] ^= prs->state[j];
+			}
+			RndXoshiro128Next(prs);
+		}
+	}
+	for (j = 0; j < 4; j++)
+		prs->state[j] = s[j];
+}
+
+//	----------------------------------------------------------------
+//
+//	RndPcg32() is PCG32 (see RndPcg32Next() in rnd.h), seeded the way the
+//	reference pcg32_srandom() is.
+
+uint32_t RndPcg32(RndStream *prs)
+{
+	return(RndPcg32Next(prs));
+}
+
+static inline uint64_t pcg32_get(RndStream *prs)
+{
+	return(((uint64_t) prs->state[1] << 32) | prs->state[0]);
+}
+
+static inline void pcg32_set(RndStream *prs, uint64_t state)
+{
+	prs->state[0] = (uint32_t) state;
+	prs->state[1] = (uint32_t)(state >> 32);
+}
+
+void RndPcg32Seed(RndStream *prs, uint32_t seed)
+{
+	pcg32_set(prs, 0);
+	RndPcg32Next(prs);
+	pcg32_set(prs, pcg32_get(prs) + seed);
+	RndPcg32Next(prs);
+}
+
+//	Like RndLc16Fill(), four lc states a step apart, so the 64-bit
+//	multiplies overlap.
+
+static inline uint32_t pcg32_output(uint64_t old)
+{
+	uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+	uint32_t rot = (uint32_t)(old >> 59);
+
+	return((xorshifted >> rot) | (xorshifted << ((32 - rot) & 31)));
+}
+
+#define PCG32_MULT2 (PCG32_MULT * PCG32_MULT)
+#define PCG32_MULT4 (PCG32_MULT2 * PCG32_MULT2)
+#define PCG32_INC4 (PCG32_INC * (1 + PCG32_MULT + PCG32_MULT2 + PCG32_MULT2 * PCG32_MULT))
+
+void RndPcg32Fill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint64_t lane[4];
+	int32_t i;
+	int j;
+
+	lane[0] = pcg32_get(prs);
+	for (j = 1; j < 4; j++)
+		lane[j] = lane[j - 1] * PCG32_MULT + PCG32_INC;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			dst[i + j] = pcg32_output(lane[j]);
+			lane[j] = lane[j] * PCG32_MULT4 + PCG32_INC4;
+		}
+	}
+	for (j = 0; i < n; i++, j++)
+		dst[i] = pcg32_output(lane[j]);
+	pcg32_set(prs, lane[j]);
+}
+
+//	Skip delta values in log2(delta) steps (Brown, "Random Number Generation
+//	with Arbitrary Stride"): square the step's multiplier and increment as
+//	we go, and apply them for each set bit of delta.
+
+void RndPcg32Advance(RndStream *prs, uint64_t delta)
+{
+	uint64_t cur_mult = PCG32_MULT, cur_plus = PCG32_INC;
+	uint64_t acc_mult = 1, acc_plus = 0;
+
+	while (delta > 0)
+	{
+		if (delta & 1)
+		{
+			acc_mult *= cur_mult;
+			acc_plus = acc_plus * cur_mult + cur_plus;
+		}
+		cur_plus = (cur_mult + 1) * cur_plus;
+		cur_mult *= cur_mult;
+		delta >>= 1;
+	}
+	pcg32_set(prs, acc_mult * pcg32_get(prs) + acc_plus);
+}
+
+void RndPcg32Jump(RndStream *prs)
+{
+	RndPcg32Advance(prs, (uint64_t) 1 << 48);
+}
+
+//	----------------------------------------------------------------
+//
+//	RndZiggurat() is a ziggurat gaussian: the normal curve covered by 128
+//	boxes of equal area, the bottom one with the tail past r = 3.4426 in it.
+//	Pick a box and a point across it; if the point is under the box above,
+//	it's under the curve.  Otherwise (about 1 time in 80) check the sliver
+//	of box that sticks out over the curve, or sample the tail.
+//
+//	The tables are zigset() from Marsaglia and Tsang, "The Ziggurat Method
+//	for Generating Random Variables" (2000), with dn = 3.442619855899 and
+//	vn = 9.91256303526217e-3, written out so every platform gets the same
+//	values: gRndZigK[] is kn[], gRndZigW[] is wn[] * 2^56 (so hz times it,
+//	>> 32, is the deviate in 8.24), and zigF[] is fn[].
+
+#define ZIG_R 3.442619855899
+
+const uint32_t gRndZigK[128] = {
+	0x76AD2212, 0x00000000, 0x600F1B53, 0x6CE447A6, 0x725B46A2, 0x7560051D,
+	0x774921EB, 0x789A25BD, 0x799045C3, 0x7A4BCE5D, 0x7ADF629F, 0x7B5682A6,
+	0x7BB8A8C6, 0x7C0AE722, 0x7C50CCE7, 0x7C8CEC5B, 0x7CC12CD6, 0x7CEEFED2,
+	0x7D177E0B, 0x7D3B8883, 0x7D5BCE6C, 0x7D78DD64, 0x7D932886, 0x7DAB0E57,
+	0x7DC0DD30, 0x7DD4D688, 0x7DE73185, 0x7DF81CEA, 0x7E07C0A3, 0x7E163EFA,
+	0x7E23B587, 0x7E303DFD, 0x7E3BEEC2, 0x7E46DB77, 0x7E51155D, 0x7E5AABB3,
+	0x7E63ABF7, 0x7E6C222C, 0x7E741906, 0x7E7B9A18, 0x7E82ADFA, 0x7E895C63,
+	0x7E8FAC4B, 0x7E95A3FB, 0x7E9B4924, 0x7EA0A0EF, 0x7EA5B00D, 0x7EAA7AC3,
+	0x7EAF04F3, 0x7EB3522A, 0x7EB765A5, 0x7EBB4259, 0x7EBEEAFD, 0x7EC2620A,
+	0x7EC5A9C4, 0x7EC8C441, 0x7ECBB365, 0x7ECE78ED, 0x7ED11671, 0x7ED38D62,
+	0x7ED5DF12, 0x7ED80CB4, 0x7EDA175C, 0x7EDC0005, 0x7EDDC78E, 0x7EDF6EBF,
+	0x7EE0F647, 0x7EE25EBE, 0x7EE3A8A9, 0x7EE4D473, 0x7EE5E276, 0x7EE6D2F5,
+	0x7EE7A620, 0x7EE85C10, 0x7EE8F4CD, 0x7EE97047, 0x7EE9CE59, 0x7EEA0ECA,
+	0x7EEA3147, 0x7EEA3568, 0x7EEA1AAB, 0x7EE9E071, 0x7EE98602, 0x7EE90A88,
+	0x7EE86D08, 0x7EE7AC6A, 0x7EE6C769, 0x7EE5BC9C, 0x7EE48A67, 0x7EE32EFC,
+	0x7EE1A857, 0x7EDFF42F, 0x7EDE0FFA, 0x7EDBF8D9, 0x7ED9AB94, 0x7ED7248D,
+	0x7ED45FAE, 0x7ED1585C, 0x7ECE095F, 0x7ECA6CCB, 0x7EC67BE2, 0x7EC22EEE,
+	0x7EBD7D1A, 0x7EB85C35, 0x7EB2C075, 0x7EAC9C20, 0x7EA5DF27, 0x7E9E769F,
+	0x7E964C16, 0x7E8D44BA, 0x7E834033, 0x7E781728, 0x7E6B9933, 0x7E5D8A1A,
+	0x7E4D9DED, 0x7E3B737A, 0x7E268C2F, 0x7E0E3FF5, 0x7DF1AA5D, 0x7DCF8C72,
+	0x7DA61A1E, 0x7D72A0FB, 0x7D30E097, 0x7CD9B4AB, 0x7C600F1A, 0x7BA90BDC,
+	0x7A722176, 0x77D664E5,
+};
+
+const uint32_t gRndZigW[128] = {
+	0x076D19A4, 0x008B6DA4, 0x00B9CA49, 0x00DA647F, 0x00F472BB, 0x010A936E,
+	0x011E0CE7, 0x012F98D7, 0x013FABEE, 0x014E94C1, 0x015C8AFE, 0x0169B7B2,
+	0x01763A16, 0x01822A86, 0x018D9C6B, 0x01989F86, 0x01A340D2, 0x01AD8B25,
+	0x01B787A8, 0x01C13E2B, 0x01CAB56B, 0x01D3F341, 0x01DCFCCC, 0x01E5D691,
+	0x01EE848F, 0x01F70A58, 0x01FF6B22, 0x0207A9CE, 0x020FC8FB, 0x0217CB09,
+	0x021FB223, 0x02278049, 0x022F3750, 0x0236D8E9, 0x023E66A7, 0x0245E1FF,
+	0x024D4C50, 0x0254A6DF, 0x025BF2E1, 0x02633175, 0x026A63AE, 0x02718A8F,
+	0x0278A70D, 0x027FBA13, 0x0286C481, 0x028DC72F, 0x0294C2EB, 0x029BB87B,
+	0x02A2A8A1, 0x02A99417, 0x02B07B91, 0x02B75FC2, 0x02BE4155, 0x02C520F4,
+	0x02CBFF45, 0x02D2DCEB, 0x02D9BA88, 0x02E098BE, 0x02E7782A, 0x02EE596B,
+	0x02F53D20, 0x02FC23E7, 0x03030E60, 0x0309FD29, 0x0310F0E5, 0x0317EA37,
+	0x031EE9C3, 0x0325F034, 0x032CFE32, 0x0334146E, 0x033B339B, 0x03425C70,
+	0x03498FA9, 0x0350CE09, 0x03581859, 0x035F6F68, 0x0366D40F, 0x036E472C,
+	0x0375C9A9, 0x037D5C79, 0x0385009A, 0x038CB718, 0x0394810A, 0x039C5F96,
+	0x03A453F3, 0x03AC5F6A, 0x03B48356, 0x03BCC127, 0x03C51A66, 0x03CD90B5,
+	0x03D625D2, 0x03DEDB9C, 0x03E7B413, 0x03F0B160, 0x03F9D5D6, 0x040323FB,
+	0x040C9E87, 0x04164874, 0x04202500, 0x042A37B4, 0x04348477, 0x043F0F93,
+	0x0449DDC8, 0x0454F45B, 0x04605930, 0x046C12DD, 0x047828D1, 0x0484A375,
+	0x04918C5F, 0x049EEE8B, 0x04ACD6A9, 0x04BB537E, 0x04CA765D, 0x04DA53CF,
+	0x04EB046E, 0x04FCA612, 0x050F5D6E, 0x05235860, 0x0538D15B, 0x05501480,
+	0x056987B8, 0x0585B7FE, 0x05A570B0, 0x05C9E775, 0x05F517AD, 0x062A9CF9,
+	0x06723832, 0x06E29F12,
+};
+
+static const double zigF[128] = {
+	1, 0.96359969312708615, 0.93628268168505957, 0.9130436479717402,
+	0.8922816507840261, 0.87324304891006954, 0.85550060786945059, 0.83878360529598961,
+	0.82290721138140899, 0.80773829468296054, 0.79317701177130506, 0.7791460859296877,
+	0.7655841738977045, 0.75244155917461142, 0.73967724367264731, 0.72725691834418482,
+	0.7151515074104986, 0.70333609901615812, 0.69178914343667508, 0.68049184099733406,
+	0.66942766734889037, 0.65858200005008805, 0.64794182111022247, 0.6374954773350423,
+	0.62723248524992725, 0.61714337081888093, 0.60721953662512029, 0.59745315094451668,
+	0.58783705443470657, 0.57836468111976314, 0.56902999106795094, 0.55982741270408687,
+	0.55075179311460454, 0.5417983550254255, 0.53296265938383613, 0.52424057267298407,
+	0.51562823824400184, 0.50712205107556896, 0.4987186354709795, 0.49041482528384411,
+	0.48220764632948521, 0.47409430069301695, 0.46607215268945612, 0.45813871626787206,
+	0.45029164368203922, 0.44252871527546844, 0.43484783024999091, 0.42724699830499607,
+	0.41972433204957438, 0.412278040102661, 0.40490642080722294, 0.39760785649387331,
+	0.39038080823731458, 0.3832238110559012, 0.37613546951056259, 0.36911445366447221,
+	0.36215949536931757, 0.35526938484791709, 0.34844296754632659, 0.34167914123155041,
+	0.33497685331358917, 0.3283350983728503, 0.32175291587598492, 0.31522938806501088,
+	0.30876363800618112, 0.30235482778648354, 0.29600215684693298, 0.28970486044295984,
+	0.28346220822323298, 0.27727350291918812, 0.27113807913838461, 0.26505530225558921,
+	0.25902456739620483, 0.25304529850732577, 0.24711694751232141, 0.24123899354543982,
+	0.23541094226347908, 0.22963232523211613, 0.22390269938500842, 0.2182216465543054,
+	0.2125887730717303, 0.20700370943992652, 0.20146611007431367, 0.19597565311627774,
+	0.19053204031913715, 0.18513499700899219, 0.17978427212329545, 0.1744796383307895,
+	0.169220892237365, 0.16400785468342038, 0.1588403711394793, 0.15371831220818166,
+	0.14864157424234226, 0.14361008009062776, 0.1386237799845946, 0.13368265258343937,
+	0.12878670619594321, 0.12393598020286782, 0.11913054670765083, 0.11437051244886601,
+	0.10965602101484027, 0.10498725540942132, 0.10036444102865587, 0.095787849121731439,
+	0.091257800826830257, 0.086774671894780178, 0.082338898242235656, 0.077950982513973394,
+	0.073611501884113403, 0.069321117393577908, 0.065080585213068073, 0.060890770348040406,
+	0.056752663481049848, 0.052667401903051012, 0.048636295859867805, 0.044660862200491425,
+	0.040742868074444175, 0.036884388786656203, 0.033087886146225751, 0.02935631744000685,
+	0.025693291935934271, 0.022103304615927098, 0.018592102737011288, 0.015167298010546568,
+	0.011839478657884862, 0.0086244844128598851, 0.0055489952207713449, 0.0026696290838809228,
+};
+
+//	uniform in (0,1), never 0 so it can be logged
+static double zig_uni(RndStream *prs)
+{
+	return(((RndXoshiro128Next(prs) >> 8) + 0.5) * (1.0 / 16777216.0));
+}
+
+static int32_t zig_fix24(double x)
+{
+	if (x > 127.0)
+		x = 127.0;
+	else if (x < -127.0)
+		x = -127.0;
+	return((int32_t) floor(x * 16777216.0 + 0.5));
+}
+
+//	What RndZigguratNormal24() does when hz is outside box iz.
+
+int32_t RndZigguratSlow(RndStream *prs, int32_t hz, int iz)
+{
+	double x, y;
+	int32_t z;
+	uint32_t r, ahz;
+
+	for (;;)
+	{
+		if (iz == 0)								// the tail, past r
+		{
+			do
+			{
+				x = -log(zig_uni(prs)) * (1.0 / ZIG_R);
+				y = -log(zig_uni(prs));
+			}
+			while (y + y < x * x);
+			return(zig_fix24((hz > 0) ? ZIG_R + x : -ZIG_R - x));
+		}
+
+		z = (int32_t)(((int64_t) hz * gRndZigW[iz]) >> 32);
+		x = z * (1.0 / 16777216.0);
+		if (zigF[iz] + zig_uni(prs) * (zigF[iz - 1] - zigF[iz]) < exp(-.5 * x * x))
+			return(z);								// in the sliver, under the curve
+
+		r = RndXoshiro128Next(prs);			// no; start over
+		iz = r & 127;
+		hz = (int32_t)(r & ~127U);
+		ahz = (hz < 0) ? 0U - (uint32_t) hz : (uint32_t) hz;
+		if (ahz < gRndZigK[iz])
+			return((int32_t)(((int64_t) hz * gRndZigW[iz]) >> 32));
+	}
+}
+
+uint32_t RndZiggurat(RndStream *prs)
+{
+	return(RndZigguratNext(prs));
+}
+
+void RndZigguratSeed(RndStream *prs, uint32_t seed)
+{
+	RndXoshiro128Seed(prs, seed);
+}
+
+//	The fills keep the state in locals, as RndXoshiro128Fill() does, and
+//	only put it back in the stream around the odd call to the slow path.
+//	(Through the stream, each value waits on the stores of the one before.)
+
+static inline int32_t zig_fill_one(RndStream *prs, uint32_t *s)
+{
+	uint32_t r, ahz;
+	int32_t hz, z;
+	int iz, j;
+
+	RND_XOSHIRO128_STEP(r, s[0], s[1], s[2], s[3]);
+	iz = r & 127;
+	hz = (int32_t)(r & ~127U);
+	ahz = (hz < 0) ? 0U - (uint32_t) hz : (uint32_t) hz;
+	if (ahz < gRndZigK[iz])
+		return((int32_t)(((int64_t) hz * gRndZigW[iz]) >> 32));
+
+	for (j = 0; j < 4; j++)
+		prs->state[j] = s[j];
+	z = RndZigguratSlow(prs, hz, iz);
+	for (j = 0; j < 4; j++)
+		s[j] = prs->state[j];
+	return(z);
+}
+
+void RndZigguratFill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint32_t s[4];
+	int32_t i;
+	int j;
+
+	for (j = 0; j < 4; j++)
+		s[j] = prs->state[j];
+	for (i = 0; i < n; i++)
+		dst[i] = RndZigguratEncode(zig_fill_one(prs, s));
+	for (j = 0; j < 4; j++)
+		prs->state[j] = s[j];
+}
+
+void RndZigguratNormalFill(RndStream *prs, fix *dst, int32_t n)
+{
+	uint32_t s[4];
+	int32_t i;
+	int j;
+
+	for (j = 0; j < 4; j++)
+		s[j] = prs->state[j];
+	for (i = 0; i < n; i++)
+		dst[i] = (zig_fill_one(prs, s) + 128) >> 8;
+	for (j = 0; j < 4; j++)
+		prs->state[j] = s[j];
+}
+
+//	----------------------------------------------------------------
+//
+//	RndPhilox4x32() is Philox4x32-10: ten rounds of two 32x32->64 bit
+//	multiplies, the high halves xor'd with the rest of the counter and the
+//	key, the key bumped by Weyl constants between rounds.
+
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+
+void RndPhilox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+	uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	uint64_t p0, p1;
+	int r;
+
+	for (r = 0; r < 10; r++)
+	{
+		p0 = (uint64_t) PHILOX_M0 * c0;
+		p1 = (uint64_t) PHILOX_M1 * c2;
+		c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		c1 = (uint32_t) p1;
+		c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		c3 = (uint32_t) p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+uint32_t RndCounterValue(uint32_t seed, uint32_t id, uint32_t tick, uint32_t index)
+{
+	uint32_t ctr[4], key[2], out[4];
+
+	ctr[0] = index >> 2;
+	ctr[1] = tick;
+	ctr[2] = 0;
+	ctr[3] = 0;
+	key[0] = seed;
+	key[1] = id;
+	RndPhilox4x32(ctr, key, out);
+	return(out[index & 3]);
+}
+
+uint32_t RndCounter(RndStream *prs)
+{
+	return(RndCounterValue(prs->state[0], prs->state[1], prs->state[2], prs->state[3]++));
+}
+
+void RndCounterSeed(RndStream *prs, uint32_t seed)
+{
+	RndCounterStart(prs, seed, 0, 0);
+}
+
+//	One Philox per four values, where RndCounter() does one per value.
+
+void RndCounterFill(RndStream *prs, uint32_t *dst, int32_t n)
+{
+	uint32_t ctr[4], key[2], out[4];
+	uint32_t index = prs->state[3];
+	int32_t i = 0;
+
+	key[0] = prs->state[0];
+	key[1] = prs->state[1];
+	ctr[1] = prs->state[2];
+	ctr[2] = 0;
+	ctr[3] = 0;
+	while (i < n)
+	{
+		ctr[0] = index >> 2;
+		RndPhilox4x32(ctr, key, out);
+		do
+			dst[i++] = out[index++ & 3];
+		while (i < n && (index & 3) != 0);
+	}
+	prs->state[3] = index;
+}
@@ -40,6 +40,8 @@ typedef struct RndStream_ {
 	uint32_t curr;
 	uint32_t (*f_Next)(struct RndStream_ *prs);
 	void (*f_Seed)(struct RndStream_ *prs, uint32_t seed);
+	void (*f_Jump)(struct RndStream_ *prs);	// to next substream, NULL if none
+	uint32_t state[4];							// for generators wider than curr
 } RndStream;
 
 //	To use a random stream, instantiate one (usually statically),
@@ -53,9 +55,13 @@ typedef struct RndStream_ {
 //		rfix = RndRangeFix(&rs,fl,fh);	// or fixed point in a range
 
 //	Here are the random stream type declaration macros
-#define RNDSTREAM_LC16(name) RndStream name = {0,RndLc16,RndLc16Seed}
-#define RNDSTREAM_GAUSS16(name) RndStream name = {0,RndGauss16,RndGauss16Seed}
-#define RNDSTREAM_GAUSS16FAST(name) RndStream name = {0,RndGauss16Fast,RndGauss16FastSeed}
+#define RNDSTREAM_LC16(name) RndStream name = {0,RndLc16,RndLc16Seed,NULL,{0}}
+#define RNDSTREAM_GAUSS16(name) RndStream name = {0,RndGauss16,RndGauss16Seed,NULL,{0}}
+#define RNDSTREAM_GAUSS16FAST(name) RndStream name = {0,RndGauss16Fast,RndGauss16FastSeed,NULL,{0}}
+#define RNDSTREAM_XOSHIRO128(name) RndStream name = {0,RndXoshiro128,RndXoshiro128Seed,RndXoshiro128Jump,{0}}
+#define RNDSTREAM_PCG32(name) RndStream name = {0,RndPcg32,RndPcg32Seed,RndPcg32Jump,{0}}
+#define RNDSTREAM_ZIGGURAT(name) RndStream name = {0,RndZiggurat,RndZigguratSeed,RndXoshiro128Jump,{0}}
+#define RNDSTREAM_COUNTER(name) RndStream name = {0,RndCounter,RndCounterSeed,NULL,{0}}
 
 #define RNDSTREAM_STD(name) RNDSTREAM_LC16(name)
 
@@ -74,14 +80,212 @@ int32_t RndRange(RndStream *prs, int32_t low, int32_t high);
 //	Get next random # and scale into low->high range
 fix RndRangeFix(RndStream *prs, fix low, fix high);
 
+//	Move a stream on to its next substream, far enough that the values
+//	skipped over will never be reached by the stream it came from.  Only
+//	classes with an f_Jump have substreams; for the rest this does nothing.
+#define RndJump(prs) ((prs)->f_Jump ? (prs)->f_Jump(prs) : (void) 0)
+
+//	Give each of n workers its own substream of prs: subs[i] is prs jumped
+//	i+1 times, and prs is left jumped n+1 times, past all of them.
+void RndSplit(RndStream *prs, RndStream *subs, int32_t n);
+
+//	Scale a random # into low->high range (high value included), as RndRange()
+static inline int32_t RndScale(uint32_t rval, int32_t low, int32_t high)
+{
+	return low + (int32_t)(((uint64_t) rval * (uint32_t)(high - low + 1)) >> 32);
+}
+
+//	Fill dst with the next n random #'s of any stream, one dispatch for all
+void RndFill(RndStream *prs, uint32_t *dst, int32_t n);
+
+//	Fill dst with the next n random #'s scaled into low->high range
+void RndFillRange(RndStream *prs, int32_t *dst, int32_t n, int32_t low, int32_t high);
+
+//	Statically dispatched streams.  Where the class of a stream is known,
+//	these skip the f_Next call and inline into the caller's loop.  They
+//	give the same values as the macros above, so they may be mixed:
+//
+//		static RNDSTREAM_STD(rs);
+//		RndSeed(&rs,22);
+//		rval = RndStdRange(&rs,1,6);		// same as RndRange(&rs,1,6)
+
+#define LC16_MULT 2053
+#define LC16_ADD 13849
+
+static inline uint32_t RndLc16Next(RndStream *prs)
+{
+	prs->curr = (prs->curr * LC16_MULT) + LC16_ADD;
+	return(prs->curr << 16);
+}
+
+#define NUM_GAUSSBITS 13			// we'll use 13 bits of our 16 bit rnums
+#define SIZE_GAUSSTABLE (1<<NUM_GAUSSBITS)	// # entries in table = 8192
+#define MASK_GAUSSTABLE (SIZE_GAUSSTABLE-1)	// mask for lookup
+
+extern uint16_t *gRndGaussTable;		// made by the first RndGauss16FastSeed()
+
+static inline uint32_t RndGauss16FastNext(RndStream *prs)
+{
+	prs->curr = (prs->curr * LC16_MULT) + LC16_ADD;
+	return((uint32_t)(gRndGaussTable[prs->curr & MASK_GAUSSTABLE]) << 16);
+}
+
+#define RndLc16Fix(prs) (fix_make(0,RndLc16Next(prs)>>16))
+#define RndLc16Range(prs,low,high) RndScale(RndLc16Next(prs),low,high)
+
+#define RndGauss16FastFix(prs) (fix_make(0,RndGauss16FastNext(prs)>>16))
+#define RndGauss16FastRange(prs,low,high) RndScale(RndGauss16FastNext(prs),low,high)
+
+#define RndStdNext(prs) RndLc16Next(prs)
+#define RndStdFix(prs) RndLc16Fix(prs)
+#define RndStdRange(prs,low,high) RndLc16Range(prs,low,high)
+
+//	xoshiro128** (Blackman and Vigna): 128 bits of state in state[0..3],
+//	period 2^128-1, every bit of the output usable.  A jump is 2^64 values.
+
+//	One step on the state in s0..s3 (variables, so a loop can keep them in
+//	registers), leaving the output in result.
+#define RND_XOSHIRO128_STEP(result,s0,s1,s2,s3)				\
+	do {															\
+		uint32_t m_ = (s1) * 5, t_ = (s1) << 9;				\
+		result = ((m_ << 7) | (m_ >> 25)) * 9;				\
+		s2 ^= s0;													\
+		s3 ^= s1;													\
+		s1 ^= s2;													\
+		s0 ^= s3;													\
+		s2 ^= t_;													\
+		s3 = (s3 << 11) | (s3 >> 21);							\
+	} while (0)
+
+static inline uint32_t RndXoshiro128Next(RndStream *prs)
+{
+	uint32_t *s = prs->state;
+	uint32_t result;
+
+	RND_XOSHIRO128_STEP(result, s[0], s[1], s[2], s[3]);
+	return(result);
+}
+
+#define RndXoshiro128Fix(prs) (fix_make(0,RndXoshiro128Next(prs)>>16))
+#define RndXoshiro128Range(prs,low,high) RndScale(RndXoshiro128Next(prs),low,high)
+
+//	PCG32 (O'Neill, XSH RR): a 64-bit lc state in state[0] (low) and
+//	state[1] (high), permuted down to 32 bits.  Period 2^64; a jump is 2^48
+//	values, so there are 65536 substreams.
+
+#define PCG32_MULT 6364136223846793005ULL
+#define PCG32_INC 1442695040888963407ULL
+
+static inline uint32_t RndPcg32Next(RndStream *prs)
+{
+	uint64_t old = ((uint64_t) prs->state[1] << 32) | prs->state[0];
+	uint64_t next = old * PCG32_MULT + PCG32_INC;
+	uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+	uint32_t rot = (uint32_t)(old >> 59);
+
+	prs->state[0] = (uint32_t) next;
+	prs->state[1] = (uint32_t)(next >> 32);
+	return((xorshifted >> rot) | (xorshifted << ((32 - rot) & 31)));
+}
+
+#define RndPcg32Fix(prs) (fix_make(0,RndPcg32Next(prs)>>16))
+#define RndPcg32Range(prs,low,high) RndScale(RndPcg32Next(prs),low,high)
+
+//	Ziggurat gaussian (Marsaglia and Tsang) drawing on xoshiro128** state.
+//	Rnd() values are spread like RndGauss16's, centered in the range with
+//	sigma 1/12 of it and clamped at 6 sigma, so RndRange() and RndFix()
+//	mean what they did; but each one is a single draw, and nearly always
+//	just a compare and a multiply.  RndZigguratNormal() is the deviate
+//	itself, mean 0 and sigma 1.
+
+extern const uint32_t gRndZigK[128];		// |hz| under this is inside the box
+extern const uint32_t gRndZigW[128];		// box width, per unit of hz, * 2^56
+int32_t RndZigguratSlow(RndStream *prs, int32_t hz, int iz);
+
+//	Next normal deviate, in 8.24 fixed point
+static inline int32_t RndZigguratNormal24(RndStream *prs)
+{
+	uint32_t r = RndXoshiro128Next(prs);
+	int iz = r & 127;							// the box from the low bits,
+	int32_t hz = (int32_t)(r & ~127U);		// where in it from the rest
+	uint32_t ahz = (hz < 0) ? 0U - (uint32_t) hz : (uint32_t) hz;
+
+	if (ahz < gRndZigK[iz])
+		return (int32_t)(((int64_t) hz * gRndZigW[iz]) >> 32);
+	return RndZigguratSlow(prs, hz, iz);
+}
+
+//	8.24 deviate to Rnd() value
+static inline uint32_t RndZigguratEncode(int32_t z24)
+{
+	int64_t v = ((int64_t) z24 * 64) / 3;		// * 2^32/12 / 2^24
+
+	if (v < -0x80000000LL)
+		v = -0x80000000LL;
+	else if (v > 0x7FFFFFFFLL)
+		v = 0x7FFFFFFFLL;
+	return((uint32_t)(v + 0x80000000LL));
+}
+
+static inline uint32_t RndZigguratNext(RndStream *prs)
+{
+	return(RndZigguratEncode(RndZigguratNormal24(prs)));
+}
+
+#define RndZigguratNormal(prs) ((fix)((RndZigguratNormal24(prs) + 128) >> 8))
+#define RndZigguratFix(prs) (fix_make(0,RndZigguratNext(prs)>>16))
+#define RndZigguratRange(prs,low,high) RndScale(RndZigguratNext(prs),low,high)
+
+//	Counter-based random #'s.  RndCounterValue() is a pure function of a
+//	seed, an object id, a tick and how many values that object has already
+//	taken this tick, so threads updating different objects never share any
+//	state, and get the same values whatever order they run in:
+//
+//		RNDSTREAM_COUNTER(rs);				// a local, per object and tick
+//		RndCounterStart(&rs,seed,objid,tick);
+//		hit = RndRange(&rs,1,6);			// any of the usual calls
+//
+//	Value i is word i&3 of Philox4x32-10 (Salmon et al., "Parallel Random
+//	Numbers: As Easy as 1, 2, 3", 2011) of counter (i/4, tick, 0, 0) under
+//	key (seed, id).  A stream keeps seed, id, tick and i in state[0..3].
+
+void RndPhilox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+uint32_t RndCounterValue(uint32_t seed, uint32_t id, uint32_t tick, uint32_t index);
+
+#define RndCounterStart(prs,seed,id,tick)	\
+	((prs)->state[0] = (seed), (prs)->state[1] = (id), (prs)->state[2] = (tick), (prs)->state[3] = 0)
+
 //	Prototypes for current set of random stream classes
 uint32_t RndLc16(RndStream *prs);
 void RndLc16Seed(RndStream *prs, uint32_t seed);
+void RndLc16Fill(RndStream *prs, uint32_t *dst, int32_t n);
 
 uint32_t RndGauss16(RndStream *prs);
 void RndGauss16Seed(RndStream *prs, uint32_t seed);
+void RndGauss16Fill(RndStream *prs, uint32_t *dst, int32_t n);
 
 uint32_t RndGauss16Fast(RndStream *prs);
 void RndGauss16FastSeed(RndStream *prs, uint32_t seed);
+void RndGauss16FastFill(RndStream *prs, uint32_t *dst, int32_t n);
+
+uint32_t RndXoshiro128(RndStream *prs);
+void RndXoshiro128Seed(RndStream *prs, uint32_t seed);
+void RndXoshiro128Fill(RndStream *prs, uint32_t *dst, int32_t n);
+void RndXoshiro128Jump(RndStream *prs);
+
+uint32_t RndPcg32(RndStream *prs);
+void RndPcg32Seed(RndStream *prs, uint32_t seed);
+void RndPcg32Fill(RndStream *prs, uint32_t *dst, int32_t n);
+void RndPcg32Jump(RndStream *prs);
+void RndPcg32Advance(RndStream *prs, uint64_t delta);	// skip delta values
+
+uint32_t RndZiggurat(RndStream *prs);
+void RndZigguratSeed(RndStream *prs, uint32_t seed);
+void RndZigguratFill(RndStream *prs, uint32_t *dst, int32_t n);
+void RndZigguratNormalFill(RndStream *prs, fix *dst, int32_t n);	// RndZigguratNormal()s
+
+uint32_t RndCounter(RndStream *prs);
+void RndCounterSeed(RndStream *prs, uint32_t seed);	// id and tick 0
+void RndCounterFill(RndStream *prs, uint32_t *dst, int32_t n);
 
 #endif
@@ -0,0 +1,22 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <time.h>
+
+volatile int32_t bench_sink;
+
+double bench_time(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+void bench_report(const char *name, double seconds, int64_t ops) {
+	printf("%-48s %10.3f ns/op %12.2f Mop/s\n", name, seconds * 1e9 / (double) ops, (double) ops / seconds / 1e6);
+}
+
+void bench_report_bytes(const char *name, double seconds, int64_t bytes) {
+	printf("%-48s %10.3f ms    %12.2f MB/s\n", name, seconds * 1e3, (double) bytes / seconds / (1024.0 * 1024.0));
+}
@@ -0,0 +1,31 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	const char *name;
+	void (*f_Run)(const char *name);
+} Benchmark;
+
+// wall clock time in seconds
+double bench_time(void);
+
+// results are stored here so the compiler can't throw the work away
+extern volatile int32_t bench_sink;
+
+// print a result line: time per operation and operations per second
+void bench_report(const char *name, double seconds, int64_t ops);
+
+// print a result line for throughput in bytes
+void bench_report_bytes(const char *name, double seconds, int64_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__BENCH_H */
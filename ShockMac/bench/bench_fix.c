@@ -0,0 +1,347 @@
+#include "bench.h"
+
+#include "fix.h"
+
+#include <math.h>
+#include <stdio.h>
+
+//////////////////////////////
+//
+// rotate, translate and project a set of points, like g3_transform_point + g3_project_point
+//
+
+#define NUM_POINTS	4096
+#define NUM_PASSES	1000
+
+static fix points[NUM_POINTS][3];
+static fix matrix[9];
+static fix translate[3];
+
+static void transform_setup(void) {
+	fix s, c;
+
+	fix_sincos(degrees_to_fixang(30), &s, &c);
+	matrix[0] = c;	matrix[1] = 0;			matrix[2] = s;
+	matrix[3] = 0;	matrix[4] = FIX_UNIT;	matrix[5] = 0;
+	matrix[6] = -s;	matrix[7] = 0;			matrix[8] = c;
+
+	translate[0] = fix_make(3, 0);
+	translate[1] = fix_make(-2, 0);
+	translate[2] = fix_make(40, 0);
+
+	for (int32_t i = 0; i < NUM_POINTS; ++i) {
+		points[i][0] = fix_make((i % 64) - 32, (i * 97) & 0xffff);
+		points[i][1] = fix_make((i / 64) - 32, (i * 31) & 0xffff);
+		points[i][2] = fix_make(i % 16, (i * 13) & 0xffff);
+	}
+}
+
+#define TRANSFORM_BODY(MUL, DIV)													\
+	int32_t sum = 0;																\
+	for (int32_t i = 0; i < NUM_POINTS; ++i) {										\
+		fix *p = points[i];															\
+		fix x = MUL(matrix[0], p[0]) + MUL(matrix[1], p[1]) + MUL(matrix[2], p[2]) + translate[0];	\
+		fix y = MUL(matrix[3], p[0]) + MUL(matrix[4], p[1]) + MUL(matrix[5], p[2]) + translate[1];	\
+		fix z = MUL(matrix[6], p[0]) + MUL(matrix[7], p[1]) + MUL(matrix[8], p[2]) + translate[2];	\
+		sum += DIV(x, z) ^ DIV(y, z);												\
+	}																				\
+	return sum;
+
+// always calls the library functions
+static int32_t transform_call(void) {
+	TRANSFORM_BODY((fix_mul), (fix_div))
+}
+
+// always uses the inline versions
+static int32_t transform_inline(void) {
+	TRANSFORM_BODY(fix_mul_inline, fix_div_inline)
+}
+
+// whatever fix_mul and fix_div are in this build (see FIX_INLINE)
+static int32_t transform_build(void) {
+	TRANSFORM_BODY(fix_mul, fix_div)
+}
+
+static void transform_run(const char *name, const char *variant, int32_t (*f_Transform)(void)) {
+	char label[128];
+	double start;
+	int32_t pass;
+
+	start = bench_time();
+	for (pass = 0; pass < NUM_PASSES; ++pass) {
+		bench_sink += f_Transform();
+	}
+
+	snprintf(label, sizeof(label), "%s/%s", name, variant);
+	bench_report(label, bench_time() - start, (int64_t) NUM_POINTS * NUM_PASSES);
+}
+
+static void bench_transform(const char *name) {
+	transform_setup();
+
+	transform_run(name, "call", transform_call);
+	transform_run(name, "inline", transform_inline);
+#ifdef FIX_INLINE
+	transform_run(name, "build (FIX_INLINE)", transform_build);
+#else
+	transform_run(name, "build", transform_build);
+#endif
+}
+
+//////////////////////////////
+//
+// 100k divides where runs of values share a denominator, like u/z and v/z
+// along a span or all the points of an object at about the same depth
+//
+
+#define NUM_DIVIDES		100000
+#define NUM_DIV_PASSES	100
+
+static fix div_num[NUM_DIVIDES];
+static fix div_den[NUM_DIVIDES];
+static fix div_out[NUM_DIVIDES];
+
+static void recip_setup(int32_t run) {
+	for (int32_t i = 0; i < NUM_DIVIDES; ++i) {
+		div_num[i] = fix_make((i % 200) - 100, (i * 7919) & 0xffff);
+		div_den[i] = fix_make(1 + (i / run) % 500, (i / run * 104729) & 0xffff);
+	}
+}
+
+static void recip_run(const char *name, int32_t run) {
+	char label[128];
+	double start;
+	fix_recip r;
+
+	recip_setup(run);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_DIV_PASSES; ++pass) {
+		for (int32_t i = 0; i < NUM_DIVIDES; ++i) {
+			div_out[i] = fix_div(div_num[i], div_den[i]);
+		}
+		bench_sink += div_out[pass];
+	}
+	snprintf(label, sizeof(label), "%s/run%d/fix_div", name, run);
+	bench_report(label, bench_time() - start, (int64_t) NUM_DIVIDES * NUM_DIV_PASSES);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_DIV_PASSES; ++pass) {
+		for (int32_t i = 0; i < NUM_DIVIDES; i += run) {
+			fix_recip_init(&r, div_den[i]);
+			fix_recip_div_array(&r, &div_out[i], &div_num[i], (NUM_DIVIDES - i < run) ? NUM_DIVIDES - i : run);
+		}
+		bench_sink += div_out[pass];
+	}
+	snprintf(label, sizeof(label), "%s/run%d/fix_recip", name, run);
+	bench_report(label, bench_time() - start, (int64_t) NUM_DIVIDES * NUM_DIV_PASSES);
+}
+
+static void bench_recip(const char *name) {
+	recip_run(name, 4);
+	recip_run(name, 32);
+	recip_run(name, NUM_DIVIDES);
+}
+
+//////////////////////////////
+//
+// sin/cos: speed of each version, and how far each is from the real thing
+//
+
+#define NUM_SINCOS_PASSES	500
+
+typedef void (*SinCosFunc)(fixang theta, fix *sin, fix *cos);
+
+static void sincos_run(const char *name, const char *variant, SinCosFunc f_SinCos) {
+	char label[128];
+	double start, err, max_err = 0, sum_err = 0;
+	fix s, c;
+	int32_t sum = 0;
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_SINCOS_PASSES; ++pass) {
+		for (int32_t th = 0; th < 0x10000; th += 1) {
+			// step through the angles out of order, like a real frame would
+			f_SinCos((fixang) (th * 40503), &s, &c);
+			sum += s ^ c;
+		}
+	}
+	bench_sink += sum;
+
+	snprintf(label, sizeof(label), "%s/%s", name, variant);
+	bench_report(label, bench_time() - start, (int64_t) 0x10000 * NUM_SINCOS_PASSES);
+
+	for (int32_t th = 0; th < 0x10000; ++th) {
+		double rad = th * (2.0 * 3.14159265358979323846 / 65536.0);
+
+		f_SinCos((fixang) th, &s, &c);
+		err = fmax(fabs(s - sin(rad) * 65536.0), fabs(c - cos(rad) * 65536.0));
+		max_err = fmax(max_err, err);
+		sum_err += err;
+	}
+	printf("%-48s max error %.3f lsb, mean error %.3f lsb\n", label, max_err, sum_err / 0x10000);
+}
+
+static void bench_sincos(const char *name) {
+	sincos_run(name, "fix_sincos", fix_sincos);
+	sincos_run(name, "fix_fastsincos", fix_fastsincos);
+	sincos_run(name, "fix_sincos_hr", fix_sincos_hr);
+}
+
+//////////////////////////////
+//
+// square roots and distances, against copies of the float versions they replaced
+//
+
+#define NUM_SQRTS		100000
+#define NUM_SQRT_PASSES	200
+
+static fix sqrt_in[NUM_SQRTS * 3];
+static fix sqrt_out[NUM_SQRTS * 3];
+
+static fix sqrt_float(fix num) {
+	float fnum = fix_float(num);
+	return (fnum > 0.0f) ? fix_from_float(sqrtf(fnum)) : 0;
+}
+
+static fix pyth_dist_float(fix a, fix b) {
+	return sqrt_float(fix_mul(a, a) + fix_mul(b, b));
+}
+
+static fix sqrt_new(fix a, fix b) {
+	(void) b;
+	return fix_sqrt(a);
+}
+
+static fix sqrt_old(fix a, fix b) {
+	(void) b;
+	return sqrt_float(a);
+}
+
+static void sqrt_run(const char *name, const char *variant, fix (*f_Func)(fix a, fix b)) {
+	char label[128];
+	double start;
+	int32_t sum = 0;
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_SQRT_PASSES; ++pass) {
+		for (int32_t i = 0; i < NUM_SQRTS; ++i) {
+			sum += f_Func(sqrt_in[i], sqrt_in[i + NUM_SQRTS]);
+		}
+	}
+	bench_sink += sum;
+
+	snprintf(label, sizeof(label), "%s/%s", name, variant);
+	bench_report(label, bench_time() - start, (int64_t) NUM_SQRTS * NUM_SQRT_PASSES);
+}
+
+static void bench_sqrt(const char *name) {
+	char label[128];
+	double start;
+
+	for (int32_t i = 0; i < NUM_SQRTS * 3; ++i) {
+		sqrt_in[i] = fix_make((int32_t) (((uint32_t) i * 7919u) % 180), (int32_t) (((uint32_t) i * 104729u) & 0xffff));
+	}
+
+	sqrt_run(name, "fix_sqrt (float)", sqrt_old);
+	sqrt_run(name, "fix_sqrt", sqrt_new);
+	sqrt_run(name, "fix_pyth_dist (float)", pyth_dist_float);
+	sqrt_run(name, "fix_pyth_dist", fix_pyth_dist);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_SQRT_PASSES; ++pass) {
+		for (int32_t i = 0; i < NUM_SQRTS; ++i) {
+			const fix *v = &sqrt_in[i * 3];
+			fix m = sqrt_float(fix_mul(v[0], v[0]) + fix_mul(v[1], v[1]) + fix_mul(v[2], v[2]));
+			if (m != 0) {
+				sqrt_out[i * 3 + 0] = fix_div(v[0], m);
+				sqrt_out[i * 3 + 1] = fix_div(v[1], m);
+				sqrt_out[i * 3 + 2] = fix_div(v[2], m);
+			}
+		}
+		bench_sink += sqrt_out[pass];
+	}
+	snprintf(label, sizeof(label), "%s/normalize (float, fix_div)", name);
+	bench_report(label, bench_time() - start, (int64_t) NUM_SQRTS * NUM_SQRT_PASSES);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < NUM_SQRT_PASSES; ++pass) {
+		fix_normalize3_array(sqrt_out, sqrt_in, NUM_SQRTS);
+		bench_sink += sqrt_out[pass];
+	}
+	snprintf(label, sizeof(label), "%s/fix_normalize3_array", name);
+	bench_report(label, bench_time() - start, (int64_t) NUM_SQRTS * NUM_SQRT_PASSES);
+}
+
+//////////////////////////////
+//
+// ns per call of each accuracy tier of the arc and exponential functions,
+// on arguments spread over the ranges the game uses
+//
+
+#define NUM_ARGS		4096
+#define NUM_ARG_PASSES	2000
+
+static fix arg_a[NUM_ARGS];
+static fix arg_b[NUM_ARGS];
+
+#define TIER_RUN(VARIANT, EXPR)												\
+	do {																	\
+		int32_t sum = 0;													\
+		start = bench_time();												\
+		for (int32_t pass = 0; pass < NUM_ARG_PASSES; ++pass) {				\
+			for (int32_t i = 0; i < NUM_ARGS; ++i) {						\
+				fix a = arg_a[i];											\
+				sum += (EXPR);												\
+			}																\
+		}																	\
+		bench_sink += sum;													\
+		snprintf(label, sizeof(label), "%s/%s", name, VARIANT);			\
+		bench_report(label, bench_time() - start, (int64_t) NUM_ARGS * NUM_ARG_PASSES);	\
+	} while (0)
+
+static void bench_tiers(const char *name) {
+	char label[128];
+	double start;
+
+	// object offsets for atan2, -1..1 for asin and acos
+	for (int32_t i = 0; i < NUM_ARGS; ++i) {
+		arg_a[i] = fix_make((int32_t) (((uint32_t) i * 7919u) % 400) - 200, (int32_t) (((uint32_t) i * 104729u) & 0xffff));
+		arg_b[i] = fix_make((int32_t) (((uint32_t) i * 6151u) % 400) - 200, (int32_t) (((uint32_t) i * 3571u) & 0xffff));
+	}
+	TIER_RUN("fix_atan2", fix_atan2(a, arg_b[i]));
+	TIER_RUN("fix_atan2_fast", fix_atan2_fast(a, arg_b[i]));
+	TIER_RUN("fix_atan2_hr", fix_atan2_hr(a, arg_b[i]));
+
+	for (int32_t i = 0; i < NUM_ARGS; ++i) {
+		arg_a[i] = (fix) (((uint32_t) i * 40503u) % (2 * FIX_UNIT + 1)) - FIX_UNIT;
+	}
+	TIER_RUN("fix_asin", fix_asin(a));
+	TIER_RUN("fix_asin_hr", fix_asin_hr(a));
+	TIER_RUN("fix_acos_hr", fix_acos_hr(a));
+
+	// exponents from -8 to 8, and the gamma curves' x in 0..1 to the 0.5..3
+	for (int32_t i = 0; i < NUM_ARGS; ++i) {
+		arg_a[i] = (fix) (((uint32_t) i * 40503u) % (16 * FIX_UNIT)) - 8 * FIX_UNIT;
+	}
+	TIER_RUN("fix_exp", fix_exp(a));
+	TIER_RUN("fix_exp_fast", fix_exp_fast(a));
+	TIER_RUN("fix_exp_hr", fix_exp_hr(a));
+
+	for (int32_t i = 0; i < NUM_ARGS; ++i) {
+		arg_a[i] = (fix) (((uint32_t) i * 40503u) % FIX_UNIT) + 1;
+		arg_b[i] = FIX_UNIT / 2 + (fix) (((uint32_t) i * 7919u) % (5 * FIX_UNIT / 2));
+	}
+	TIER_RUN("fix_pow", fix_pow(a, arg_b[i]));
+	TIER_RUN("fix_pow_fast", fix_pow_fast(a, arg_b[i]));
+	TIER_RUN("fix_pow_hr", fix_pow_hr(a, arg_b[i]));
+}
+
+Benchmark fix_benches[] = {
+	{ "/transform", bench_transform },
+	{ "/recip", bench_recip },
+	{ "/sincos", bench_sincos },
+	{ "/sqrt", bench_sqrt },
+	{ "/tiers", bench_tiers },
+	{ NULL, NULL }
+};
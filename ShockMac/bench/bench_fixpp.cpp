@@ -0,0 +1,343 @@
+#include "bench.h"
+
+#include "fixpp.h"
+#include "fixppvec.h"
+
+#include <math.h>
+#include <stdio.h>
+
+//////////////////////////////
+//
+// soliton_lite's industrial strength step (EDMS soliton.cc) on a made-up set
+// of objects.  Every coordinate is a damped spring, the kind of equation of
+// motion robot.cc and pelvis.cc write as Q expressions.
+//
+// The old way is what soliton.cc and the old Q operators did: every product
+// through fix_mul.  The fused way is the same step written with Q, so sums of
+// products are rounded once.  Both are also checked against doubles, one
+// step at a time from the same state.
+//
+
+#define NUM_OBJECTS	96
+#define NUM_COORDS	7
+#define NUM_STEPS	2000
+#define NUM_ERROR_STEPS	200
+
+struct Object {
+	Q S[NUM_COORDS][3];			// position, velocity, acceleration
+	Q A[NUM_COORDS][2];			// where the equations of motion look
+	Q k[4][NUM_COORDS];			// expansion coefficients
+	Q stiff, drag, butt, grav;
+};
+
+struct ObjectRef {
+	double S[NUM_COORDS][3];
+	double A[NUM_COORDS][2];
+	double k[4][NUM_COORDS];
+	double stiff, drag, butt, grav;
+};
+
+static Object objects[NUM_OBJECTS];
+static ObjectRef objects_ref[NUM_OBJECTS];
+
+static const Q	timestep = .03,
+				one_sixth = .1666666666667,
+				point_five = .5,
+				point_one_two_five = .125,
+				two = 2.;
+
+static void soliton_setup(void) {
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+		Object &o = objects[i];
+
+		o.stiff = Q(4 + (i % 17));
+		o.drag = Q(0.5 + 0.125 * (i % 13));
+		o.butt = Q(0.5 + (i % 5) * 0.25);
+		o.grav = Q((i & 1) ? 9.8 : 0.0);
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.S[c][0].val = (fix) (((uint32_t) (i * NUM_COORDS + c) * 40503u) % (16 * FIX_UNIT)) - 8 * FIX_UNIT;
+			o.S[c][1].val = (fix) (((uint32_t) (i * NUM_COORDS + c) * 7919u) % (4 * FIX_UNIT)) - 2 * FIX_UNIT;
+			o.S[c][2] = 0;
+		}
+	}
+}
+
+// start the doubles where the fixpoints are
+static void soliton_sync(void) {
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+		Object &o = objects[i];
+		ObjectRef &r = objects_ref[i];
+
+		r.stiff = o.stiff.to_double();
+		r.drag = o.drag.to_double();
+		r.butt = o.butt.to_double();
+		r.grav = o.grav.to_double();
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			r.S[c][0] = o.S[c][0].to_double();
+			r.S[c][1] = o.S[c][1].to_double();
+			r.S[c][2] = 0;
+		}
+	}
+}
+
+// The step with fix_mul (or whatever MUL is) on the raw values, like soliton.cc.
+#define EVAL_OLD(MUL, o, kk)																		\
+	for (int32_t c = 0; c < NUM_COORDS; ++c) {														\
+		o.S[c][2].val = MUL(o.butt.val, o.grav.val - MUL(o.stiff.val, o.A[c][0].val) - MUL(o.drag.val, o.A[c][1].val));	\
+		o.k[kk][c].val = MUL(timestep.val, o.S[c][2].val);											\
+	}
+
+#define ORDER_OLD(MUL, o, kk)																		\
+	for (int32_t c = 0; c < NUM_COORDS; ++c) {														\
+		o.A[c][0].val = o.S[c][0].val																\
+			+ MUL(MUL(point_five.val, timestep.val), o.S[c][1].val)									\
+			+ MUL(MUL(point_one_two_five.val, timestep.val), o.k[kk][c].val);						\
+		o.A[c][1].val = o.S[c][1].val + MUL(point_five.val, o.k[kk][c].val);						\
+	}
+
+#define SOLITON_OLD(MUL)																			\
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {														\
+		Object &o = objects[i];																		\
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {													\
+			o.A[c][0].val = o.S[c][0].val;															\
+			o.A[c][1].val = o.S[c][1].val;															\
+		}																							\
+		EVAL_OLD(MUL, o, 0)																			\
+		ORDER_OLD(MUL, o, 0)																		\
+		EVAL_OLD(MUL, o, 1)																			\
+		ORDER_OLD(MUL, o, 1)																		\
+		EVAL_OLD(MUL, o, 2)																			\
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {													\
+			o.A[c][0].val = o.S[c][0].val + MUL(timestep.val, o.S[c][1].val)						\
+				+ MUL(MUL(point_five.val, timestep.val), o.k[2][c].val);							\
+			o.A[c][1].val = o.S[c][1].val + o.k[2][c].val;											\
+		}																							\
+		EVAL_OLD(MUL, o, 3)																			\
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {													\
+			o.S[c][0].val += MUL(timestep.val, (o.S[c][1].val										\
+				+ MUL(one_sixth.val, (o.k[0][c].val + o.k[1][c].val + o.k[2][c].val))));			\
+			o.S[c][1].val += MUL(one_sixth.val, (o.k[0][c].val										\
+				+ MUL(two.val, (o.k[1][c].val + o.k[2][c].val)) + o.k[3][c].val));					\
+		}																							\
+	}
+
+static void soliton_call(void) {
+	SOLITON_OLD((fix_mul))
+}
+
+static void soliton_inline(void) {
+	SOLITON_OLD(fix_mul_inline)
+}
+
+// The same step written with Q.
+#define EVAL_Q(o, kk)																				\
+	for (int32_t c = 0; c < NUM_COORDS; ++c) {														\
+		o.S[c][2] = o.butt * (o.grav - o.stiff * o.A[c][0] - o.drag * o.A[c][1]);					\
+		o.k[kk][c] = timestep * o.S[c][2];															\
+	}
+
+#define ORDER_Q(o, kk)																				\
+	for (int32_t c = 0; c < NUM_COORDS; ++c) {														\
+		o.A[c][0] = o.S[c][0] + point_five * timestep * o.S[c][1]									\
+			+ point_one_two_five * timestep * o.k[kk][c];											\
+		o.A[c][1] = o.S[c][1] + point_five * o.k[kk][c];											\
+	}
+
+static void soliton_fused(void) {
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+		Object &o = objects[i];
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.A[c][0] = o.S[c][0];
+			o.A[c][1] = o.S[c][1];
+		}
+		EVAL_Q(o, 0)
+		ORDER_Q(o, 0)
+		EVAL_Q(o, 1)
+		ORDER_Q(o, 1)
+		EVAL_Q(o, 2)
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.A[c][0] = o.S[c][0] + timestep * o.S[c][1] + point_five * timestep * o.k[2][c];
+			o.A[c][1] = o.S[c][1] + o.k[2][c];
+		}
+		EVAL_Q(o, 3)
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.S[c][0] += timestep * (o.S[c][1] + one_sixth * (o.k[0][c] + o.k[1][c] + o.k[2][c]));
+			o.S[c][1] += one_sixth * (o.k[0][c] + two * (o.k[1][c] + o.k[2][c]) + o.k[3][c]);
+		}
+	}
+}
+
+// And in doubles, with the constants rounded the same way.
+static void soliton_double(void) {
+	const double h = timestep.to_double(), sixth = one_sixth.to_double();
+
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+		ObjectRef &o = objects_ref[i];
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.A[c][0] = o.S[c][0];
+			o.A[c][1] = o.S[c][1];
+		}
+		for (int32_t kk = 0; kk < 4; ++kk) {
+			for (int32_t c = 0; c < NUM_COORDS; ++c) {
+				o.S[c][2] = o.butt * (o.grav - o.stiff * o.A[c][0] - o.drag * o.A[c][1]);
+				o.k[kk][c] = h * o.S[c][2];
+			}
+			for (int32_t c = 0; c < NUM_COORDS; ++c) {
+				if (kk < 2) {
+					o.A[c][0] = o.S[c][0] + 0.5 * h * o.S[c][1] + 0.125 * h * o.k[kk][c];
+					o.A[c][1] = o.S[c][1] + 0.5 * o.k[kk][c];
+				} else if (kk == 2) {
+					o.A[c][0] = o.S[c][0] + h * o.S[c][1] + 0.5 * h * o.k[2][c];
+					o.A[c][1] = o.S[c][1] + o.k[2][c];
+				}
+			}
+		}
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			o.S[c][0] += h * (o.S[c][1] + sixth * (o.k[0][c] + o.k[1][c] + o.k[2][c]));
+			o.S[c][1] += sixth * (o.k[0][c] + 2.0 * (o.k[1][c] + o.k[2][c]) + o.k[3][c]);
+		}
+	}
+}
+
+// distance from the doubles summed over every coordinate, in fix units
+static double soliton_error(void) {
+	double err = 0;
+
+	for (int32_t i = 0; i < NUM_OBJECTS; ++i) {
+		for (int32_t c = 0; c < NUM_COORDS; ++c) {
+			err += fabs(objects[i].S[c][0].to_double() - objects_ref[i].S[c][0]);
+			err += fabs(objects[i].S[c][1].to_double() - objects_ref[i].S[c][1]);
+		}
+	}
+	return err * 65536.0;
+}
+
+static void bench_soliton(const char *name) {
+	static const struct {
+		const char *label;
+		void (*step)(void);
+	} variants[] = {
+		{ "fix_mul", soliton_call },
+		{ "fix_mul_inline", soliton_inline },
+		{ "fused", soliton_fused },
+	};
+	char label[128];
+
+	for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v) {
+		soliton_setup();
+		double start = bench_time();
+		for (int32_t step = 0; step < NUM_STEPS; ++step) {
+			variants[v].step();
+		}
+		double seconds = bench_time() - start;
+		bench_sink += objects[0].S[0][0].to_fix();
+
+		double err = 0;
+		soliton_setup();
+		for (int32_t step = 0; step < NUM_ERROR_STEPS; ++step) {
+			soliton_sync();
+			variants[v].step();
+			soliton_double();
+			err += soliton_error();
+		}
+
+		snprintf(label, sizeof(label), "%s/%s", name, variants[v].label);
+		bench_report(label, seconds, (int64_t) NUM_OBJECTS * NUM_STEPS);
+		printf("%-48s %10.3f lsb from double per step\n", "", err / ((double) NUM_ERROR_STEPS * NUM_OBJECTS * NUM_COORDS * 2));
+	}
+}
+
+//////////////////////////////
+//
+// Rotate a cloud of points, and take dots and crosses along it, with scalar
+// Q expressions and with Q3/Q3x3.  Both give the same answers.
+//
+
+#define NUM_POINTS	4096
+#define NUM_PASSES	200
+
+static Q points[NUM_POINTS][3], moved[NUM_POINTS][3];
+static Q3 points3[NUM_POINTS], moved3[NUM_POINTS];
+static Q rot[3][3];
+static Q3x3 rot3;
+
+static void vec_setup(void) {
+	for (int32_t i = 0; i < NUM_POINTS; ++i) {
+		for (int32_t c = 0; c < 3; ++c)
+			points[i][c].val = (fix) (((uint32_t) (i * 3 + c) * 40503u) % (64 * FIX_UNIT)) - 32 * FIX_UNIT;
+		points3[i] = Q3(points[i]);
+	}
+
+	// a turn about (1,1,1), a little off orthonormal like EDMS keeps them
+	for (int32_t r = 0; r < 3; ++r) {
+		for (int32_t c = 0; c < 3; ++c)
+			rot[r][c] = (r == c) ? Q(.6666) : ((c == (r + 1) % 3) ? Q(-.3333) : Q(.6667));
+		rot3.set(r, 0, rot[r][0]); rot3.set(r, 1, rot[r][1]); rot3.set(r, 2, rot[r][2]); rot3.m[r][3] = 0;
+	}
+}
+
+static void transform_q(void) {
+	for (int32_t i = 0; i < NUM_POINTS; ++i)
+		for (int32_t r = 0; r < 3; ++r)
+			moved[i][r] = rot[r][0] * points[i][0] + rot[r][1] * points[i][1] + rot[r][2] * points[i][2];
+}
+
+static void transform_q3(void) {
+	for (int32_t i = 0; i < NUM_POINTS; ++i)
+		moved3[i] = rot3 * points3[i];
+}
+
+static void dot_cross_q(void) {
+	Q acc = 0;
+	for (int32_t i = 0; i + 1 < NUM_POINTS; ++i) {
+		const Q *a = points[i], *b = points[i + 1];
+		moved[i][0] = a[1] * b[2] - a[2] * b[1];
+		moved[i][1] = a[2] * b[0] - a[0] * b[2];
+		moved[i][2] = a[0] * b[1] - a[1] * b[0];
+		acc += a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+	bench_sink += acc.to_fix();
+}
+
+static void dot_cross_q3(void) {
+	Q acc = 0;
+	for (int32_t i = 0; i + 1 < NUM_POINTS; ++i) {
+		moved3[i] = cross(points3[i], points3[i + 1]);
+		acc += dot(points3[i], points3[i + 1]);
+	}
+	bench_sink += acc.to_fix();
+}
+
+static void bench_vec3(const char *name) {
+	static const struct {
+		const char *label;
+		void (*pass)(void);
+	} variants[] = {
+		{ "transform/q", transform_q },
+		{ "transform/q3", transform_q3 },
+		{ "dot_cross/q", dot_cross_q },
+		{ "dot_cross/q3", dot_cross_q3 },
+	};
+	char label[128];
+
+	vec_setup();
+	for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); ++v) {
+		double start = bench_time();
+		for (int32_t pass = 0; pass < NUM_PASSES; ++pass) {
+			variants[v].pass();
+		}
+		double seconds = bench_time() - start;
+		bench_sink += moved[7][1].to_fix() + moved3[7][1].to_fix();
+
+		snprintf(label, sizeof(label), "%s/%s", name, variants[v].label);
+		bench_report(label, seconds, (int64_t) NUM_POINTS * NUM_PASSES);
+	}
+}
+
+extern "C" Benchmark fixpp_benches[];
+
+Benchmark fixpp_benches[] = {
+	{ "/soliton_lite", bench_soliton },
+	{ "/vec3", bench_vec3 },
+	{ NULL, NULL }
+};
@@ -0,0 +1,35 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+extern Benchmark fix_benches[];
+extern Benchmark fixpp_benches[];
+extern Benchmark rnd_benches[];
+extern Benchmark res_benches[];
+
+static const struct {
+	const char *prefix;
+	Benchmark *benches;
+} suites[] = {
+	{ "/fix", fix_benches },
+	{ "/fixpp", fixpp_benches },
+	{ "/rnd", rnd_benches },
+	{ "/res", res_benches },
+	{ NULL, NULL }
+};
+
+// runs every benchmark, or only those whose name starts with argv[1]
+int main(int argc, char *argv[]) {
+	char name[256];
+
+	for (size_t s = 0; suites[s].prefix != NULL; ++s) {
+		for (Benchmark *b = suites[s].benches; b->name != NULL; ++b) {
+			snprintf(name, sizeof(name), "%s%s", suites[s].prefix, b->name);
+			if (argc > 1 && strncmp(name, argv[1], strlen(argv[1])) != 0) continue;
+			b->f_Run(name);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,530 @@
+#include "bench.h"
+
+#include "lz4.h"
+#include "lzw.h"
+#include "res_.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//////////////////////////////
+//
+// LZW expansion, byte callbacks against the block expander.  The input is
+// the sources in RES/Tests/LZW Tests (text, like the TEXT resource those
+// tests compress), as is and repeated out to a level-sized block.
+//
+
+#define LZW_OUTPUT_BYTES	(64 << 20)		// expand this much per timing
+
+static const char *lzw_inputs[] = { "LzwLoadRes.c", "LzwMakeRes.c", "lzwtest.c", NULL };
+
+// concatenate the test inputs, repeated copies times
+static uint8_t *lzw_load_inputs(int32_t copies, int32_t *psize) {
+	uint8_t *data = NULL;
+	int32_t size = 0;
+	char path[512];
+
+	for (const char **f = lzw_inputs; *f != NULL; ++f) {
+		snprintf(path, sizeof(path), "%s/%s", LZW_TESTS_DIR, *f);
+		FILE *fp = fopen(path, "rb");
+		if (fp == NULL) {
+			printf("can't open %s\n", path);
+			exit(1);
+		}
+		fseek(fp, 0, SEEK_END);
+		int32_t len = (int32_t) ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		data = realloc(data, size + len);
+		size += (int32_t) fread(data + size, 1, len, fp);
+		fclose(fp);
+	}
+
+	data = realloc(data, size * copies);
+	for (int32_t c = 1; c < copies; ++c)
+		memcpy(data + size * c, data, size);
+	*psize = size * copies;
+	return data;
+}
+
+static void bench_lzw_expand(const char *name, int32_t copies) {
+	char full[128];
+	int32_t size;
+	uint8_t *data = lzw_load_inputs(copies, &size);
+	uint8_t *comp = malloc(2 * size + 16);
+	uint8_t *out = malloc(size + 16);
+	int32_t csize = LzwCompressBuff2Buff(data, size, comp, 2 * size + 16);
+	int32_t passes = LZW_OUTPUT_BYTES / size;
+	double start;
+
+	printf("%-48s %10d bytes -> %d\n", name, size, csize);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < passes; ++pass)
+		bench_sink += LzwExpandBuff2Buff(comp, out, 0, 0);
+	snprintf(full, sizeof(full), "%s/callback", name);
+	bench_report_bytes(full, bench_time() - start, (int64_t) size * passes);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < passes; ++pass)
+		bench_sink += LzwExpandBlock(comp, csize, out, size);
+	snprintf(full, sizeof(full), "%s/block", name);
+	bench_report_bytes(full, bench_time() - start, (int64_t) size * passes);
+
+	if (memcmp(out, data, size) != 0)
+		printf("%s: block expand doesn't match!\n", name);
+
+	free(out);
+	free(comp);
+	free(data);
+}
+
+static void bench_lzw_tests(const char *name) {
+	bench_lzw_expand(name, 1);
+}
+
+static void bench_lzw_level(const char *name) {
+	bench_lzw_expand(name, 32);
+}
+
+//////////////////////////////
+//
+// Resource load time by format: the same input stored LZW and LZ4, each
+// expanded by its block expander, as a mapped resfile load would.
+//
+
+static void bench_lz4_expand(const char *name, int32_t copies) {
+	char full[128];
+	int32_t size;
+	uint8_t *data = lzw_load_inputs(copies, &size);
+	uint8_t *lzw = malloc(2 * size + 16);
+	uint8_t *lz4 = malloc(LZ4_MAXSIZE(size));
+	uint8_t *out = malloc(size + 16);
+	int32_t lzwSize = LzwCompressBuff2Buff(data, size, lzw, 2 * size + 16);
+	int32_t lz4Size = Lz4Compress(data, size, lz4, LZ4_MAXSIZE(size));
+	int32_t passes = LZW_OUTPUT_BYTES / size;
+	double start;
+
+	printf("%-48s %10d bytes -> lzw %d, lz4 %d\n", name, size, lzwSize, lz4Size);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < passes; ++pass)
+		bench_sink += LzwExpandBlock(lzw, lzwSize, out, size);
+	snprintf(full, sizeof(full), "%s/lzw", name);
+	bench_report_bytes(full, bench_time() - start, (int64_t) size * passes);
+
+	start = bench_time();
+	for (int32_t pass = 0; pass < passes; ++pass)
+		bench_sink += Lz4Expand(lz4, lz4Size, out, size);
+	snprintf(full, sizeof(full), "%s/lz4", name);
+	bench_report_bytes(full, bench_time() - start, (int64_t) size * passes);
+
+	if (memcmp(out, data, size) != 0)
+		printf("%s: lz4 expand doesn't match!\n", name);
+
+	free(out);
+	free(lz4);
+	free(lzw);
+	free(data);
+}
+
+static void bench_lz4_tests(const char *name) {
+	bench_lz4_expand(name, 1);
+}
+
+static void bench_lz4_level(const char *name) {
+	bench_lz4_expand(name, 32);
+}
+
+//////////////////////////////
+//
+// Resource file open: a synthetic set of files, 20k resources in all,
+// opened cold (directory walked entry by entry, as ResReadDirEntries does,
+// then indexed) and warm (index mapped, checked & applied in one pass).
+// Either way the entries land in a descriptor table grown as ResExtendDesc
+// grows it.  Files are in TMPDIR, or the current directory.
+//
+
+#define RESIDX_FILES		20
+#define RESIDX_PER_FILE		1000
+#define RESIDX_ROUNDS		20
+
+typedef struct {
+	int32_t offset;
+	int32_t size;
+	uint8_t flags;
+	uint8_t type;
+} ResIdxDesc;
+
+static ResIdxDesc *residx_desc;
+static int32_t residx_max = -1;
+
+static void residx_extend(int32_t id) {
+	if (id <= residx_max)
+		return;
+	int32_t newMax = ((id + 1024) & ~1023) - 1;
+	residx_desc = realloc(residx_desc, (newMax + 1) * sizeof(ResIdxDesc));
+	memset(residx_desc + residx_max + 1, 0, (newMax - residx_max) * sizeof(ResIdxDesc));
+	residx_max = newMax;
+}
+
+static void residx_put(int32_t id, int32_t offset, int32_t size, uint8_t flags, uint8_t type) {
+	residx_extend(id);
+	residx_desc[id].offset = offset;
+	residx_desc[id].size = size;
+	residx_desc[id].flags = flags;
+	residx_desc[id].type = type;
+}
+
+// a resfile of n 16-byte resources from id first on, directory at the end
+static void residx_write_file(const char *path, int32_t first, int32_t n) {
+	uint8_t head[128] = "LG Res File v2\r\n";
+	uint8_t data[16] = { 0 };
+	uint8_t e[10];
+	int32_t dataOffset = sizeof(head);
+	int32_t dirOffset = dataOffset + n * (int32_t) sizeof(data);
+	FILE *fp = fopen(path, "wb");
+
+	head[124] = dirOffset;
+	head[125] = dirOffset >> 8;
+	head[126] = dirOffset >> 16;
+	head[127] = dirOffset >> 24;
+	fwrite(head, sizeof(head), 1, fp);
+	for (int32_t i = 0; i < n; ++i)
+		fwrite(data, sizeof(data), 1, fp);
+	e[0] = n; e[1] = n >> 8;
+	e[2] = dataOffset; e[3] = dataOffset >> 8; e[4] = dataOffset >> 16; e[5] = dataOffset >> 24;
+	fwrite(e, 6, 1, fp);
+	for (int32_t i = 0; i < n; ++i) {
+		int32_t id = first + i;
+		e[0] = id; e[1] = id >> 8;
+		e[2] = sizeof(data); e[3] = 0; e[4] = 0;
+		e[5] = 0;
+		e[6] = sizeof(data); e[7] = 0; e[8] = 0;
+		e[9] = 1 + i % 4;
+		fwrite(e, sizeof(e), 1, fp);
+	}
+	fclose(fp);
+}
+
+// open with the index if good, else walk the directory & index it
+static int32_t residx_open(const char *path) {
+	uint8_t head[128], dh[6], block[64 * 10];
+	ResIndexHeader stamp, *phead;
+	size_t size;
+	FILE *fp = fopen(path, "rb");
+
+	fread(head, sizeof(head), 1, fp);
+	int32_t dirOffset = head[124] | (head[125] << 8) | (head[126] << 16) | ((int32_t) head[127] << 24);
+	ResIndexStamp(fp, dirOffset, &stamp);
+
+	phead = ResIndexLoad((char *) path, &stamp, &size);
+	if (phead != NULL) {
+		ResIndexEntry *pie = (ResIndexEntry *) (phead + 1);
+		int32_t n = phead->numEntries;
+		if (n > 0)
+			residx_extend(pie[n - 1].id);
+		for (int32_t i = 0; i < n; ++i, ++pie)
+			residx_put(pie->id, pie->offset, pie->size, pie->flags, pie->type);
+		ResIndexFree(phead, size);
+		fclose(fp);
+		return n;
+	}
+
+	fseek(fp, dirOffset, SEEK_SET);
+	fread(dh, sizeof(dh), 1, fp);
+	int32_t n = dh[0] | (dh[1] << 8);
+	int32_t offset = dh[2] | (dh[3] << 8) | (dh[4] << 16) | ((int32_t) dh[5] << 24);
+	ResIndexEntry *pindex = malloc(n * sizeof(ResIndexEntry) + 1);
+	for (int32_t i = 0; i < n; ++i) {
+		if (i % 64 == 0)
+			fread(block, 10, n - i < 64 ? n - i : 64, fp);
+		uint8_t *e = block + (i % 64) * 10;
+		int32_t csize = e[6] | (e[7] << 8) | (e[8] << 16);
+		pindex[i].id = e[0] | (e[1] << 8);
+		pindex[i].size = e[2] | (e[3] << 8) | (e[4] << 16);
+		pindex[i].flags = e[5];
+		pindex[i].type = e[9];
+		pindex[i].offset = offset;
+		residx_put(pindex[i].id, offset, pindex[i].size, e[5], e[9]);
+		offset = (offset + csize + 3) & ~3;
+	}
+	ResIndexSave((char *) path, &stamp, pindex, n);
+	free(pindex);
+	fclose(fp);
+	return n;
+}
+
+static void bench_resindex_open(const char *name) {
+	char paths[RESIDX_FILES][512], idx[520], full[128];
+	const char *dir = getenv("TMPDIR");
+	int32_t total;
+	double start, cold = 0, warm = 0;
+
+	if (dir == NULL)
+		dir = ".";
+	for (int f = 0; f < RESIDX_FILES; ++f) {
+		snprintf(paths[f], sizeof(paths[f]), "%s/bench_residx%02d.res", dir, f);
+		residx_write_file(paths[f], 1000 + f * RESIDX_PER_FILE, RESIDX_PER_FILE);
+	}
+
+	for (int round = 0; round < RESIDX_ROUNDS; ++round) {
+		// cold: no index, each file's directory is walked and indexed
+		for (int f = 0; f < RESIDX_FILES; ++f) {
+			snprintf(idx, sizeof(idx), "%s%s", paths[f], RES_INDEX_EXT);
+			remove(idx);
+		}
+		free(residx_desc);
+		residx_desc = NULL;
+		residx_max = -1;
+		total = 0;
+		start = bench_time();
+		for (int f = 0; f < RESIDX_FILES; ++f)
+			total += residx_open(paths[f]);
+		cold += bench_time() - start;
+
+		// warm: the indexes just made are used
+		free(residx_desc);
+		residx_desc = NULL;
+		residx_max = -1;
+		start = bench_time();
+		for (int f = 0; f < RESIDX_FILES; ++f)
+			total += residx_open(paths[f]);
+		warm += bench_time() - start;
+		bench_sink += total;
+	}
+
+	printf("%-48s %10d resources in %d files\n", name, RESIDX_FILES * RESIDX_PER_FILE, RESIDX_FILES);
+	snprintf(full, sizeof(full), "%s/cold", name);
+	bench_report(full, cold, (int64_t) RESIDX_ROUNDS * RESIDX_FILES * RESIDX_PER_FILE);
+	snprintf(full, sizeof(full), "%s/warm", name);
+	bench_report(full, warm, (int64_t) RESIDX_ROUNDS * RESIDX_FILES * RESIDX_PER_FILE);
+
+	for (int f = 0; f < RESIDX_FILES; ++f) {
+		snprintf(idx, sizeof(idx), "%s%s", paths[f], RES_INDEX_EXT);
+		remove(idx);
+		remove(paths[f]);
+	}
+	free(residx_desc);
+	residx_desc = NULL;
+}
+
+//////////////////////////////
+//
+// Building a resfile: a level's worth of resources compressed as a batch,
+// as ResWriteBatch() does, on 1 to 8 threads.  Each resource is the LZW
+// test inputs with a few bytes of its own, so no two are the same.  The
+// output must match the one thread output byte for byte.
+//
+
+#define BUILD_RESOURCES		96
+#define BUILD_COPIES		4
+
+static void bench_build_batch(const char *name, uint8_t flag) {
+	static const int32_t threads[] = { 1, 2, 4, 8 };
+	ResCompJob jobs[BUILD_RESOURCES], first[BUILD_RESOURCES];
+	char full[128];
+	int32_t size;
+	uint8_t *data = lzw_load_inputs(BUILD_COPIES, &size);
+	int64_t total = 0;
+
+	for (int r = 0; r < BUILD_RESOURCES; ++r) {
+		jobs[r].pres = malloc(size);
+		memcpy(jobs[r].pres, data, size);
+		memcpy(jobs[r].pres + (r * 997) % (size - 8), &r, sizeof(r));
+		jobs[r].size = size;
+		jobs[r].sizeTable = jobs[r].numItems = 0;
+		jobs[r].offsets = NULL;
+		total += size;
+	}
+
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+		for (int r = 0; r < BUILD_RESOURCES; ++r)
+			jobs[r].flags = flag;
+		double start = bench_time();
+		ResCompressJobs(jobs, BUILD_RESOURCES, threads[t]);
+		snprintf(full, sizeof(full), "%s/threads%d", name, threads[t]);
+		bench_report_bytes(full, bench_time() - start, total);
+
+		for (int r = 0; r < BUILD_RESOURCES; ++r) {
+			if (t == 0) {
+				first[r] = jobs[r];
+				continue;
+			}
+			if (jobs[r].compSize != first[r].compSize ||
+				(jobs[r].pcomp && memcmp(jobs[r].pcomp, first[r].pcomp, jobs[r].compSize) != 0))
+				printf("%s: %d threads don't match 1 thread!\n", name, threads[t]);
+			free(jobs[r].pcomp);
+		}
+	}
+
+	for (int r = 0; r < BUILD_RESOURCES; ++r) {
+		free(first[r].pcomp);
+		free(jobs[r].pres);
+	}
+	free(data);
+}
+
+static void bench_build_lzw(const char *name) {
+	bench_build_batch(name, RDF_LZW);
+}
+
+static void bench_build_lz4(const char *name) {
+	bench_build_batch(name, RDF_LZ4);
+}
+
+//////////////////////////////
+//
+// Extracting in blocks: LZW expanded into a stream of 16K blocks, as
+// ResExtractInBlocks() does, with a consumer that does about as much work
+// per byte as the expansion.  Depth 1 calls it in place; deeper queues it
+// to a consumer thread, so expansion & consumption overlap.
+//
+
+#define STREAM_BLOCK		16384
+
+static ResStream *stream_ps;
+static uint8_t *stream_space;
+static int32_t stream_avail, stream_used;
+
+static void stream_dest_ctrl(intptr_t destLoc, LzwCtrl ctrl) {
+	(void) destLoc;
+	if (ctrl == BEGIN)
+		stream_avail = stream_used = 0;
+	else if (stream_used)
+		ResStreamAdvance(stream_ps, stream_used);
+}
+
+static void stream_dest_put(uint8_t byte) {
+	if (stream_avail == 0) {
+		if (stream_used)
+			ResStreamAdvance(stream_ps, stream_used);
+		stream_used = 0;
+		stream_space = ResStreamSpace(stream_ps, &stream_avail);
+		if (stream_avail == 0)
+			return;
+	}
+	*stream_space++ = byte;
+	stream_avail--;
+	stream_used++;
+}
+
+static uint32_t stream_sum;
+
+static int32_t stream_consume(void *buff, int32_t numBytes, int32_t iblock) {
+	uint32_t h = stream_sum;
+	(void) iblock;
+	for (int32_t i = 0; i < numBytes; ++i)
+		for (int r = 0; r < 8; ++r)
+			h = (h ^ ((uint8_t *) buff)[i]) * 16777619u;
+	stream_sum = h;
+	return 0;
+}
+
+static void bench_stream_lzw(const char *name) {
+	static const int32_t depths[] = { 1, 2, 4 };
+	char full[128];
+	int32_t size;
+	uint8_t *data = lzw_load_inputs(32, &size);
+	uint8_t *comp = malloc(2 * size + 16);
+	int32_t csize = LzwCompressBuff2Buff(data, size, comp, 2 * size + 16);
+	uint32_t first = 0;
+
+	printf("%-48s %10d bytes -> %d\n", name, size, csize);
+
+	for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+		double start = bench_time();
+		stream_sum = 2166136261u;
+		stream_ps = ResStreamOpen(size, NULL, STREAM_BLOCK, depths[d], stream_consume);
+		LzwExpandBuff2User(comp, stream_dest_ctrl, stream_dest_put, 0, 0, size);
+		ResStreamClose(stream_ps);
+		snprintf(full, sizeof(full), "%s/depth%d", name, depths[d]);
+		bench_report_bytes(full, bench_time() - start, size);
+
+		if (d == 0)
+			first = stream_sum;
+		else if (stream_sum != first)
+			printf("%s: depth %d consumed different bytes!\n", name, depths[d]);
+	}
+
+	free(comp);
+	free(data);
+}
+
+//////////////////////////////
+//
+// Byte swapping a loaded resource: a value at a time through a call, as
+// the game's scattered SwapShortBytes()/FlipLong() calls do, against bulk
+// swapping by type layout.  16-bit arrays (">h") and mixed records
+// (">hhl", which fit 16 bytes evenly, and ">hl", which don't).
+//
+
+#define SWAP_BYTES			(1 << 20)
+#define SWAP_PASSES			64
+
+// one value at a time, not inlined, like the game's swap routines
+static void __attribute__((noinline)) swap_one(uint8_t *p, int size) {
+	for (int i = 0; i < size / 2; ++i) {
+		uint8_t t = p[i];
+		p[i] = p[size - 1 - i];
+		p[size - 1 - i] = t;
+	}
+}
+
+static void bench_swap_layout(const char *name, char *layout, const int *fields) {
+	char full[128];
+	uint8_t *data = malloc(SWAP_BYTES);
+	ResLayout rl;
+	int rec = 0;
+	double start;
+
+	for (const int *f = fields; *f; ++f)
+		rec += *f;
+	for (int32_t i = 0; i < SWAP_BYTES; ++i)
+		data[i] = i;
+	ResLayoutCompile(layout, &rl);
+
+	start = bench_time();
+	for (int pass = 0; pass < SWAP_PASSES; ++pass) {
+		for (uint8_t *p = data; p + rec <= data + SWAP_BYTES; )
+			for (const int *f = fields; *f; p += *f++)
+				if (*f > 1)
+					swap_one(p, *f);
+	}
+	snprintf(full, sizeof(full), "%s/%s/onebyone", name, layout + 1);
+	bench_report_bytes(full, bench_time() - start, (int64_t) SWAP_BYTES * SWAP_PASSES);
+
+	start = bench_time();
+	for (int pass = 0; pass < SWAP_PASSES; ++pass)
+		ResSwapRecords(&rl, data, SWAP_BYTES);
+	snprintf(full, sizeof(full), "%s/%s/bulk", name, layout + 1);
+	bench_report_bytes(full, bench_time() - start, (int64_t) SWAP_BYTES * SWAP_PASSES);
+
+	// an even # passes each way: back where we started
+	for (int32_t i = 0; i < SWAP_BYTES - SWAP_BYTES % rec; ++i)
+		if (data[i] != (uint8_t) i) {
+			printf("%s: %s didn't swap back!\n", name, layout);
+			break;
+		}
+	free(data);
+}
+
+static void bench_swap_bulk(const char *name) {
+	static const int shorts[] = { 2, 0 }, hhl[] = { 2, 2, 4, 0 }, hl[] = { 2, 4, 0 };
+	bench_swap_layout(name, ">h", shorts);
+	bench_swap_layout(name, ">hhl", hhl);
+	bench_swap_layout(name, ">hl", hl);
+}
+
+Benchmark res_benches[] = {
+	{ "/lzw/tests", bench_lzw_tests },
+	{ "/lzw/level", bench_lzw_level },
+	{ "/lz4/tests", bench_lz4_tests },
+	{ "/lz4/level", bench_lz4_level },
+	{ "/resindex/open", bench_resindex_open },
+	{ "/build/lzw", bench_build_lzw },
+	{ "/build/lz4", bench_build_lz4 },
+	{ "/stream/lzw", bench_stream_lzw },
+	{ "/swap/bulk", bench_swap_bulk },
+	{ NULL, NULL }
+};
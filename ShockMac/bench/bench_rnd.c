@@ -0,0 +1,105 @@
+#include "bench.h"
+
+#include "rnd.h"
+
+#include <stdio.h>
+
+//////////////////////////////
+//
+// Random values through f_Next, inline, and in bulk.  The range case is the
+// shape of the damage rolls in damage.c: a small range, one value at a time.
+//
+
+#define NUM_VALUES	4096
+#define NUM_PASSES	2000
+
+static uint32_t values[NUM_VALUES];
+static int32_t rolls[NUM_VALUES];
+
+static void rnd_report(const char *name, const char *label, double seconds) {
+	char full[128];
+
+	snprintf(full, sizeof(full), "%s/%s", name, label);
+	bench_report(full, seconds, (int64_t) NUM_VALUES * NUM_PASSES);
+}
+
+#define RND_LOOP(rs, label, body)									\
+	{																\
+		RndSeed(&rs, 22);											\
+		double start = bench_time();								\
+		for (int32_t pass = 0; pass < NUM_PASSES; ++pass) {			\
+			body													\
+			bench_sink += values[pass & (NUM_VALUES - 1)] + rolls[pass & (NUM_VALUES - 1)];	\
+		}															\
+		rnd_report(name, label, bench_time() - start);				\
+	}
+
+static void bench_lc16(const char *name) {
+	RNDSTREAM_LC16(rs);
+
+	RND_LOOP(rs, "next/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "next/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndLc16Next(&rs);)
+	RND_LOOP(rs, "next/fill", RndFill(&rs, values, NUM_VALUES);)
+	RND_LOOP(rs, "range/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) rolls[i] = RndRange(&rs, 1, 7);)
+	RND_LOOP(rs, "range/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) rolls[i] = RndLc16Range(&rs, 1, 7);)
+	RND_LOOP(rs, "range/fill", RndFillRange(&rs, rolls, NUM_VALUES, 1, 7);)
+}
+
+static void bench_gauss16fast(const char *name) {
+	RNDSTREAM_GAUSS16FAST(rs);
+
+	RND_LOOP(rs, "next/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "next/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndGauss16FastNext(&rs);)
+	RND_LOOP(rs, "next/fill", RndFill(&rs, values, NUM_VALUES);)
+}
+
+static void bench_xoshiro128(const char *name) {
+	RNDSTREAM_XOSHIRO128(rs);
+
+	RND_LOOP(rs, "next/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "next/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndXoshiro128Next(&rs);)
+	RND_LOOP(rs, "next/fill", RndFill(&rs, values, NUM_VALUES);)
+	RND_LOOP(rs, "range/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) rolls[i] = RndXoshiro128Range(&rs, 1, 7);)
+}
+
+static void bench_pcg32(const char *name) {
+	RNDSTREAM_PCG32(rs);
+
+	RND_LOOP(rs, "next/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "next/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndPcg32Next(&rs);)
+	RND_LOOP(rs, "next/fill", RndFill(&rs, values, NUM_VALUES);)
+	RND_LOOP(rs, "range/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) rolls[i] = RndPcg32Range(&rs, 1, 7);)
+}
+
+// every gaussian the library has, one value at a time and in bulk
+static void bench_gauss(const char *name) {
+	RNDSTREAM_GAUSS16(rsGauss16);
+	RNDSTREAM_GAUSS16FAST(rsGauss16Fast);
+	RNDSTREAM_ZIGGURAT(rs);
+
+	RND_LOOP(rsGauss16, "gauss16/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rsGauss16);)
+	RND_LOOP(rsGauss16Fast, "gauss16fast/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rsGauss16Fast);)
+	RND_LOOP(rs, "ziggurat/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "ziggurat/inline", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndZigguratNext(&rs);)
+	RND_LOOP(rs, "ziggurat/fill", RndFill(&rs, values, NUM_VALUES);)
+	RND_LOOP(rs, "ziggurat/normal_fix", for (int32_t i = 0; i < NUM_VALUES; ++i) rolls[i] = RndZigguratNormal(&rs);)
+	RND_LOOP(rs, "ziggurat/normal_fill", RndZigguratNormalFill(&rs, rolls, NUM_VALUES);)
+}
+
+static void bench_counter(const char *name) {
+	RNDSTREAM_COUNTER(rs);
+
+	RND_LOOP(rs, "next/pointer", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = Rnd(&rs);)
+	RND_LOOP(rs, "next/fill", RndFill(&rs, values, NUM_VALUES);)
+	RND_LOOP(rs, "value", for (int32_t i = 0; i < NUM_VALUES; ++i) values[i] = RndCounterValue(22, i, pass, 0);)
+}
+
+Benchmark rnd_benches[] = {
+	{ "/lc16", bench_lc16 },
+	{ "/gauss16fast", bench_gauss16fast },
+	{ "/xoshiro128", bench_xoshiro128 },
+	{ "/pcg32", bench_pcg32 },
+	{ "/gauss", bench_gauss },
+	{ "/counter", bench_counter },
+	{ NULL, NULL }
+};
@@ -146,6 +146,67 @@ static MunitResult test_dist(const MunitParameter params[], void* user_data_or_f
 	munit_assert_int32(fix_pyth_dist(fix_make(0, 0), fix_make(1, 0)), ==, fix_from_float(1.0f));
 	munit_assert_int32(fix_pyth_dist(fix_make(3, 0), fix_make(4, 0)), ==, fix_from_float(5.0f));
 
+	// the squares don't fit in a fix, but the distance does
+	munit_assert_int32(fix_pyth_dist(fix_make(3000, 0), fix_make(-4000, 0)), ==, fix_make(5000, 0));
+	munit_assert_int32(gOVResult, ==, 0);
+	munit_assert_int32(fix_pyth_dist(fix_make(30000, 0), fix_make(30000, 0)), ==, FIX_MAX);
+	munit_assert_int32(gOVResult, !=, 0);
+	munit_assert_int32(fix_pyth_dist(FIX_MIN, 0), ==, FIX_MAX);
+
+    return MUNIT_OK;
+}
+
+// r is the square root of x rounded down
+static bool is_isqrt(uint64_t x, uint32_t r) {
+	uint64_t r1 = (uint64_t) r + 1;
+	return (uint64_t) r * r <= x && (r1 > 0xffffffff || r1 * r1 > x);
+}
+
+static MunitResult test_sqrt_exact(const MunitParameter params[], void* user_data_or_fixture) {
+
+	for (fix x = 1; x < 0x20000; ++x) {
+		munit_assert_true(is_isqrt((uint64_t) x << 16, fix_sqrt(x)));
+	}
+	for (uint32_t x = 0x20000; x < 0x80000000; x += 4099) {
+		munit_assert_true(is_isqrt((uint64_t) x << 16, fix_sqrt(x)));
+	}
+	munit_assert_true(is_isqrt((uint64_t) FIX_MAX << 16, fix_sqrt(FIX_MAX)));
+
+	// perfect squares and their neighbours are where an estimate is most likely off by one
+	for (uint32_t r = 1000; r < 0xb504f3; r += 997) {
+		uint64_t sq = (uint64_t) r * r;
+		if ((sq & 0xffff) == 0) {
+			munit_assert_int32(fix_sqrt((fix) (sq >> 16)), ==, r);
+		}
+		munit_assert_int32(long_sqrt((int32_t) (r >> 8) * (r >> 8)), ==, r >> 8);
+		munit_assert_int32(long_sqrt((int32_t) (r >> 8) * (r >> 8) - 1), ==, (r >> 8) - 1);
+	}
+	munit_assert_int32(long_sqrt(0x7fffffff), ==, 46340);
+	munit_assert_int32(long_sqrt(-5), ==, 0);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_quad_sqrt(const MunitParameter params[], void* user_data_or_fixture) {
+
+	uint64_t x = 88172645463325252ull;
+
+	for (int32_t i = 0; i < 100000; ++i) {
+		uint64_t v, s;
+
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		v = x >> (i & 63);
+		munit_assert_true(is_isqrt(v, (uint32_t) quad_sqrt((int32_t) (v >> 32), (int32_t) v)));
+
+		s = v >> 32;
+		v = s * s;
+		munit_assert_uint32((uint32_t) quad_sqrt((int32_t) (v >> 32), (int32_t) v), ==, (uint32_t) s);
+		v -= 1;
+		munit_assert_true(is_isqrt(v, (uint32_t) quad_sqrt((int32_t) (v >> 32), (int32_t) v)));
+	}
+	munit_assert_uint32((uint32_t) quad_sqrt(-1, -1), ==, 0xffffffff);
+	munit_assert_uint32((uint32_t) quad_sqrt(0, 0), ==, 0);
+
     return MUNIT_OK;
 }
 
@@ -303,6 +364,46 @@ static MunitResult test_fast_sin_cos(const MunitParameter params[], void* user_d
     return MUNIT_OK;
 }
 
+static MunitResult test_sin_cos_hr(const MunitParameter params[], void* user_data_or_fixture) {
+
+	fix s, c, old_s, old_c;
+	double max_err = 0, old_max_err = 0;
+
+	fix_sincos_hr(degrees_to_fixang(0), &s, &c);
+	munit_assert_int32(s, ==, fix_make(0, 0));
+	munit_assert_int32(c, ==, fix_make(1, 0));
+
+	fix_sincos_hr(degrees_to_fixang(90), &s, &c);
+	munit_assert_int32(s, ==, fix_make(1, 0));
+	munit_assert_int32(c, ==, fix_make(0, 0));
+
+	fix_sincos_hr(degrees_to_fixang(180), &s, &c);
+	munit_assert_int32(s, ==, fix_make(0, 0));
+	munit_assert_int32(c, ==, -fix_make(1, 0));
+
+	fix_sincos_hr(degrees_to_fixang(270), &s, &c);
+	munit_assert_int32(s, ==, -fix_make(1, 0));
+	munit_assert_int32(c, ==, fix_make(0, 0));
+
+	// must be at least as accurate as fix_sincos everywhere, whatever the table size
+	for (int32_t th = 0; th < 0x10000; ++th) {
+		double rad = th * (2.0 * 3.14159265358979323846 / 65536.0);
+		double es = sin(rad) * 65536.0, ec = cos(rad) * 65536.0;
+
+		fix_sincos_hr((fixang) th, &s, &c);
+		munit_assert_int32(s, ==, fix_sin_hr((fixang) th));
+		munit_assert_int32(c, ==, fix_cos_hr((fixang) th));
+		max_err = fmax(max_err, fmax(fabs(s - es), fabs(c - ec)));
+
+		fix_sincos((fixang) th, &old_s, &old_c);
+		old_max_err = fmax(old_max_err, fmax(fabs(old_s - es), fabs(old_c - ec)));
+	}
+
+	munit_assert_double(max_err, <, old_max_err);
+
+    return MUNIT_OK;
+}
+
 static MunitResult test_asin(const MunitParameter params[], void* user_data_or_fixture) {
 
 	munit_assert_int32(abs(fix_asin(fix_from_float(0.0f)) - degrees_to_fixang(0)), <, 2);
@@ -345,6 +446,346 @@ static MunitResult test_atan2(const MunitParameter params[], void* user_data_or_
     return MUNIT_OK;
 }
 
+//////////////////////////////
+//
+// array functions, every implementation the cpu supports must match the scalar code bit for bit
+//
+
+#define ARRAY_LEN	1003		// not a multiple of the vector width, so the tails get tested too
+
+static const FixArrayImpl array_impls[] = {FIX_ARRAY_SCALAR, FIX_ARRAY_SSE2, FIX_ARRAY_AVX2};
+#define NUM_ARRAY_IMPLS	(sizeof(array_impls) / sizeof(array_impls[0]))
+
+static const fix array_edge_values[] = {
+	0, 1, -1, 0xffff, -0xffff, FIX_UNIT, -FIX_UNIT, 0x7fffffff, (fix) 0x80000000, 0x12345678, -0x12345678
+};
+#define NUM_ARRAY_EDGE_VALUES	(sizeof(array_edge_values) / sizeof(array_edge_values[0]))
+
+static fix array_value(uint32_t *seed, bool nonzero) {
+	fix result;
+
+	do {
+		*seed = *seed * 1664525u + 1013904223u;
+		result = (fix) *seed >> ((*seed >> 8) & 31);		// mix small and large magnitudes
+	} while (nonzero && result == 0);
+
+	return result;
+}
+
+static void array_fill(fix *a, int32_t n, uint32_t seed, bool nonzero) {
+	int32_t i;
+
+	for (i = 0; i < n; ++i) {
+		if (i < NUM_ARRAY_EDGE_VALUES) {
+			a[i] = array_edge_values[(i + seed) % NUM_ARRAY_EDGE_VALUES];
+			if (nonzero && a[i] == 0) a[i] = FIX_UNIT;
+		} else {
+			a[i] = array_value(&seed, nonzero);
+		}
+	}
+}
+
+// distance in fixangs from the angle a to rad radians, either way around
+static double fixang_err(fixang a, double rad) {
+	double d = fmod(a - rad * (65536.0 / (2.0 * 3.14159265358979323846)), 65536.0);
+
+	if (d > 32768.0) d -= 65536.0;
+	if (d < -32768.0) d += 65536.0;
+	return fabs(d);
+}
+
+static MunitResult test_atan2_tiers(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static const fix edges[] = { 0, 1, -1, FIX_UNIT, -FIX_UNIT, FIX_MAX, FIX_MIN, 0x12345678 };
+	uint32_t seed = 5;
+
+	// the exact angles come out exact
+	munit_assert_uint16(fix_atan2_hr(0, FIX_UNIT), ==, 0x0000);
+	munit_assert_uint16(fix_atan2_hr(FIX_UNIT, FIX_UNIT), ==, 0x2000);
+	munit_assert_uint16(fix_atan2_hr(FIX_UNIT, 0), ==, 0x4000);
+	munit_assert_uint16(fix_atan2_hr(0, -FIX_UNIT), ==, 0x8000);
+	munit_assert_uint16(fix_atan2_hr(-FIX_UNIT, -FIX_UNIT), ==, 0xa000);
+	munit_assert_uint16(fix_atan2_hr(-FIX_UNIT, 0), ==, 0xc000);
+	munit_assert_int32(abs(fix_atan2_fast(FIX_UNIT, -FIX_UNIT) - 0x6000), <=, 1);
+	munit_assert_uint16(fix_atan2_fast(0, 0), ==, 0);
+
+	for (int32_t i = 0; i < 200000; ++i) {
+		fix y = array_value(&seed, false), x = array_value(&seed, false);
+
+		if (i < 64) {
+			y = edges[i & 7];
+			x = edges[i >> 3];
+		}
+		if (x == 0 && y == 0) continue;
+		munit_assert_double(fixang_err(fix_atan2_hr(y, x), atan2(y, x)), <, 0.6);
+		munit_assert_double(fixang_err(fix_atan2_fast(y, x), atan2(y, x)), <, 2.0);
+		munit_assert_uint16(fix24_atan2_hr(y, x), ==, fix_atan2_hr(y, x));
+	}
+
+	// fix_asin is way off near -1 and 1, the hr one isn't
+	for (fix x = -FIX_UNIT; x <= FIX_UNIT; x += 3) {
+		munit_assert_double(fixang_err(fix_asin_hr(x), asin(x / 65536.0)), <, 1.0);
+		munit_assert_double(fixang_err(fix_acos_hr(x), acos(x / 65536.0)), <, 1.0);
+	}
+	munit_assert_uint16(fix_asin_hr(FIX_UNIT), ==, 0x4000);
+	munit_assert_uint16(fix_asin_hr(FIX_MIN), ==, 0xc000);
+	munit_assert_uint16(fix_acos_hr(-FIX_UNIT), ==, 0x8000);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_exp_tiers(const MunitParameter params[], void* user_data_or_fixture) {
+
+	munit_assert_int32(fix_exp_hr(0), ==, FIX_UNIT);
+	munit_assert_int32(fix_exp_fast(0), ==, FIX_UNIT);
+	munit_assert_int32(fix_exp_hr(FIX_UNIT), ==, 178145);				// e
+	munit_assert_int32(fix_exp_hr(fix_make(11, 0)), ==, FIX_MAX);
+	munit_assert_int32(fix_exp_hr(FIX_MAX), ==, FIX_MAX);
+	munit_assert_int32(fix_exp_hr(fix_make(-12, 0)), ==, 0);
+	munit_assert_int32(fix_exp_hr(FIX_MIN), ==, 0);
+
+	for (fix x = fix_make(-12, 0); x < fix_make(10, 0x6000); x += 37) {
+		double e = exp(x / 65536.0) * 65536.0;
+
+		// within a rounding plus a couple of parts in a billion
+		munit_assert_double(fabs(fix_exp_hr(x) - e), <, 0.5 + e * 2e-9);
+		munit_assert_double(fabs(fix_exp_fast(x) - e), <, 0.5 + e * 1e-4);
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_pow_tiers(const MunitParameter params[], void* user_data_or_fixture) {
+
+	uint32_t seed = 6;
+
+	munit_assert_int32(fix_pow_hr(fix_make(2, 0), fix_make(10, 0)), ==, fix_make(1024, 0));
+	munit_assert_int32(fix_pow_hr(fix_make(9, 0), FRACT_500), ==, fix_make(3, 0));
+	munit_assert_int32(fix_pow_hr(fix_make(2, 0), fix_make(-2, 0)), ==, FRACT_250);
+	munit_assert_int32(fix_pow_hr(fix_make(-2, 0), fix_make(3, 0)), ==, fix_make(-8, 0));
+	munit_assert_int32(fix_pow_hr(fix_make(-2, 0), FRACT_500), ==, 0);
+	munit_assert_int32(fix_pow_hr(0, FIX_UNIT), ==, 0);
+	munit_assert_int32(fix_pow_hr(0, 0), ==, FIX_UNIT);
+	munit_assert_int32(fix_pow_hr(fix_make(2, 0), fix_make(31, 0)), ==, FIX_MAX);
+	munit_assert_int32(fix_pow_hr(FIX_MAX, FIX_MAX), ==, FIX_MAX);
+	munit_assert_int32(fix_pow_hr(1, FIX_MAX), ==, 0);
+
+	// the gamma curves in pal.c and star.c
+	for (int32_t i = 0; i < 256; ++i) {
+		for (fix gamma = FRACT_250; gamma < fix_make(3, 0); gamma += FRACT_250) {
+			fix x = fix_make(i, 0) / 255;
+			double e = pow(x / 65536.0, gamma / 65536.0) * 65536.0;
+
+			munit_assert_double(fabs(fix_pow_hr(x, gamma) - e), <, 0.51);
+			munit_assert_double(fabs(fix_pow_fast(x, gamma) - e), <, 0.5 + e * 1e-4);
+		}
+	}
+
+	for (int32_t i = 0; i < 100000; ++i) {
+		fix x = array_value(&seed, true), y = array_value(&seed, false) >> 8;
+		double e;
+
+		if (x < 0) x = -x;
+		e = pow(x / 65536.0, y / 65536.0) * 65536.0;
+		if (e >= 2147483647.0) {
+			munit_assert_int32(fix_pow_hr(x, y), >=, FIX_MAX - 4);
+		} else {
+			munit_assert_double(fabs(fix_pow_hr(x, y) - e), <, 0.5 + e * 2e-9 + fabs(y / 65536.0) * e * 1e-11);
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_mul_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[ARRAY_LEN], b[ARRAY_LEN], r[ARRAY_LEN];
+
+	array_fill(a, ARRAY_LEN, 1, false);
+	array_fill(b, ARRAY_LEN, 2, false);
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_mul_array(r, a, b, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			munit_assert_int32(r[i], ==, fix_mul(a[i], b[i]));
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_div_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[ARRAY_LEN], b[ARRAY_LEN], r[ARRAY_LEN];
+
+	array_fill(a, ARRAY_LEN, 3, false);
+	array_fill(b, ARRAY_LEN, 4, true);
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_div_array(r, a, b, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			munit_assert_int32(r[i], ==, fix_div(a[i], b[i]));
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_mul_div_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[ARRAY_LEN], b[ARRAY_LEN], c[ARRAY_LEN], r[ARRAY_LEN];
+
+	array_fill(a, ARRAY_LEN, 5, false);
+	array_fill(b, ARRAY_LEN, 6, false);
+	array_fill(c, ARRAY_LEN, 7, true);
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_mul_div_array(r, a, b, c, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			munit_assert_int32(r[i], ==, fix_mul_div(a[i], b[i], c[i]));
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_sincos_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fixang theta[0x10000];
+	static fix s[0x10000], c[0x10000];
+	fix es, ec;
+
+	for (int32_t i = 0; i < 0x10000; ++i) {
+		theta[i] = (fixang) i;
+	}
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_sincos_array(s, c, theta, 0x10000 - 3);
+		for (int32_t i = 0; i < 0x10000 - 3; ++i) {
+			fix_sincos(theta[i], &es, &ec);
+			munit_assert_int32(s[i], ==, es);
+			munit_assert_int32(c[i], ==, ec);
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_dot3_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[3 * ARRAY_LEN], b[3 * ARRAY_LEN], r[ARRAY_LEN];
+
+	array_fill(a, 3 * ARRAY_LEN, 8, false);
+	array_fill(b, 3 * ARRAY_LEN, 9, false);
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_dot3_array(r, a, b, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			fix *va = &a[3*i], *vb = &b[3*i];
+			munit_assert_int32(r[i], ==, fix_mul(va[0], vb[0]) + fix_mul(va[1], vb[1]) + fix_mul(va[2], vb[2]));
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_cross3_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[3 * ARRAY_LEN], b[3 * ARRAY_LEN], r[3 * ARRAY_LEN];
+
+	array_fill(a, 3 * ARRAY_LEN, 10, false);
+	array_fill(b, 3 * ARRAY_LEN, 11, false);
+
+	for (size_t impl = 0; impl < NUM_ARRAY_IMPLS; ++impl) {
+		if (!fix_array_select(array_impls[impl])) continue;
+
+		fix_cross3_array(r, a, b, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			fix *va = &a[3*i], *vb = &b[3*i], *vr = &r[3*i];
+			munit_assert_int32(vr[0], ==, fix_mul(va[1], vb[2]) - fix_mul(va[2], vb[1]));
+			munit_assert_int32(vr[1], ==, fix_mul(va[2], vb[0]) - fix_mul(va[0], vb[2]));
+			munit_assert_int32(vr[2], ==, fix_mul(va[0], vb[1]) - fix_mul(va[1], vb[0]));
+		}
+	}
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_recip_div(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix a[ARRAY_LEN], d[ARRAY_LEN], r[ARRAY_LEN];
+	fix_recip recip;
+
+	array_fill(a, ARRAY_LEN, 12, false);
+	array_fill(d, ARRAY_LEN, 13, true);
+
+	for (int32_t j = 0; j < ARRAY_LEN; ++j) {
+		fix_recip_init(&recip, d[j]);
+		fix_recip_div_array(&recip, r, a, ARRAY_LEN);
+		for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+			munit_assert_int32(r[i], ==, fix_div(a[i], d[j]));
+		}
+	}
+
+	// the cases where the quotient is exact are the most likely to be off by one
+	for (int32_t i = 1; i < 1000; ++i) {
+		fix_recip_init(&recip, i * 977);
+		munit_assert_int32(fix_recip_div(&recip, i * 977), ==, FIX_UNIT);
+		munit_assert_int32(fix_recip_div(&recip, -i * 977 * 3), ==, -3 * FIX_UNIT);
+	}
+
+	fix_recip_init(&recip, 0);
+	munit_assert_int32(fix_recip_div(&recip, FIX_UNIT), ==, 0);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_mag3_array(const MunitParameter params[], void* user_data_or_fixture) {
+
+	static fix v[ARRAY_LEN * 3], m[ARRAY_LEN], u[ARRAY_LEN * 3];
+
+	array_fill(v, ARRAY_LEN * 3, 14, false);
+	for (int32_t i = 0; i < ARRAY_LEN * 3; ++i) {
+		v[i] >>= 2;										// keep most of the lengths in range
+	}
+	v[0] = fix_make(2, 0); v[1] = fix_make(-3, 0); v[2] = fix_make(6, 0);
+	v[3] = v[4] = v[5] = 0;
+
+	fix_mag3_array(m, v, ARRAY_LEN);
+	fix_normalize3_array(u, v, ARRAY_LEN);
+
+	munit_assert_int32(m[0], ==, fix_make(7, 0));
+	munit_assert_int32(m[1], ==, 0);
+	munit_assert_int32(u[3], ==, 0);
+
+	for (int32_t i = 0; i < ARRAY_LEN; ++i) {
+		const fix *p = &v[i * 3];
+		uint64_t sq = (uint64_t) ((int64_t) p[0] * p[0]) + (uint64_t) ((int64_t) p[1] * p[1]) + (uint64_t) ((int64_t) p[2] * p[2]);
+
+		if (m[i] == FIX_MAX || m[i] == 0) continue;
+		munit_assert_true(is_isqrt(sq, m[i]));
+		for (int32_t k = 0; k < 3; ++k) {
+			munit_assert_int32(u[i * 3 + k], ==, fix_div(p[k], m[i]));
+		}
+	}
+
+	// in place
+	fix_normalize3_array(v, v, ARRAY_LEN);
+	munit_assert_memory_equal(sizeof(u), v, u);
+
+    return MUNIT_OK;
+}
+
 MunitTest fix_tests[] = {
     { "/from_float", test_from_float, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/to_float", test_to_float, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
@@ -355,13 +796,27 @@ MunitTest fix_tests[] = {
     { "/mul_div", test_mul_div, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/sqrt", test_sqrt, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/dist", test_dist, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/sqrt_exact", test_sqrt_exact, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/quad_sqrt", test_quad_sqrt, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/fast_dist", test_fast_dist, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/sin_cos", test_sin_cos, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/sin", test_sin, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/cos", test_cos, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/fast_sin_cos", test_fast_sin_cos, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/sin_cos_hr", test_sin_cos_hr, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/asin", test_asin, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/acos", test_acos, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/atan2", test_atan2, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/atan2_tiers", test_atan2_tiers, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/exp_tiers", test_exp_tiers, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/pow_tiers", test_pow_tiers, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/mul_array", test_mul_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/div_array", test_div_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/mul_div_array", test_mul_div_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/sincos_array", test_sincos_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/dot3_array", test_dot3_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/cross3_array", test_cross3_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/recip_div", test_recip_div, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/mag3_array", test_mag3_array, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
 };
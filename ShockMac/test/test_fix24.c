@@ -130,6 +130,7 @@ static MunitResult test_dist(const MunitParameter params[], void* user_data_or_f
 	munit_assert_int32(fix24_pyth_dist(fix24_make(1, 0), fix24_make(0, 0)), ==, fix24_from_float(1.0f));
 	munit_assert_int32(fix24_pyth_dist(fix24_make(0, 0), fix24_make(1, 0)), ==, fix24_from_float(1.0f));
 	munit_assert_int32(fix24_pyth_dist(fix24_make(3, 0), fix24_make(4, 0)), ==, fix24_from_float(5.0f));
+	munit_assert_int32(fix24_pyth_dist(fix24_make(300000, 0), fix24_make(400000, 0)), ==, fix24_make(500000, 0));
 
     return MUNIT_OK;
 }
@@ -333,6 +334,29 @@ static MunitResult test_atan2(const MunitParameter params[], void* user_data_or_
     return MUNIT_OK;
 }
 
+static MunitResult test_tiers(const MunitParameter params[], void* user_data_or_fixture) {
+
+	munit_assert_uint16(fix24_atan2_hr(fix24_make(1, 0), -(1u << 8)), ==, 0x6000);
+	munit_assert_int32(abs(fix24_atan2_fast(-(1u << 8), fix24_make(0, 0)) - degrees_to_fixang(-90)), <=, 1);
+	munit_assert_uint16(fix24_asin_hr(fix24_make(1, 0)), ==, 0x4000);
+	munit_assert_uint16(fix24_asin_hr(fix24_make(-100, 0)), ==, 0xc000);
+	munit_assert_int32(abs(fix24_acos_hr(fix24_from_float(0.5f)) - degrees_to_fixang(60)), <=, 1);
+
+	for (fix24 x = fix24_make(-6, 0); x < fix24_make(15, 0); ++x) {
+		double e = exp(x / 256.0) * 256.0;
+
+		munit_assert_double(fabs(fix24_exp_hr(x) - e), <, 0.5 + e * 2e-9);
+		munit_assert_double(fabs(fix24_exp_fast(x) - e), <, 0.5 + e * 1e-4);
+	}
+	munit_assert_int32(fix24_exp_hr(fix24_make(16, 0)), ==, FIX_MAX);
+
+	munit_assert_int32(fix24_pow_hr(fix24_make(2, 0), fix24_make(20, 0)), ==, fix24_make(1 << 20, 0));
+	munit_assert_int32(fix24_pow_hr(fix24_make(16, 0), FRACT_250), ==, fix24_make(2, 0));
+	munit_assert_int32(fix24_pow_fast(fix24_make(-3, 0), fix24_make(3, 0)), ==, fix24_make(-27, 0));
+
+    return MUNIT_OK;
+}
+
 MunitTest fix24_tests[] = {
     { "/from_float", test_from_float, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/to_float", test_to_float, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
@@ -350,5 +374,6 @@ MunitTest fix24_tests[] = {
     { "/asin", test_asin, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/acos", test_acos, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/atan2", test_atan2, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/tiers", test_tiers, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
 };
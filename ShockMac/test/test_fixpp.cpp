@@ -0,0 +1,200 @@
+#include "munit/munit.h"
+
+#include "fixpp.h"
+#include "fixppvec.h"
+
+typedef Fixpoint<24> Q24;
+typedef Fixpoint<8> Q8;
+
+static MunitResult test_q_is_fix(const MunitParameter params[], void* user_data_or_fixture) {
+
+	Q a(1.5), b(-2.25);
+
+	munit_assert_int32(a.to_fix(), ==, fix_make(1, 0x8000));
+	munit_assert_int32((a * b).to_fix(), ==, fix_mul(a.to_fix(), b.to_fix()));
+	Q t(a);
+	munit_assert_int32((t *= b).to_fix(), ==, fix_mul(a.to_fix(), b.to_fix()));
+	munit_assert_int32((a / b).to_fix(), ==, fix_div(a.to_fix(), b.to_fix()));
+	munit_assert_int32((a * 2).to_fix(), ==, fix_make(3, 0));
+	munit_assert_int32((2 * a).to_fix(), ==, fix_make(3, 0));
+	munit_assert_int32((1 - a).to_fix(), ==, -fix_make(0, 0x8000));
+	munit_assert_int32(sqrt(Q(9)).to_fix(), ==, fix_make(3, 0));
+
+	Q half_pi;
+	half_pi.fixang_to(0x4000);
+	munit_assert_int32(abs(half_pi.to_fixang() - 0x4000), <=, 1);
+	munit_assert_int32(sin(half_pi).to_fix(), ==, fix_sin(half_pi.to_fixang()));
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_convert(const MunitParameter params[], void* user_data_or_fixture) {
+
+	Q a(-3.75);
+
+	// more fraction bits and back is lossless
+	Q24 wide(a);
+	munit_assert_int32(wide.val, ==, a.val << 8);
+	munit_assert_int32(Q(wide).val, ==, a.val);
+
+	// fewer fraction bits rounds down
+	Q b(0.00390625 + 1.0 / 65536);
+	munit_assert_int32(Q8(b).val, ==, 1);
+	munit_assert_int32(Q8(-b).val, ==, -2);
+
+	munit_assert_int32(Q24(2).to_fix(), ==, fix_make(2, 0));
+	munit_assert_int32(Q24(2).to_int(), ==, 2);
+	munit_assert_double(Q24(0.125).to_double(), ==, 0.125);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_wide_math(const MunitParameter params[], void* user_data_or_fixture) {
+
+	Q24 third = Q24(1) / Q24(3);
+	munit_assert_int32(third.val, ==, (1 << 24) / 3);
+	munit_assert_int32((third * 3).val, ==, (1 << 24) - 1);
+
+	// 1/3 in 16:16 is eight bits coarser
+	munit_assert_int32(Q24(Q(1) / Q(3)).val, ==, ((1 << 16) / 3) << 8);
+
+	Q24 two(2);
+	munit_assert_int32(sqrt(two).val, ==, (int32_t) (1.4142135623730951 * (1 << 24)));
+	munit_assert_int32(sqrt(Q24(-1)).val, ==, 0);
+
+	// trig goes through 16:16
+	Q24 angle;
+	angle.fixang_to(0x2000);
+	munit_assert_int32(abs(angle.to_fixang() - 0x2000), <=, 1);
+	munit_assert_int32(sin(angle).to_fix(), ==, fix_sin(angle.to_fixang()));
+
+	Q8 c(5), d(0.5);
+	munit_assert_int32((c * d).val, ==, (5 << 8) / 2);
+	munit_assert_int32((c / d).val, ==, 10 << 8);
+
+    return MUNIT_OK;
+}
+
+static MunitResult test_fused(const MunitParameter params[], void* user_data_or_fixture) {
+
+	Q a, b, c, d, e, t;
+	a.val = 0x18001; b.val = 0x8001; c.val = -0x28003; d.val = 0x4001; e.val = 0x12345;
+
+	// one product is rounded to nearest
+	Q p = a * b;
+	munit_assert_int32(p.to_fix(), ==, (fix) (((int64_t) a.val * b.val + 0x8000) >> 16));
+	t.val = 0x8000;
+	munit_assert_int32((Q(3) * t).to_fix(), ==, fix_make(1, 0x8000));
+	t.val = 3;
+	munit_assert_int32((t * t.shifted(15)).to_fix(), ==, fix_mul(3, 3 << 15) + 1);
+	munit_assert_int32((c * d).to_fix(), ==, fix_mul(c.to_fix(), d.to_fix()));
+	munit_assert_int32((-(a * b)).to_fix(), ==, -p.to_fix());
+	munit_assert_int32((2 * a).to_fix(), ==, 2 * a.to_fix());
+
+	// *= rounds the same as *
+	t = a;
+	t *= b;
+	munit_assert_int32(t.to_fix(), ==, p.to_fix());
+	t.val = 3;
+	t *= t.shifted(15);
+	munit_assert_int32(t.to_fix(), ==, fix_mul(3, 3 << 15) + 1);
+
+	// a sum of products is rounded once
+	int64_t exact = (int64_t) a.val * b.val + (int64_t) c.val * d.val + ((int64_t) e.val << 16);
+	Q sum = a * b + c * d + e;
+	munit_assert_int32(sum.to_fix(), ==, (fix) ((exact + 0x8000) >> 16));
+	munit_assert_int32((e + a * b + c * d).to_fix(), ==, (fix) ((exact + 0x8000) >> 16));
+
+	exact = (int64_t) a.val * b.val - (int64_t) c.val * d.val - ((int64_t) e.val << 16);
+	munit_assert_int32((a * b - c * d - e).to_fix(), ==, (fix) ((exact + 0x8000) >> 16));
+	munit_assert_int32((-e - c * d + a * b).to_fix(), ==, (fix) ((exact + 0x8000) >> 16));
+
+	// products still work everywhere a Q does
+	munit_assert_true(a * b > 0);
+	munit_assert_int32(abs(c * d).to_fix(), ==, -(c * d).to_fix());
+	munit_assert_int32(sqrt(Q(3) * Q(3) + Q(4) * Q(4)).to_fix(), ==, fix_make(5, 0));
+	munit_assert_int32((a * b * c).to_fix(), ==, (fix) (((int64_t) p.val * c.val + 0x8000) >> 16));
+
+	Q24 x(0.75), y(-1.5);
+	munit_assert_int32((x * y + x).val, ==, (int32_t) (-0.375 * (1 << 24)));
+
+    return MUNIT_OK;
+}
+
+// pseudo-random Q in [-range, range)
+static Q vec_random(int32_t range) {
+	static uint32_t seed = 12345;
+	Q r;
+	seed = seed * 1664525u + 1013904223u;
+	r.val = (fix) ((seed >> 8) % (uint32_t) (2 * range * FIX_UNIT)) - range * FIX_UNIT;
+	return r;
+}
+
+static MunitResult test_vectors(const MunitParameter params[], void* user_data_or_fixture) {
+
+	for (int32_t n = 0; n < 1000; ++n) {
+		Q a[4], b[4], m[3][3], s = vec_random(4);
+		for (int32_t i = 0; i < 4; ++i) {
+			a[i] = vec_random(100);
+			b[i] = vec_random(100);
+		}
+		for (int32_t i = 0; i < 3; ++i)
+			for (int32_t j = 0; j < 3; ++j)
+				m[i][j] = vec_random(2);
+
+		// every result matches the same Q expression
+		Q3 a3(a), b3(b);
+		Q3 sum = a3 + b3, diff = a3 - b3, neg = -a3, scaled = a3 * s, c = cross(a3, b3);
+		for (int32_t i = 0; i < 3; ++i) {
+			munit_assert_int32(sum[i].val, ==, (a[i] + b[i]).val);
+			munit_assert_int32(diff[i].val, ==, (a[i] - b[i]).val);
+			munit_assert_int32(neg[i].val, ==, (-a[i]).val);
+			munit_assert_int32(scaled[i].val, ==, Q(a[i] * s).val);
+		}
+		munit_assert_int32(c[0].val, ==, Q(a[1] * b[2] - a[2] * b[1]).val);
+		munit_assert_int32(c[1].val, ==, Q(a[2] * b[0] - a[0] * b[2]).val);
+		munit_assert_int32(c[2].val, ==, Q(a[0] * b[1] - a[1] * b[0]).val);
+		munit_assert_int32(dot(a3, b3).val, ==, Q(a[0] * b[0] + a[1] * b[1] + a[2] * b[2]).val);
+		munit_assert_int32(c.v[3] | scaled.v[3] | neg.v[3], ==, 0);
+
+		Q4 a4(a), b4(b);
+		munit_assert_int32(dot(a4, b4).val, ==, Q(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]).val);
+		munit_assert_int32((s * a4)[3].val, ==, Q(a[3] * s).val);
+
+		Q3 r0(m[0]), r1(m[1]), r2(m[2]);
+		Q3x3 mm(r0, r1, r2);
+		Q3 t = mm * a3;
+		for (int32_t i = 0; i < 3; ++i)
+			munit_assert_int32(t[i].val, ==, Q(m[i][0] * a[0] + m[i][1] * a[1] + m[i][2] * a[2]).val);
+
+		Q3x3 sq = mm * mm;
+		for (int32_t i = 0; i < 3; ++i)
+			for (int32_t j = 0; j < 3; ++j)
+				munit_assert_int32(sq(i, j).val, ==, Q(m[i][0] * m[0][j] + m[i][1] * m[1][j] + m[i][2] * m[2][j]).val);
+	}
+
+	// the in-place forms and the way back to an array
+	Q3 v(1, 2, 3);
+	v += Q3(1, 1, 1);
+	v *= Q(0.5);
+	v -= Q3(1, 0, 0);
+	Q out[3];
+	v.to(out);
+	munit_assert_int32(out[0].to_fix(), ==, 0);
+	munit_assert_int32(out[1].to_fix(), ==, fix_make(1, 0x8000));
+	munit_assert_int32(out[2].to_fix(), ==, fix_make(2, 0));
+	munit_assert_true(v == Q3(0, 1.5, 2));
+
+    return MUNIT_OK;
+}
+
+extern "C" MunitTest fixpp_tests[];
+
+MunitTest fixpp_tests[] = {
+    { (char *) "/q_is_fix", test_q_is_fix, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *) "/convert", test_convert, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *) "/wide_math", test_wide_math, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *) "/fused", test_fused, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { (char *) "/vectors", test_vectors, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
@@ -3,6 +3,8 @@
 extern MunitTest fix_tests[];
 extern MunitTest fix24_tests[];
 extern MunitTest rnd_tests[];
+extern MunitTest fixpp_tests[];
+extern MunitTest res_tests[];
 
 static MunitSuite extern_suites[] = {
 	{	.prefix = "/fix",
@@ -17,12 +19,24 @@ static MunitSuite extern_suites[] = {
 		.iterations = 1,
 		.options = MUNIT_SUITE_OPTION_NONE
 	},
+	{	.prefix = "/fixpp",
+		.tests = fixpp_tests,
+		.suites = NULL,
+		.iterations = 1,
+		.options = MUNIT_SUITE_OPTION_NONE
+	},
 	{	.prefix = "/random",
 		.tests = rnd_tests,
 		.suites = NULL,
 		.iterations = 1,
 		.options = MUNIT_SUITE_OPTION_NONE
 	},
+	{	.prefix = "/res",
+		.tests = res_tests,
+		.suites = NULL,
+		.iterations = 1,
+		.options = MUNIT_SUITE_OPTION_NONE
+	},
 	{ NULL, NULL, NULL, 0, MUNIT_SUITE_OPTION_NONE}
 };
 
@@ -0,0 +1,1262 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "munit/munit.h"
+
+#include "lz4.h"
+#include "lzw.h"
+#include "res_.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+enum { LZW_TEXT, LZW_RUNS, LZW_NOISE, LZW_SAME };
+
+// test data: word soup, bitmap-like runs, noise, or one repeated byte
+static uint8_t *lzw_data(int kind, int32_t size) {
+	static const char *words[] = { "the ", "cyborg ", "shodan ", "citadel ", "station ", "hacker ", "of ", "and ", "\n" };
+	uint8_t *data = malloc(size);
+	uint32_t seed = 12345 + kind;
+	int32_t i = 0;
+
+	while (i < size) {
+		seed = seed * 1664525u + 1013904223u;
+		if (kind == LZW_TEXT) {
+			for (const char *w = words[(seed >> 16) % 9]; *w && i < size; ++w)
+				data[i++] = *w;
+		} else if (kind == LZW_RUNS) {
+			for (int32_t n = (seed >> 24) & 31; n >= 0 && i < size; --n)
+				data[i++] = (seed >> 8) & 15;
+		} else if (kind == LZW_NOISE) {
+			data[i++] = seed >> 24;
+		} else {
+			data[i++] = 'a';
+		}
+	}
+	return data;
+}
+
+static MunitResult test_lzw_block(const MunitParameter params[], void* user_data_or_fixture) {
+	static const int32_t sizes[] = { 2, 100, 5000, 200000 };
+
+	for (int kind = LZW_TEXT; kind <= LZW_SAME; ++kind) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			int32_t size = sizes[s];
+			uint8_t *data = lzw_data(kind, size);
+			uint8_t *comp = malloc(2 * size + 16);
+			uint8_t *ref = malloc(size + 16);
+			uint8_t *out = malloc(size + 16);
+
+			int32_t csize = LzwCompressBuff2Buff(data, size, comp, 2 * size + 16);
+			munit_assert_int32(csize, >, 0);
+
+			// same bytes and size as the callback expander
+			munit_assert_int32(LzwExpandBuff2Buff(comp, ref, 0, 0), ==, size);
+			munit_assert_memory_equal(size, ref, data);
+			munit_assert_int32(LzwExpandBlock(comp, csize, out, size), ==, size);
+			munit_assert_memory_equal(size, out, data);
+			munit_assert_int32(LzwExpandBlock(comp, csize, out, 0), ==, size);
+			munit_assert_memory_equal(size, out, data);
+
+			// a short destination gets a prefix, and nothing past it
+			int32_t part = size / 3 + 1;
+			memset(out, 0xEE, size + 16);
+			munit_assert_int32(LzwExpandBlock(comp, csize, out, part), ==, part);
+			munit_assert_memory_equal(part, out, data);
+			for (int32_t i = part; i < size + 16; ++i)
+				munit_assert_uint8(out[i], ==, 0xEE);
+
+			free(out);
+			free(ref);
+			free(comp);
+			free(data);
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+typedef struct {
+	LzwContext *plc;
+	int kind;
+	int32_t size;
+	int32_t bad;				// # round trips that didn't match
+} LzwWork;
+
+// round trips through one context, by callbacks and by block
+static void *lzw_worker(void *arg) {
+	LzwWork *w = arg;
+	uint8_t *data = lzw_data(w->kind, w->size);
+	uint8_t *comp = malloc(2 * w->size + 16);
+	uint8_t *out = malloc(w->size + 16);
+
+	for (int round = 0; round < 20; ++round) {
+		int32_t csize = LzwContextCompressBuff2Buff(w->plc, data, w->size, comp, 2 * w->size + 16);
+		memset(out, 0, w->size);
+		if (LzwContextExpandBuff2Buff(w->plc, comp, out, 0, 0) != w->size || memcmp(out, data, w->size) != 0)
+			w->bad++;
+		memset(out, 0, w->size);
+		if (LzwContextExpandBlock(w->plc, comp, csize, out, w->size) != w->size || memcmp(out, data, w->size) != 0)
+			w->bad++;
+	}
+
+	free(out);
+	free(comp);
+	free(data);
+	return NULL;
+}
+
+static MunitResult test_lzw_contexts(const MunitParameter params[], void* user_data_or_fixture) {
+	pthread_t tid[8];
+	LzwWork work[8];
+
+	// every thread compresses and expands different data at the same time
+	for (int t = 0; t < 8; ++t) {
+		work[t].plc = LzwContextCreate();
+		munit_assert_ptr_not_null(work[t].plc);
+		work[t].kind = t % (LZW_SAME + 1);
+		work[t].size = 20000 + 7919 * t;
+		work[t].bad = 0;
+		pthread_create(&tid[t], NULL, lzw_worker, &work[t]);
+	}
+	for (int t = 0; t < 8; ++t) {
+		pthread_join(tid[t], NULL);
+		munit_assert_int32(work[t].bad, ==, 0);
+		LzwContextDestroy(work[t].plc);
+	}
+
+	// file sources and destinations work from a context too
+	LzwContext *plc = LzwContextCreate();
+	int32_t size = 30000;
+	uint8_t *data = lzw_data(LZW_TEXT, size);
+	uint8_t *out = malloc(size);
+	FILE *fp = tmpfile();
+	munit_assert_ptr_not_null(fp);
+
+	int32_t csize = LzwContextCompress(plc, LzwBuffSrcC(data, size), LzwFpDestC(fp));
+	munit_assert_int32(csize, ==, LzwCompressBuff2Null(data, size));
+	rewind(fp);
+	munit_assert_int32(LzwContextExpand(plc, LzwFpSrcE(fp), LzwBuffDestE(out, 0, 0)), ==, size);
+	munit_assert_memory_equal(size, out, data);
+
+	fclose(fp);
+	free(out);
+	free(data);
+	LzwContextDestroy(plc);
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_lz4_block(const MunitParameter params[], void* user_data_or_fixture) {
+	static const int32_t sizes[] = { 0, 1, 12, 13, 100, 5000, 200000 };
+
+	// a hand-made block: 3 literals, a 9 byte match 3 back, 5 last literals
+	static uint8_t block[] = { 12, 0, 0, 0, 0x35, 'a', 'b', 'c', 3, 0, 0x50, 'h', 'e', 'l', 'l', 'o' };
+	uint8_t text[32];
+	munit_assert_int32(Lz4Expand(block, sizeof(block), text, sizeof(text)), ==, 17);
+	munit_assert_memory_equal(17, text, "abcabcabcabchello");
+
+	for (int kind = LZW_TEXT; kind <= LZW_SAME; ++kind) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			int32_t size = sizes[s];
+			uint8_t *data = lzw_data(kind, size);
+			uint8_t *comp = malloc(LZ4_MAXSIZE(size));
+			uint8_t *out = malloc(size + 16);
+
+			int32_t csize = Lz4Compress(data, size, comp, LZ4_MAXSIZE(size));
+			munit_assert_int32(csize, >, LZ4_HEADERSIZE);
+			munit_assert_int32(Lz4Size(comp), ==, csize);
+			if (kind != LZW_NOISE && size >= 5000)
+				munit_assert_int32(csize, <, size / 2);
+
+			// too small a buffer is refused, not overrun
+			munit_assert_int32(Lz4Compress(data, size, comp, csize - 1), ==, -1);
+			munit_assert_int32(Lz4Compress(data, size, comp, csize), ==, csize);
+
+			munit_assert_int32(Lz4Expand(comp, csize, out, size), ==, size);
+			munit_assert_memory_equal(size, out, data);
+
+			// a short destination gets a prefix, and nothing past it
+			int32_t part = size / 3 + 1;
+			memset(out, 0xEE, size + 16);
+			munit_assert_int32(Lz4Expand(comp, csize, out, part), ==, part < size ? part : size);
+			munit_assert_memory_equal(part < size ? part : size, out, data);
+			for (int32_t i = part; i < size + 16; ++i)
+				munit_assert_uint8(out[i], ==, 0xEE);
+
+			// damaged data stays inside the buffers
+			for (int32_t i = LZ4_HEADERSIZE; i < csize; i += 1 + csize / 50) {
+				comp[i] ^= 0x5A;
+				memset(out, 0xEE, size + 16);
+				int32_t n = Lz4Expand(comp, csize, out, size);
+				munit_assert_int32(n, <=, size);
+				for (int32_t j = size; j < size + 16; ++j)
+					munit_assert_uint8(out[j], ==, 0xEE);
+				comp[i] ^= 0x5A;
+			}
+
+			free(out);
+			free(comp);
+			free(data);
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_lz4_items(const MunitParameter params[], void* user_data_or_fixture) {
+	// items of mixed kinds and sizes, some empty, after a 10 byte "ref table"
+	static const int32_t sizes[] = { 3000, 0, 1, 20000, 0, 77, 5000, 12 };
+	enum { NUM_ITEMS = sizeof(sizes) / sizeof(sizes[0]) };
+	int32_t offsets[NUM_ITEMS + 1];
+	int32_t size = 10;
+
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		offsets[i] = size;
+		size += sizes[i];
+	}
+	offsets[NUM_ITEMS] = size;
+
+	uint8_t *data = malloc(size);
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		uint8_t *item = lzw_data(i % (LZW_SAME + 1), sizes[i]);
+		memcpy(data + offsets[i], item, sizes[i]);
+		free(item);
+	}
+	int32_t max = LZ4_ITEMTABLESIZE(NUM_ITEMS) + NUM_ITEMS * LZ4_MAXSIZE(0) + LZ4_MAXSIZE(size);
+	uint8_t *comp = malloc(max);
+	uint8_t *out = malloc(size + 16);
+
+	int32_t csize = Lz4CompressItems(data, offsets, NUM_ITEMS, comp, max);
+	munit_assert_int32(csize, >, LZ4_ITEMTABLESIZE(NUM_ITEMS));
+	munit_assert_int32(LZ4_ITEMOFFSET(comp, 0), ==, LZ4_ITEMTABLESIZE(NUM_ITEMS));
+	munit_assert_int32(LZ4_ITEMOFFSET(comp, NUM_ITEMS), ==, csize);
+	munit_assert_int32(Lz4CompressItems(data, offsets, NUM_ITEMS, comp, csize - 1), ==, -1);
+
+	// any one item expands alone, from its own block
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		memset(out, 0xEE, size + 16);
+		munit_assert_int32(Lz4ExpandItem(comp, csize, i, out, sizes[i]), ==, sizes[i]);
+		munit_assert_memory_equal(sizes[i], out, data + offsets[i]);
+		munit_assert_uint8(out[sizes[i]], ==, 0xEE);
+		munit_assert_int32(LZ4_ITEMOFFSET(comp, i + 1) - LZ4_ITEMOFFSET(comp, i), ==,
+			Lz4Size(comp + LZ4_ITEMOFFSET(comp, i)));
+	}
+
+	// all of them land at their offsets, around what's already there
+	memset(out, 0xEE, size + 16);
+	munit_assert_int32(Lz4ExpandItems(comp, csize, offsets, NUM_ITEMS, out), ==, 0);
+	for (int i = 0; i < 10; ++i)
+		munit_assert_uint8(out[i], ==, 0xEE);
+	munit_assert_memory_equal(size - 10, out + 10, data + 10);
+	munit_assert_uint8(out[size], ==, 0xEE);
+
+	// out of range items and damaged tables are refused
+	munit_assert_int32(Lz4ExpandItem(comp, csize, -1, out, size), ==, -1);
+	munit_assert_int32(Lz4ExpandItem(comp, csize, NUM_ITEMS, out, size), ==, -1);
+	munit_assert_int32(Lz4ExpandItem(comp, LZ4_ITEMTABLESIZE(NUM_ITEMS), 3, out, size), ==, -1);
+	comp[4 * 3] ^= 0x40;
+	munit_assert_int32(Lz4ExpandItems(comp, csize, offsets, NUM_ITEMS, out), ==, -1);
+	comp[4 * 3] ^= 0x40;
+	comp[4 * 5 + 3] = 0x80;
+	munit_assert_int32(Lz4ExpandItem(comp, csize, 5, out, sizes[5]), ==, -1);
+
+	free(out);
+	free(comp);
+	free(data);
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_index(const MunitParameter params[], void* user_data_or_fixture) {
+	const char *path = "test_index.res";
+	char idxPath[64];
+	ResIndexEntry entries[300];
+	ResIndexHeader stamp, *phead;
+	size_t size;
+
+	snprintf(idxPath, sizeof(idxPath), "%s%s", path, RES_INDEX_EXT);
+	remove(idxPath);
+	FILE *fp = fopen(path, "wb+");
+	munit_assert_ptr_not_null(fp);
+	fwrite("stand-in for a resource file", 28, 1, fp);
+	fflush(fp);
+
+	// no index yet
+	ResIndexStamp(fp, 20, &stamp);
+	munit_assert_int32(stamp.fileSize, ==, 28);
+	munit_assert_ptr_null(ResIndexLoad((char *) path, &stamp, &size));
+
+	// saved out of order, loaded back sorted
+	for (int i = 0; i < 300; ++i) {
+		entries[i].id = (Id) (3 + (i * 7919) % 300);
+		entries[i].flags = i & 7;
+		entries[i].type = i & 15;
+		entries[i].size = i * 100;
+		entries[i].csize = i * 60;
+		entries[i].offset = 128 + i * 4;
+	}
+	munit_assert_true(ResIndexSave((char *) path, &stamp, entries, 300));
+	phead = ResIndexLoad((char *) path, &stamp, &size);
+	munit_assert_ptr_not_null(phead);
+	munit_assert_int32(phead->numEntries, ==, 300);
+	ResIndexEntry *pie = (ResIndexEntry *) (phead + 1);
+	for (int i = 0; i < 300; ++i) {
+		munit_assert_uint16(pie[i].id, ==, 3 + i);
+		int j = (int) ((pie[i].offset - 128) / 4);
+		munit_assert_int32(pie[i].size, ==, j * 100);
+		munit_assert_int32(pie[i].csize, ==, j * 60);
+		munit_assert_uint8(pie[i].type, ==, j & 15);
+	}
+	ResIndexFree(phead, size);
+
+	// stale once the resource file changes, or its directory moves
+	ResIndexHeader moved;
+	ResIndexStamp(fp, 24, &moved);
+	munit_assert_ptr_null(ResIndexLoad((char *) path, &moved, &size));
+	fwrite("more", 4, 1, fp);
+	fflush(fp);
+	ResIndexHeader grown;
+	ResIndexStamp(fp, 20, &grown);
+	munit_assert_ptr_null(ResIndexLoad((char *) path, &grown, &size));
+	fclose(fp);
+
+	// damaged index is refused
+	FILE *fi = fopen(idxPath, "rb+");
+	munit_assert_ptr_not_null(fi);
+	fseek(fi, sizeof(ResIndexHeader) + 5 * sizeof(ResIndexEntry) + 4, SEEK_SET);
+	fputc(0x55, fi);
+	fclose(fi);
+	munit_assert_ptr_null(ResIndexLoad((char *) path, &stamp, &size));
+
+	remove(idxPath);
+	remove(path);
+	return MUNIT_OK;
+}
+
+// counts one id from many threads at once
+static void *telem_worker(void *arg) {
+	for (int i = 0; i < 100000; ++i)
+		ResTelemCount(4000, 7, RES_TELEM_BYTESREAD, 3);
+	return NULL;
+}
+
+static MunitResult test_telemetry(const MunitParameter params[], void* user_data_or_fixture) {
+	pthread_t tid[8];
+
+	ResTelemReset();
+	munit_assert_ptr_null(ResTelemId(60000));
+
+	// counts go to the id and its type
+	ResTelemCount(5, 2, RES_TELEM_HITS, 1);
+	ResTelemCount(5, 2, RES_TELEM_HITS, 1);
+	ResTelemCount(6, 2, RES_TELEM_HITS, 1);
+	munit_assert_uint64(ResTelemId(5)->count[RES_TELEM_HITS], ==, 2);
+	munit_assert_uint64(ResTelemId(6)->count[RES_TELEM_HITS], ==, 1);
+	munit_assert_uint64(ResTelemType(2)->count[RES_TELEM_HITS], ==, 3);
+
+	// no counts lost between threads
+	for (int t = 0; t < 8; ++t)
+		pthread_create(&tid[t], NULL, telem_worker, NULL);
+	for (int t = 0; t < 8; ++t)
+		pthread_join(tid[t], NULL);
+	munit_assert_uint64(ResTelemId(4000)->count[RES_TELEM_BYTESREAD], ==, 8 * 100000 * 3);
+	munit_assert_uint64(ResTelemType(7)->count[RES_TELEM_BYTESREAD], ==, 8 * 100000 * 3);
+
+	// loads land in one histogram bucket, and in totals & worst
+	uint64_t start = ResTelemNow();
+	ResTelemLoaded(5, 2, start);
+	ResTelemLoaded(6, 2, start - 5000000);
+	ResTelemHist *ph = ResTelemHistogram(RES_TELEM_LOADTIME);
+	uint64_t n = 0;
+	for (int b = 0; b < RES_TELEM_BUCKETS; ++b)
+		n += ph->count[b];
+	munit_assert_uint64(n, ==, 2);
+	munit_assert_uint64(ph->maxNs, >=, 5000000);
+	munit_assert_uint64(ph->count[0] + ph->count[1], <=, 1);
+	munit_assert_uint64(ResTelemId(6)->count[RES_TELEM_MAXLOADNS], >=, 5000000);
+	munit_assert_uint64(ResTelemType(2)->count[RES_TELEM_LOADS], ==, 2);
+
+	// JSON has ids worst first, and only those asked for
+	char text[8192];
+	FILE *fp = tmpfile();
+	munit_assert_ptr_not_null(fp);
+	munit_assert_int32(ResTelemDumpJson(fp, 2), ==, 2);
+	rewind(fp);
+	text[fread(text, 1, sizeof(text) - 1, fp)] = 0;
+	fclose(fp);
+	munit_assert_ptr_not_null(strstr(text, "\"histograms\""));
+	munit_assert_ptr_not_null(strstr(text, "\"name\": \"IMAGE\""));
+	char *p6 = strstr(text, "{\"id\": 6,");
+	char *p5 = strstr(text, "{\"id\": 5,");
+	munit_assert_ptr_not_null(p6);
+	munit_assert_ptr_not_null(p5);
+	munit_assert_true(p6 < p5);
+	munit_assert_ptr_null(strstr(text, "{\"id\": 4000,"));
+
+	ResTelemReset();
+	munit_assert_uint64(ResTelemId(5)->count[RES_TELEM_HITS], ==, 0);
+	munit_assert_uint64(ResTelemHistogram(RES_TELEM_LOADTIME)->maxNs, ==, 0);
+	return MUNIT_OK;
+}
+
+// a batch of plain and compound resources, LZW and LZ4, some of which won't shrink
+enum { COMP_JOBS = 24 };
+
+static void comp_jobs_setup(ResCompJob *jobs, int32_t offsets[][4]) {
+	for (int j = 0; j < COMP_JOBS; ++j) {
+		ResCompJob *pj = &jobs[j];
+		pj->size = 1000 + 3371 * j;
+		pj->pres = lzw_data(j % (LZW_SAME + 1), pj->size);
+		pj->flags = (j % 3 == 0) ? RDF_LZ4 : (j % 3 == 1) ? RDF_LZW : RDF_LZW | RDF_LZ4;
+		pj->sizeTable = pj->numItems = 0;
+		pj->offsets = NULL;
+		if (j % 4 == 3) {
+			pj->numItems = 3;
+			pj->sizeTable = REFTABLESIZE(3);
+			offsets[j][0] = pj->sizeTable;
+			offsets[j][1] = pj->sizeTable + 100;
+			offsets[j][2] = pj->size / 2;
+			offsets[j][3] = pj->size;
+			pj->offsets = offsets[j];
+		}
+	}
+}
+
+static MunitResult test_comp_jobs(const MunitParameter params[], void* user_data_or_fixture) {
+	static const int32_t threads[] = { 2, 3, 8, 100 };
+	ResCompJob serial[COMP_JOBS], jobs[COMP_JOBS];
+	int32_t offsets[COMP_JOBS][4];
+
+	// one at a time with the shared LZW state, as ResWrite() does
+	comp_jobs_setup(serial, offsets);
+	for (int j = 0; j < COMP_JOBS; ++j) {
+		ResCompress(&serial[j], NULL);
+		if (j % (LZW_SAME + 1) == LZW_NOISE) {
+			munit_assert_ptr_null(serial[j].pcomp);
+			munit_assert_uint8(serial[j].flags, ==, 0);
+		} else {
+			munit_assert_ptr_not_null(serial[j].pcomp);
+			munit_assert_uint8(serial[j].flags, ==, (j % 3 == 1) ? RDF_LZW : RDF_LZ4);
+		}
+	}
+
+	// any number of threads comes out the same, byte for byte
+	for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+		comp_jobs_setup(jobs, offsets);
+		ResCompressJobs(jobs, COMP_JOBS, threads[t]);
+		for (int j = 0; j < COMP_JOBS; ++j) {
+			munit_assert_uint8(jobs[j].flags, ==, serial[j].flags);
+			munit_assert_int32(jobs[j].compSize, ==, serial[j].compSize);
+			if (serial[j].pcomp != NULL)
+				munit_assert_memory_equal(serial[j].compSize, jobs[j].pcomp, serial[j].pcomp);
+			free(jobs[j].pcomp);
+			free(jobs[j].pres);
+		}
+	}
+
+	// compound resources as LZ4 expand an item at a time
+	for (int j = 3; j < COMP_JOBS; j += 4) {
+		if (serial[j].flags & RDF_LZ4) {
+			uint8_t *out = malloc(serial[j].size);
+			munit_assert_int32(Lz4ExpandItems(serial[j].pcomp, serial[j].compSize, offsets[j], 3, out), ==, 0);
+			munit_assert_memory_equal(serial[j].size - serial[j].sizeTable, out + serial[j].sizeTable,
+				serial[j].pres + serial[j].sizeTable);
+			free(out);
+		}
+	}
+
+	for (int j = 0; j < COMP_JOBS; ++j) {
+		free(serial[j].pcomp);
+		free(serial[j].pres);
+	}
+
+	return MUNIT_OK;
+}
+
+// what the game supplies the res system, stood in for here
+static ResDesc2 test_resdesc2[65536];
+ResDesc2 *gResDesc2 = test_resdesc2;
+Id idBeingLoaded;
+
+void *ResMalloc(size_t size) { return malloc(size); }
+void *ResRealloc(void *p, size_t newsize) { return realloc(p, newsize); }
+void ResFree(void *p) { free(p); }
+void ResAddPath(char *path) {}
+void *ResDefaultPager(int32_t size) { return NULL; }
+void ResInstallPager(void *f(int32_t size)) {}
+
+// resfiles written here are in this machine's byte order
+int32_t SwapLongBytes(int32_t in) { return in; }
+int16_t SwapShortBytes(int16_t in) { return in; }
+
+typedef struct {
+	Id id;
+	uint8_t type;
+	uint8_t flags;			// RDF_LZW or RDF_LZ4 if data is compressed
+	int32_t size;			// size in ram
+	int32_t csize;			// size of data
+	void *data;
+} res_item;
+
+// a resfile laid out as resfile.c reads it: header, data, directory
+static void res_write_file(const char *path, const res_item *items, int32_t n) {
+	static const uint8_t pad[4];
+	ResFileHeader head;
+	ResDirHeader dirHead;
+	ResDirEntry entry;
+	char idxPath[64];
+	FILE *fp = fopen(path, "wb");
+	munit_assert_ptr_not_null(fp);
+
+	snprintf(idxPath, sizeof(idxPath), "%s%s", path, RES_INDEX_EXT);
+	remove(idxPath);
+	memset(&head, 0, sizeof(head));
+	memcpy(head.signature, resFileSignature, sizeof(head.signature));
+	fwrite(&head, sizeof(head), 1, fp);
+	for (int32_t i = 0; i < n; ++i) {
+		fwrite(items[i].data, items[i].csize, 1, fp);
+		fwrite(pad, RES_OFFSET_PADBYTES(items[i].csize), 1, fp);
+	}
+
+	head.dirOffset = (int32_t) ftell(fp);
+	memset(&dirHead, 0, sizeof(dirHead));
+	dirHead.numEntries = n;
+	dirHead.dataOffset = sizeof(head);
+	fwrite(&dirHead, sizeof(dirHead), 1, fp);
+	for (int32_t i = 0; i < n; ++i) {
+		memset(&entry, 0, sizeof(entry));
+		entry.id = items[i].id;
+		entry.size = items[i].size;
+		entry.flags = items[i].flags;
+		entry.csize = items[i].csize;
+		entry.type = items[i].type;
+		fwrite(&entry, sizeof(entry), 1, fp);
+	}
+	fseek(fp, 0, SEEK_SET);
+	fwrite(&head, sizeof(head), 1, fp);
+	fclose(fp);
+}
+
+static void res_remove_file(const char *path) {
+	char idxPath[64];
+
+	snprintf(idxPath, sizeof(idxPath), "%s%s", path, RES_INDEX_EXT);
+	remove(idxPath);
+	remove(path);
+}
+
+// what a block routine was handed
+static struct {
+	uint8_t *out;
+	int32_t size;
+	int32_t blocks;
+	int32_t bad;
+	int32_t next;
+} stream_got;
+
+static int32_t stream_proc(void *buff, int32_t numBytes, int32_t iblock) {
+	if (REBF_BLOCKNUM(iblock) != stream_got.blocks ||
+		!(iblock & REBF_FIRST) != (stream_got.blocks != 0))
+		stream_got.bad++;
+	memcpy(stream_got.out + stream_got.size, buff, numBytes);
+	stream_got.size += numBytes;
+	stream_got.blocks++;
+	if (iblock & REBF_LAST)
+		stream_got.bad += 1000;
+	return stream_got.next++ % 7 * 100;
+}
+
+static MunitResult test_stream(const MunitParameter params[], void* user_data_or_fixture) {
+	static const int32_t depths[] = { 1, 2, 4 };
+	static const int32_t sizes[] = { 0, 1, 999, 1000, 1001, 54321 };
+	uint8_t buff[1000];
+
+	for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+			int32_t size = sizes[s];
+			uint8_t *data = lzw_data(LZW_TEXT, size);
+			memset(&stream_got, 0, sizeof(stream_got));
+			stream_got.out = malloc(size + 1);
+
+			// put in by copying and straight into the blocks, unevenly
+			ResStream *ps = ResStreamOpen(size, depths[d] == 1 ? buff : NULL, 1000, depths[d], stream_proc);
+			munit_assert_ptr_not_null(ps);
+			int32_t put = 0;
+			while (put < size) {
+				int32_t n = (put & 1) ? 333 : 17, avail;
+				if (n > size - put)
+					n = size - put;
+				if (put % 3) {
+					ResStreamWrite(ps, data + put, n);
+				} else {
+					uint8_t *space = ResStreamSpace(ps, &avail);
+					if (n > avail)
+						n = avail;
+					memcpy(space, data + put, n);
+					ResStreamAdvance(ps, n);
+				}
+				put += n;
+			}
+			munit_assert_true(ResStreamClose(ps));
+
+			// one last block, all the bytes in order
+			munit_assert_int32(stream_got.bad, ==, 1000);
+			munit_assert_int32(stream_got.size, ==, size);
+			munit_assert_memory_equal(size, stream_got.out, data);
+			if (size == 0)
+				munit_assert_int32(stream_got.blocks, ==, 1);
+			if (depths[d] > 1)
+				munit_assert_int32(stream_got.blocks, ==, size ? (size + 999) / 1000 : 1);
+
+			free(stream_got.out);
+			free(data);
+		}
+	}
+
+	// the block routine picks the next block size, unless pipelined
+	uint8_t data[2000] = { 0 };
+	memset(&stream_got, 0, sizeof(stream_got));
+	stream_got.out = malloc(sizeof(data));
+	stream_got.next = 1;
+	ResStream *ps = ResStreamOpen(sizeof(data), buff, 1000, 1, stream_proc);
+	ResStreamWrite(ps, data, sizeof(data));
+	munit_assert_true(ResStreamClose(ps));
+	munit_assert_int32(stream_got.blocks, ==, 5);	// 1000, then 100, 200, 300, 400 as asked
+	munit_assert_int32(stream_got.size, ==, 2000);
+
+	// coming up short still ends with a last block
+	stream_got.size = stream_got.blocks = stream_got.bad = 0;
+	ps = ResStreamOpen(sizeof(data), NULL, 1000, 2, stream_proc);
+	ResStreamWrite(ps, data, 1500);
+	munit_assert_true(!ResStreamClose(ps));
+	munit_assert_int32(stream_got.size, ==, 1500);
+	munit_assert_int32(stream_got.bad, ==, 1000);
+	free(stream_got.out);
+
+	// from a resfile: a compound resource as LZW and as LZ4, items of text
+	// with an empty one, after a ref table
+	static const int32_t itemSizes[] = { 2500, 0, 3100, 1234 };
+	enum { NUM_ITEMS = sizeof(itemSizes) / sizeof(itemSizes[0]) };
+	const char *path = "test_stream.res";
+	int32_t tableSize = REFTABLESIZE(NUM_ITEMS);
+	int32_t offsets[NUM_ITEMS + 1];
+	int32_t size = tableSize;
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		offsets[i] = size;
+		size += itemSizes[i];
+	}
+	offsets[NUM_ITEMS] = size;
+
+	uint8_t *res = malloc(size);
+	RefTable *prt = (RefTable *) res;
+	prt->numRefs = NUM_ITEMS;
+	for (int i = 0; i <= NUM_ITEMS; ++i)
+		prt->offset[i] = offsets[i];
+	for (int i = 0; i < NUM_ITEMS; ++i) {
+		uint8_t *item = lzw_data(LZW_TEXT, itemSizes[i]);
+		memcpy(res + offsets[i], item, itemSizes[i]);
+		free(item);
+	}
+
+	// the ref table stays plain, what's after it is compressed
+	int32_t max = tableSize + LZ4_ITEMTABLESIZE(NUM_ITEMS) + NUM_ITEMS * LZ4_MAXSIZE(0) +
+		LZ4_MAXSIZE(size) + 2 * size;
+	uint8_t *lzw = malloc(max);
+	uint8_t *lz4 = malloc(max);
+	memcpy(lzw, res, tableSize);
+	memcpy(lz4, res, tableSize);
+	int32_t lzwSize = tableSize + LzwCompressBuff2Buff(res + tableSize, size - tableSize,
+		lzw + tableSize, max - tableSize);
+	int32_t lz4Size = tableSize + Lz4CompressItems(res, offsets, NUM_ITEMS,
+		lz4 + tableSize, max - tableSize);
+	munit_assert_int32(lz4Size, >, tableSize);
+	res_item items[] = {
+		{ 0x1500, RTYPE_APP + 5, RDF_COMPOUND | RDF_LZW, size, lzwSize, lzw },
+		{ 0x1501, RTYPE_APP + 5, RDF_COMPOUND | RDF_LZ4, size, lz4Size, lz4 },
+	};
+	res_write_file(path, items, 2);
+	ResInit();
+	int32_t filenum = ResOpenResFile((char *) path, ROM_READ, FALSE);
+	munit_assert_int32(filenum, >=, 0);
+	stream_got.out = malloc(size);
+
+	for (int k = 0; k < 2; ++k) {
+		for (int piped = 0; piped < 2; ++piped) {
+			// whole, the ref table comes first as is
+			stream_got.size = stream_got.blocks = stream_got.bad = stream_got.next = 0;
+			if (piped)
+				ResExtractInBlocksPiped(items[k].id, 1000, 2, stream_proc);
+			else
+				ResExtractInBlocks(items[k].id, buff, 1000, stream_proc);
+			munit_assert_int32(stream_got.bad, ==, 1000);
+			munit_assert_int32(stream_got.size, ==, size);
+			munit_assert_memory_equal(size, stream_got.out, res);
+
+			// items, from the table given or the one in the file; LZW ones
+			// past the first are expanded from the middle, the empty one is a
+			// single block, both first & last
+			for (int i = 0; i < 2 * NUM_ITEMS; ++i) {
+				Ref ref = MKREF(items[k].id, i / 2);
+				RefTable *pt = (i & 1) ? prt : NULL;
+				stream_got.size = stream_got.blocks = stream_got.bad = stream_got.next = 0;
+				if (piped)
+					RefExtractInBlocksPiped(pt, ref, 1000, 2, stream_proc);
+				else
+					RefExtractInBlocks(pt, ref, buff, 1000, stream_proc);
+				munit_assert_int32(stream_got.bad, ==, 1000);
+				munit_assert_int32(stream_got.size, ==, itemSizes[i / 2]);
+				munit_assert_memory_equal(itemSizes[i / 2], stream_got.out, res + offsets[i / 2]);
+				if (itemSizes[i / 2] == 0)
+					munit_assert_int32(stream_got.blocks, ==, 1);
+			}
+		}
+	}
+
+	ResCloseFile(filenum);
+	ResTerm();
+	res_remove_file(path);
+	free(stream_got.out);
+	free(lz4);
+	free(lzw);
+	free(res);
+
+	return MUNIT_OK;
+}
+
+// swap a record by hand: sizes of its fields, 0 terminated
+static void swap_by_hand(uint8_t *p, int32_t size, const uint8_t *fields) {
+	int32_t rec = 0;
+	for (const uint8_t *f = fields; *f; ++f)
+		rec += *f;
+	for (int32_t r = 0; r + rec <= size; r += rec) {
+		for (const uint8_t *f = fields; *f; p += *f++) {
+			for (int i = 0; i < *f / 2; ++i) {
+				uint8_t t = p[i];
+				p[i] = p[*f - 1 - i];
+				p[*f - 1 - i] = t;
+			}
+		}
+	}
+}
+
+static MunitResult test_swap(const MunitParameter params[], void* user_data_or_fixture) {
+	static const struct {
+		char *layout;
+		uint8_t fields[20];
+	} layouts[] = {
+		{ ">h", { 2 } },
+		{ ">l", { 4 } },
+		{ ">4h", { 2, 2, 2, 2 } },
+		{ ">hhl", { 2, 2, 4 } },
+		{ ">bxh", { 1, 1, 2 } },
+		{ ">lhbb", { 4, 2, 1, 1 } },
+		{ ">hl", { 2, 4 } },
+		{ ">l2h4b", { 4, 2, 2, 1, 1, 1, 1 } },
+		{ ">3b", { 1, 1, 1 } },
+		{ ">16b", { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 } },
+	};
+	static const uint16_t one = 1;
+	bool big = (*(uint8_t *) &one == 0);
+	uint8_t data[1000 + 1], want[1000 + 1];
+	ResLayout rl;
+
+	for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l) {
+		munit_assert_true(ResLayoutCompile(layouts[l].layout, &rl));
+		if (big)
+			munit_assert_uint8(rl.recSize, ==, 0);
+
+		// every size, at odd & even addresses, a partial record left alone
+		for (int32_t size = 0; size < 200; size += (size < 40) ? 1 : 37) {
+			for (int a = 0; a < 2; ++a) {
+				for (int32_t i = 0; i < size + 1; ++i)
+					data[a + i] = want[a + i] = i * 7 + l;
+				if (!big)
+					swap_by_hand(want + a, size, layouts[l].fields);
+				ResSwapRecords(&rl, data + a, size);
+				munit_assert_memory_equal(size + 1, data + a, want + a);
+			}
+		}
+	}
+
+	// data in this machine's order needs nothing, bad layouts are refused
+	munit_assert_true(ResLayoutCompile(big ? ">4h" : "<4h", &rl));
+	munit_assert_uint8(rl.recSize, ==, 0);
+	munit_assert_true(!ResLayoutCompile("4h", &rl));
+	munit_assert_true(!ResLayoutCompile(">4q", &rl));
+	munit_assert_true(!ResLayoutCompile(">", &rl));
+	munit_assert_true(!ResLayoutCompile(">300b", &rl));
+	munit_assert_true(!ResLayoutCompile(">99999999999h", &rl));
+
+	// bulk 16 & 32 bit swaps, twice is back where we started
+	for (int32_t i = 0; i < 1000; ++i)
+		data[i] = want[i] = i;
+	ResSwap16(data + 1, 301);
+	munit_assert_uint8(data[1], ==, 2);
+	munit_assert_uint8(data[2], ==, 1);
+	munit_assert_uint8(data[601], ==, (uint8_t) 602);
+	munit_assert_uint8(data[603], ==, (uint8_t) 603);
+	ResSwap16(data + 1, 301);
+	munit_assert_memory_equal(1000, data, want);
+	ResSwap32(data + 3, 199);
+	munit_assert_uint8(data[3], ==, 6);
+	munit_assert_uint8(data[6], ==, 3);
+	munit_assert_uint8(data[799], ==, (uint8_t) 799);
+	ResSwap32(data + 3, 199);
+	munit_assert_memory_equal(1000, data, want);
+
+	// compound resources are swapped item by item, the ref table left alone
+	munit_assert_true(ResSetTypeLayout(RTYPE_RECT, ">4h"));
+	munit_assert_true(ResTypeLayout(RTYPE_RECT) != NULL || big);
+	munit_assert_ptr_null(ResTypeLayout(RTYPE_IMAGE));
+	int32_t res[16];
+	RefTable *prt = (RefTable *) res;
+	int32_t base = (int32_t) ((uint8_t *) &prt->offset[3] - (uint8_t *) res);
+	int32_t size = base + 8 + 16;
+	prt->numRefs = 2;
+	prt->offset[0] = base;
+	prt->offset[1] = base + 8;
+	prt->offset[2] = base + 8 + 16;
+	for (int32_t i = base; i < size; ++i)
+		((uint8_t *) res)[i] = i;
+	memcpy(want, res, size);
+	if (!big) {
+		swap_by_hand(want + prt->offset[0], 8, layouts[2].fields);
+		swap_by_hand(want + prt->offset[1], 16, layouts[2].fields);
+	}
+	ResSwapData(&resLayouts[RTYPE_RECT], RDF_COMPOUND, res, size);
+	munit_assert_memory_equal(size, res, want);
+	munit_assert_true(ResSetTypeLayout(RTYPE_RECT, NULL));
+	munit_assert_ptr_null(ResTypeLayout(RTYPE_RECT));
+	munit_assert_true(!ResSetTypeLayout(200, ">h"));
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_mapped(const MunitParameter params[], void* user_data_or_fixture) {
+	const char *path = "test_mapped.res";
+	uint8_t *plain = lzw_data(LZW_RUNS, 5001);
+	uint8_t *text = lzw_data(LZW_TEXT, 20000);
+	uint8_t *comp = malloc(2 * 20000 + 16);
+	int32_t csize = LzwCompressBuff2Buff(text, 20000, comp, 2 * 20000 + 16);
+	res_item items[] = {
+		{ 0x1000, RTYPE_APP, 0, 5001, 5001, plain },
+		{ 0x1001, RTYPE_APP, RDF_LZW, 20000, csize, comp },
+		{ 0x1002, RTYPE_RECT, 0, 5001, 5001, plain },
+	};
+
+	res_write_file(path, items, 3);
+	ResInit();
+	munit_assert_true(ResSetTypeLayout(RTYPE_RECT, ">4h"));
+	int32_t filenum = ResOpenResFile((char *) path, ROM_MAP, FALSE);
+	munit_assert_int32(filenum, >=, 0);
+	uint8_t *pmap = resFile[filenum].pmap;
+	munit_assert_ptr_not_null(pmap);
+
+	// uncompressed & needing no swap: used in place, nothing loaded
+	int32_t loads = resCacheStat.numResources;
+	munit_assert_true(ResIsMapped(0x1000));
+	uint8_t *p = ResLock(0x1000);
+	munit_assert_ptr_equal(p, pmap + 128);
+	munit_assert_memory_equal(5001, p, plain);
+	munit_assert_int32(resCacheStat.numResources, ==, loads);
+	munit_assert_ptr_equal(ResLoadResource(0x1000), p);
+
+	// changes go to the file image, not the file
+	p[0] ^= 0xFF;
+	ResUnlock(0x1000);
+	ResDrop(0x1000);
+	munit_assert_ptr_null(ResPtr(0x1000));
+	p = ResGet(0x1000);
+	munit_assert_ptr_equal(p, pmap + 128);
+	munit_assert_uint8(p[0], ==, (uint8_t) (plain[0] ^ 0xFF));
+	FILE *fp = fopen(path, "rb");
+	uint8_t first;
+	fseek(fp, 128, SEEK_SET);
+	munit_assert_int(fread(&first, 1, 1, fp), ==, 1);
+	fclose(fp);
+	munit_assert_uint8(first, ==, plain[0]);
+
+	// compressed, or to be swapped: loaded into memory as usual
+	munit_assert_true(!ResIsMapped(0x1001));
+	p = ResLock(0x1001);
+	munit_assert_ptr_not_null(p);
+	munit_assert_true(p < pmap || p >= pmap + resFile[filenum].mapSize);
+	munit_assert_memory_equal(20000, p, text);
+	munit_assert_int32(resCacheStat.numResources, ==, loads + 1);
+	ResUnlock(0x1001);
+	munit_assert_true(!ResIsMapped(0x1002));
+	p = ResLoadResource(0x1002);
+	munit_assert_ptr_not_null(p);
+	munit_assert_true(p < pmap || p >= pmap + resFile[filenum].mapSize);
+	munit_assert_int32(resCacheStat.numResources, ==, loads + 2);
+
+	// closing lets go of the image
+	ResDrop(0x1001);
+	ResDrop(0x1002);
+	munit_assert_int32(resCacheStat.numResources, ==, loads);
+	ResCloseFile(filenum);
+	munit_assert_ptr_null(ResPtr(0x1000));
+	munit_assert_true(!ResIsMapped(0x1000));
+	munit_assert_ptr_null(resFile[filenum].pmap);
+
+	munit_assert_true(ResSetTypeLayout(RTYPE_RECT, NULL));
+	ResTerm();
+	res_remove_file(path);
+	free(plain);
+	free(text);
+	free(comp);
+
+	return MUNIT_OK;
+}
+
+// wait for prefetch workers to have read n bytes of type from resfiles
+static void res_wait_read(uint8_t type, uint64_t n) {
+	uint64_t *pread = &ResTelemType(type)->count[RES_TELEM_BYTESREAD];
+
+	for (int i = 0; i < 10000000 && __atomic_load_n(pread, __ATOMIC_RELAXED) < n; ++i)
+		sched_yield();
+	munit_assert_uint64(__atomic_load_n(pread, __ATOMIC_RELAXED), >=, n);
+}
+
+static MunitResult test_prefetch(const MunitParameter params[], void* user_data_or_fixture) {
+	const char *path = "test_prefetch.res";
+	const uint8_t type = RTYPE_APP + 1;
+	uint8_t *data[8], *comp[8];
+	res_item items[8];
+	ResPrefetchStat was;
+
+	for (int i = 0; i < 8; ++i) {
+		data[i] = lzw_data(i & 1 ? LZW_TEXT : LZW_RUNS, 30000 + i);
+		comp[i] = malloc(2 * 30000 + 32);
+		items[i].id = 0x1100 + i;
+		items[i].type = type;
+		items[i].size = 30000 + i;
+		if (i & 1) {
+			items[i].flags = RDF_LZW;
+			items[i].csize = LzwCompressBuff2Buff(data[i], items[i].size, comp[i], 2 * 30000 + 32);
+			items[i].data = comp[i];
+		} else {
+			items[i].flags = 0;
+			items[i].csize = items[i].size;
+			items[i].data = data[i];
+		}
+	}
+	res_write_file(path, items, 8);
+	ResInit();
+	int32_t filenum = ResOpenResFile((char *) path, ROM_READ, FALSE);
+	munit_assert_int32(filenum, >=, 0);
+	if (ResPrefetchStart(2) == 0) {
+		ResTerm();
+		res_remove_file(path);
+		return MUNIT_SKIP;
+	}
+
+	// done by a worker, collected by the lock
+	for (int i = 0; i < 2; ++i) {
+		Id id = 0x1100 + i;
+		uint64_t read = ResTelemType(type)->count[RES_TELEM_BYTESREAD];
+		was = resPrefetchStat;
+		ResPrefetch(id);
+		munit_assert_uint32(resPrefetchStat.numIssued, ==, was.numIssued + 1);
+		munit_assert_true(ResFlags(id) & RDF_PREFETCH);
+		munit_assert_ptr_null(ResPtr(id));
+		ResPrefetch(id);
+		munit_assert_uint32(resPrefetchStat.numIssued, ==, was.numIssued + 1);
+		res_wait_read(type, read + items[i].csize);
+		uint8_t *p = ResLock(id);
+		munit_assert_ptr_not_null(p);
+		munit_assert_memory_equal(items[i].size, p, data[i]);
+		munit_assert_true(!(ResFlags(id) & RDF_PREFETCH));
+		munit_assert_uint32(resPrefetchStat.numHits + resPrefetchStat.numLateHits, ==,
+			was.numHits + was.numLateHits + 1);
+		munit_assert_uint32(resPrefetchStat.numMisses, ==, was.numMisses);
+
+		// in memory now, so nothing to prefetch
+		ResPrefetch(id);
+		munit_assert_uint32(resPrefetchStat.numIssued, ==, was.numIssued + 1);
+		ResUnlock(id);
+		ResDrop(id);
+	}
+
+	// dropped before it's collected: forgotten, and loaded when used
+	for (int i = 2; i < 4; ++i) {
+		Id id = 0x1100 + i;
+		was = resPrefetchStat;
+		ResPrefetch(id);
+		ResDrop(id);
+		munit_assert_true(!(ResFlags(id) & RDF_PREFETCH));
+		munit_assert_ptr_null(ResPtr(id));
+		uint8_t *p = ResLock(id);
+		munit_assert_ptr_not_null(p);
+		munit_assert_memory_equal(items[i].size, p, data[i]);
+		munit_assert_uint32(resPrefetchStat.numMisses, ==, was.numMisses + 1);
+		munit_assert_uint32(resPrefetchStat.numHits + resPrefetchStat.numLateHits, ==,
+			was.numHits + was.numLateHits);
+		ResUnlock(id);
+		ResDrop(id);
+	}
+
+	// closing the file, or stopping the workers, forgets the rest
+	for (int i = 4; i < 8; ++i)
+		ResPrefetch(0x1100 + i);
+	ResPrefetchStop();
+	for (int i = 4; i < 8; ++i) {
+		munit_assert_true(!(ResFlags(0x1100 + i) & RDF_PREFETCH));
+		ResPrefetch(0x1100 + i);
+	}
+	ResCloseFile(filenum);
+	for (int i = 4; i < 8; ++i) {
+		munit_assert_true(!(ResFlags(0x1100 + i) & RDF_PREFETCH));
+		munit_assert_ptr_null(ResPtr(0x1100 + i));
+	}
+
+	ResTerm();
+	res_remove_file(path);
+	for (int i = 0; i < 8; ++i) {
+		free(data[i]);
+		free(comp[i]);
+	}
+
+	return MUNIT_OK;
+}
+
+// lock & unlock a resource, loading it if need be
+static void res_touch(Id id) {
+	munit_assert_ptr_not_null(ResLock(id));
+	ResUnlock(id);
+}
+
+// ids of resources dropped since last looked, in id order
+static int32_t res_dropped(Id first, int32_t n, bool *pin, Id *pdropped) {
+	int32_t numDropped = 0;
+
+	for (Id id = first; id < first + n; ++id) {
+		if (pin[id - first] && ResPtr(id) == NULL)
+			pdropped[numDropped++] = id;
+		pin[id - first] = (ResPtr(id) != NULL);
+	}
+	return numDropped;
+}
+
+static MunitResult test_evict(const MunitParameter params[], void* user_data_or_fixture) {
+	static const struct {
+		ResCachePolicy *policy;
+		Id dropped[2];		// on loading 4th & 5th
+	} cases[] = {
+		{ &resCacheLRU, { 0x1200, 0x1201 } },		// least recently used
+		{ &resCacheClock, { 0x1202, 0x1200 } },	// unused since loaded, then hand
+	};
+	const char *path = "test_evict.res";
+	uint8_t data[5][64];
+	res_item items[5];
+	bool in[5];
+	Id dropped[5];
+
+	for (int i = 0; i < 5; ++i) {
+		memset(data[i], 'a' + i, sizeof(data[i]));
+		items[i].id = 0x1200 + i;
+		items[i].type = RTYPE_APP + 2;
+		items[i].flags = 0;
+		items[i].size = items[i].csize = sizeof(data[i]);
+		items[i].data = data[i];
+	}
+	res_write_file(path, items, 5);
+
+	for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+		ResInit();
+		ResCacheSetPolicy(cases[c].policy);
+		int32_t filenum = ResOpenResFile((char *) path, ROM_READ, FALSE);
+		munit_assert_int32(filenum, >=, 0);
+		ResCacheSetBudget(3 * 64);
+		ResCacheStat was = resCacheStat;
+		memset(in, 0, sizeof(in));
+
+		// two used again, then one more: full
+		res_touch(0x1200);
+		res_touch(0x1201);
+		res_touch(0x1200);
+		res_touch(0x1201);
+		res_touch(0x1202);
+		munit_assert_int32(res_dropped(0x1200, 5, in, dropped), ==, 0);
+
+		// each of two more drops one
+		res_touch(0x1203);
+		munit_assert_int32(res_dropped(0x1200, 5, in, dropped), ==, 1);
+		munit_assert_uint16(dropped[0], ==, cases[c].dropped[0]);
+		res_touch(0x1204);
+		munit_assert_int32(res_dropped(0x1200, 5, in, dropped), ==, 1);
+		munit_assert_uint16(dropped[0], ==, cases[c].dropped[1]);
+		munit_assert_uint32(resCacheStat.numEvictions, ==, was.numEvictions + 2);
+		munit_assert_uint32(resCacheStat.totBytesEvicted, ==, was.totBytesEvicted + 2 * 64);
+		munit_assert_int32(resCacheStat.totBytes, ==, was.totBytes + 3 * 64);
+
+		// locked ones stay, even over budget
+		for (Id id = 0x1200; id < 0x1205; ++id)
+			munit_assert_ptr_not_null(ResLock(id));
+		munit_assert_int32(res_dropped(0x1200, 5, in, dropped), ==, 0);
+		munit_assert_int32(resCacheStat.totBytes, ==, was.totBytes + 5 * 64);
+		munit_assert_uint32(resCacheStat.numOverBudget, ==, was.numOverBudget + 2);
+		munit_assert_memory_equal(64, ResPtr(0x1202), data[2]);
+		for (Id id = 0x1200; id < 0x1205; ++id)
+			ResUnlock(id);
+
+		// back in budget as soon as asked
+		ResCacheSetBudget(2 * 64);
+		munit_assert_int32(resCacheStat.totBytes, ==, was.totBytes + 2 * 64);
+		ResCacheSetBudget(0);
+		for (Id id = 0x1200; id < 0x1205; ++id)
+			ResDrop(id);
+		ResCloseFile(filenum);
+		ResCacheSetPolicy(&resCacheClock);
+		ResTerm();
+	}
+	res_remove_file(path);
+
+	return MUNIT_OK;
+}
+
+// a compound resource of numItems items of itemSize bytes, items 'a', 'b'...
+static uint8_t *res_compound(int32_t numItems, int32_t itemSize, int32_t *psize) {
+	int32_t tableSize = REFTABLESIZE(numItems);
+	uint8_t *p = calloc(1, tableSize + numItems * itemSize);
+	RefTable *prt = (RefTable *) p;
+
+	prt->numRefs = numItems;
+	for (int32_t i = 0; i <= numItems; ++i)
+		prt->offset[i] = tableSize + i * itemSize;
+	for (int32_t i = 0; i < numItems; ++i)
+		memset(p + prt->offset[i], 'a' + i, itemSize);
+	*psize = tableSize + numItems * itemSize;
+	return p;
+}
+
+static MunitResult test_partial(const MunitParameter params[], void* user_data_or_fixture) {
+	const char *path = "test_partial.res";
+	const uint8_t type = RTYPE_APP + 3;
+	const int32_t itemSize = 6000;
+	int32_t size;
+	uint8_t *data = res_compound(4, itemSize, &size);
+	uint64_t *pread = &ResTelemType(type)->count[RES_TELEM_BYTESREAD];
+	res_item items[] = {
+		{ 0x1300, type, RDF_COMPOUND, size, size, data },
+		{ 0x1301, type, RDF_COMPOUND, size, size, data },
+	};
+	RefTable *prt = (RefTable *) data;
+
+	munit_assert_int32(size, >=, RES_PARTIAL_MINSIZE);
+	res_write_file(path, items, 2);
+	ResInit();
+	int32_t filenum = ResOpenResFile((char *) path, ROM_READ, FALSE);
+	munit_assert_int32(filenum, >=, 0);
+
+	// getting an item reads just it
+	uint64_t read = *pread;
+	uint8_t *p = RefGet(MKREF(0x1300, 2));
+	munit_assert_ptr_not_null(p);
+	munit_assert_memory_equal(itemSize, p, data + prt->offset[2]);
+	munit_assert_true(ResIsPartial(0x1300));
+	munit_assert_uint64(*pread - read, ==, itemSize);
+	munit_assert_ptr_equal(RefGet(MKREF(0x1300, 2)), p);
+	munit_assert_uint64(*pread - read, ==, itemSize);
+
+	// locking it whole reads the rest
+	p = ResLock(0x1300);
+	munit_assert_ptr_not_null(p);
+	munit_assert_true(!ResIsPartial(0x1300));
+	munit_assert_memory_equal(size, p, data);
+	munit_assert_uint64(*pread - read, ==, 4 * itemSize);
+	ResUnlock(0x1300);
+	ResDrop(0x1300);
+
+	// leaving the cache forgets which items were in
+	munit_assert_ptr_not_null(RefGet(MKREF(0x1300, 1)));
+	munit_assert_true(ResIsPartial(0x1300));
+	ResCacheSetBudget(1);
+	munit_assert_ptr_null(ResPtr(0x1300));
+	munit_assert_true(!ResIsPartial(0x1300));
+	ResCacheSetBudget(0);
+
+	// items cut off the end of the file fail, and so does the whole
+	int32_t offset = RES_OFFSET_DESC2REAL(gResDesc[0x1301].offset);
+	munit_assert_int(truncate(path, offset + prt->offset[1] + 100), ==, 0);
+	p = RefGet(MKREF(0x1301, 0));
+	munit_assert_ptr_not_null(p);
+	munit_assert_memory_equal(itemSize, p, data + prt->offset[0]);
+	munit_assert_ptr_null(RefGet(MKREF(0x1301, 1)));
+	munit_assert_ptr_null(RefGet(MKREF(0x1301, 3)));
+	munit_assert_true(ResIsPartial(0x1301));
+	munit_assert_ptr_null(ResLock(0x1301));
+	munit_assert_ptr_null(ResPtr(0x1301));
+	munit_assert_true(!ResIsPartial(0x1301));
+	munit_assert_uint8(ResLocked(0x1301), ==, 0);
+
+	ResCloseFile(filenum);
+	ResTerm();
+	res_remove_file(path);
+	free(data);
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_extract(const MunitParameter params[], void* user_data_or_fixture) {
+	const char *path = "test_extract.res";
+	const int32_t itemSize = 3000;
+	int32_t size;
+	uint8_t *data = res_compound(4, itemSize, &size);
+	RefTable *prt = (RefTable *) data;
+	int32_t tableSize = REFTABLESIZE(prt->numRefs);
+	uint8_t *comp = malloc(2 * size + 16);
+	uint8_t buff[3000];
+
+	// the ref table stays plain, the items after it are compressed
+	memcpy(comp, data, tableSize);
+	int32_t csize = tableSize + LzwCompressBuff2Buff(data + tableSize, size - tableSize,
+		comp + tableSize, 2 * size);
+	res_item items[] = {
+		{ 0x1400, RTYPE_APP + 4, RDF_COMPOUND | RDF_LZW, size, csize, comp },
+	};
+	res_write_file(path, items, 1);
+	ResInit();
+	int32_t filenum = ResOpenResFile((char *) path, ROM_READ, FALSE);
+	munit_assert_int32(filenum, >=, 0);
+
+	// items are expanded from the middle, with or without the ref table
+	for (RefIndex i = 0; i < 4; ++i) {
+		memset(buff, 0, sizeof(buff));
+		munit_assert_ptr_equal(RefExtract(prt, MKREF(0x1400, i), buff), buff);
+		munit_assert_memory_equal(itemSize, buff, data + prt->offset[i]);
+	}
+	memset(buff, 0, sizeof(buff));
+	munit_assert_ptr_equal(RefExtract(NULL, MKREF(0x1400, 2), buff), buff);
+	munit_assert_memory_equal(itemSize, buff, data + prt->offset[2]);
+
+	ResCloseFile(filenum);
+	ResTerm();
+	res_remove_file(path);
+	free(comp);
+	free(data);
+
+	return MUNIT_OK;
+}
+
+MunitTest res_tests[] = {
+    { "/lzw_block", test_lzw_block, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/lzw_contexts", test_lzw_contexts, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/lz4_block", test_lz4_block, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/lz4_items", test_lz4_items, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/index", test_index, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/telemetry", test_telemetry, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/comp_jobs", test_comp_jobs, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/stream", test_stream, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/swap", test_swap, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/mapped", test_mapped, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/prefetch", test_prefetch, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/evict", test_evict, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/partial", test_partial, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/extract", test_extract, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
+};
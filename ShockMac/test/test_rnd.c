@@ -2,6 +2,10 @@
 
 #include "rnd.h"
 
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
 static MunitResult test_range_zero_one(RndStream *rs) {
 
 	RndSeed(rs, 0xDEADBEEF);
@@ -125,6 +129,458 @@ static MunitResult test_gauss16fast_range_fix(const MunitParameter params[], voi
     return test_range_fix(&rsGauss16Fast);
 }
 
+// bulk and inline values are the ones Rnd() would give, and leave the stream in the same place
+static MunitResult test_fill(RndStream *rs, RndStream *ref) {
+#define FILL_MAX	1000
+
+	static const int32_t counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, FILL_MAX };
+	uint32_t buff[FILL_MAX];
+	int32_t rbuff[FILL_MAX];
+
+	RndSeed(rs, 0xDEADBEEF);
+	RndSeed(ref, 0xDEADBEEF);
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		int32_t n = counts[c];
+		RndFill(rs, buff, n);
+		for (int32_t i = 0; i < n; ++i) {
+			munit_assert_uint32(buff[i], ==, Rnd(ref));
+		}
+		munit_assert_uint32(rs->curr, ==, ref->curr);
+
+		RndFillRange(rs, rbuff, n, -3, 17);
+		for (int32_t i = 0; i < n; ++i) {
+			munit_assert_int32(rbuff[i], ==, RndRange(ref, -3, 17));
+		}
+		munit_assert_uint32(rs->curr, ==, ref->curr);
+		munit_assert_memory_equal(sizeof(rs->state), rs->state, ref->state);
+	}
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_lc16_fill(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_LC16(rsLc16);
+	RNDSTREAM_LC16(rsRef);
+	MunitResult res = test_fill(&rsLc16, &rsRef);
+
+	for (size_t i = 0; i < 100; ++i) {
+		munit_assert_uint32(RndLc16Next(&rsLc16), ==, Rnd(&rsRef));
+		munit_assert_int32(RndStdRange(&rsLc16, 1, 6), ==, RndRange(&rsRef, 1, 6));
+		munit_assert_int32(RndLc16Fix(&rsLc16), ==, RndFix(&rsRef));
+	}
+	return res;
+}
+
+static MunitResult test_gauss16_fill(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_GAUSS16(rsGauss16);
+	RNDSTREAM_GAUSS16(rsRef);
+	return test_fill(&rsGauss16, &rsRef);
+}
+
+static MunitResult test_gauss16fast_fill(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_GAUSS16FAST(rsGauss16Fast);
+	RNDSTREAM_GAUSS16FAST(rsRef);
+	MunitResult res = test_fill(&rsGauss16Fast, &rsRef);
+
+	for (size_t i = 0; i < 100; ++i) {
+		munit_assert_uint32(RndGauss16FastNext(&rsGauss16Fast), ==, Rnd(&rsRef));
+		munit_assert_int32(RndGauss16FastRange(&rsGauss16Fast, 0, 99), ==, RndRange(&rsRef, 0, 99));
+	}
+	return res;
+}
+
+// every output bit is set half the time, and the low byte is uniform
+// (test_distribution() is only for lc generators, which fill bins far
+// more evenly than chance would)
+static MunitResult test_quality(RndStream *rs) {
+#define QUALITY_SAMPLES	65536
+
+	int32_t bits[32] = {0};
+	int32_t bytes[256] = {0};
+	double chi2 = 0;
+
+	RndSeed(rs, 0xDEADBEEF);
+
+	for (int32_t i = 0; i < QUALITY_SAMPLES; ++i) {
+		uint32_t r = Rnd(rs);
+		for (int32_t b = 0; b < 32; ++b) {
+			bits[b] += (r >> b) & 1;
+		}
+		bytes[r & 0xFF] += 1;
+	}
+
+	// 5 sigma of a fair coin
+	for (int32_t b = 0; b < 32; ++b) {
+		munit_assert_int32(abs(bits[b] - QUALITY_SAMPLES / 2), <=, 5 * 128);
+	}
+
+	// chi-square with 255 degrees of freedom, 330 is p = .001
+	for (int32_t i = 0; i < 256; ++i) {
+		double d = bytes[i] - QUALITY_SAMPLES / 256.0;
+		chi2 += d * d / (QUALITY_SAMPLES / 256.0);
+	}
+	munit_assert_double(chi2, <, 330.0);
+
+	return MUNIT_OK;
+}
+
+// substreams are the parent jumped, and don't start alike
+static MunitResult test_split(RndStream *rs) {
+#define NUM_SUBS	4
+
+	RndStream subs[NUM_SUBS], ref;
+
+	RndSeed(rs, 0xDEADBEEF);
+	ref = *rs;
+	RndSplit(rs, subs, NUM_SUBS);
+
+	for (int32_t i = 0; i < NUM_SUBS; ++i) {
+		RndJump(&ref);
+		munit_assert_memory_equal(sizeof(ref.state), ref.state, subs[i].state);
+	}
+	RndJump(&ref);
+	munit_assert_memory_equal(sizeof(ref.state), ref.state, rs->state);
+
+	uint32_t first[NUM_SUBS + 1];
+	for (int32_t i = 0; i < NUM_SUBS; ++i) {
+		first[i] = Rnd(&subs[i]);
+	}
+	first[NUM_SUBS] = Rnd(rs);
+	for (int32_t i = 0; i <= NUM_SUBS; ++i) {
+		for (int32_t j = i + 1; j <= NUM_SUBS; ++j) {
+			munit_assert_uint32(first[i], !=, first[j]);
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_xoshiro128_known(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_XOSHIRO128(rs);
+	static const uint32_t from_1234[] = { 11520, 0, 5927040, 70819200 };
+	static const uint32_t seeded[] = { 0xa9c3d393, 0x9d8f8341, 0x818871d8, 0x7e10181e };
+	static const uint32_t jumped[] = { 0x7645446c, 0x6007dd27 };
+
+	// the reference implementation's values from state 1, 2, 3, 4
+	for (uint32_t i = 0; i < 4; ++i) {
+		rs.state[i] = i + 1;
+	}
+	for (size_t i = 0; i < 4; ++i) {
+		munit_assert_uint32(Rnd(&rs), ==, from_1234[i]);
+	}
+
+	RndSeed(&rs, 0xDEADBEEF);
+	for (size_t i = 0; i < 4; ++i) {
+		munit_assert_uint32(RndXoshiro128Next(&rs), ==, seeded[i]);
+	}
+	RndJump(&rs);
+	for (size_t i = 0; i < 2; ++i) {
+		munit_assert_uint32(Rnd(&rs), ==, jumped[i]);
+	}
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_pcg32_known(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_PCG32(rs);
+	RNDSTREAM_PCG32(ref);
+	static const uint32_t seeded[] = { 0xc3b00ccb, 0xe7cc54a7, 0x20d2f15a, 0x968ee6dd };
+	static const uint32_t jumped[] = { 0x43c0a36e, 0xc903078c };
+
+	RndSeed(&rs, 0xDEADBEEF);
+	for (size_t i = 0; i < 4; ++i) {
+		munit_assert_uint32(RndPcg32Next(&rs), ==, seeded[i]);
+	}
+	RndJump(&rs);
+	for (size_t i = 0; i < 2; ++i) {
+		munit_assert_uint32(Rnd(&rs), ==, jumped[i]);
+	}
+
+	// advancing is the same as stepping
+	RndSeed(&rs, 7);
+	RndSeed(&ref, 7);
+	RndPcg32Advance(&rs, 1000);
+	for (size_t i = 0; i < 1000; ++i) {
+		Rnd(&ref);
+	}
+	munit_assert_uint32(Rnd(&rs), ==, Rnd(&ref));
+
+	return MUNIT_OK;
+}
+
+#define NEW_STREAM_TESTS(cls, decl)																	\
+static MunitResult test_##cls##_range_zero_one(const MunitParameter params[], void* user_data_or_fixture) {	\
+	decl(rs);																						\
+	return test_range_zero_one(&rs);																\
+}																									\
+static MunitResult test_##cls##_range_integer(const MunitParameter params[], void* user_data_or_fixture) {	\
+	decl(rs);																						\
+	return test_range_integer(&rs);																	\
+}																									\
+static MunitResult test_##cls##_fill(const MunitParameter params[], void* user_data_or_fixture) {		\
+	decl(rs);																						\
+	decl(ref);																						\
+	return test_fill(&rs, &ref);																	\
+}																									\
+static MunitResult test_##cls##_quality(const MunitParameter params[], void* user_data_or_fixture) {	\
+	decl(rs);																						\
+	return test_quality(&rs);																		\
+}																									\
+static MunitResult test_##cls##_split(const MunitParameter params[], void* user_data_or_fixture) {		\
+	decl(rs);																						\
+	return test_split(&rs);																			\
+}
+
+NEW_STREAM_TESTS(xoshiro128, RNDSTREAM_XOSHIRO128)
+NEW_STREAM_TESTS(pcg32, RNDSTREAM_PCG32)
+
+#define NEW_STREAM_ENTRIES(cls)																		\
+    { "/" #cls "_range_zero_one", test_##cls##_range_zero_one, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },	\
+    { "/" #cls "_range_integer", test_##cls##_range_integer, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },	\
+    { "/" #cls "_fill", test_##cls##_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },						\
+    { "/" #cls "_quality", test_##cls##_quality, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },				\
+    { "/" #cls "_split", test_##cls##_split, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+
+// normal deviates land in bins as often as the normal curve says
+static MunitResult test_ziggurat_normal(const MunitParameter params[], void* user_data_or_fixture) {
+#define NORMAL_SAMPLES	200000
+#define NORMAL_BINS		32				// quarter sigma wide from -4 to 4, plus the two tails
+
+	RNDSTREAM_ZIGGURAT(rs);
+	int32_t bins[NORMAL_BINS + 2] = {0};
+	double sum = 0, sum2 = 0, chi2 = 0;
+
+	RndSeed(&rs, 0xDEADBEEF);
+
+	for (int32_t i = 0; i < NORMAL_SAMPLES; ++i) {
+		double z = RndZigguratNormal24(&rs) / 16777216.0;
+		int32_t b = (int32_t) floor(z * 4) + NORMAL_BINS / 2 + 1;
+		if (b < 0) b = 0;
+		if (b > NORMAL_BINS + 1) b = NORMAL_BINS + 1;
+		bins[b] += 1;
+		sum += z;
+		sum2 += z * z;
+	}
+
+	double mean = sum / NORMAL_SAMPLES;
+	munit_assert_double(fabs(mean), <, 0.01);
+	munit_assert_double(fabs(sum2 / NORMAL_SAMPLES - mean * mean - 1.0), <, 0.02);
+
+	// chi-square with 33 degrees of freedom, 64 is p = .001
+	for (int32_t b = 0; b < NORMAL_BINS + 2; ++b) {
+		double lo = (b == 0) ? -INFINITY : (b - 1 - NORMAL_BINS / 2) / 4.0;
+		double hi = (b == NORMAL_BINS + 1) ? INFINITY : (b - NORMAL_BINS / 2) / 4.0;
+		double expect = NORMAL_SAMPLES * 0.5 * (erf(hi / sqrt(2.0)) - erf(lo / sqrt(2.0)));
+		chi2 += (bins[b] - expect) * (bins[b] - expect) / expect;
+	}
+	munit_assert_double(chi2, <, 64.0);
+
+	// the fix version is the same deviate, rounded
+	RNDSTREAM_ZIGGURAT(ref);
+	RndSeed(&rs, 22);
+	RndSeed(&ref, 22);
+	for (int32_t i = 0; i < 1000; ++i) {
+		fix f = RndZigguratNormal(&rs);
+		munit_assert_int32(f, ==, (RndZigguratNormal24(&ref) + 128) >> 8);
+	}
+
+	fix buff[1000];
+	RndZigguratNormalFill(&rs, buff, 1000);
+	for (int32_t i = 0; i < 1000; ++i) {
+		munit_assert_int32(buff[i], ==, RndZigguratNormal(&ref));
+	}
+	munit_assert_memory_equal(sizeof(rs.state), rs.state, ref.state);
+
+	return MUNIT_OK;
+}
+
+// Rnd() of a ziggurat stream is spread like RndGauss16's
+static MunitResult test_ziggurat_like_gauss16(const MunitParameter params[], void* user_data_or_fixture) {
+#define LIKE_SAMPLES	100000
+
+	RNDSTREAM_ZIGGURAT(rs);
+	RNDSTREAM_GAUSS16(gauss);
+	double zsum = 0, zsum2 = 0, gsum = 0, gsum2 = 0;
+
+	RndSeed(&rs, 0xDEADBEEF);
+	RndSeed(&gauss, 0xDEADBEEF);
+
+	for (int32_t i = 0; i < LIKE_SAMPLES; ++i) {
+		double z = fix_float(RndFix(&rs)), g = fix_float(RndFix(&gauss));
+		zsum += z;
+		zsum2 += z * z;
+		gsum += g;
+		gsum2 += g * g;
+	}
+
+	double zmean = zsum / LIKE_SAMPLES, gmean = gsum / LIKE_SAMPLES;
+	munit_assert_double(fabs(zmean - 0.5), <, 0.002);
+	munit_assert_double(fabs(sqrt(zsum2 / LIKE_SAMPLES - zmean * zmean) * 12 - 1), <, 0.02);
+
+	// RndGauss16's lc steps are correlated, so it only comes close
+	munit_assert_double(fabs(gmean - 0.5), <, 0.01);
+	munit_assert_double(fabs(sqrt(gsum2 / LIKE_SAMPLES - gmean * gmean) * 12 - 1), <, 0.05);
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_ziggurat_range_integer(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_ZIGGURAT(rs);
+	return test_range_integer(&rs);
+}
+
+static MunitResult test_ziggurat_fill(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_ZIGGURAT(rs);
+	RNDSTREAM_ZIGGURAT(ref);
+	return test_fill(&rs, &ref);
+}
+
+static MunitResult test_ziggurat_split(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_ZIGGURAT(rs);
+	return test_split(&rs);
+}
+
+static MunitResult test_philox_known(const MunitParameter params[], void* user_data_or_fixture) {
+	// Random123's known answers for philox4x32-10
+	static const uint32_t ctr[3][4] = {
+		{ 0, 0, 0, 0 },
+		{ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+		{ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+	};
+	static const uint32_t key[3][2] = {
+		{ 0, 0 },
+		{ 0xffffffff, 0xffffffff },
+		{ 0xa4093822, 0x299f31d0 },
+	};
+	static const uint32_t expect[3][4] = {
+		{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+		{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+		{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 },
+	};
+	uint32_t out[4];
+
+	for (size_t i = 0; i < 3; ++i) {
+		RndPhilox4x32(ctr[i], key[i], out);
+		for (size_t j = 0; j < 4; ++j) {
+			munit_assert_uint32(out[j], ==, expect[i][j]);
+		}
+	}
+
+	// a stream is the pure function, counted along
+	RNDSTREAM_COUNTER(rs);
+	RndCounterStart(&rs, 1234, 56, 22);
+	for (uint32_t i = 0; i < 10; ++i) {
+		munit_assert_uint32(Rnd(&rs), ==, RndCounterValue(1234, 56, 22, i));
+	}
+	munit_assert_uint32(RndCounterValue(1234, 56, 22, 0), ==, 0xac3ed049);
+	munit_assert_uint32(RndCounterValue(1234, 56, 22, 1), ==, 0x85f0ea30);
+
+	return MUNIT_OK;
+}
+
+static MunitResult test_counter_fill(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_COUNTER(rs);
+	RNDSTREAM_COUNTER(ref);
+	return test_fill(&rs, &ref);
+}
+
+static MunitResult test_counter_quality(const MunitParameter params[], void* user_data_or_fixture) {
+	RNDSTREAM_COUNTER(rs);
+	return test_quality(&rs);
+}
+
+// A made-up simulation: objects that take a varying number of rolls each
+// tick, each from a stream of its own.  Run by any number of threads, in any
+// order, it has to come out the same.
+
+#define DET_OBJECTS		500
+#define DET_TICKS		40
+#define DET_SEED		0xC0FFEE
+
+typedef struct {
+	int32_t hp;
+	fix pos;
+	uint32_t rolls;
+} DetObject;
+
+typedef struct {
+	DetObject *objects;
+	int32_t first, step;
+} DetWork;
+
+static void det_update(DetObject *o, uint32_t id, uint32_t tick) {
+	RNDSTREAM_COUNTER(rs);
+	RndCounterStart(&rs, DET_SEED, id, tick);
+
+	int32_t n = RndRange(&rs, 1, 4);
+	for (int32_t i = 0; i < n; ++i) {
+		o->hp -= RndRange(&rs, 0, 9);
+		o->pos += RndRangeFix(&rs, -FIX_UNIT, FIX_UNIT);
+	}
+	if (o->hp < 0) {
+		o->hp += 100 + RndRange(&rs, 0, 50);
+	}
+	o->rolls += rs.state[3];
+}
+
+static void *det_worker(void *arg) {
+	DetWork *w = (DetWork *) arg;
+
+	// odd workers go backwards, so the order differs from any serial run
+	for (uint32_t tick = 0; tick < DET_TICKS; ++tick) {
+		if (w->first & 1) {
+			int32_t last = w->first;
+			while (last + w->step < DET_OBJECTS) last += w->step;
+			for (int32_t i = last; i >= 0; i -= w->step) {
+				det_update(&w->objects[i], i, tick);
+			}
+		} else {
+			for (int32_t i = w->first; i < DET_OBJECTS; i += w->step) {
+				det_update(&w->objects[i], i, tick);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void det_run(DetObject *objects, int32_t threads) {
+	pthread_t tid[16];
+	DetWork work[16];
+
+	for (int32_t i = 0; i < DET_OBJECTS; ++i) {
+		objects[i].hp = 100;
+		objects[i].pos = 0;
+		objects[i].rolls = 0;
+	}
+	for (int32_t t = 0; t < threads; ++t) {
+		work[t].objects = objects;
+		work[t].first = t;
+		work[t].step = threads;
+		pthread_create(&tid[t], NULL, det_worker, &work[t]);
+	}
+	for (int32_t t = 0; t < threads; ++t) {
+		pthread_join(tid[t], NULL);
+	}
+}
+
+static MunitResult test_counter_threads(const MunitParameter params[], void* user_data_or_fixture) {
+	static DetObject one[DET_OBJECTS], many[DET_OBJECTS];
+	static const int32_t counts[] = { 2, 4, 7, 16 };
+
+	det_run(one, 1);
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		det_run(many, counts[c]);
+		munit_assert_memory_equal(sizeof(one), one, many);
+	}
+
+	// and the objects didn't all do the same thing
+	munit_assert_int32(one[0].pos, !=, one[1].pos);
+	munit_assert_uint32(one[0].rolls, !=, 0);
+
+	return MUNIT_OK;
+}
+
 MunitTest rnd_tests[] = {
     { "/lc16_range_zero_one", test_lc16_range_zero_one, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/lc16_range_integer", test_lc16_range_integer, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
@@ -136,5 +592,21 @@ MunitTest rnd_tests[] = {
     { "/gauss16fast_range_zero_one", test_gauss16fast_range_zero_one, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { "/gauss16fast_range_integer", test_gauss16fast_range_integer, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
 	{ "/gauss16fast_range_fix", test_gauss16fast_range_fix, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/lc16_fill", test_lc16_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/gauss16_fill", test_gauss16_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/gauss16fast_fill", test_gauss16fast_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/xoshiro128_known", test_xoshiro128_known, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/pcg32_known", test_pcg32_known, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    NEW_STREAM_ENTRIES(xoshiro128)
+    NEW_STREAM_ENTRIES(pcg32)
+    { "/ziggurat_normal", test_ziggurat_normal, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/ziggurat_like_gauss16", test_ziggurat_like_gauss16, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/ziggurat_range_integer", test_ziggurat_range_integer, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/ziggurat_fill", test_ziggurat_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/ziggurat_split", test_ziggurat_split, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/philox_known", test_philox_known, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/counter_fill", test_counter_fill, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/counter_quality", test_counter_quality, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
+    { "/counter_threads", test_counter_threads, NULL, NULL,  MUNIT_TEST_OPTION_NONE, NULL },
     { NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL }
 };